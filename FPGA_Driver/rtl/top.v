@@ -36,6 +36,8 @@ module top(
     parameter DEVICE_Set    = 8'h3f;     // 采样指令符 
     parameter DEVICE_Get    = 8'hf6;     // 读取指令符 
     parameter DEVICE_Div    = 8'h74;     // 读取指令符 
+    parameter DEVICE_GetPP  = 8'hC9;     // 流水读取指令符: 读取最近写满的bank，帧头带帧计数
+    parameter DEVICE_Cnt    = 8'h5C;     // 帧计数查询指令符: 返回最近写满的bank的帧计数(4字节)
  
     parameter START_ID_H    = 8'hAA;     // 起始校验符
     parameter START_ID_L    = 8'h55;     // 起始校验符
@@ -56,14 +58,22 @@ module top(
     reg [3:0] led_reg = 4'b0011;  
 
     // ADC
-
-    reg [9:0] ad0_buffer [0:Buffer_Length-1];
-    reg [9:0] ad1_buffer [0:Buffer_Length-1];
-    reg [9:0] ad2_buffer [0:Buffer_Length-1];
+    // 乒乓缓冲: 每个通道两个bank，ADC 持续写入 adc_wr_bank，写满后与 adc_rd_bank 交换，
+    // 主机读取 adc_rd_bank 期间 ADC 不停止采样，实现连续采集
+    reg [9:0] ad0_buffer [0:Buffer_Length*2-1];
+    reg [9:0] ad1_buffer [0:Buffer_Length*2-1];
+    reg [9:0] ad2_buffer [0:Buffer_Length*2-1];
 
     reg [10:0] adc_wr_addr;  // 独立地址指针
-    reg adc_lock;
-    reg adc_full;
+    reg adc_wr_bank;         // 正在写入的bank
+    reg adc_rd_bank;         // 最近写满、可供读取的bank
+    reg [31:0] adc_frame_cnt; // 已写满的帧计数(含因主机读取中而被丢弃的帧)
+    reg [31:0] adc_rd_cnt;    // adc_rd_bank 中那一帧的帧计数
+    reg [2:0] adc_clk_sync;  // adc_clk 同步到 clk_100m 后做上升沿检测
+    wire adc_sample = adc_clk_sync[1] & ~adc_clk_sync[2];
+    reg adc_lock;            // 主机正在读取 send_bank，禁止交换
+    reg send_bank;           // 本次读取锁定的bank
+    reg [31:0] send_cnt;     // 本次读取锁定的帧计数
     reg [12:0] data_index;  // 支持最大8092字节
     
     reg [31:0] div_cfg = DEFAULT_DIV_CFG; 
@@ -76,7 +86,9 @@ module top(
                state_ready = 1,
                state_send = 2,
                state_set = 3,
-               state_div = 4;
+               state_div = 4,
+               state_send_pp = 5,
+               state_cnt = 6;
     // SPI
     wire clk_100m;
     wire [7:0] spi_recv_data;
@@ -112,21 +124,38 @@ module top(
     );
 
     //=============== ADC数据采集 ===============//
-    
-    always @(posedge adc_clk or negedge rst) begin
+    // 与控制状态机同处 clk_100m 下降沿，bank 交换与读取锁定在同一时钟域内判定，不存在跨时钟竞争
+    // 本拍刚收到读取指令时也不交换，保证状态机锁定的 adc_rd_bank 在整个读取过程中不被写入
+    wire get_request = !cs_n && spi_recv_ready && fpga_state == state_ready &&
+                       (spi_recv_data == DEVICE_Get || spi_recv_data == DEVICE_GetPP);
+
+    always @(negedge clk_100m or negedge rst) begin
         if (!rst) begin
+            adc_clk_sync <= 0;
             adc_wr_addr <= 0;
-            adc_full <= 0;
-        end else if(!adc_lock||!adc_full) begin
-            ad0_buffer[adc_wr_addr] <= ad0_data;
-            ad1_buffer[adc_wr_addr] <= ad1_data;
-            ad2_buffer[adc_wr_addr] <= ad2_data;
-            if(adc_wr_addr == Buffer_Length-1)begin
-                adc_wr_addr <= 0;
-                adc_full <= 1;
-            end else begin
-                adc_wr_addr <= adc_wr_addr + 1;
-                adc_full <= 0;
+            adc_wr_bank <= 0;
+            adc_rd_bank <= 1;
+            adc_frame_cnt <= 0;
+            adc_rd_cnt <= 0;
+        end else begin
+            adc_clk_sync <= {adc_clk_sync[1:0], adc_clk};
+            if (adc_sample) begin
+                ad0_buffer[(adc_wr_bank ? Buffer_Length : 0) + adc_wr_addr] <= ad0_data;
+                ad1_buffer[(adc_wr_bank ? Buffer_Length : 0) + adc_wr_addr] <= ad1_data;
+                ad2_buffer[(adc_wr_bank ? Buffer_Length : 0) + adc_wr_addr] <= ad2_data;
+                if(adc_wr_addr == Buffer_Length-1)begin
+                    adc_wr_addr <= 0;
+                    adc_frame_cnt <= adc_frame_cnt + 1;
+                    if (!adc_lock && !get_request) begin
+                        // 写满一帧: 交换bank，新写满的bank可供读取
+                        adc_rd_bank <= adc_wr_bank;
+                        adc_wr_bank <= ~adc_wr_bank;
+                        adc_rd_cnt <= adc_frame_cnt + 1;
+                    end
+                    // 否则主机正在读取另一个bank，本帧被覆盖丢弃，主机通过帧计数跳变得知
+                end else begin
+                    adc_wr_addr <= adc_wr_addr + 1;
+                end
             end
         end
     end
@@ -137,6 +166,8 @@ module top(
             fpga_state <= state_idle;
             led_reg <= 4'b0011;
             adc_lock <= 0;
+            send_bank <= 0;
+            send_cnt <= 0;
             div_bytes_received <= 0;
             div_cfg <= DEFAULT_DIV_CFG;  // 复位时加载默认值
         end else if(!cs_n) begin
@@ -161,11 +192,27 @@ module top(
                             DEVICE_Get: begin
                                 fpga_state <= state_send;
                                 led_reg <= led_reg ^ 4'b1111; 
+                                adc_lock <= 1;
+                                send_bank <= adc_rd_bank;
+                                send_cnt <= adc_rd_cnt;
+                            end
+                            DEVICE_GetPP: begin
+                                fpga_state <= state_send_pp;
+                                led_reg <= led_reg ^ 4'b1111; 
+                                adc_lock <= 1;
+                                send_bank <= adc_rd_bank;
+                                send_cnt <= adc_rd_cnt;
+                            end
+                            DEVICE_Cnt: begin
+                                fpga_state <= state_cnt;
+                                send_cnt <= adc_rd_cnt;
                             end
                             default:  fpga_state <= state_idle;
                         endcase
                     end
                     state_send: fpga_state <= state_send;
+                    state_send_pp: fpga_state <= state_send_pp;
+                    state_cnt: fpga_state <= state_cnt;
                     state_set: fpga_state <= state_set;
                     state_div:begin
                     // 接收4字节分频系数
@@ -188,14 +235,23 @@ module top(
             end
         end else begin
             div_bytes_received <= 0;  // CS_N变高时重置接收计数器
-            if(fpga_state == state_set) adc_lock <= 1;
-            else if(fpga_state == state_send) adc_lock <= 0;
+            // 采样指令不再冻结缓冲区(双缓冲下最近写满的bank始终完整)，读取结束后解除锁定
+            adc_lock <= 0;
             fpga_state <= state_idle;
             div_cfg <= div_cfg;
         end
     end
 
     //=============== 数据发送逻辑 ===============//
+    // 流水读取帧: START(2) 帧计数(4, 大端) X SEP1 Y SEP2 Z END，帧计数之后的部分与普通读取完全相同
+    wire send_pp = (fpga_state == state_send_pp);
+    wire [12:0] frame_index = (send_pp && data_index >= 6) ? data_index - 4 : data_index;
+    wire [12:0] frame_last = send_pp ? (Buffer_Length*6+12) : (Buffer_Length*6+8);
+    wire [10:0] bank_base = send_bank ? Buffer_Length : 0;
+    wire [9:0] x_addr = (frame_index-2)>>1;
+    wire [9:0] y_addr = (frame_index-(Buffer_Length*2+4))>>1;
+    wire [9:0] z_addr = (frame_index-(Buffer_Length*4+6))>>1;
+
     always @(posedge clk_100m or negedge rst) begin
         if (!rst) begin
             data_index <= 0;
@@ -203,47 +259,56 @@ module top(
         end else begin
             if (!cs_n) begin
                 if (spi_recv_ready) begin
-                    if(fpga_state == state_send) begin
-                        case(data_index)
+                    if(fpga_state == state_send || send_pp) begin
+                        if(send_pp && data_index >= 2 && data_index < 6) begin
+                            // 帧计数
+                            case(data_index)
+                                2: spi_send_data <= send_cnt[31:24];
+                                3: spi_send_data <= send_cnt[23:16];
+                                4: spi_send_data <= send_cnt[15:8];
+                                default: spi_send_data <= send_cnt[7:0];
+                            endcase
+                        end else
+                        case(frame_index)
                             // 起始标识
                             0: spi_send_data <= START_ID_H;
                             1: spi_send_data <= START_ID_L;
                             
                             // AD1数据区（512点×2字节）
                             default: begin
-                                if(data_index < Buffer_Length*2+2) begin // Buffer_Length*2+2
-                                    if(data_index[0])  // 奇数字节发低位
-                                        spi_send_data <= {6'b0, ad0_buffer[(data_index-2)>>1][1:0]};
+                                if(frame_index < Buffer_Length*2+2) begin // Buffer_Length*2+2
+                                    if(frame_index[0])  // 奇数字节发低位
+                                        spi_send_data <= {6'b0, ad0_buffer[bank_base + x_addr][1:0]};
                                     else               // 偶数字节发高位
-                                        spi_send_data <= ad0_buffer[(data_index-2)>>1][9:2];
+                                        spi_send_data <= ad0_buffer[bank_base + x_addr][9:2];
                                 end
-                                else if(data_index < Buffer_Length*2+4) begin // 分隔符1 Buffer_Length*2+4
-                                    spi_send_data <= (data_index == Buffer_Length*2+2) ? SEPARATOR1_H : SEPARATOR1_L;
+                                else if(frame_index < Buffer_Length*2+4) begin // 分隔符1 Buffer_Length*2+4
+                                    spi_send_data <= (frame_index == Buffer_Length*2+2) ? SEPARATOR1_H : SEPARATOR1_L;
                                 end
-                                else if(data_index < (Buffer_Length*4+4)) begin // AD0数据区 Buffer_Length*4+4
+                                else if(frame_index < (Buffer_Length*4+4)) begin // AD0数据区 Buffer_Length*4+4
                                     if(data_index[0])
-                                        spi_send_data <= {6'b0, ad1_buffer[(data_index-(Buffer_Length*2+4))>>1][1:0]};
+                                        spi_send_data <= {6'b0, ad1_buffer[bank_base + y_addr][1:0]};
                                     else
-                                        spi_send_data <= ad1_buffer[(data_index-(Buffer_Length*2+4))>>1][9:2];
+                                        spi_send_data <= ad1_buffer[bank_base + y_addr][9:2];
                                 end
-                                else if(data_index < (Buffer_Length*4+6)) begin // 分隔符2 Buffer_Length*4+6
-                                    spi_send_data <= (data_index == (Buffer_Length*4+4)) ? SEPARATOR2_H : SEPARATOR2_L;
+                                else if(frame_index < (Buffer_Length*4+6)) begin // 分隔符2 Buffer_Length*4+6
+                                    spi_send_data <= (frame_index == (Buffer_Length*4+4)) ? SEPARATOR2_H : SEPARATOR2_L;
                                 end
-                                else if(data_index < (Buffer_Length*6+6)) begin // AD0数据区 Buffer_Length*6+6
+                                else if(frame_index < (Buffer_Length*6+6)) begin // AD0数据区 Buffer_Length*6+6
                                     if(data_index[0])
-                                        spi_send_data <= {6'b0, ad2_buffer[(data_index-(Buffer_Length*4+6))>>1][1:0]};
+                                        spi_send_data <= {6'b0, ad2_buffer[bank_base + z_addr][1:0]};
                                     else
-                                        spi_send_data <= ad2_buffer[(data_index-(Buffer_Length*4+6))>>1][9:2];
+                                        spi_send_data <= ad2_buffer[bank_base + z_addr][9:2];
                                 end
-                                else if(data_index < (Buffer_Length*6+8)) begin // 结束符 Buffer_Length*6+8
-                                    spi_send_data <= (data_index == (Buffer_Length*6+6)) ? END_ID_H : END_ID_L;
+                                else if(frame_index < (Buffer_Length*6+8)) begin // 结束符 Buffer_Length*6+8
+                                    spi_send_data <= (frame_index == (Buffer_Length*6+6)) ? END_ID_H : END_ID_L;
                                 end
                                 else begin
                                     spi_send_data <= 8'h00;
                                 end
                             end
                         endcase
-                        data_index <= (data_index == (Buffer_Length*6+8)) ? 0 : data_index + 1;
+                        data_index <= (data_index == frame_last) ? 0 : data_index + 1;
                     end else if(fpga_state == state_set)begin
                         case(data_index)
                             // 起始标识
@@ -252,6 +317,15 @@ module top(
                             default: spi_send_data <= 8'h00;
                         endcase
                         data_index <= (data_index == 1) ? 0 : data_index + 1;
+                    end else if(fpga_state == state_cnt)begin
+                        case(data_index)
+                            0: spi_send_data <= send_cnt[31:24];
+                            1: spi_send_data <= send_cnt[23:16];
+                            2: spi_send_data <= send_cnt[15:8];
+                            3: spi_send_data <= send_cnt[7:0];
+                            default: spi_send_data <= 8'h00;
+                        endcase
+                        data_index <= (data_index == 3) ? 0 : data_index + 1;
                     end
                 end
             end else begin
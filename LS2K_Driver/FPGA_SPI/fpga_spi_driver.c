@@ -5,100 +5,503 @@
 #include <linux/cdev.h>
 #include <linux/of.h>
 #include <linux/spi/spi.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/gfp.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/delay.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/device.h>
+#include <linux/idr.h>
+#include <linux/kref.h>
+#include <linux/cache.h>
+#include <asm/io.h>
+#include <asm/unaligned.h>
+#include "fpga_spi_uapi.h"
 
-#define DEVICE_IP   	 0x16  // 设备识别符 
-#define DEVICE_Set  	 0x3f  // 采样指令符 
-#define DEVICE_Get  	 0xf6  // 读取指令符 
+#ifdef FPGA_SPI_TRACEPOINTS
+#define CREATE_TRACE_POINTS
+#include "fpga_spi_trace.h"
+#else
+static inline void trace_fpga_spi_frame(u32 seq, u32 lost, u64 cmd_ns, u64 xfer_ns) {}
+static inline void trace_fpga_spi_error(int kind, int err, u8 b0, u8 b1) {}
+#endif
+
+#define DEVICE_IP   	 0x16  // 设备识别符
+#define DEVICE_Set  	 0x3f  // 采样指令符
+#define DEVICE_Get  	 0xf6  // 读取指令符
 #define DEVICE_Div  	 0x74  // 分频指令符
+#define DEVICE_GetPP 	 0xc9  // 流水读取指令符(双缓冲，帧头带FPGA帧计数)
+#define DEVICE_Cnt  	 0x5c  // 帧计数查询指令符
 #define SPI_SEPARATOR1_H 0x5a  // 分隔校验符1
 #define SPI_SEPARATOR1_L 0xa5  // 分隔校验符1
-#define SPI_SEPARATOR2_H 0x7b  // 分隔校验符2 
-#define SPI_SEPARATOR2_L 0x89  // 分隔校验符2 
+#define SPI_SEPARATOR2_H 0x7b  // 分隔校验符2
+#define SPI_SEPARATOR2_L 0x89  // 分隔校验符2
 #define START_ID_H 		 0xaa  // 开始接收
 #define START_ID_L 		 0x55  // 开始接收
 #define END_ID_H 		 0xff  // 接收完毕
 #define END_ID_L 		 0xee  // 接收完毕
-#define ADC_DATA_SIZE	 2048  // byte for 1024 adc_data
+#define ADC_DATA_SIZE	 FPGA_ADC_DATA_SIZE  // byte for 1024 adc_data
+#define RING_SLOT_COUNT  16    // 环形缓冲区槽数(2的幂)
+#define RING_HDR_SIZE    64    // 槽内帧头区大小(>= 缓存行)，原始帧(SPI接收缓冲区)从此处开始，与CPU写入的帧头不共用缓存行
+#define FPGA_SPI_DEFAULT_SPEED 2000000  // 默认SPI时钟
+#define FPGA_SPI_MAX_CHUNKS    DIV_ROUND_UP(FPGA_FRAME_PP_RAW_SIZE, FPGA_SPI_CHUNK_MIN)
+#define FPGA_DEFAULT_DIV       500      // 与FPGA复位值一致: 10kHz 采样
+#define FPGA_SELFTEST_MAX_FRAMES 1000
+#define FPGA_SPI_MAX_DEVICES   8        // 最多支持的采集板数量，对应 /dev/FPGA_SPI_dev0 ~ 7
+#define FPGA_LAT_BUCKETS       24       // log2 直方图: 桶 i 统计 [2^(i-1), 2^i) us，桶 0 为 <1us，最后一桶含更大值
+
+// 两次采样指令之间的间隔(us)的初始值，默认为一帧的采样时长: 1024点 @ 10kHz = 102.4ms. 各设备设置分频后单独更新
+static unsigned int frame_period_us = 102400;
+module_param(frame_period_us, uint, 0644);
+MODULE_PARM_DESC(frame_period_us, "Initial interval between two captures in microseconds");
+
+// 流水模式: FPGA 双缓冲连续采样，主机读取上一帧的同时 FPGA 写入下一帧; 旧版 FPGA 固件需设为 0
+static bool pipelined = true;
+module_param(pipelined, bool, 0444);
+MODULE_PARM_DESC(pipelined, "Use double-buffered FPGA capture with frame counter (needs matching bitstream)");
 ssize_t this_read(struct file *file, char __user *ubuf, size_t size, loff_t *lofft);
 ssize_t this_write(struct file *file, const char __user *ubuf, size_t size, loff_t *lofft);
+long this_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
+int this_mmap(struct file *file, struct vm_area_struct *vma);
+__poll_t this_poll(struct file *file, poll_table *wait);
 int this_open(struct inode *inode, struct file *file);
 int this_close(struct inode *inode, struct file *file);
+
+// 帧校验结果，同时作为 fpga_spi_error 跟踪点的 kind
+enum fpga_frame_check {
+	FPGA_FRAME_OK = 0,
+	FPGA_FRAME_BAD_START,
+	FPGA_FRAME_BAD_SEP1,
+	FPGA_FRAME_BAD_SEP2,
+	FPGA_FRAME_BAD_END,
+	FPGA_FRAME_BAD_ACK,     // 采样指令应答错误
+	FPGA_FRAME_SPI_ERROR,   // spi_sync 失败
+};
+
+/*
+ * 链路统计，由采样线程在持有 lock 时更新，通过 sysfs(计数) 和 debugfs(直方图) 导出
+ */
+struct FPGA_SPI_stats{
+	u64 frames_ok;
+	u64 start_errors;
+	u64 sep1_errors;
+	u64 sep2_errors;
+	u64 end_errors;
+	u64 ack_errors;
+	u64 spi_errors;
+	u64 enomem_errors;
+	u64 idle_polls;                    // 流水模式下查询帧计数时尚无新帧的次数
+	u32 cmd_lat_hist[FPGA_LAT_BUCKETS];  // 采样指令到应答耗时(流水模式为帧计数查询耗时)
+	u32 xfer_lat_hist[FPGA_LAT_BUCKETS]; // 整帧传输耗时
+};
+
+/*
+ * 驱动全局数据: 所有采集板共用一个主设备号、设备类和 debugfs 目录，次设备号由 idr 分配并映射到设备
+ */
 struct FPGA_SPI_cdev{
-	dev_t devt;
-	struct cdev cdev;
+	dev_t devt;                        // 主设备号及起始次设备号，共 FPGA_SPI_MAX_DEVICES 个
 	struct file_operations fop;
 	struct class* cls;
-	struct device* dev;
+	struct dentry *debugfs_root;
 };
 
-struct FPGA_SPI_cdev fpga_spi_cdev = {
-	.cdev = {
-		.owner = THIS_MODULE
-	},
+// 次设备号 -> struct FPGA_SPI_dev，open 在 fpga_spi_devs_lock 下查找并取得引用，remove 在其下移除
+static DEFINE_IDR(fpga_spi_devs);
+static DEFINE_MUTEX(fpga_spi_devs_lock);
+
+static struct FPGA_SPI_cdev fpga_spi_cdev = {
 	.fop = {
 		.owner = THIS_MODULE,
 		.open = this_open,
 		.release = this_close,
 		.read = this_read,
-		.write = this_write
+		.write = this_write,
+		.unlocked_ioctl = this_ioctl,
+		.mmap = this_mmap,
+		.poll = this_poll
 	}
 };
-	
-struct spi_device *FPGA_SPI;
+
+/*
+ * 每块采集板的运行时数据(spi_get_drvdata): 预分配的环形缓冲区和SPI消息，采集过程中不再申请任何内存.
+ * 各设备拥有独立的锁、采样线程和字符设备，不同SPI总线上的采集互不阻塞.
+ * 环形缓冲区由 __get_free_pages 分配，物理连续，可直接作为SPI DMA接收缓冲区，
+ * 同时通过 mmap 映射给用户程序，SPI 接收到的数据无需任何拷贝即可被用户读取.
+ * 设备被打开期间由内核线程连续采样写入环中，读者通过等待队列/poll 被唤醒.
+ * 生命周期: probe 持有一个引用，每个打开的文件和每个映射(vma)各持有一个引用，最后一个引用释放时才释放环和本结构.
+ * remove 在 spi_lock 和 lock 下标记 dead 并停止采样线程，之后 read/poll/ioctl 返回 -ENODEV，已有的映射仍指向有效(不再更新)的环.
+ * 两把锁: spi_lock 串行化SPI访问(采样线程的传输、改时钟/分段/分频、自检、write)，lock 保护环的发布、统计、
+ * 打开计数和 dead. 采样线程只在持有 spi_lock 时传输到 head 所在的槽(该槽只属于生产者)，发布和更新统计时才获取 lock，
+ * 所以 read/poll/open 不会等待整帧传输. 需要两把锁时先获取 spi_lock.
+ */
+struct FPGA_SPI_dev{
+	struct spi_device *spi;            // dead 之后不再访问
+	struct cdev *cdev;                 // cdev_alloc 单独分配，其生命周期由 cdev 自身的引用计数管理
+	struct kref kref;
+	bool dead;                         // 设备已解除绑定，置位时同时持有 spi_lock 和 lock，读取时持有其一即可
+	struct device *dev;
+	int minor;
+	struct mutex spi_lock;             // 串行化本设备的SPI访问，以及传输用到的配置(chunk_size、div、cmd_buf 和各 spi_message)
+	struct mutex lock;                 // 保护环的发布(head)、读者消费(tail)、统计和打开计数
+	void *ring;                        // 环形缓冲区起始地址(控制区 + 槽)
+	unsigned int ring_order;
+	size_t ring_bytes;
+	struct fpga_ring_ctrl *ctrl;
+	u32 slot_size;
+	u32 data_offset;
+	u8 *cmd_buf;                       // 指令与应答缓冲区(kmalloc，DMA安全)
+	struct spi_transfer set_xfers[2];
+	struct spi_message set_msg;
+	struct spi_transfer get_xfers[1 + FPGA_SPI_MAX_CHUNKS];  // 指令 + 按 chunk_size 切分的接收段
+	struct spi_message get_msg;
+	u32 chunk_size;                    // 单次 spi_transfer 最大接收字节数，0 表示整帧一次传输
+	u32 div;                           // 当前FPGA分频系数
+	u32 period_us;                     // 当前帧周期(us)，随分频系数更新
+	struct spi_transfer cnt_xfers[2];
+	struct spi_message cnt_msg;
+	u32 seq;
+	u32 fpga_cnt;                      // 上一帧的FPGA帧计数(流水模式)
+	bool fpga_cnt_valid;               // 打开后尚未收到过帧时为 false，不统计丢帧
+	struct FPGA_SPI_stats stats;
+	struct dentry *debugfs_dir;
+	struct task_struct *sampler;       // 采样线程，首次打开时启动，最后一次关闭时停止
+	wait_queue_head_t wq;              // 有新帧发布时唤醒读者
+	int users;                         // 打开计数，受 lock 保护
+};
+
+#define CMD_SET_OFFSET 0   // cmd_buf[0..1]: DEVICE_IP, DEVICE_Set
+#define CMD_GET_OFFSET 2   // cmd_buf[2..3]: DEVICE_IP, DEVICE_Get
+#define CMD_ACK_OFFSET 4   // cmd_buf[4..5]: 采样指令应答 END_ID
+#define CMD_CNT_OFFSET 6   // cmd_buf[6..7]: DEVICE_IP, DEVICE_Cnt
+#define CMD_CNT_RX     8   // cmd_buf[8..11]: 帧计数(大端)
+#define CMD_DIV_OFFSET 12  // cmd_buf[12..17]: DEVICE_IP, DEVICE_Div, 分频系数(小端4字节)
+#define CMD_BUF_SIZE   64
+
+/*
+ * 每个打开的文件各自的状态
+ */
+struct FPGA_SPI_file{
+	struct FPGA_SPI_dev *fdev;
+	u32 read_format;                   // FPGA_READ_FORMAT_*
+};
+
+static inline u8 *ring_slot(struct FPGA_SPI_dev *fdev, u32 index)
+{
+	return (u8 *)fdev->ring + fdev->data_offset + (size_t)(index & (RING_SLOT_COUNT - 1)) * fdev->slot_size;
+}
+
+/*
+ * 原始帧在槽内的偏移. 两种模式都从按缓存行对齐的 RING_HDR_SIZE 处接收:
+ * SPI 控制器以 DMA 写入接收缓冲区，若与 CPU 写入的帧头共用缓存行，在非一致性 DMA 上
+ * 缓存失效/回写会互相覆盖帧头或帧数据. 槽长同样按缓存行对齐，接收缓冲区也不与下一槽的帧头共用缓存行.
+ */
+static inline u32 fpga_frame_offset(void)
+{
+	return RING_HDR_SIZE;
+}
+
+/*
+ * 有效数据(X SEP1 Y SEP2 Z)在槽内的偏移: 流水帧在 START 之后多 4 字节帧计数，有效数据随之后移，
+ * 用户程序按 fpga_ring_ctrl/fpga_ring_info 中的 payload_offset 定位
+ */
+static inline u32 fpga_payload_offset(void)
+{
+	return RING_HDR_SIZE + FPGA_FRAME_PAYLOAD_OFFSET + (pipelined ? FPGA_FRAME_CNT_SIZE : 0);
+}
+
+static int fpga_ring_alloc(struct FPGA_SPI_dev *fdev)
+{
+	BUILD_BUG_ON(RING_HDR_SIZE < sizeof(struct fpga_frame_hdr));
+	BUILD_BUG_ON(RING_HDR_SIZE % SMP_CACHE_BYTES != 0);
+	fdev->slot_size = ALIGN(RING_HDR_SIZE + FPGA_FRAME_PP_RAW_SIZE, SMP_CACHE_BYTES);
+	fdev->data_offset = PAGE_ALIGN(sizeof(struct fpga_ring_ctrl));
+	fdev->ring_bytes = PAGE_ALIGN(fdev->data_offset + (size_t)fdev->slot_size * RING_SLOT_COUNT);
+	fdev->ring_order = get_order(fdev->ring_bytes);
+	fdev->ring = (void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, fdev->ring_order);
+	if (!fdev->ring)
+		return -ENOMEM;
+
+	fdev->ctrl = fdev->ring;
+	fdev->ctrl->magic = FPGA_RING_MAGIC;
+	fdev->ctrl->version = FPGA_RING_VERSION;
+	fdev->ctrl->slot_count = RING_SLOT_COUNT;
+	fdev->ctrl->slot_size = fdev->slot_size;
+	fdev->ctrl->data_offset = fdev->data_offset;
+	fdev->ctrl->frame_offset = fpga_frame_offset();
+	fdev->ctrl->payload_offset = fpga_payload_offset();
+	return 0;
+}
+
+static void fpga_ring_free(struct FPGA_SPI_dev *fdev)
+{
+	if (fdev->ring)
+		free_pages((unsigned long)fdev->ring, fdev->ring_order);
+	fdev->ring = NULL;
+}
+
+/*
+ * 最后一个引用释放: 此时 remove 已完成，没有打开的文件和映射，采样线程已停止
+ */
+static void fpga_dev_release(struct kref *kref)
+{
+	struct FPGA_SPI_dev *fdev = container_of(kref, struct FPGA_SPI_dev, kref);
+
+	fpga_ring_free(fdev);
+	kfree(fdev->cmd_buf);
+	kfree(fdev);
+}
+
+static void fpga_dev_put(struct FPGA_SPI_dev *fdev)
+{
+	kref_put(&fdev->kref, fpga_dev_release);
+}
+
+/*
+ * 预先填好采样指令和读取指令的SPI传输描述，与 spi_write_then_read 一样在同一条消息内完成"写2字节再读N字节"
+ */
+static void fpga_prepare_messages(struct FPGA_SPI_dev *fdev)
+{
+	fdev->cmd_buf[CMD_SET_OFFSET] = DEVICE_IP;
+	fdev->cmd_buf[CMD_SET_OFFSET + 1] = DEVICE_Set;
+	fdev->cmd_buf[CMD_GET_OFFSET] = DEVICE_IP;
+	fdev->cmd_buf[CMD_GET_OFFSET + 1] = pipelined ? DEVICE_GetPP : DEVICE_Get;
+	fdev->cmd_buf[CMD_CNT_OFFSET] = DEVICE_IP;
+	fdev->cmd_buf[CMD_CNT_OFFSET + 1] = DEVICE_Cnt;
+
+	memset(fdev->set_xfers, 0, sizeof(fdev->set_xfers));
+	fdev->set_xfers[0].tx_buf = fdev->cmd_buf + CMD_SET_OFFSET;
+	fdev->set_xfers[0].len = 2;
+	fdev->set_xfers[1].rx_buf = fdev->cmd_buf + CMD_ACK_OFFSET;
+	fdev->set_xfers[1].len = 2;
+
+	memset(fdev->get_xfers, 0, sizeof(fdev->get_xfers));
+	fdev->get_xfers[0].tx_buf = fdev->cmd_buf + CMD_GET_OFFSET;
+	fdev->get_xfers[0].len = 2;
+	// 接收段在每次采集时由 fpga_build_get_message 指向环中的空槽
+
+	memset(fdev->cnt_xfers, 0, sizeof(fdev->cnt_xfers));
+	fdev->cnt_xfers[0].tx_buf = fdev->cmd_buf + CMD_CNT_OFFSET;
+	fdev->cnt_xfers[0].len = 2;
+	fdev->cnt_xfers[1].rx_buf = fdev->cmd_buf + CMD_CNT_RX;
+	fdev->cnt_xfers[1].len = FPGA_FRAME_CNT_SIZE;
+}
+
+/*
+ * sysfs: /sys/class/FPGA_SPI/FPGA_SPI_devN/ 下每个计数一个文件，写 reset_stats 清零
+ */
+#define FPGA_STAT_ATTR(name)								\
+static ssize_t name##_show(struct device *dev, struct device_attribute *attr, char *buf)	\
+{											\
+	struct FPGA_SPI_dev *fdev = dev_get_drvdata(dev);				\
+	return sprintf(buf, "%llu\n", (unsigned long long)READ_ONCE(fdev->stats.name));	\
+}											\
+static DEVICE_ATTR_RO(name)
+
+FPGA_STAT_ATTR(frames_ok);
+FPGA_STAT_ATTR(start_errors);
+FPGA_STAT_ATTR(sep1_errors);
+FPGA_STAT_ATTR(sep2_errors);
+FPGA_STAT_ATTR(end_errors);
+FPGA_STAT_ATTR(ack_errors);
+FPGA_STAT_ATTR(spi_errors);
+FPGA_STAT_ATTR(enomem_errors);
+FPGA_STAT_ATTR(idle_polls);
+
+static ssize_t overruns_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct FPGA_SPI_dev *fdev = dev_get_drvdata(dev);
+	return sprintf(buf, "%u\n", READ_ONCE(fdev->ctrl->overruns));
+}
+static DEVICE_ATTR_RO(overruns);
+
+static ssize_t fpga_lost_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct FPGA_SPI_dev *fdev = dev_get_drvdata(dev);
+	return sprintf(buf, "%u\n", READ_ONCE(fdev->ctrl->fpga_lost));
+}
+static DEVICE_ATTR_RO(fpga_lost);
+
+static ssize_t reset_stats_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct FPGA_SPI_dev *fdev = dev_get_drvdata(dev);
+	mutex_lock(&fdev->lock);
+	memset(&fdev->stats, 0, sizeof(fdev->stats));
+	fdev->ctrl->overruns = 0;
+	fdev->ctrl->fpga_lost = 0;
+	mutex_unlock(&fdev->lock);
+	return count;
+}
+static DEVICE_ATTR_WO(reset_stats);
+
+static struct attribute *fpga_spi_attrs[] = {
+	&dev_attr_frames_ok.attr,
+	&dev_attr_start_errors.attr,
+	&dev_attr_sep1_errors.attr,
+	&dev_attr_sep2_errors.attr,
+	&dev_attr_end_errors.attr,
+	&dev_attr_ack_errors.attr,
+	&dev_attr_spi_errors.attr,
+	&dev_attr_enomem_errors.attr,
+	&dev_attr_idle_polls.attr,
+	&dev_attr_overruns.attr,
+	&dev_attr_fpga_lost.attr,
+	&dev_attr_reset_stats.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(fpga_spi);
+
+/*
+ * debugfs: /sys/kernel/debug/fpga_spi/FPGA_SPI_devN/latency 输出指令应答与整帧传输耗时的 log2 直方图
+ */
+static void fpga_print_hist(struct seq_file *m, const char *name, const u32 *hist)
+{
+	int i = 0;
+
+	seq_printf(m, "%s:\n", name);
+	for (i = 0; i < FPGA_LAT_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		if (i == 0)
+			seq_printf(m, "  %10s us : %u\n", "<1", hist[i]);
+		else if (i == FPGA_LAT_BUCKETS - 1)
+			seq_printf(m, "  >= %7lu us : %u\n", 1UL << (i - 1), hist[i]);
+		else
+			seq_printf(m, "  %4lu-%-5lu us : %u\n", 1UL << (i - 1), (1UL << i) - 1, hist[i]);
+	}
+}
+
+static int fpga_latency_show(struct seq_file *m, void *v)
+{
+	struct FPGA_SPI_dev *fdev = m->private;
+
+	fpga_print_hist(m, pipelined ? "counter query latency" : "set-to-ack latency", fdev->stats.cmd_lat_hist);
+	fpga_print_hist(m, "frame transfer latency", fdev->stats.xfer_lat_hist);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fpga_latency);
+
 int	FPGA_SPI_probe(struct spi_device *spi)
 {
 	int ret = 0;
+	struct FPGA_SPI_dev *fdev;
+	dev_t devt;
 	printk("This is FPGA_SPI_probe\n");
-	FPGA_SPI = spi;
 
 	// 设置SPI模式，这里以模式0为例
-	spi->max_speed_hz = 2000000;
+	spi->max_speed_hz = FPGA_SPI_DEFAULT_SPEED;
 	spi->mode = SPI_MODE_0;
 	ret = spi_setup(spi);
 	if (ret < 0) {
 		printk("Failed to setup SPI device with mode 3\n");
 		return ret;
 	}
-	
-	ret = alloc_chrdev_region(&fpga_spi_cdev.devt, 0, 1, "FPGA_SPI");
-	if(ret!=0){
-		printk("alloc_chrdev_region error\n");
-		goto error_alloc_chrdev_region;
+
+	// 不使用 devm: 解除绑定后仍可能有打开的文件或映射引用本结构和环，由 kref 决定释放时机
+	fdev = kzalloc(sizeof(*fdev), GFP_KERNEL);
+	if (!fdev)
+		return -ENOMEM;
+	kref_init(&fdev->kref);
+	fdev->spi = spi;
+	fdev->div = FPGA_DEFAULT_DIV;
+	fdev->period_us = frame_period_us;
+	mutex_init(&fdev->spi_lock);
+	mutex_init(&fdev->lock);
+	init_waitqueue_head(&fdev->wq);
+	fdev->cmd_buf = kzalloc(CMD_BUF_SIZE, GFP_KERNEL);
+	if (!fdev->cmd_buf) {
+		ret = -ENOMEM;
+		goto error_alloc;
 	}
-	cdev_init(&fpga_spi_cdev.cdev, &fpga_spi_cdev.fop);
-	ret = cdev_add(&fpga_spi_cdev.cdev, fpga_spi_cdev.devt, 1);
+	fpga_prepare_messages(fdev);
+	ret = fpga_ring_alloc(fdev);
+	if (ret != 0) {
+		printk("Failed to allocate FPGA ring buffer\n");
+		goto error_alloc;
+	}
+
+	mutex_lock(&fpga_spi_devs_lock);
+	fdev->minor = idr_alloc(&fpga_spi_devs, fdev, 0, FPGA_SPI_MAX_DEVICES, GFP_KERNEL);
+	mutex_unlock(&fpga_spi_devs_lock);
+	if(fdev->minor < 0){
+		printk("No free FPGA_SPI minor number\n");
+		ret = fdev->minor;
+		goto error_alloc;
+	}
+	devt = MKDEV(MAJOR(fpga_spi_cdev.devt), fdev->minor);
+	// cdev 单独分配: open 在查找设备之前已持有 cdev 的引用，不能让它随 fdev 一起释放
+	fdev->cdev = cdev_alloc();
+	if (!fdev->cdev) {
+		ret = -ENOMEM;
+		goto error_cdev_add;
+	}
+	fdev->cdev->ops = &fpga_spi_cdev.fop;
+	fdev->cdev->owner = THIS_MODULE;
+	ret = cdev_add(fdev->cdev, devt, 1);
 	if(ret!=0){
 		printk("cdev_add error\n");
+		kobject_put(&fdev->cdev->kobj);
 		goto error_cdev_add;
 	}
-	fpga_spi_cdev.cls = class_create(THIS_MODULE, "FPGA_SPI");
-	if(!fpga_spi_cdev.cls){
-		printk("class_create error\n");
-		goto error_class_create;
-	}
-	fpga_spi_cdev.dev = device_create(fpga_spi_cdev.cls,NULL,fpga_spi_cdev.devt,NULL,"FPGA_SPI_dev");
-	if(!fpga_spi_cdev.dev){
+	fdev->dev = device_create_with_groups(fpga_spi_cdev.cls,&spi->dev,devt,fdev,fpga_spi_groups,"FPGA_SPI_dev%d",fdev->minor);
+	if(IS_ERR(fdev->dev)){
 		printk("device_create error\n");
+		ret = PTR_ERR(fdev->dev);
 		goto error_device_create;
 	}
+	// debugfs 仅用于调试，创建失败不影响驱动工作
+	fdev->debugfs_dir = debugfs_create_dir(dev_name(fdev->dev), fpga_spi_cdev.debugfs_root);
+	debugfs_create_file("latency", 0444, fdev->debugfs_dir, fdev, &fpga_latency_fops);
+	spi_set_drvdata(spi, fdev);
 	return 0;
 	error_device_create:
-		device_destroy(fpga_spi_cdev.cls, fpga_spi_cdev.devt);
-	error_class_create:
-		class_destroy(fpga_spi_cdev.cls);
+		cdev_del(fdev->cdev);
 	error_cdev_add:
-		cdev_del(&fpga_spi_cdev.cdev);
-	error_alloc_chrdev_region:
-		unregister_chrdev_region(fpga_spi_cdev.devt, 1);
+		mutex_lock(&fpga_spi_devs_lock);
+		idr_remove(&fpga_spi_devs, fdev->minor);
+		mutex_unlock(&fpga_spi_devs_lock);
+	error_alloc:
+		fpga_dev_put(fdev);
 	return ret;
 }
 
+/*
+ * 解除绑定: 先让 open 找不到本设备，再在 spi_lock 和 lock 下标记 dead 并取下采样线程，此后不再访问SPI.
+ * 仍打开着的文件和映射各自持有引用，环和 fdev 在最后一个 this_close / 映射关闭时释放.
+ */
 int	FPGA_SPI_remove(struct spi_device *spi)
 {
-	device_destroy(fpga_spi_cdev.cls, fpga_spi_cdev.devt);
-	class_destroy(fpga_spi_cdev.cls);
-	cdev_del(&fpga_spi_cdev.cdev);
-	unregister_chrdev_region(fpga_spi_cdev.devt, 1);
+	struct FPGA_SPI_dev *fdev = spi_get_drvdata(spi);
+	struct task_struct *task;
+
+	mutex_lock(&fpga_spi_devs_lock);
+	idr_remove(&fpga_spi_devs, fdev->minor);
+	mutex_unlock(&fpga_spi_devs_lock);
+
+	// 持有 spi_lock 时没有正在进行的传输，之后的SPI访问都会先看到 dead
+	mutex_lock(&fdev->spi_lock);
+	mutex_lock(&fdev->lock);
+	fdev->dead = true;
+	task = fdev->sampler;
+	fdev->sampler = NULL;
+	mutex_unlock(&fdev->lock);
+	mutex_unlock(&fdev->spi_lock);
+	// 采样线程每轮都要获取 spi_lock 和 lock，因此在解锁之后再等待其结束; dead 已置位，线程不会再发起采集
+	if (task)
+		kthread_stop(task);
+	// 唤醒阻塞在 read/poll/WAIT_FRAME 中的读者，它们看到 dead 后返回 -ENODEV
+	wake_up_interruptible_all(&fdev->wq);
+
+	debugfs_remove_recursive(fdev->debugfs_dir);
+	device_destroy(fpga_spi_cdev.cls, fdev->cdev->dev);
+	cdev_del(fdev->cdev);
+	fpga_dev_put(fdev);
 	return 0;
 }
 
@@ -117,116 +520,527 @@ struct spi_driver FPGA_SPI_drv = {
 };
 
 
+/*
+ * 主设备号、设备类和 debugfs 根目录在模块加载时创建一次，之后每探测到一块采集板占用一个次设备号
+ */
 static int FPGA_SPI_init(void)
 {
 	int ret;
+	ret = alloc_chrdev_region(&fpga_spi_cdev.devt, 0, FPGA_SPI_MAX_DEVICES, "FPGA_SPI");
+	if(ret!=0){
+		printk("alloc_chrdev_region error\n");
+		return ret;
+	}
+	fpga_spi_cdev.cls = class_create(THIS_MODULE, "FPGA_SPI");
+	if(IS_ERR(fpga_spi_cdev.cls)){
+		printk("class_create error\n");
+		ret = PTR_ERR(fpga_spi_cdev.cls);
+		goto error_class_create;
+	}
+	fpga_spi_cdev.debugfs_root = debugfs_create_dir("fpga_spi", NULL);
 	ret = spi_register_driver(&FPGA_SPI_drv);
+	if(ret!=0)
+		goto error_register;
+	return 0;
+	error_register:
+		debugfs_remove_recursive(fpga_spi_cdev.debugfs_root);
+		class_destroy(fpga_spi_cdev.cls);
+	error_class_create:
+		unregister_chrdev_region(fpga_spi_cdev.devt, FPGA_SPI_MAX_DEVICES);
 	return ret;
 }
 
 static void FPGA_SPI_exit(void)
 {
 	spi_unregister_driver(&FPGA_SPI_drv);
+	debugfs_remove_recursive(fpga_spi_cdev.debugfs_root);
+	class_destroy(fpga_spi_cdev.cls);
+	unregister_chrdev_region(fpga_spi_cdev.devt, FPGA_SPI_MAX_DEVICES);
+	idr_destroy(&fpga_spi_devs);
 }
 
 module_init(FPGA_SPI_init);
 module_exit(FPGA_SPI_exit);
 MODULE_LICENSE("GPL");
 
-bool FPGA_ADC_set(void)
+static inline void fpga_lat_record(u32 *hist, u64 ns)
+{
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+	unsigned int bucket = us ? fls64(us) : 0;
+
+	if (bucket >= FPGA_LAT_BUCKETS)
+		bucket = FPGA_LAT_BUCKETS - 1;
+	hist[bucket]++;
+}
+
+/*
+ * 记录一次采集失败: 累加对应计数并触发跟踪点(替代原先逐帧打印到内核日志).
+ * 在 lock 下累加，调用者持有 spi_lock、不得持有 lock
+ */
+static void fpga_record_error(struct FPGA_SPI_dev *fdev, enum fpga_frame_check kind, int err, const u8 *bytes)
+{
+	struct FPGA_SPI_stats *st = &fdev->stats;
+
+	mutex_lock(&fdev->lock);
+	switch (kind) {
+	case FPGA_FRAME_BAD_START: st->start_errors++; break;
+	case FPGA_FRAME_BAD_SEP1:  st->sep1_errors++;  break;
+	case FPGA_FRAME_BAD_SEP2:  st->sep2_errors++;  break;
+	case FPGA_FRAME_BAD_END:   st->end_errors++;   break;
+	case FPGA_FRAME_BAD_ACK:   st->ack_errors++;   break;
+	case FPGA_FRAME_SPI_ERROR: st->spi_errors++;   break;
+	default: break;
+	}
+	mutex_unlock(&fdev->lock);
+	trace_fpga_spi_error(kind, err, bytes ? bytes[0] : 0, bytes ? bytes[1] : 0);
+}
+
+/*
+ * 发送采样指令并校验应答. 返回 0 成功，-EPROTO 应答错误，其他为 spi_sync 错误
+ */
+int FPGA_ADC_set(struct FPGA_SPI_dev *fdev)
 {
 	int ret = 0;
-	char set_buf[2] = {DEVICE_IP, DEVICE_Set};
-	char end_buf[2];
+	u8 *end_buf = fdev->cmd_buf + CMD_ACK_OFFSET;
 	// 发送设备识别码并接收数据
-    ret = spi_write_then_read(FPGA_SPI, set_buf, 2, end_buf, 2);
-    if (ret != 0) {
-        printk("Failed to perform write then read operation\n");
-        return false;
-    }
+	spi_message_init(&fdev->set_msg);
+	spi_message_add_tail(&fdev->set_xfers[0], &fdev->set_msg);
+	spi_message_add_tail(&fdev->set_xfers[1], &fdev->set_msg);
+	ret = spi_sync(fdev->spi, &fdev->set_msg);
+	if (ret != 0) {
+		fpga_record_error(fdev, FPGA_FRAME_SPI_ERROR, ret, NULL);
+		return ret;
+	}
 
 	// 校验结束校验码
-    if ((uint8_t)end_buf[0] != END_ID_H || (uint8_t)end_buf[1] != END_ID_L) {
-        printk("End check code error\n");
-        return false;
-    }
+	if (end_buf[0] != END_ID_H || end_buf[1] != END_ID_L) {
+		fpga_record_error(fdev, FPGA_FRAME_BAD_ACK, -EPROTO, end_buf);
+		return -EPROTO;
+	}
 
-	return true;
+	return 0;
 }
 
-ssize_t this_read(struct file *file, char __user *ubuf, size_t size, loff_t *lofft)
+static inline u32 fpga_frame_raw_size(void)
+{
+	return pipelined ? FPGA_FRAME_PP_RAW_SIZE : FPGA_FRAME_RAW_SIZE;
+}
+
+/*
+ * 组装读取消息: 2 字节读取指令 + 接收段. 设置了 chunk_size 时把整帧切成多段传输，
+ * 各段位于同一条消息内，片选在整条消息期间保持有效，FPGA 看到的仍是一次连续读取
+ */
+static void fpga_build_get_message(struct FPGA_SPI_dev *fdev, u8 *rx_buf)
+{
+	u32 len = fpga_frame_raw_size();
+	u32 chunk = fdev->chunk_size ? fdev->chunk_size : len;
+	u32 off = 0;
+	struct spi_transfer *t = &fdev->get_xfers[1];
+
+	spi_message_init(&fdev->get_msg);
+	spi_message_add_tail(&fdev->get_xfers[0], &fdev->get_msg);
+	for (off = 0; off < len; off += chunk, t++) {
+		memset(t, 0, sizeof(*t));
+		t->rx_buf = rx_buf + off;
+		t->len = min(chunk, len - off);
+		spi_message_add_tail(t, &fdev->get_msg);
+	}
+}
+
+/*
+ * 查询FPGA最近写满的一帧的帧计数(流水模式)，只传输 6 字节，用于判断是否有新帧可读
+ */
+static int fpga_read_counter(struct FPGA_SPI_dev *fdev, u32 *cnt)
 {
 	int ret = 0;
-	char id_buf[2] = {DEVICE_IP, DEVICE_Get};
-    char *re_buf = kmalloc(2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE + 2, GFP_KERNEL);
-    if (!re_buf) {
-        printk("Failed to allocate memory for re_buf\n");
-        return -ENOMEM;
-    }
+	spi_message_init(&fdev->cnt_msg);
+	spi_message_add_tail(&fdev->cnt_xfers[0], &fdev->cnt_msg);
+	spi_message_add_tail(&fdev->cnt_xfers[1], &fdev->cnt_msg);
+	ret = spi_sync(fdev->spi, &fdev->cnt_msg);
+	if (ret != 0)
+		return ret;
+	*cnt = get_unaligned_be32(fdev->cmd_buf + CMD_CNT_RX);
+	return 0;
+}
 
-	if(FPGA_ADC_set()){
-		printk("FPGA_ADC_set Successfully\n");
-	}else{
-		printk("FPGA_ADC_set error\n");
-		kfree(re_buf);
-		return -1;
-	}
-    // 发送设备识别码并接收数据
-    ret = spi_write_then_read(FPGA_SPI, id_buf, 2, re_buf, 2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE + 2);
-    if (ret != 0) {
-        printk("Failed to perform write then read operation\n");
-        kfree(re_buf);
-        return ret;
-    }
+/*
+ * 校验一帧的各校验码. start 指向 START_ID，payload 指向 X 轴数据.
+ * 出错时 *bad 指向校验失败处收到的两个字节
+ */
+static enum fpga_frame_check fpga_check_frame(const u8 *start, const u8 *payload, const u8 **bad)
+{
+	const u8 *sep1 = payload + ADC_DATA_SIZE;
+	const u8 *sep2 = sep1 + 2 + ADC_DATA_SIZE;
+	const u8 *end = sep2 + 2 + ADC_DATA_SIZE;
 
-	printk("%x,%x\n",(uint8_t)re_buf[0],(uint8_t)re_buf[1]);
-	printk("%x,%x\n",(uint8_t)re_buf[2+ADC_DATA_SIZE],(uint8_t)re_buf[2+ADC_DATA_SIZE+1]);
-	printk("%x,%x\n",(uint8_t)re_buf[2+ADC_DATA_SIZE+2+ADC_DATA_SIZE],(uint8_t)re_buf[2+ADC_DATA_SIZE+2+ADC_DATA_SIZE+1]);
-	printk("%x,%x\n",(uint8_t)re_buf[2+ADC_DATA_SIZE+2+ADC_DATA_SIZE+2+ADC_DATA_SIZE],(uint8_t)re_buf[2+ADC_DATA_SIZE+2+ADC_DATA_SIZE+2+ADC_DATA_SIZE+1]);
-	
-    // 校验开始校验码
-    if ((uint8_t)re_buf[0] != START_ID_H || (uint8_t)re_buf[1] != START_ID_L) {
-        printk("Start check code error\n");
-        kfree(re_buf);
-        return -EINVAL;
-    }
+	// 校验开始校验码
+	*bad = start;
+	if (start[0] != START_ID_H || start[1] != START_ID_L)
+		return FPGA_FRAME_BAD_START;
 
-    // 校验分隔校验码1
-    if ((uint8_t)re_buf[2 + ADC_DATA_SIZE] != SPI_SEPARATOR1_H || (uint8_t)re_buf[2 + ADC_DATA_SIZE + 1] != SPI_SEPARATOR1_L) {
-        printk("Separator1 check code error\n");
-        kfree(re_buf);
-        return -EINVAL;
-    }
+	// 校验分隔校验码1
+	*bad = sep1;
+	if (sep1[0] != SPI_SEPARATOR1_H || sep1[1] != SPI_SEPARATOR1_L)
+		return FPGA_FRAME_BAD_SEP1;
 
 	// 校验分隔校验码2
-    if ((uint8_t)re_buf[2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE] != SPI_SEPARATOR2_H || (uint8_t)re_buf[2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE + 1] != SPI_SEPARATOR2_L) {
-        printk("Separator2 check code error\n");
-        kfree(re_buf);
-        return -EINVAL;
-    }
+	*bad = sep2;
+	if (sep2[0] != SPI_SEPARATOR2_H || sep2[1] != SPI_SEPARATOR2_L)
+		return FPGA_FRAME_BAD_SEP2;
 
-    // 校验结束校验码
-    if ((uint8_t)re_buf[2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE] != END_ID_H || (uint8_t)re_buf[2 + ADC_DATA_SIZE + 2 + ADC_DATA_SIZE+ 2 + ADC_DATA_SIZE + 1] != END_ID_L) {
-        printk("End check code error\n");
-        kfree(re_buf);
-        return -EINVAL;
-    }
-	
-    ret = copy_to_user(ubuf, re_buf + 2, ADC_DATA_SIZE * 3 + 2 * 2);
-    if (ret != 0) {
-        printk("Failed to copy_to_user\n");
-        kfree(re_buf);
-        return ret;
-    }
-    kfree(re_buf);
-    return ADC_DATA_SIZE * 3 + 2 * 2;
+	// 校验结束校验码
+	*bad = end;
+	if (end[0] != END_ID_H || end[1] != END_ID_L)
+		return FPGA_FRAME_BAD_END;
+
+	*bad = NULL;
+	return FPGA_FRAME_OK;
+}
+
+/*
+ * 检查采样数据位: FPGA 发送低位字节时高 6 位恒为 0，出现非零说明传输有误码
+ */
+static bool fpga_check_data_bits(const u8 *payload)
+{
+	int axis = 0;
+	int i = 0;
+	const u8 *p;
+
+	for (axis = 0; axis < 3; axis++) {
+		p = payload + axis * (ADC_DATA_SIZE + 2);
+		for (i = 1; i < ADC_DATA_SIZE; i += 2) {
+			if (p[i] & 0xfc)
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * 采集一帧并直接接收到环中下一个空槽，校验通过后发布(head + 1)
+ * 流水模式下先查询帧计数，FPGA 尚未写满新帧时返回 -EAGAIN; 帧计数跳变时累计丢帧数.
+ * 调用者必须持有 fdev->spi_lock，不得持有 fdev->lock: 传输直接写入 head 所在的槽，该槽在发布前不会被读者访问，
+ * 只有发布 head 和更新统计时获取 lock. head、seq、fpga_cnt 只由采样线程修改(open 在采样线程启动前重置)
+ */
+static int fpga_capture_frame(struct FPGA_SPI_dev *fdev)
+{
+	int ret = 0;
+	struct fpga_ring_ctrl *ctrl = fdev->ctrl;
+	u32 head = ctrl->head;
+	u32 tail = smp_load_acquire(&ctrl->tail);
+	struct fpga_frame_hdr *hdr;
+	u8 *re_buf;
+	u8 *payload;
+	const u8 *bad;
+	enum fpga_frame_check check;
+	u32 cnt = 0;
+	u32 lost = 0;
+	u64 t0, t1, t2;
+
+	// 环满: 不覆盖用户尚未消费的槽，丢弃本帧
+	if (head - tail >= RING_SLOT_COUNT) {
+		mutex_lock(&fdev->lock);
+		ctrl->overruns++;
+		mutex_unlock(&fdev->lock);
+		return -ENOSPC;
+	}
+	hdr = (struct fpga_frame_hdr *)ring_slot(fdev, head);
+	re_buf = (u8 *)hdr + fpga_frame_offset();
+	payload = (u8 *)hdr + fpga_payload_offset();
+
+	t0 = ktime_get_ns();
+	if (pipelined) {
+		ret = fpga_read_counter(fdev, &cnt);
+		if (ret != 0) {
+			fpga_record_error(fdev, FPGA_FRAME_SPI_ERROR, ret, NULL);
+			return ret;
+		}
+		if (fdev->fpga_cnt_valid && cnt == fdev->fpga_cnt) {
+			mutex_lock(&fdev->lock);
+			fdev->stats.idle_polls++;
+			mutex_unlock(&fdev->lock);
+			return -EAGAIN;
+		}
+	} else {
+		ret = FPGA_ADC_set(fdev);
+		if (ret != 0)
+			return ret;
+	}
+	t1 = ktime_get_ns();
+
+	// 发送设备识别码并接收数据，接收缓冲区即环中的槽
+	fpga_build_get_message(fdev, re_buf);
+	ret = spi_sync(fdev->spi, &fdev->get_msg);
+	if (ret != 0) {
+		fpga_record_error(fdev, FPGA_FRAME_SPI_ERROR, ret, NULL);
+		return ret;
+	}
+	t2 = ktime_get_ns();
+
+	check = fpga_check_frame(re_buf, payload, &bad);
+	if (check != FPGA_FRAME_OK) {
+		fpga_record_error(fdev, check, -EINVAL, bad);
+		return -EINVAL;
+	}
+
+	if (pipelined) {
+		// 查询之后到读取之前可能又写满了一帧，以帧内携带的计数为准
+		cnt = get_unaligned_be32(re_buf + 2);
+		if (fdev->fpga_cnt_valid) {
+			if (cnt == fdev->fpga_cnt)
+				return -EAGAIN;
+			lost = cnt - fdev->fpga_cnt - 1;
+		}
+		fdev->fpga_cnt = cnt;
+		fdev->fpga_cnt_valid = true;
+		hdr->seq = cnt;
+	} else {
+		hdr->seq = fdev->seq++;
+	}
+	hdr->status = 0;
+	hdr->timestamp_ns = t2;
+	hdr->lost = lost;
+	// 帧数据与帧头写完后再发布 head，用户看到新 head 时数据一定完整
+	mutex_lock(&fdev->lock);
+	fpga_lat_record(fdev->stats.cmd_lat_hist, t1 - t0);
+	fpga_lat_record(fdev->stats.xfer_lat_hist, t2 - t1);
+	ctrl->fpga_lost += lost;
+	smp_store_release(&ctrl->head, head + 1);
+	fdev->stats.frames_ok++;
+	mutex_unlock(&fdev->lock);
+	trace_fpga_spi_frame(hdr->seq, lost, t1 - t0, t2 - t1);
+	return 0;
+}
+
+/*
+ * 修改SPI时钟，失败时恢复原值. 调用者必须持有 fdev->spi_lock
+ */
+static int fpga_set_speed(struct FPGA_SPI_dev *fdev, u32 speed_hz)
+{
+	int ret = 0;
+	u32 old = fdev->spi->max_speed_hz;
+	u32 limit = fdev->spi->controller->max_speed_hz;
+
+	if (speed_hz < FPGA_SPI_SPEED_MIN || (limit && speed_hz > limit))
+		return -EINVAL;
+	fdev->spi->max_speed_hz = speed_hz;
+	ret = spi_setup(fdev->spi);
+	if (ret < 0) {
+		fdev->spi->max_speed_hz = old;
+		spi_setup(fdev->spi);
+		return ret;
+	}
+	return 0;
+}
+
+/*
+ * 下发FPGA分频系数(DEVICE_Div + 4字节小端)，并按新的采样率更新帧周期.
+ * 采样率 = 10MHz / (2 * div)，一帧 1024 点. 调用者必须持有 fdev->spi_lock
+ */
+static int fpga_set_div(struct FPGA_SPI_dev *fdev, u32 div)
+{
+	int ret = 0;
+	u8 *tx = fdev->cmd_buf + CMD_DIV_OFFSET;
+
+	if (div == 0)
+		return -EINVAL;
+	tx[0] = DEVICE_IP;
+	tx[1] = DEVICE_Div;
+	put_unaligned_le32(div, tx + 2);
+	ret = spi_write(fdev->spi, tx, 6);
+	if (ret != 0)
+		return ret;
+	fdev->div = div;
+	fdev->period_us = (u32)div_u64((u64)div * 2 * (FPGA_ADC_DATA_SIZE / 2) * USEC_PER_SEC, 10000000);
+	return 0;
+}
+
+/*
+ * 吞吐/误码自检: 以当前SPI时钟和分段大小连续读取 frames 帧(不等待新帧)，统计耗时、校验码错误和数据位错误.
+ * 测试期间持有 spi_lock，采样线程暂停(读者和 poll 不受影响)，期间FPGA写满的帧会以帧计数跳变的形式体现为丢帧.
+ */
+static int fpga_selftest(struct FPGA_SPI_dev *fdev, struct fpga_selftest *st)
+{
+	int ret = 0;
+	u32 i = 0;
+	u32 len = fpga_frame_raw_size();
+	u32 payload_off = pipelined ? FPGA_FRAME_CNT_SIZE + FPGA_FRAME_PAYLOAD_OFFSET : FPGA_FRAME_PAYLOAD_OFFSET;
+	u64 start_ns;
+	const u8 *bad;
+	u8 *buf;
+
+	if (st->frames == 0 || st->frames > FPGA_SELFTEST_MAX_FRAMES)
+		return -EINVAL;
+	buf = kmalloc(len, GFP_KERNEL);
+	if (!buf) {
+		fdev->stats.enomem_errors++;
+		return -ENOMEM;
+	}
+
+	st->speed_hz = fdev->spi->max_speed_hz;
+	st->chunk_size = fdev->chunk_size;
+	start_ns = ktime_get_ns();
+	for (i = 0; i < st->frames; i++) {
+		memset(buf, 0, len);
+		fpga_build_get_message(fdev, buf);
+		ret = spi_sync(fdev->spi, &fdev->get_msg);
+		if (ret != 0) {
+			st->spi_errors++;
+			continue;
+		}
+		st->bytes += len + 2;
+		if (fpga_check_frame(buf, buf + payload_off, &bad) != FPGA_FRAME_OK)
+			st->framing_errors++;
+		else if (!fpga_check_data_bits(buf + payload_off))
+			st->data_errors++;
+		else
+			st->ok_frames++;
+	}
+	st->elapsed_ns = ktime_get_ns() - start_ns;
+	if (st->elapsed_ns)
+		st->bytes_per_sec = div64_u64(st->bytes * NSEC_PER_SEC, st->elapsed_ns);
+	kfree(buf);
+	return 0;
+}
+
+static inline bool fpga_ring_empty(struct FPGA_SPI_dev *fdev)
+{
+	return smp_load_acquire(&fdev->ctrl->head) == fdev->ctrl->tail;
+}
+
+/*
+ * 采样线程: 连续触发采样、读取并发布到环中，每帧之后休眠一个帧周期等待FPGA缓冲区重新填满.
+ * 流水模式下FPGA自行连续采样，本线程在预计下一帧写满前醒来，以短间隔查询帧计数，读到新帧即发布.
+ */
+static int fpga_sampler_fn(void *data)
+{
+	struct FPGA_SPI_dev *fdev = data;
+	u32 period_us = 0;
+	int ret = 0;
+
+	while (!kthread_should_stop()) {
+		mutex_lock(&fdev->spi_lock);
+		// remove 置位 dead 后SPI设备可能已解绑，只等待 kthread_stop
+		ret = fdev->dead ? -ENODEV : fpga_capture_frame(fdev);
+		mutex_unlock(&fdev->spi_lock);
+		if (ret == 0)
+			wake_up_interruptible(&fdev->wq);
+		// 错误已计入 stats，这里不再打印
+		period_us = READ_ONCE(fdev->period_us);
+		if (ret == -EAGAIN)
+			usleep_range(period_us / 32, period_us / 16);
+		else if (pipelined)
+			usleep_range(period_us * 3 / 4, period_us * 13 / 16);
+		else
+			usleep_range(period_us, period_us + period_us / 16);
+	}
+	return 0;
+}
+
+/*
+ * 等待环中出现未消费的帧. O_NONBLOCK 时立即返回 -EAGAIN，设备已解除绑定时返回 -ENODEV
+ */
+static int fpga_wait_frame(struct FPGA_SPI_dev *fdev, struct file *file)
+{
+	int ret;
+
+	if (READ_ONCE(fdev->dead))
+		return -ENODEV;
+	if (!fpga_ring_empty(fdev))
+		return 0;
+	if (file->f_flags & O_NONBLOCK)
+		return -EAGAIN;
+	ret = wait_event_interruptible(fdev->wq, !fpga_ring_empty(fdev) || READ_ONCE(fdev->dead));
+	if (ret == 0 && READ_ONCE(fdev->dead))
+		return -ENODEV;
+	return ret;
+}
+
+/*
+ * read(): 阻塞直到采样线程发布了新帧，把最早的帧拷贝给用户并消费对应的槽.
+ * 默认格式每次只返回一帧有效数据(与旧版驱动一致); 通过 FPGA_SPI_IOC_SET_READ_FORMAT 选择批量格式后，
+ * 在用户缓冲区放得下的前提下一次返回环中所有已就绪的整帧，每帧前带 struct fpga_read_hdr.
+ * 使用 mmap 的程序无需调用 read().
+ */
+ssize_t this_read(struct file *file, char __user *ubuf, size_t size, loff_t *lofft)
+{
+	int ret = 0;
+	struct FPGA_SPI_file *ff = file->private_data;
+	struct FPGA_SPI_dev *fdev = ff->fdev;
+	struct fpga_ring_ctrl *ctrl = fdev->ctrl;
+	bool batch = ff->read_format == FPGA_READ_FORMAT_BATCH;
+	size_t rec_size = batch ? FPGA_BATCH_RECORD_SIZE : FPGA_FRAME_PAYLOAD_SIZE;
+	struct fpga_read_hdr rhdr;
+	struct fpga_frame_hdr *hdr;
+	char __user *dst;
+	u32 tail;
+	u32 count;
+	u32 i = 0;
+	u8 *slot;
+
+	if (size < rec_size)
+		return -EINVAL;
+
+	for (;;) {
+		ret = fpga_wait_frame(fdev, file);
+		if (ret != 0)
+			return ret;
+
+		mutex_lock(&fdev->lock);
+		if (fdev->dead) {
+			mutex_unlock(&fdev->lock);
+			return -ENODEV;
+		}
+		tail = ctrl->tail;
+		count = smp_load_acquire(&ctrl->head) - tail;
+		if (count != 0)
+			break;
+		// 等待之后、加锁之前被其他读者抢先消费: 非阻塞读者返回 -EAGAIN，阻塞读者重新等待
+		mutex_unlock(&fdev->lock);
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+	}
+	if (!batch)
+		count = 1;
+	else if (count > size / rec_size)
+		count = size / rec_size;
+
+	for (i = 0; i < count; i++) {
+		slot = ring_slot(fdev, tail + i);
+		dst = ubuf + i * rec_size;
+		if (batch) {
+			hdr = (struct fpga_frame_hdr *)slot;
+			memset(&rhdr, 0, sizeof(rhdr));
+			rhdr.seq = hdr->seq;
+			rhdr.lost = hdr->lost;
+			rhdr.timestamp_ns = hdr->timestamp_ns;
+			rhdr.payload_size = FPGA_FRAME_PAYLOAD_SIZE;
+			if (copy_to_user(dst, &rhdr, sizeof(rhdr)))
+				break;
+			dst += sizeof(rhdr);
+		}
+		if (copy_to_user(dst, slot + ctrl->payload_offset, FPGA_FRAME_PAYLOAD_SIZE))
+			break;
+		if (batch && clear_user(dst + FPGA_FRAME_PAYLOAD_SIZE, FPGA_BATCH_RECORD_SIZE - sizeof(rhdr) - FPGA_FRAME_PAYLOAD_SIZE))
+			break;
+	}
+	if (i == 0) {
+		mutex_unlock(&fdev->lock);
+		return -EFAULT;
+	}
+	// 只消费已完整拷贝的帧，拷贝失败的帧留给下一次读取
+	smp_store_release(&ctrl->tail, tail + i);
+	mutex_unlock(&fdev->lock);
+	return i * rec_size;
 }
 
 ssize_t this_write(struct file *file, const char __user *ubuf, size_t size, loff_t *lofft)
 {
     int ret = 0;
+    struct FPGA_SPI_dev *fdev = ((struct FPGA_SPI_file *)file->private_data)->fdev;
     char *wr_buf = kmalloc(size, GFP_KERNEL);
     if (!wr_buf) {
+        fdev->stats.enomem_errors++;
         printk("Failed to allocate memory for wr_buf\n");
         return -ENOMEM;
     }
@@ -235,9 +1049,11 @@ ssize_t this_write(struct file *file, const char __user *ubuf, size_t size, loff
     {
         printk("Failed to copy_from_user\n");
         kfree(wr_buf);
-        return ret;
+        return -EFAULT;
     }
-    ret = spi_write(FPGA_SPI, wr_buf, size);
+    mutex_lock(&fdev->spi_lock);
+    ret = fdev->dead ? -ENODEV : spi_write(fdev->spi, wr_buf, size);
+    mutex_unlock(&fdev->spi_lock);
     if(ret != 0)
     {
         printk("Failed to spi_write\n");
@@ -248,13 +1064,221 @@ ssize_t this_write(struct file *file, const char __user *ubuf, size_t size, loff
     return size;
 }
 
+long this_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	int ret = 0;
+	struct FPGA_SPI_dev *fdev = ((struct FPGA_SPI_file *)file->private_data)->fdev;
+	struct fpga_ring_info info;
+	struct fpga_spi_config cfg;
+	struct fpga_selftest st;
+	u32 val = 0;
+
+	// 这里的检查只是提前返回; 会访问SPI的命令在 spi_lock 下再次检查 dead
+	if (READ_ONCE(fdev->dead))
+		return -ENODEV;
+
+	switch (cmd) {
+	case FPGA_SPI_IOC_WAIT_FRAME:
+		return fpga_wait_frame(fdev, file);
+	case FPGA_SPI_IOC_RING_INFO:
+		memset(&info, 0, sizeof(info));
+		info.mmap_size = fdev->ring_bytes;
+		info.slot_count = RING_SLOT_COUNT;
+		info.slot_size = fdev->slot_size;
+		info.data_offset = fdev->data_offset;
+		info.frame_offset = fpga_frame_offset();
+		info.payload_offset = fpga_payload_offset();
+		if (copy_to_user((void __user *)arg, &info, sizeof(info)))
+			return -EFAULT;
+		return 0;
+	case FPGA_SPI_IOC_SET_SPEED:
+		if (get_user(val, (__u32 __user *)arg))
+			return -EFAULT;
+		mutex_lock(&fdev->spi_lock);
+		ret = fdev->dead ? -ENODEV : fpga_set_speed(fdev, val);
+		mutex_unlock(&fdev->spi_lock);
+		return ret;
+	case FPGA_SPI_IOC_SET_CHUNK:
+		if (get_user(val, (__u32 __user *)arg))
+			return -EFAULT;
+		if (val != 0 && val < FPGA_SPI_CHUNK_MIN)
+			return -EINVAL;
+		mutex_lock(&fdev->spi_lock);
+		fdev->chunk_size = val;
+		mutex_unlock(&fdev->spi_lock);
+		return 0;
+	case FPGA_SPI_IOC_SET_DIV:
+		if (get_user(val, (__u32 __user *)arg))
+			return -EFAULT;
+		mutex_lock(&fdev->spi_lock);
+		ret = fdev->dead ? -ENODEV : fpga_set_div(fdev, val);
+		mutex_unlock(&fdev->spi_lock);
+		return ret;
+	case FPGA_SPI_IOC_GET_CONFIG:
+		memset(&cfg, 0, sizeof(cfg));
+		mutex_lock(&fdev->spi_lock);
+		cfg.speed_hz = fdev->spi->max_speed_hz;
+		cfg.chunk_size = fdev->chunk_size;
+		cfg.div = fdev->div;
+		cfg.frame_period_us = fdev->period_us;
+		cfg.pipelined = pipelined;
+		mutex_unlock(&fdev->spi_lock);
+		if (copy_to_user((void __user *)arg, &cfg, sizeof(cfg)))
+			return -EFAULT;
+		return 0;
+	case FPGA_SPI_IOC_SET_READ_FORMAT:
+		if (get_user(val, (__u32 __user *)arg))
+			return -EFAULT;
+		if (val != FPGA_READ_FORMAT_FRAME && val != FPGA_READ_FORMAT_BATCH)
+			return -EINVAL;
+		((struct FPGA_SPI_file *)file->private_data)->read_format = val;
+		return 0;
+	case FPGA_SPI_IOC_SELF_TEST:
+		if (copy_from_user(&st, (void __user *)arg, sizeof(st)))
+			return -EFAULT;
+		val = st.frames;
+		memset(&st, 0, sizeof(st));
+		st.frames = val;
+		mutex_lock(&fdev->spi_lock);
+		ret = fdev->dead ? -ENODEV : fpga_selftest(fdev, &st);
+		mutex_unlock(&fdev->spi_lock);
+		if (ret != 0)
+			return ret;
+		if (copy_to_user((void __user *)arg, &st, sizeof(st)))
+			return -EFAULT;
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+/*
+ * 每个映射持有 fdev 的一个引用，保证解除绑定后映射到的页在 munmap 之前不被释放(fork 复制映射时调用 open)
+ */
+static void fpga_vma_open(struct vm_area_struct *vma)
+{
+	struct FPGA_SPI_dev *fdev = vma->vm_private_data;
+
+	kref_get(&fdev->kref);
+}
+
+static void fpga_vma_close(struct vm_area_struct *vma)
+{
+	fpga_dev_put(vma->vm_private_data);
+}
+
+static const struct vm_operations_struct fpga_vm_ops = {
+	.open = fpga_vma_open,
+	.close = fpga_vma_close,
+};
+
+/*
+ * mmap(): 把整个环(控制区 + 所有槽)映射到用户空间，用户读取 head、消费槽后写回 tail
+ */
+int this_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct FPGA_SPI_dev *fdev = ((struct FPGA_SPI_file *)file->private_data)->fdev;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (vma->vm_pgoff != 0 || size > fdev->ring_bytes)
+		return -EINVAL;
+	if (READ_ONCE(fdev->dead))
+		return -ENODEV;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+	ret = remap_pfn_range(vma, vma->vm_start, virt_to_phys(fdev->ring) >> PAGE_SHIFT,
+			      size, vma->vm_page_prot);
+	if (ret != 0)
+		return ret;
+	// 首次映射不调用 vm_ops->open，在这里取得引用
+	vma->vm_private_data = fdev;
+	vma->vm_ops = &fpga_vm_ops;
+	fpga_vma_open(vma);
+	return 0;
+}
+
+__poll_t this_poll(struct file *file, poll_table *wait)
+{
+	struct FPGA_SPI_dev *fdev = ((struct FPGA_SPI_file *)file->private_data)->fdev;
+
+	poll_wait(file, &fdev->wq, wait);
+	if (READ_ONCE(fdev->dead))
+		return EPOLLERR | EPOLLHUP;
+	if (!fpga_ring_empty(fdev))
+		return EPOLLIN | EPOLLRDNORM;
+	return 0;
+}
+
 int this_open(struct inode *inode, struct file *file)
 {
+	int ret = 0;
+	struct FPGA_SPI_dev *fdev;
+	struct FPGA_SPI_file *ff;
+	struct task_struct *task;
+
 	printk("open FPGA_SPI_dev called\n");
-	return 0;
+	// 按次设备号查找并取得引用; remove 已从 idr 中移除的设备打不开
+	mutex_lock(&fpga_spi_devs_lock);
+	fdev = idr_find(&fpga_spi_devs, iminor(inode));
+	if (fdev)
+		kref_get(&fdev->kref);
+	mutex_unlock(&fpga_spi_devs_lock);
+	if (!fdev)
+		return -ENODEV;
+
+	ff = kzalloc(sizeof(*ff), GFP_KERNEL);
+	if (!ff) {
+		fdev->stats.enomem_errors++;
+		fpga_dev_put(fdev);
+		return -ENOMEM;
+	}
+	ff->fdev = fdev;
+	ff->read_format = FPGA_READ_FORMAT_FRAME;
+	file->private_data = ff;
+
+	mutex_lock(&fdev->lock);
+	if (fdev->dead) {
+		ret = -ENODEV;
+		goto out;
+	}
+	if (fdev->users == 0) {
+		// 丢弃上次打开时残留的旧帧，新用户只看到打开之后采集的数据
+		fdev->ctrl->tail = fdev->ctrl->head;
+		fdev->fpga_cnt_valid = false;
+		task = kthread_run(fpga_sampler_fn, fdev, "fpga_spi_sampler%d", fdev->minor);
+		if (IS_ERR(task)) {
+			printk("Failed to start FPGA sampler thread\n");
+			ret = PTR_ERR(task);
+			goto out;
+		}
+		fdev->sampler = task;
+	}
+	fdev->users++;
+out:
+	mutex_unlock(&fdev->lock);
+	if (ret != 0) {
+		kfree(ff);
+		file->private_data = NULL;
+		fpga_dev_put(fdev);
+	}
+	return ret;
 }
 int this_close(struct inode *inode, struct file *file)
 {
+	struct FPGA_SPI_dev *fdev = ((struct FPGA_SPI_file *)file->private_data)->fdev;
+	struct task_struct *task = NULL;
+
 	printk("close FPGA_SPI_dev called\n");
+	mutex_lock(&fdev->lock);
+	if (--fdev->users == 0) {
+		task = fdev->sampler;
+		fdev->sampler = NULL;
+	}
+	mutex_unlock(&fdev->lock);
+	// 采样线程发布时要获取 lock，因此在解锁之后再等待其结束; 已解除绑定时线程已由 remove 停止
+	if (task)
+		kthread_stop(task);
+	kfree(file->private_data);
+	fpga_dev_put(fdev);
 	return 0;
 }
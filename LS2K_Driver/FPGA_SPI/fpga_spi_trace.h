@@ -0,0 +1,60 @@
+/*
+ * FPGA_SPI 驱动的跟踪点，仅在编译时定义 FPGA_SPI_TRACEPOINTS 时启用:
+ *   ccflags-y += -DFPGA_SPI_TRACEPOINTS -I$(src)
+ * 启用后可通过 /sys/kernel/debug/tracing/events/fpga_spi/ 逐帧跟踪采集时序和校验错误.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM fpga_spi
+
+#if !defined(_FPGA_SPI_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _FPGA_SPI_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// 每发布一帧触发一次
+TRACE_EVENT(fpga_spi_frame,
+	TP_PROTO(u32 seq, u32 lost, u64 cmd_ns, u64 xfer_ns),
+	TP_ARGS(seq, lost, cmd_ns, xfer_ns),
+	TP_STRUCT__entry(
+		__field(u32, seq)
+		__field(u32, lost)
+		__field(u64, cmd_ns)
+		__field(u64, xfer_ns)
+	),
+	TP_fast_assign(
+		__entry->seq = seq;
+		__entry->lost = lost;
+		__entry->cmd_ns = cmd_ns;
+		__entry->xfer_ns = xfer_ns;
+	),
+	TP_printk("seq=%u lost=%u cmd_ns=%llu xfer_ns=%llu",
+		  __entry->seq, __entry->lost, __entry->cmd_ns, __entry->xfer_ns)
+);
+
+// 采集出错时触发，b0/b1 为校验失败位置实际收到的两个字节
+TRACE_EVENT(fpga_spi_error,
+	TP_PROTO(int kind, int err, u8 b0, u8 b1),
+	TP_ARGS(kind, err, b0, b1),
+	TP_STRUCT__entry(
+		__field(int, kind)
+		__field(int, err)
+		__field(u8, b0)
+		__field(u8, b1)
+	),
+	TP_fast_assign(
+		__entry->kind = kind;
+		__entry->err = err;
+		__entry->b0 = b0;
+		__entry->b1 = b1;
+	),
+	TP_printk("kind=%d err=%d bytes=%02x,%02x",
+		  __entry->kind, __entry->err, __entry->b0, __entry->b1)
+);
+
+#endif /* _FPGA_SPI_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE fpga_spi_trace
+#include <trace/define_trace.h>
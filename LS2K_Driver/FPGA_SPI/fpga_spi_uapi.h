@@ -0,0 +1,129 @@
+#ifndef FPGA_SPI_UAPI_H
+#define FPGA_SPI_UAPI_H
+
+/*
+ * FPGA_SPI 驱动与用户程序共用的接口定义(ioctl、mmap 环形缓冲区布局)
+ * 内核驱动和用户程序(test_app、Qt 服务端)包含同一份头文件，保证两端布局一致.
+ */
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define FPGA_ADC_DATA_SIZE       2048  // 单轴数据字节数(1024点 × 2字节)
+// FPGA 一次 DEVICE_Get 返回的原始帧: START(2) X(2048) SEP1(2) Y(2048) SEP2(2) Z(2048) END(2)
+#define FPGA_FRAME_RAW_SIZE      (2 + FPGA_ADC_DATA_SIZE + 2 + FPGA_ADC_DATA_SIZE + 2 + FPGA_ADC_DATA_SIZE + 2)
+// 流水读取(双缓冲)模式下的原始帧: START(2) 帧计数(4, 大端) X SEP1 Y SEP2 Z END
+#define FPGA_FRAME_CNT_SIZE      4
+#define FPGA_FRAME_PP_RAW_SIZE   (FPGA_FRAME_RAW_SIZE + FPGA_FRAME_CNT_SIZE)
+// read() 返回的有效数据: X SEP1 Y SEP2 Z，相对普通原始帧偏移 2 字节
+#define FPGA_FRAME_PAYLOAD_OFFSET 2
+#define FPGA_FRAME_PAYLOAD_SIZE  (FPGA_ADC_DATA_SIZE * 3 + 2 * 2)
+
+/*
+ * mmap 环形缓冲区布局:
+ *   [0, data_offset)          控制区 struct fpga_ring_ctrl
+ *   data_offset + i*slot_size 第 i 个槽: struct fpga_frame_hdr + (frame_offset 处) 原始帧,
+ *                             有效数据(X SEP1 Y SEP2 Z)位于槽内 payload_offset 处.
+ *                             原始帧按缓存行对齐，payload_offset 随读取模式(是否带帧计数)变化，用户程序不应假定其值
+ * head 由驱动写入，tail 由用户写入，两者都是自由递增的计数，槽号 = 计数 & (slot_count - 1).
+ * 只有通过全部校验的帧才会被发布(head 递增)，环满时驱动丢弃新帧并累加 overruns.
+ * 设备打开期间驱动自行连续采样; 用户可用 poll/epoll 或 FPGA_SPI_IOC_WAIT_FRAME 等待新帧.
+ */
+#define FPGA_RING_MAGIC   0x46524e47  // "FRNG"
+#define FPGA_RING_VERSION 3  // 3: 增加 payload_offset 与 FPGA 帧计数丢帧统计
+
+struct fpga_ring_ctrl {
+	__u32 magic;
+	__u32 version;
+	__u32 slot_count;     // 槽数量(2的幂)
+	__u32 slot_size;      // 每个槽的字节数
+	__u32 data_offset;    // 第一个槽相对映射起点的偏移
+	__u32 frame_offset;   // 原始帧在槽内的偏移
+	__u32 overruns;       // 环满丢弃的帧数
+	__u32 payload_offset; // 有效数据在槽内的偏移
+	__u32 fpga_lost;      // 流水模式下由 FPGA 帧计数跳变统计的丢帧总数
+	__u32 reserved0[7];
+	__u32 head;           // 驱动写入: 已发布帧计数(独占一个缓存行)
+	__u32 reserved1[15];
+	__u32 tail;           // 用户写入: 已消费帧计数(独占一个缓存行)
+	__u32 reserved2[15];
+};
+
+struct fpga_frame_hdr {
+	__u32 seq;            // 帧序号: 流水模式下为 FPGA 帧计数，否则为驱动内递增计数
+	__u32 status;         // 0 表示校验通过
+	__u64 timestamp_ns;   // 帧传输完成时刻(ktime_get_ns)
+	__u32 lost;           // 本帧之前丢失的帧数(FPGA 帧计数跳变)
+	__u32 reserved;
+};
+
+struct fpga_ring_info {
+	__u32 mmap_size;      // 需要映射的总字节数
+	__u32 slot_count;
+	__u32 slot_size;
+	__u32 data_offset;
+	__u32 frame_offset;
+	__u32 payload_offset;
+};
+
+/*
+ * 运行时配置(FPGA_SPI_IOC_SET_SPEED / SET_CHUNK / SET_DIV 各传一个 __u32)
+ */
+#define FPGA_SPI_SPEED_MIN   100000  // SPI时钟下限(Hz)，上限由SPI控制器决定
+#define FPGA_SPI_CHUNK_MIN   256     // 分段传输的最小段长(字节)，0 表示整帧一次传输
+
+struct fpga_spi_config {
+	__u32 speed_hz;        // 当前SPI时钟
+	__u32 chunk_size;      // 当前分段大小，0 表示不分段
+	__u32 div;             // 当前FPGA分频系数，采样率 = 10MHz / (2 * div)
+	__u32 frame_period_us; // 驱动按分频系数推算的帧周期
+	__u32 pipelined;       // 是否使用双缓冲流水读取
+};
+
+/*
+ * 吞吐/误码自检: 以当前配置连续读取 frames 帧，不等待新帧，只检验传输链路
+ */
+struct fpga_selftest {
+	__u32 frames;          // 输入: 读取帧数(1 ~ 1000)
+	__u32 speed_hz;        // 输出: 测试时的SPI时钟
+	__u32 chunk_size;      // 输出: 测试时的分段大小
+	__u32 ok_frames;       // 输出: 校验全部通过的帧数
+	__u32 framing_errors;  // 输出: 开始/分隔/结束校验码错误的帧数
+	__u32 data_errors;     // 输出: 校验码正确但数据位出现误码的帧数
+	__u32 spi_errors;      // 输出: spi_sync 失败次数
+	__u32 reserved;
+	__u64 bytes;           // 输出: 总传输字节数
+	__u64 elapsed_ns;      // 输出: 总耗时
+	__u64 bytes_per_sec;   // 输出: 有效吞吐率
+};
+
+/*
+ * read() 格式(FPGA_SPI_IOC_SET_READ_FORMAT，对每个打开的文件单独设置)
+ *   FRAME: 每次 read 返回一帧有效数据(FPGA_FRAME_PAYLOAD_SIZE 字节)，与旧版驱动一致
+ *   BATCH: 每次 read 返回尽可能多的整帧，每帧为一条 FPGA_BATCH_RECORD_SIZE 字节的记录:
+ *          struct fpga_read_hdr + 有效数据 + 填充至 8 字节对齐(填充为 0).
+ *          readv 对每个 iovec 依次读取，iovec 长度应为记录长度的整数倍，某个 iovec 未填满时 readv 即返回.
+ */
+#define FPGA_READ_FORMAT_FRAME 0
+#define FPGA_READ_FORMAT_BATCH 1
+
+struct fpga_read_hdr {
+	__u32 seq;            // 同 struct fpga_frame_hdr
+	__u32 lost;
+	__u64 timestamp_ns;
+	__u32 payload_size;   // 其后有效数据的字节数
+	__u32 reserved;
+};
+
+#define FPGA_BATCH_RECORD_SIZE   ((sizeof(struct fpga_read_hdr) + FPGA_FRAME_PAYLOAD_SIZE + 7) & ~7UL)
+
+#define FPGA_SPI_MAGIC          'F'
+#define FPGA_SPI_IOC_WAIT_FRAME _IO(FPGA_SPI_MAGIC, 0)                             // 阻塞直到环中有未消费的帧
+#define FPGA_SPI_IOC_RING_INFO  _IOR(FPGA_SPI_MAGIC, 1, struct fpga_ring_info)     // 查询环布局
+#define FPGA_SPI_IOC_SET_SPEED  _IOW(FPGA_SPI_MAGIC, 2, __u32)                     // 设置SPI时钟(Hz)
+#define FPGA_SPI_IOC_SET_CHUNK  _IOW(FPGA_SPI_MAGIC, 3, __u32)                     // 设置分段大小
+#define FPGA_SPI_IOC_SET_DIV    _IOW(FPGA_SPI_MAGIC, 4, __u32)                     // 设置FPGA分频系数
+#define FPGA_SPI_IOC_GET_CONFIG _IOR(FPGA_SPI_MAGIC, 5, struct fpga_spi_config)    // 查询当前配置
+#define FPGA_SPI_IOC_SELF_TEST  _IOWR(FPGA_SPI_MAGIC, 6, struct fpga_selftest)     // 吞吐/误码自检
+#define FPGA_SPI_IOC_SET_READ_FORMAT _IOW(FPGA_SPI_MAGIC, 7, __u32)                // 设置 read() 格式
+
+#endif /* FPGA_SPI_UAPI_H */
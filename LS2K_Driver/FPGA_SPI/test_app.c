@@ -3,26 +3,114 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include "fpga_spi_uapi.h"
 
-#define DEVICE_NAME "/dev/FPGA_SPI_dev"
+#define DEVICE_NAME "/dev/FPGA_SPI_dev0" // 默认第一块采集板，可用环境变量 FPGA_SPI_DEV 指定其他设备
 #define ADC_DATA_SIZE 2048
 #define BUFFER_SIZE (ADC_DATA_SIZE * 3 + 2 * 2)
 int x_adc[ADC_DATA_SIZE / 2];
 int y_adc[ADC_DATA_SIZE / 2];
 int z_adc[ADC_DATA_SIZE / 2];
 
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s                               read one frame and print x,y,z\n", prog);
+    fprintf(stderr, "       %s config                        show current configuration\n", prog);
+    fprintf(stderr, "       %s speed <hz> | chunk <bytes> | div <div>\n", prog);
+    fprintf(stderr, "       %s selftest [frames] [speed_hz ...]  throughput/error test, optionally sweeping speeds\n", prog);
+    fprintf(stderr, "Device: $FPGA_SPI_DEV, default %s\n", DEVICE_NAME);
+}
+
+static int show_config(int fd)
+{
+    struct fpga_spi_config cfg;
+    if (ioctl(fd, FPGA_SPI_IOC_GET_CONFIG, &cfg) == -1) {
+        perror("FPGA_SPI_IOC_GET_CONFIG");
+        return -1;
+    }
+    printf("speed_hz=%u chunk_size=%u div=%u frame_period_us=%u pipelined=%u\n",
+           cfg.speed_hz, cfg.chunk_size, cfg.div, cfg.frame_period_us, cfg.pipelined);
+    return 0;
+}
+
+static int set_u32(int fd, unsigned long request, const char *name, const char *arg)
+{
+    __u32 val = (__u32)strtoul(arg, NULL, 0);
+    if (ioctl(fd, request, &val) == -1) {
+        perror(name);
+        return -1;
+    }
+    return show_config(fd);
+}
+
+static int run_selftest(int fd, unsigned int frames)
+{
+    struct fpga_selftest st;
+    memset(&st, 0, sizeof(st));
+    st.frames = frames;
+    if (ioctl(fd, FPGA_SPI_IOC_SELF_TEST, &st) == -1) {
+        perror("FPGA_SPI_IOC_SELF_TEST");
+        return -1;
+    }
+    printf("speed_hz=%u chunk=%u frames=%u ok=%u framing_err=%u data_err=%u spi_err=%u "
+           "bytes=%llu time_ms=%.3f throughput=%.1f KB/s frame_time_us=%.1f\n",
+           st.speed_hz, st.chunk_size, st.frames, st.ok_frames, st.framing_errors,
+           st.data_errors, st.spi_errors, (unsigned long long)st.bytes,
+           st.elapsed_ns / 1e6, st.bytes_per_sec / 1024.0,
+           st.elapsed_ns / 1e3 / st.frames);
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     int fd;
     char read_buffer[BUFFER_SIZE];
     ssize_t bytes_read;
+    int ret = 0;
+    const char *dev_name = getenv("FPGA_SPI_DEV");
 
     // 打开设备文件
-    fd = open(DEVICE_NAME, O_RDWR);
+    if (!dev_name)
+        dev_name = DEVICE_NAME;
+    fd = open(dev_name, O_RDWR);
     if (fd == -1) {
         perror("Failed to open device");
         return -1;
     }
 
+    if (argc > 1) {
+        if (strcmp(argv[1], "config") == 0) {
+            ret = show_config(fd);
+        } else if (strcmp(argv[1], "speed") == 0 && argc > 2) {
+            ret = set_u32(fd, FPGA_SPI_IOC_SET_SPEED, "FPGA_SPI_IOC_SET_SPEED", argv[2]);
+        } else if (strcmp(argv[1], "chunk") == 0 && argc > 2) {
+            ret = set_u32(fd, FPGA_SPI_IOC_SET_CHUNK, "FPGA_SPI_IOC_SET_CHUNK", argv[2]);
+        } else if (strcmp(argv[1], "div") == 0 && argc > 2) {
+            ret = set_u32(fd, FPGA_SPI_IOC_SET_DIV, "FPGA_SPI_IOC_SET_DIV", argv[2]);
+        } else if (strcmp(argv[1], "selftest") == 0) {
+            unsigned int frames = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 0) : 100;
+            if (argc > 3) {
+                // 依次在每个SPI时钟下自检，便于找到最快的稳定配置
+                for (int i = 3; i < argc && ret == 0; i++) {
+                    __u32 speed = (__u32)strtoul(argv[i], NULL, 0);
+                    if (ioctl(fd, FPGA_SPI_IOC_SET_SPEED, &speed) == -1) {
+                        fprintf(stderr, "speed %u: ", speed);
+                        perror("FPGA_SPI_IOC_SET_SPEED");
+                        continue;
+                    }
+                    ret = run_selftest(fd, frames);
+                }
+            } else {
+                ret = run_selftest(fd, frames);
+            }
+        } else {
+            usage(argv[0]);
+            ret = -1;
+        }
+        close(fd);
+        return ret;
+    }
+
     // 读取数据
     bytes_read = read(fd, read_buffer, BUFFER_SIZE);
     if (bytes_read == -1) {
@@ -9,7 +9,7 @@ from tqdm import tqdm
 import torch
 from torch.utils.data import Dataset, DataLoader
 
-from pure_python_mfcc import safe_mfcc
+from pure_python_mfcc import MFCC
 
 # 设置中文显示
 plt.rcParams["font.family"] = ["SimHei", "WenQuanYi Micro Hei", "Heiti TC"]
@@ -33,6 +33,13 @@ class AccelerometerDataset(Dataset):
         self.frame_length = frame_length
         self.transform = transform
         self.label_encoder = LabelEncoder()
+        # 窗函数、滤波器组等只计算一次，供所有样本复用
+        self.mfcc = MFCC(
+            samplerate=self.sample_rate,
+            numcep=13,  # MFCC系数数量
+            nfilt=26,  # 梅尔滤波器数量
+            nfft=1024  # FFT点数
+        )
 
         # 加载数据集
         self.data, self.labels = self._load_data()
@@ -65,29 +72,17 @@ class AccelerometerDataset(Dataset):
                     print(f"警告: 文件 {csv_file} 的行数少于 {self.frame_length}，已跳过")
                     continue
 
-                # 分割数据为多个样本
-                for i in range(num_samples):
-                    #每frame_length个数据为一个样本，将一个csv文件数据分为多个样本
-                    start_idx = i * self.frame_length
-                    end_idx = start_idx + self.frame_length
-
-                    # 提取X、Y、Z轴数据并转换为numpy数组
-                    x_axis = df.iloc[start_idx:end_idx, 0].values
-                    y_axis = df.iloc[start_idx:end_idx, 1].values
-                    z_axis = df.iloc[start_idx:end_idx, 2].values
+                # 分割数据为多个样本：每frame_length个数据为一个样本，整理为 [样本数, 3轴, frame_length]
+                signals = df.values[:num_samples * self.frame_length].reshape(
+                    num_samples, self.frame_length, 3).transpose(0, 2, 1)
 
-                    # 计算每个轴的MFCC特征
-                    # x_mfcc：X 轴加速度数据的 MFCC 特征，形状为(帧数, MFCC系数)
-                    x_mfcc = self._calculate_mfcc(x_axis)
-                    y_mfcc = self._calculate_mfcc(y_axis)
-                    z_mfcc = self._calculate_mfcc(z_axis)
+                # 整个文件的所有样本、所有轴一次计算MFCC，形状为 [样本数, 3轴, 帧数, MFCC系数]
+                # 再调整为与原先 np.stack(axis=2) 相同的 [样本数, 帧数, MFCC系数, 3轴]
+                combined_mfcc = self._calculate_mfcc(signals).transpose(0, 2, 3, 1)
 
-                    # 合并三个轴的MFCC特征，由于每个MFCC特征为二维数据，因此axis=2
-                    combined_mfcc = np.stack([x_mfcc, y_mfcc, z_mfcc], axis=2)
-
-                    #将处理好的数据加到数据集中
-                    data.append(combined_mfcc)
-                    labels.append(label)
+                #将处理好的数据加到数据集中
+                data.extend(combined_mfcc)
+                labels.extend([label] * num_samples)
 
             except Exception as e:
                 print(f"处理文件 {csv_file} 时出错: {str(e)}")
@@ -107,7 +102,7 @@ class AccelerometerDataset(Dataset):
         return data, encoded_labels
 
     def _calculate_mfcc(self, signal):
-        """计算一维信号的MFCC特征"""
+        """计算信号的MFCC特征，signal 形状为 [..., 采样点数]，返回 [..., 帧数, MFCC系数]"""
         # 确保信号是正确的格式
         signal = signal.astype(np.float32)
 
@@ -120,13 +115,7 @@ class AccelerometerDataset(Dataset):
         #                  nfft=1024  # 与信号长度匹配
         #                  )
 
-        mfcc_feat = safe_mfcc(
-            signal,
-            samplerate=self.sample_rate,
-            numcep=13,  # MFCC系数数量
-            nfilt=26,  # 梅尔滤波器数量
-            nfft=1024  # FFT点数
-        )
+        mfcc_feat = self.mfcc(signal)
 
         return mfcc_feat
 
@@ -102,6 +102,90 @@ def safe_matrix_multiply(a, b):
     return np.einsum('ij,jk->ik', a, b)
 
 
+class MFCC:
+    """
+    预计算版MFCC，参数与数值结果均与 safe_mfcc 一致
+
+    窗函数、梅尔滤波器组、DCT矩阵和提升系数在构造时计算一次；
+    调用时输入 [..., samples]（如 [batch, axes, samples]），所有样本所有轴的帧
+    一次性完成 rFFT 和矩阵乘法，输出 [..., num_frames, numcep]
+    """
+
+    def __init__(self, samplerate=10000, numcep=13, nfilt=26, nfft=512, lowfreq=0, highfreq=None, preemph=0.97,
+                 ceplifter=22, appendEnergy=True):
+        self.nfft = nfft
+        self.preemph = preemph
+        self.appendEnergy = appendEnergy
+        self.frame_len = int(0.025 * samplerate)
+        self.frame_step = int(0.01 * samplerate)
+        self.window = np.hamming(self.frame_len)
+        self._indices = {}  # 信号长度 -> (帧数, 补零后长度, 分帧索引)
+
+        # 梅尔滤波器组 [nfilt, nfft//2+1]，与 safe_mfcc 中双重循环的结果相同
+        highfreq = highfreq or samplerate / 2
+        mel_points = np.linspace(hz2mel(lowfreq), hz2mel(highfreq), nfilt + 2)
+        bin = np.floor((nfft + 1) * mel2hz(mel_points) / samplerate).astype(np.int32)
+        left, center, right = bin[:-2, None], bin[1:-1, None], bin[2:, None]
+        i = np.arange(nfft // 2 + 1)
+        with np.errstate(divide="ignore", invalid="ignore"):
+            rising = (i - left) / (center - left)
+            falling = (right - i) / (right - center)
+        self.fbank = np.where((i >= left) & (i < center), rising, np.where((i >= center) & (i < right), falling, 0.0))
+
+        # DCT矩阵 [numcep, nfilt]
+        n = np.arange(nfilt)
+        self.dctm = np.cos(np.arange(1, numcep + 1)[:, None] * np.pi * (n + 0.5) / nfilt)
+
+        self.lift = 1 + (ceplifter / 2) * np.sin(np.pi * np.arange(numcep) / ceplifter) if ceplifter > 0 else None
+
+    def _frame_indices(self, signal_length):
+        if signal_length not in self._indices:
+            num_frames = int(np.ceil(float(np.abs(signal_length - self.frame_len)) / self.frame_step)) + 1
+            pad_length = num_frames * self.frame_step + self.frame_len
+            indices = np.arange(self.frame_len)[None, :] + np.arange(0, num_frames * self.frame_step,
+                                                                     self.frame_step)[:, None]
+            self._indices[signal_length] = (num_frames, pad_length, indices)
+        return self._indices[signal_length]
+
+    def __call__(self, signals):
+        signals = np.asarray(signals, dtype=np.float32)
+        lead_shape, signal_length = signals.shape[:-1], signals.shape[-1]
+        num_frames, pad_length, indices = self._frame_indices(signal_length)
+
+        # 1. 预加重 + 补零
+        pad_signal = np.zeros(lead_shape + (pad_length,), dtype=np.float32)
+        if self.preemph > 0:
+            pad_signal[..., 0] = signals[..., 0]
+            pad_signal[..., 1:signal_length] = signals[..., 1:] - self.preemph * signals[..., :-1]
+        else:
+            pad_signal[..., :signal_length] = signals
+
+        # 2. 分帧加窗 [..., num_frames, frame_len]
+        frames = pad_signal[..., indices]
+        frames *= self.window
+
+        # 3. 所有帧一次 rFFT 求功率谱
+        pow_frames = (1.0 / self.nfft) * np.square(np.abs(np.fft.rfft(frames, self.nfft)))
+
+        # 4. 梅尔滤波 + 对数 + DCT，展平为二维后各做一次矩阵乘法
+        #    与 safe_mfcc 同样传入转置视图，einsum 累加顺序相同，结果逐位一致
+        pow_frames = pow_frames.reshape(-1, pow_frames.shape[-1])
+        filter_banks = safe_matrix_multiply(pow_frames, self.fbank.T)
+        filter_banks = np.where(filter_banks == 0, np.finfo(float).eps, filter_banks)
+        filter_banks = 20 * safe_log10(filter_banks)
+        mfcc = safe_matrix_multiply(filter_banks, self.dctm.T)
+
+        if self.lift is not None:
+            mfcc *= self.lift
+
+        if self.appendEnergy:
+            energy = np.sum(pow_frames, -1)
+            energy = np.where(energy == 0, np.finfo(float).eps, energy)
+            mfcc[:, 0] = np.log(energy)
+
+        return mfcc.reshape(lead_shape + (num_frames, mfcc.shape[-1]))
+
+
 # 使用示例
 if __name__ == "__main__":
     sample_rate = 10000
@@ -0,0 +1,236 @@
+import os
+import sys
+import struct
+import argparse # 用于解析命令行参数
+import subprocess
+import tempfile
+import numpy as np
+
+from pure_python_mfcc import MFCC
+from recordfile import read_record
+
+# 与 Qt_Loong/enginecheck.h 中的定义保持一致
+CHECK_MAGIC = b"LSENGCHK"
+CHECK_VERSION = 1
+CHECK_OPTION = "--engine-check"
+SECTION_FLOAT_LOGITS = 0x0001
+SECTION_INT8_LOGITS = 0x0002
+NUM_CLASSES = 13
+FRAME_LENGTH = 1024
+SAMPLE_RATE = 10000
+FEATURE_SHAPE = (3, 9, 13)  # [C, H, W]，与 data_pretreater.py 一致
+# MFCC 允许误差: |C++ - numpy| <= MFCC_ATOL + MFCC_RTOL * |numpy|
+# C++ 以 float 计算(numpy 为 float64)，误差主要来自 20*log10 前的梅尔能量，
+# 特征幅值 1e2~1e3 时约为 1e-3 量级
+MFCC_RTOL = 1e-4
+MFCC_ATOL = 1e-2
+# logits 允许误差(同一份特征输入): C++ 把 BatchNorm 并入卷积，累加顺序与 PyTorch 不同
+LOGIT_RTOL = 1e-3
+LOGIT_ATOL = 1e-3
+# int8 logits 与 quantize_model.py 中 numpy int8 实现的允许误差(逐窗口): 两边 float 激活的微小差异
+# 偶尔使某个处在舍入边界上的激活量化到相邻的整数，该差异经后续各层放大，
+# 所以不要求每个窗口都在容差内，只要求绝大多数窗口一致(numpy 实现自身在输入扰动 1e-5 时也有约 1% 的窗口变化)
+INT8_LOGIT_RTOL = 1e-2
+INT8_LOGIT_ATOL = 2e-2
+INT8_MIN_MATCHED = 97.0
+# 端到端(各自计算特征再推理)的分类一致率下限(%)，MFCC 的微小误差只会改变两类得分几乎相同的窗口
+MIN_AGREEMENT = 99.0
+
+
+def write_test_signal(path, num_windows, seed=0):
+    """
+    生成可复现的测试数据(CSV: Time,X,Y,Z)，不依赖采集设备:
+    各轴为不同频率的正弦及其谐波、周期性冲击(模拟轴承故障)和高斯噪声，幅值与采集数据同量级(±5)
+    """
+    rng = np.random.default_rng(seed)
+    n = num_windows * FRAME_LENGTH
+    t = np.arange(n) / SAMPLE_RATE
+    impulses = np.zeros(n)
+    impulses[::97] = 1.0
+    impulses = np.convolve(impulses, np.exp(-np.arange(40) / 6.0) * np.sin(np.arange(40) * 1.3))[:n]
+    x = 1.5 * np.sin(2 * np.pi * 157 * t) + 0.4 * np.sin(2 * np.pi * 314 * t) + 0.8 * impulses
+    y = 0.5 * np.sin(2 * np.pi * 1230 * t + 0.3) + 0.3 * impulses
+    z = 0.2 * np.sin(2 * np.pi * 49 * t)
+    samples = np.stack([x, y, z], axis=1) + 0.1 * rng.standard_normal((n, 3))
+    samples = np.clip(samples, -5.0, 5.0).astype(np.float32)
+    # %.9g 可无损表示 float32，C++ 端解析后与此处的数组逐位相同
+    np.savetxt(path, np.column_stack([t, samples]), fmt=["%.4f", "%.9g", "%.9g", "%.9g"],
+               delimiter=",", header="Time,X,Y,Z", comments="")
+
+
+def load_windows(path, max_windows):
+    """读取 .rec 或 CSV 中连续、不重叠的 FRAME_LENGTH 点窗口，返回 [N, 3, FRAME_LENGTH]，与 LoongQt --engine-check 一致"""
+    if path.endswith(".rec"):
+        _, _, values = read_record(path)
+    else:
+        values = np.loadtxt(path, delimiter=",", skiprows=1, usecols=(1, 2, 3), dtype=np.float64, ndmin=2)
+    num_windows = min(len(values) // FRAME_LENGTH, max_windows)
+    values = values[:num_windows * FRAME_LENGTH].astype(np.float32)
+    return values.reshape(num_windows, FRAME_LENGTH, 3).transpose(0, 2, 1)
+
+
+def run_engine(executable, data_path, max_windows, repeat, weights=None):
+    """
+    运行 LoongQt --engine-check，返回 (标准输出, 段标志, MFCC 特征 [N, 3, 9, 13], {段标志: logits [N, 13]})
+    """
+    with tempfile.TemporaryDirectory() as tmp:
+        output = os.path.join(tmp, "engine_check.bin")
+        command = [executable, CHECK_OPTION, data_path, output, "--windows", str(max_windows), "--repeat", str(repeat)]
+        if weights:
+            command += ["--weights", weights]
+        completed = subprocess.run(command, capture_output=True, text=True)
+        if completed.returncode != 0:
+            raise RuntimeError(f"{' '.join(command)} 失败(退出码 {completed.returncode}): {completed.stderr.strip()}")
+        with open(output, "rb") as f:
+            data = f.read()
+
+    if data[:len(CHECK_MAGIC)] != CHECK_MAGIC:
+        raise ValueError("结果文件格式错误")
+    version, num_windows, sections = struct.unpack_from("<III", data, len(CHECK_MAGIC))
+    if version != CHECK_VERSION:
+        raise ValueError(f"不支持的结果文件版本 {version}")
+    pos = len(CHECK_MAGIC) + 12
+    count = num_windows * int(np.prod(FEATURE_SHAPE))
+    features = np.frombuffer(data, dtype="<f4", count=count, offset=pos).reshape((num_windows,) + FEATURE_SHAPE)
+    pos += 4 * count
+    logits = {}
+    for section in (SECTION_FLOAT_LOGITS, SECTION_INT8_LOGITS):
+        if sections & section:
+            count = num_windows * NUM_CLASSES
+            logits[section] = np.frombuffer(data, dtype="<f4", count=count, offset=pos).reshape(num_windows, NUM_CLASSES)
+            pos += 4 * count
+    return completed.stdout, sections, features, logits
+
+
+def reference_model(model_path, weights_path):
+    """
+    返回 (名称, logits 函数): 有 PyTorch 和 best_model.pth 时为 model_loader.py 中的原模型，
+    否则为 quantize_model.py 中与 C++ 逐层一致的 numpy 实现(只能检查 C++ 的实现，不能检查导出)
+    """
+    try:
+        import torch
+    except ImportError:
+        torch = None
+    if torch is not None and model_path and os.path.exists(model_path):
+        from model_loader import resnet18
+
+        model = resnet18(num_classes=NUM_CLASSES)
+        checkpoint = torch.load(model_path, map_location="cpu")
+        state_dict = checkpoint.get('model_state_dict', checkpoint)
+        model.load_state_dict({name[len("module."):] if name.startswith("module.") else name: tensor
+                               for name, tensor in state_dict.items()})
+        model.eval()
+
+        def forward(features):
+            with torch.no_grad():
+                return model(torch.from_numpy(np.ascontiguousarray(features, dtype=np.float32))).numpy()
+        return f"PyTorch ({model_path})", forward
+
+    from export_weights import read_weights
+    from quantize_model import FoldedResNet
+
+    named_arrays, eps = read_weights(weights_path)
+    model = FoldedResNet(dict(named_arrays), eps)
+    return f"numpy 参考实现 ({weights_path}，未找到 PyTorch 或模型文件)", model.forward
+
+
+def int8_reference(weights_path):
+    """quantize_model.py 中的 int8 实现，量化系数取自权重文件(<卷积名>input_scale)"""
+    from export_weights import read_weights
+    from quantize_model import FoldedResNet
+
+    named_arrays, eps = read_weights(weights_path)
+    suffix = "input_scale"
+    scales = {name[:-len(suffix)]: float(array.ravel()[0]) for name, array in named_arrays if name.endswith(suffix)}
+    model = FoldedResNet({name: array for name, array in named_arrays if not name.endswith(suffix)}, eps)
+    model.set_input_scales(scales)
+    return lambda features: model.forward(features, int8=True)
+
+
+def compare(name, actual, expected, rtol, atol):
+    """逐项比较，打印最大误差，返回是否全部在容差内"""
+    actual = actual.astype(np.float64)
+    expected = expected.astype(np.float64)
+    error = np.abs(actual - expected)
+    bad = int(np.count_nonzero(error > atol + rtol * np.abs(expected)))
+    relative = error / np.maximum(np.abs(expected), 1.0)
+    print(f"{name}: 最大绝对误差 {error.max():.3e}, 最大相对误差 {relative.max():.3e}, "
+          f"超出容差 {bad}/{error.size} {'通过' if bad == 0 else '失败'}", flush=True)
+    return bad == 0
+
+
+def compare_windows(name, actual, expected, rtol, atol, min_matched):
+    """逐窗口比较，窗口内全部 logits 在容差内即为一致，返回一致窗口的比例是否达到 min_matched(%)"""
+    actual = actual.astype(np.float64)
+    expected = expected.astype(np.float64)
+    error = np.abs(actual - expected)
+    matched = 100.0 * np.mean(np.all(error <= atol + rtol * np.abs(expected), axis=1))
+    print(f"{name}: 最大绝对误差 {error.max():.3e}, 误差中位数 {np.median(error):.3e}, "
+          f"一致窗口 {matched:.2f}% {'通过' if matched >= min_matched else '失败'}", flush=True)
+    return matched >= min_matched
+
+
+if __name__ == "__main__":
+    # 在装有 LoongQt 的开发机或目标板上运行(只需 numpy; 以 PyTorch 模型为 logits 参考时需要 torch)，返回码 0 表示一致
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="比较 C++ 推理引擎(LoongQt --engine-check)与 Python 端的 MFCC 特征和模型输出。")
+    parser.add_argument("data", type=str, nargs="?", default=None,
+                        help="Collect 模式的 .rec 或 CSV 文件; 省略时生成可复现的测试数据。")
+    parser.add_argument("--exe", type=str, default=os.path.join(script_dir, "LoongQt"),
+                        help="LoongQt 可执行文件(默认为脚本同级目录下的 LoongQt)。")
+    parser.add_argument("--weights", type=str, default=os.path.join(script_dir, "resnet_weights.bin"),
+                        help="C++ 引擎的权重文件(export_weights.py 导出); 不存在时只比较 MFCC 特征。")
+    parser.add_argument("--model", type=str, default=os.path.join(script_dir, "best_model.pth"),
+                        help="PyTorch 模型文件，logits 以该模型为参考。")
+    parser.add_argument("--export", action="store_true",
+                        help="先由 --model 重新导出 --weights(需要 PyTorch)，检查导出 -> C++ 推理的完整流程。")
+    parser.add_argument("--windows", type=int, default=200, help="最多比较的窗口数。")
+    parser.add_argument("--repeat", type=int, default=3, help="C++ 端计时时每个窗口的重复次数。")
+    args = parser.parse_args()
+
+    try:
+        if args.export:
+            from export_weights import export_checkpoint
+            export_checkpoint(args.model, args.weights)
+        weights = args.weights if os.path.exists(args.weights) else None
+        with tempfile.TemporaryDirectory() as tmp:
+            data_path = args.data
+            if data_path is None:
+                data_path = os.path.join(tmp, "engine_check.csv")
+                write_test_signal(data_path, args.windows)
+                print(f"Python: 使用生成的测试数据 ({args.windows} 个窗口)", flush=True)
+            windows = load_windows(data_path, args.windows)
+            stdout, sections, cpp_features, cpp_logits = run_engine(args.exe, data_path, args.windows, args.repeat,
+                                                                    weights)
+        print(stdout.strip(), flush=True)
+        if len(cpp_features) != len(windows):
+            raise ValueError(f"窗口数不一致: C++ {len(cpp_features)}, Python {len(windows)}")
+
+        # 与 data_pretreater.AccelerometerDataPreprocessor 的参数一致
+        mfcc = MFCC(samplerate=SAMPLE_RATE, numcep=13, nfilt=26, nfft=1024)
+        py_features = mfcc(windows).astype(np.float32)
+        ok = compare("MFCC 特征", cpp_features, py_features, MFCC_RTOL, MFCC_ATOL)
+
+        if SECTION_FLOAT_LOGITS in cpp_logits:
+            name, forward = reference_model(args.model, args.weights)
+            print(f"Python: logits 参考: {name}", flush=True)
+            # 1. 同一份(C++)特征输入，只比较网络
+            ok &= compare("logits", cpp_logits[SECTION_FLOAT_LOGITS], forward(cpp_features), LOGIT_RTOL, LOGIT_ATOL)
+            # 2. 端到端: Python 特征 -> 参考模型，与 C++ 特征 -> C++ 引擎的分类结果
+            agreement = 100.0 * np.mean(cpp_logits[SECTION_FLOAT_LOGITS].argmax(axis=1) == forward(py_features).argmax(axis=1))
+            print(f"端到端分类一致率: {agreement:.2f}% {'通过' if agreement >= MIN_AGREEMENT else '失败'}", flush=True)
+            ok &= agreement >= MIN_AGREEMENT
+            if SECTION_INT8_LOGITS in cpp_logits:
+                # 3. int8 路径: 与 numpy int8 实现比较，并统计 int8 与 float 的分类一致率(无标签时的精度损失)
+                ok &= compare_windows("int8 logits", cpp_logits[SECTION_INT8_LOGITS],
+                                      int8_reference(args.weights)(cpp_features),
+                                      INT8_LOGIT_RTOL, INT8_LOGIT_ATOL, INT8_MIN_MATCHED)
+                agreement = 100.0 * np.mean(cpp_logits[SECTION_INT8_LOGITS].argmax(axis=1)
+                                            == cpp_logits[SECTION_FLOAT_LOGITS].argmax(axis=1))
+                print(f"int8 与 float 分类一致率: {agreement:.2f}% (逐类准确率见 quantize_model.py --report)", flush=True)
+        else:
+            print(f"Python: 权重文件 {args.weights} 不存在，跳过 logits 比较", flush=True)
+    except (OSError, ValueError, RuntimeError, KeyError) as e:
+        print(f"Python Error: 一致性检查失败: {e}", file=sys.stderr, flush=True)
+        sys.exit(2)
+    sys.exit(0 if ok else 1)
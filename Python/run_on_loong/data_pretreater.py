@@ -2,7 +2,7 @@ import os
 import pandas as pd
 import numpy as np
 import torch
-from pure_python_mfcc import safe_mfcc
+from pure_python_mfcc import MFCC
 
 class AccelerometerDataPreprocessor:
     """加速度计数据MFCC特征预处理器，用于模型推理"""
@@ -19,23 +19,20 @@ class AccelerometerDataPreprocessor:
         self.sample_rate = sample_rate
         self.frame_length = frame_length
         self.transform = transform
-
-    def _calculate_mfcc(self, signal):
-        """计算一维信号的MFCC特征"""
-        # 确保信号是正确的格式
-        signal = signal.astype(np.float32)
-
-        # 计算MFCC特征
+        # 窗函数、滤波器组、DCT矩阵只在启动时计算一次
         # numcep: 特征数量，nfilt: 滤波器数量，nfft: FFT大小
-        mfcc_feat = safe_mfcc(
-            signal,
+        self.mfcc = MFCC(
             samplerate=self.sample_rate,
             numcep=13,  # MFCC系数数量
             nfilt=26,  # 梅尔滤波器数量
             nfft=1024  # FFT点数
         )
 
-        return mfcc_feat
+    def _calculate_mfcc(self, signal):
+        """计算信号的MFCC特征，signal 形状为 [..., 采样点数]，返回 [..., 帧数, MFCC系数]"""
+        # 确保信号是正确的格式
+        signal = np.asarray(signal, dtype=np.float32)
+        return self.mfcc(signal)
 
     def preprocess_file(self, csv_file_path):
         """
@@ -67,30 +64,39 @@ class AccelerometerDataPreprocessor:
             y_axis = df.iloc[:, 1].values
             z_axis = df.iloc[:, 2].values
 
-            # 计算每个轴的MFCC特征
-            x_mfcc = self._calculate_mfcc(x_axis)
-            y_mfcc = self._calculate_mfcc(y_axis)
-            z_mfcc = self._calculate_mfcc(z_axis)
+            return self.preprocess_arrays(x_axis, y_axis, z_axis)
 
-            # 合并三个轴的MFCC特征，由于每个MFCC特征为二维数据，因此axis=2
-            # x_mfcc, y_mfcc, z_mfcc 的形状是 [num_frames, num_cep]
-            # np.stack后形状是 [num_frames, num_cep, 3]
-            combined_mfcc = np.stack([x_mfcc, y_mfcc, z_mfcc], axis=2)
+        except Exception as e:
+            print(f"处理文件 {csv_file_path} 时出错: {str(e)}")
+            raise # 重新抛出异常，让调用者处理
 
-            # 转换为PyTorch张量并调整维度顺序
-            # 原始Dataset中是 .permute(2, 0, 1)，对应 [C, H, W]
-            # 这里 C=3 (轴数), H=num_frames (MFCC帧数), W=num_cep (MFCC系数数量)
-            features = torch.tensor(combined_mfcc, dtype=torch.float32).permute(2, 0, 1)
+    def preprocess_arrays(self, x_axis, y_axis, z_axis):
+        """
+        预处理一帧三轴数据(--ipc 模式下由Qt直接发送，不经过CSV文件)
 
-            # 应用数据转换（如果有）
-            if self.transform:
-                features = self.transform(features)
+        参数:
+            x_axis, y_axis, z_axis: 长度为 frame_length 的一维数组
 
-            return features
+        返回:
+            torch.Tensor: 预处理后的特征张量，形状为 [C, H, W]
+        """
+        for axis in (x_axis, y_axis, z_axis):
+            if len(axis) != self.frame_length:
+                raise ValueError(
+                    f"数据长度 ({len(axis)}) 与期望的 frame_length ({self.frame_length}) 不符。"
+                )
 
-        except Exception as e:
-            print(f"处理文件 {csv_file_path} 时出错: {str(e)}")
-            raise # 重新抛出异常，让调用者处理
+        # 三个轴一次计算MFCC特征，形状直接就是 [C, H, W]
+        # 这里 C=3 (轴数), H=num_frames (MFCC帧数), W=num_cep (MFCC系数数量)
+        # 与原始Dataset中 np.stack(axis=2) 后 .permute(2, 0, 1) 的结果相同
+        combined_mfcc = self._calculate_mfcc(np.stack([x_axis, y_axis, z_axis]))
+        features = torch.tensor(combined_mfcc, dtype=torch.float32)
+
+        # 应用数据转换（如果有）
+        if self.transform:
+            features = self.transform(features)
+
+        return features
 
 
 # --- 使用示例 ---
@@ -0,0 +1,99 @@
+import os
+import sys
+import struct
+import argparse # 用于解析命令行参数
+import numpy as np
+
+# 与 Qt_Loong/resnetengine.h 中的定义保持一致
+WEIGHTS_MAGIC = b"LSRESNET"
+WEIGHTS_VERSION = 1
+BN_EPS = 1e-5  # nn.BatchNorm2d 默认 eps
+
+
+def write_weights(path, named_arrays, eps=BN_EPS):
+    """
+    将 state_dict 中的浮点张量写为 ResNetEngine 可加载的平铺二进制文件(小端)
+
+    格式: magic[8] | u32 version | u32 张量个数 | f32 eps |
+          每个张量: u32 名称长度 | 名称 | u32 维数 | u32 各维大小 | f32 数据(行优先)
+
+    参数:
+        path: 输出文件路径
+        named_arrays: (名称, numpy 数组) 列表
+        eps: BatchNorm 的 eps
+    """
+    with open(path, "wb") as f:
+        f.write(WEIGHTS_MAGIC)
+        f.write(struct.pack("<IIf", WEIGHTS_VERSION, len(named_arrays), eps))
+        for name, array in named_arrays:
+            array = np.ascontiguousarray(array, dtype="<f4")
+            encoded = name.encode("utf-8")
+            f.write(struct.pack("<I", len(encoded)))
+            f.write(encoded)
+            f.write(struct.pack("<I", array.ndim))
+            f.write(struct.pack("<%dI" % array.ndim, *array.shape))
+            f.write(array.tobytes())
+
+
+def read_weights(path):
+    """读取 write_weights 写出的文件，返回 ((名称, numpy 数组) 列表, eps)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:len(WEIGHTS_MAGIC)] != WEIGHTS_MAGIC:
+        raise ValueError(f"文件 {path} 不是权重文件")
+    pos = len(WEIGHTS_MAGIC)
+    version, count, eps = struct.unpack_from("<IIf", data, pos)
+    pos += 12
+    if version != WEIGHTS_VERSION:
+        raise ValueError(f"不支持的权重文件版本 {version}")
+
+    named_arrays = []
+    for _ in range(count):
+        (name_len,) = struct.unpack_from("<I", data, pos)
+        pos += 4
+        name = data[pos:pos + name_len].decode("utf-8")
+        pos += name_len
+        (ndim,) = struct.unpack_from("<I", data, pos)
+        pos += 4
+        shape = struct.unpack_from("<%dI" % ndim, data, pos)
+        pos += 4 * ndim
+        size = int(np.prod(shape)) if ndim else 1
+        array = np.frombuffer(data, dtype="<f4", count=size, offset=pos).reshape(shape).astype(np.float32)
+        pos += 4 * size
+        named_arrays.append((name, array))
+    return named_arrays, eps
+
+
+def export_checkpoint(model_path, output_path):
+    """从 best_model.pth 导出权重，BatchNorm 的计数器(num_batches_tracked)等非浮点张量不导出"""
+    import torch
+
+    checkpoint = torch.load(model_path, map_location="cpu")
+    state_dict = checkpoint.get('model_state_dict', checkpoint)
+
+    named_arrays = []
+    for name, tensor in state_dict.items():
+        if not torch.is_floating_point(tensor):
+            continue
+        if name.startswith("module."):  # nn.DataParallel 保存的模型
+            name = name[len("module."):]
+        named_arrays.append((name, tensor.detach().cpu().numpy()))
+
+    write_weights(output_path, named_arrays)
+    print(f"Python: 已导出 {len(named_arrays)} 个张量到 '{output_path}'", flush=True)
+
+
+if __name__ == "__main__":
+    # 在开发机(有 PyTorch)上运行，生成的 resnet_weights.bin 与 LoongQt 程序一起部署
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="将 best_model.pth 导出为 C++ 推理引擎使用的权重文件。")
+    parser.add_argument("--model", type=str, default=os.path.join(script_dir, "best_model.pth"),
+                        help="模型权重文件路径(默认为脚本同级目录下的 best_model.pth)。")
+    parser.add_argument("--output", type=str, default=os.path.join(script_dir, "resnet_weights.bin"),
+                        help="输出文件路径。")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.model):
+        print(f"Python Error: 模型文件 {args.model} 不存在", file=sys.stderr, flush=True)
+        sys.exit(1)
+    export_checkpoint(args.model, args.output)
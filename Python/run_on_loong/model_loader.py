@@ -6,6 +6,10 @@ import argparse # 用于解析命令行参数
 import json     # 用于结构化输出
 import sys      # 用于刷新输出流
 import shutil   # 用于移动文件
+import socket   # --ipc 模式下与Qt通信
+import select
+import struct
+import numpy as np
 
 from data_pretreater import AccelerometerDataPreprocessor
 
@@ -116,7 +120,175 @@ def resnet18(num_classes=13):
     return ResNet(BasicBlock, [2, 2, 2], num_classes=num_classes)
 
 
-def main(watch_directory):
+# --ipc 模式的数据包格式，与 Qt_Loong/modelipc.h 保持一致(小端)
+# 包头: magic(4) | type(2) | flags(2) | sequence(4) | length(4)
+IPC_HEADER = struct.Struct("<IHHII")
+IPC_MAGIC = 0x4D50534C  # "LSPM"
+IPC_TYPE_FRAME = 0x0001   # Qt -> Python: float32 x[n], y[n], z[n]
+IPC_TYPE_RESULT = 0x0002  # Python -> Qt: 见 serve_ipc
+IPC_FLAG_CONTINUOUS = 0x0001  # Frame: 与上一帧在采集流中首尾相接
+IPC_FLAG_OVERLAPPED = 0x0002  # Result: 上一帧后半与本帧前半组成的重叠窗口
+IPC_FLAG_FEATURES = 0x0004    # Frame: Qt 需要显示 MFCC 特征，结果中附带特征
+IPC_FLAG_OVERLAP = 0x0008     # Frame: 请求与上一帧之间的 50% 重叠窗口(需同时带 IPC_FLAG_CONTINUOUS)
+IPC_STATUS_OK = 0
+IPC_STATUS_ERROR = 1
+DEFAULT_BATCH_SIZE = 8
+
+
+def recv_exact(sock, size):
+    """从套接字读取 size 字节，连接关闭时抛出 ConnectionError"""
+    buffer = bytearray(size)
+    view = memoryview(buffer)
+    received = 0
+    while received < size:
+        n = sock.recv_into(view[received:])
+        if n == 0:
+            raise ConnectionError("通信通道已被Qt端关闭")
+        received += n
+    return buffer
+
+
+def recv_packet(sock):
+    """读取一个完整的数据包，返回 (类型, flags, 序号, 数据)"""
+    magic, msg_type, flags, sequence, length = IPC_HEADER.unpack(recv_exact(sock, IPC_HEADER.size))
+    if magic != IPC_MAGIC:
+        raise ConnectionError(f"数据包头错误: {magic:#x}")
+    return msg_type, flags, sequence, recv_exact(sock, length)
+
+
+def pack_result(sequence, flags, payload):
+    return IPC_HEADER.pack(IPC_MAGIC, IPC_TYPE_RESULT, flags, sequence, len(payload)) + payload
+
+
+# torch.inference_mode (PyTorch 1.9+) 比 no_grad 更省: 不记录梯度和版本计数
+inference_mode = getattr(torch, "inference_mode", torch.no_grad)
+
+
+def predict_batch(model, features_list, device):
+    """将多个窗口的特征合并为一个批次推理，返回各窗口的概率 [N, NUM_CLASSES]"""
+    with inference_mode():
+        outputs = model(torch.stack(features_list).to(device))
+    return torch.softmax(outputs, dim=1).cpu().numpy()
+
+
+def configure_threads(num_threads):
+    """
+    设置推理线程数，num_threads <= 0 时为 CPU 核心数减一:
+    Qt 程序的采集线程为实时线程，需要保留一个核心，否则推理线程与其争抢会造成抖动
+    """
+    if num_threads <= 0:
+        num_threads = max(1, (os.cpu_count() or 1) - 1)
+    torch.set_num_threads(num_threads)
+    try:
+        torch.set_num_interop_threads(1)  # 单个小模型，不需要算子间并行
+    except RuntimeError:
+        pass  # 已有并行任务运行后不能再设置
+    return num_threads
+
+
+def optimize_model(model, device, batch_size):
+    """
+    TorchScript 跟踪并冻结模型: 冻结时 BatchNorm 折叠进卷积，参数变为常量，
+    optimize_for_inference 再做算子融合. 任何一步失败时返回原模型(eval 模式)
+    """
+    example = torch.zeros(batch_size, 3, 9, 13, device=device)
+    try:
+        with torch.no_grad():
+            scripted = torch.jit.trace(model, example)
+            scripted = torch.jit.freeze(scripted.eval())
+            if hasattr(torch.jit, "optimize_for_inference"):
+                scripted = torch.jit.optimize_for_inference(scripted)
+        return scripted
+    except Exception as e:
+        print(f"Python: TorchScript 优化失败，使用原模型: {e}", flush=True)
+        return model
+
+
+def warm_up(model, device, batch_size, rounds=3):
+    """按单窗口和整批各推理几次: TorchScript 的前几次调用会做图优化，避免首个预测的延迟尖峰"""
+    for size in sorted({1, batch_size}):
+        example = [torch.zeros(3, 9, 13)] * size
+        for _ in range(rounds):
+            predict_batch(model, example, device)
+
+
+def serve_ipc(ipc_path, model, preprocessor, device, batch_size=DEFAULT_BATCH_SIZE, overlap=False):
+    """
+    --ipc 模式: 连接Qt端的Unix域套接字，接收原始float32三轴数据帧，返回二进制结果:
+        成功: i32 status(0) | i32 类别索引 | f32 置信度(%) | f32 各类别概率(%)[13] | f32 MFCC特征[3*9*13]
+              (MFCC特征仅在数据帧带 IPC_FLAG_FEATURES 时附带)
+        失败: i32 status(1) | UTF-8 错误信息
+    阻塞等待第一帧，再取出已到达的其余帧(最多 batch_size 帧)合并为一个批次推理，
+    积压时一次追上; 结果按帧序号逐个返回.
+    overlap: 与上一帧首尾相接的帧额外拼接一个 50% 重叠窗口，结果带 IPC_FLAG_OVERLAPPED;
+             为 False 时由Qt端按帧以 IPC_FLAG_OVERLAP 请求(运行中可切换)
+    """
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    # Qt 先监听再启动本进程，重试只为应对极端的启动时序
+    for _ in range(50):
+        try:
+            sock.connect(ipc_path)
+            break
+        except (FileNotFoundError, ConnectionRefusedError):
+            time.sleep(0.1)
+    else:
+        raise ConnectionError(f"无法连接通信通道 '{ipc_path}'")
+    print(f"Python: 已连接通信通道 '{ipc_path}'，批大小 {batch_size}，重叠窗口 {'开启' if overlap else '关闭'}。",
+          flush=True)
+
+    previous = None  # 上一帧原始数据 [3, n]，用于拼接重叠窗口
+    with sock:
+        while True:
+            packets = [recv_packet(sock)]
+            while len(packets) < batch_size and select.select([sock], [], [], 0)[0]:
+                packets.append(recv_packet(sock))
+
+            # 1. 拆分窗口并预处理，单个窗口出错不影响同批次的其他窗口
+            windows = []  # (序号, 结果 flags, 数据帧 flags, 特征)
+            replies = []
+            for msg_type, flags, sequence, payload in packets:
+                if msg_type != IPC_TYPE_FRAME:
+                    continue
+                try:
+                    samples = np.frombuffer(payload, dtype="<f4")
+                    if len(samples) % 3 != 0:
+                        raise ValueError(f"数据帧长度 ({len(samples)}) 不是3的倍数")
+                    samples = samples.reshape(3, -1)
+                    if ((overlap or flags & IPC_FLAG_OVERLAP) and previous is not None and flags & IPC_FLAG_CONTINUOUS
+                            and previous.shape == samples.shape):
+                        half = samples.shape[1] // 2
+                        joined = np.concatenate([previous[:, half:], samples[:, :half]], axis=1)
+                        windows.append((sequence, IPC_FLAG_OVERLAPPED, flags,
+                                        preprocessor.preprocess_arrays(*joined)))
+                    previous = samples
+                    windows.append((sequence, 0, flags, preprocessor.preprocess_arrays(*samples)))
+                except ValueError as e:  # 来自预处理的错误
+                    previous = None
+                    print(f"Python DataError: 数据帧 {sequence} 处理失败: {e}", file=sys.stderr, flush=True)
+                    replies.append(pack_result(sequence, 0, struct.pack("<i", IPC_STATUS_ERROR) + str(e).encode("utf-8")))
+
+            # 2. 整批推理，结果按窗口逐个打包
+            if windows:
+                try:
+                    probabilities = predict_batch(model, [features for _, _, _, features in windows], device)
+                    for (sequence, flags, frame_flags, features), probs in zip(windows, probabilities):
+                        predicted_class_index = int(probs.argmax())
+                        result = struct.pack("<iif", IPC_STATUS_OK, predicted_class_index,
+                                             float(probs[predicted_class_index]) * 100)
+                        result += (probs * 100).astype("<f4").tobytes()
+                        if frame_flags & IPC_FLAG_FEATURES:  # 仅在Qt需要显示时附带MFCC特征
+                            result += features.cpu().numpy().astype("<f4").tobytes()
+                        replies.append(pack_result(sequence, flags, result))
+                except Exception as e:
+                    print(f"Python Error: 批次推理过程中发生未知错误: {e}", file=sys.stderr, flush=True)
+                    message = struct.pack("<i", IPC_STATUS_ERROR) + f"未知错误: {e}".encode("utf-8")
+                    replies.extend(pack_result(sequence, flags, message) for sequence, flags, _, _ in windows)
+
+            sock.sendall(b"".join(replies))
+
+
+def main(watch_directory, ipc_path=None, batch_size=DEFAULT_BATCH_SIZE, overlap=False,
+         jit=False, num_threads=0, display_features=True):
     # 设置设备
     device = torch.device("cuda" if torch.cuda.is_available() else "cpu")
     print(f"Python: 使用设备: {device}", flush=True)  # flush=True 很重要
@@ -145,10 +317,6 @@ def main(watch_directory):
             checkpoint = torch.load(model_path, map_location=device)
             model.load_state_dict(checkpoint['model_state_dict'])
             val_acc = checkpoint.get('val_acc', 'N/A')  # 兼容可能没有val_acc的情况
-            if isinstance(val_acc, (float, int)):
-                print(f"Python: 成功加载模型，验证准确率: {val_acc:.2f}%", flush=True)
-            else:
-                print(f"Python: 成功加载模型，验证准确率: {val_acc}", flush=True)
         except Exception as e:
             print(f"Python Error: 加载模型权重失败: {e}", file=sys.stderr, flush=True)
             return  # 无法加载模型，退出
@@ -159,106 +327,115 @@ def main(watch_directory):
     # 设置为评估模式
     model.eval()
 
+    # 线程数、TorchScript 冻结和预热完成后才报告模型就绪(Qt 以该消息判断部署成功)
+    num_threads = configure_threads(num_threads)
+    if jit:
+        model = optimize_model(model, device, batch_size)
+    warm_up(model, device, batch_size)
+    print(f"Python: 推理线程数 {num_threads}，TorchScript {'开启' if jit else '关闭'}。", flush=True)
+    if isinstance(val_acc, (float, int)):
+        print(f"Python: 成功加载模型，验证准确率: {val_acc:.2f}%", flush=True)
+    else:
+        print(f"Python: 成功加载模型，验证准确率: {val_acc}", flush=True)
+
     # 初始化数据预处理器
     preprocessor = AccelerometerDataPreprocessor()
 
+    if ipc_path:
+        try:
+            serve_ipc(ipc_path, model, preprocessor, device, batch_size, overlap)
+        except ConnectionError as e:
+            print(f"Python: {e}", flush=True)
+        except KeyboardInterrupt:
+            print("Python: 模型服务被用户中断。", flush=True)
+        finally:
+            print("Python: 模型服务正在关闭。", flush=True)
+        return
+
     # 创建一个子目录来存放已处理的文件
     processed_dir = os.path.join(watch_directory, "processed_csv")
     os.makedirs(processed_dir, exist_ok=True)
     print(f"Python: 将监视目录 '{watch_directory}' 中的CSV文件。", flush=True)
     print(f"Python: 已处理文件将移至 '{processed_dir}'。", flush=True)
 
-    processed_files = set()  # 用于快速查找已处理的文件（可选，因为我们会移动文件, 所以用不上）
-
     try:
         while True:
-            found_new_file = False
-            for filename in os.listdir(watch_directory):
-                # 有新的文件!
-                if filename.endswith(".csv") and filename not in processed_files:
-                    input_csv_path = os.path.join(watch_directory, filename)
-                    # 确保它是一个文件而不是目录（processed_csv目录也可能被列出）
-                    if not os.path.isfile(input_csv_path):
-                        continue
-
-                    found_new_file = True
-                    print(f"Python: 发现新文件: {filename}", flush=True)
-
-                    result_payload = {"file_name": filename}  # 用于JSON输出
-
-                    try:
-                        # 1.数据预处理
-                        features_tensor = preprocessor.preprocess_file(input_csv_path)
-                        # 转换为适合JSON序列化的Python列表,用于QT显示
-                        features_for_json = features_tensor.cpu().numpy().tolist()
-
-                        # 2. 准备模型输入
-                        model_input = features_tensor.unsqueeze(0).to(device)
-
-                        # 3. 模型预测
-                        with torch.no_grad():
-                            outputs = model(model_input)
-
-                        # 4. 解析预测结果
-                        probabilities = torch.softmax(outputs, dim=1)
-                        confidence, predicted_idx = torch.max(probabilities, 1)
-
-                        predicted_class_index = predicted_idx.item()
+            # 一次取出最多 batch_size 个新文件(文件名带时间戳，按名称排序即按时间先后)，合并为一个批次推理，
+            # 积压时逐批追上而不是逐个文件处理
+            new_files = sorted(
+                filename for filename in os.listdir(watch_directory)
+                # 确保它是一个文件而不是目录（processed_csv目录也可能被列出）
+                if filename.endswith(".csv") and os.path.isfile(os.path.join(watch_directory, filename))
+            )[:batch_size]
+            if not new_files:
+                # 没有新文件时，可以稍微等待一下，避免CPU空转
+                time.sleep(1)  # 轮询间隔1秒
+                continue
+
+            # 1.数据预处理，单个文件出错不影响同批次的其他文件
+            result_payloads = []  # 用于JSON输出，与 new_files 一一对应
+            batch = []            # (result_payload, features_tensor)
+            for filename in new_files:
+                print(f"Python: 发现新文件: {filename}", flush=True)
+                result_payload = {"file_name": filename}
+                result_payloads.append(result_payload)
+                try:
+                    features_tensor = preprocessor.preprocess_file(os.path.join(watch_directory, filename))
+                    batch.append((result_payload, features_tensor))
+                except ValueError as e:  # 来自预处理的错误
+                    print(f"Python DataError: 文件 '{filename}' 处理失败: {e}", file=sys.stderr, flush=True)
+                    result_payload["status"] = "error"
+                    result_payload["error_message"] = str(e)
+                except Exception as e:
+                    print(f"Python Error: 文件 '{filename}' 预处理过程中发生未知错误: {e}", file=sys.stderr,
+                          flush=True)
+                    result_payload["status"] = "error"
+                    result_payload["error_message"] = f"未知错误: {e}"
+
+            # 2. 整批模型预测，结果按文件逐个解析
+            if batch:
+                try:
+                    probabilities = predict_batch(model, [features for _, features in batch], device)
+                    for (result_payload, features_tensor), probs in zip(batch, probabilities):
+                        predicted_class_index = int(probs.argmax())
                         predicted_class_name = CLASS_NAMES[predicted_class_index]
-                        prediction_confidence = confidence.item() * 100
-
-                        # 获取所有类别的概率，并转换为Python列表
-                        all_probs_list = probabilities.squeeze().cpu().numpy().tolist()
-
-                        # 创建一个字典来存储每个类别及其对应的置信度（百分比）
-                        all_class_probabilities = {
-                            # 键值对，键为CLASS_NAME,值为概率
-                            CLASS_NAMES[i]: prob * 100
-                            for i, prob in enumerate(all_probs_list)
-                        }
+                        prediction_confidence = float(probs[predicted_class_index]) * 100
 
                         result_payload["status"] = "success"
                         result_payload["predicted_class_index"] = predicted_class_index
                         result_payload["predicted_class_name"] = predicted_class_name
                         result_payload["confidence"] = prediction_confidence
-                        result_payload["features_to_display"] = features_for_json
-                        result_payload["all_class_probabilities"] = all_class_probabilities
-
+                        # 转换为适合JSON序列化的Python列表,用于QT显示(可用 --no-features 关闭)
+                        if display_features:
+                            result_payload["features_to_display"] = features_tensor.cpu().numpy().tolist()
+                        # 键值对，键为CLASS_NAME,值为概率（百分比）
+                        result_payload["all_class_probabilities"] = {
+                            CLASS_NAMES[i]: float(prob) * 100 for i, prob in enumerate(probs)
+                        }
                         print(
-                            f"Python: 文件 '{filename}' 预测结果: {predicted_class_name} ({prediction_confidence:.2f}%)",
+                            f"Python: 文件 '{result_payload['file_name']}' 预测结果: {predicted_class_name} ({prediction_confidence:.2f}%)",
                             flush=True)
-
-                    except ValueError as e:  # 来自预处理的错误
-                        print(f"Python DataError: 文件 '{filename}' 处理失败: {e}", file=sys.stderr, flush=True)
-                        result_payload["status"] = "error"
-                        result_payload["error_message"] = str(e)
-                    except Exception as e:
-                        print(f"Python Error: 文件 '{filename}' 预测过程中发生未知错误: {e}", file=sys.stderr,
-                              flush=True)
+                except Exception as e:
+                    print(f"Python Error: 批次预测过程中发生未知错误: {e}", file=sys.stderr, flush=True)
+                    for result_payload, _ in batch:
                         result_payload["status"] = "error"
                         result_payload["error_message"] = f"未知错误: {e}"
 
-                    # 将结果作为JSON打印到stdout
-                    print(json.dumps(result_payload), flush=True)
-
-                    # 移动已处理的文件
-                    try:
-                        destination_path = os.path.join(processed_dir, filename)
-                        shutil.move(input_csv_path, destination_path)
-                        # processed_files.add(filename) # 如果不移动文件，则需要这个
-                        print(f"Python: 文件 '{filename}' 已移至 '{processed_dir}'", flush=True)
-                    except Exception as e:
-                        print(f"Python Error: 移动文件 '{filename}' 失败: {e}", file=sys.stderr, flush=True)
-                        # 即使移动失败，也尝试将其标记为已处理，避免无限循环处理同一个错误文件
-                        # 但这可能会导致文件在主目录中累积。更好的做法是记录下来。
-                        # 为了简单起见，我们这里不添加它到 processed_files，以便下次尝试移动。
-
-            if not found_new_file:
-                # 没有新文件时，可以稍微等待一下，避免CPU空转
-                time.sleep(1)  # 轮询间隔1秒
-            else:
-                # 如果处理了文件，可以立即再次检查，或者也稍作等待
-                time.sleep(0.1)  # 短暂等待
+            for result_payload in result_payloads:
+                filename = result_payload["file_name"]
+                # 将结果作为JSON打印到stdout
+                print(json.dumps(result_payload), flush=True)
+
+                # 移动已处理的文件
+                try:
+                    shutil.move(os.path.join(watch_directory, filename), os.path.join(processed_dir, filename))
+                    print(f"Python: 文件 '{filename}' 已移至 '{processed_dir}'", flush=True)
+                except Exception as e:
+                    # 移动失败的文件下次轮询会被再次处理
+                    print(f"Python Error: 移动文件 '{filename}' 失败: {e}", file=sys.stderr, flush=True)
+
+            # 处理了文件后短暂等待，积压的文件在下一轮继续成批处理
+            time.sleep(0.1)
 
     except KeyboardInterrupt:
         print("Python: 模型服务被用户中断。", flush=True)
@@ -270,16 +447,35 @@ def main(watch_directory):
 
 if __name__ == "__main__":
     # Python脚本可以独立运行，并作为后端服务响应Qt应用放置在共享目录中的数据文件。
-    parser = argparse.ArgumentParser(description="PyTorch模型推理服务，监视CSV文件目录。")
-    parser.add_argument("watch_dir", type=str, help="需要监视的包含CSV文件的目录路径。")
+    parser = argparse.ArgumentParser(description="PyTorch模型推理服务，监视CSV文件目录或通过Unix域套接字接收数据。")
+    parser.add_argument("watch_dir", type=str, nargs="?", default=None, help="需要监视的包含CSV文件的目录路径。")
+    parser.add_argument("--ipc", type=str, default=None,
+                        help="Qt端通信通道(Unix域套接字)路径，指定后不再监视目录。")
+    parser.add_argument("--batch-size", type=int, default=DEFAULT_BATCH_SIZE,
+                        help="每个批次最多合并的窗口(文件)数。")
+    parser.add_argument("--overlap", action="store_true",
+                        help="--ipc 模式下在首尾相接的两帧之间额外分析一个50%%重叠窗口。")
+    parser.add_argument("--jit", action="store_true",
+                        help="启动时用 TorchScript 跟踪并冻结模型(折叠 BatchNorm)。")
+    parser.add_argument("--threads", type=int, default=0,
+                        help="推理线程数，0 表示 CPU 核心数减一(为采集线程保留一个核心)。")
+    parser.add_argument("--no-features", action="store_true",
+                        help="目录模式下JSON结果不附带MFCC特征(--ipc 模式由Qt按帧请求)。")
 
     args = parser.parse_args()
 
+    if args.ipc:
+        main(None, args.ipc, max(1, args.batch_size), args.overlap, args.jit, args.threads)
+        sys.exit(0)
+    if args.watch_dir is None:
+        print("Python Error: 需要指定监视目录或 --ipc 通信通道。", file=sys.stderr, flush=True)
+        sys.exit(1)
     if not os.path.isdir(args.watch_dir):
         print(f"Python Error: 指定的监视目录 '{args.watch_dir}' 不存在或不是一个目录。", file=sys.stderr, flush=True)
         sys.exit(1)
     # Python脚本的 main 函数设计为一个持续运行的服务，用于监视一个指定的目录，
     # 一旦发现新的CSV文件，就加载它，用预训练的PyTorch模型进行推理，然后将结果输出，并把处理过的文件移走。
-    main(args.watch_dir)
+    main(args.watch_dir, batch_size=max(1, args.batch_size), jit=args.jit, num_threads=args.threads,
+         display_features=not args.no_features)
 
 
@@ -0,0 +1,237 @@
+import os
+import sys
+import argparse # 用于解析命令行参数
+import numpy as np
+import pandas as pd
+
+from pure_python_mfcc import MFCC
+from export_weights import read_weights, write_weights
+from recordfile import read_record
+
+# 与 model_loader.py / Qt_Loong/resnetengine.cpp 一致
+CLASS_NAMES = [
+    "0.7inner", "0.7outer", "0.9inner", "0.9outer", "1.1inner",
+    "1.1outer", "1.3inner", "1.3outer", "1.5inner", "1.5outer",
+    "1.7inner", "1.7outer", "healthy"
+]
+FRAME_LENGTH = 1024
+SAMPLE_RATE = 10000
+# 残差块: (state_dict 前缀, 输入通道, 输出通道, 步长)
+BLOCKS = [
+    ("layer1.0.", 16, 16, 1), ("layer1.1.", 16, 16, 1),
+    ("layer2.0.", 16, 32, 2), ("layer2.1.", 32, 32, 1),
+    ("layer3.0.", 32, 64, 2), ("layer3.1.", 64, 64, 1),
+]
+WEIGHT_LEVELS = 127      # int8 权重 [-127, 127]，按输出通道对称量化
+ACTIVATION_LEVELS = 255  # ReLU 输出量化为 [0, 255]
+
+
+class FoldedResNet:
+    """
+    BatchNorm 已并入卷积的 ResNet(BasicBlock, [2, 2, 2])，numpy 实现，
+    与 ResNetEngine 的 float 路径和 int8 路径逐层一致，用于标定和评估量化误差
+    """
+
+    def __init__(self, tensors, eps):
+        self.tensors = tensors
+        self.eps = np.float64(np.float32(eps))
+        self.convs = {}  # 卷积名 -> (折叠后的权重 [Cout, Cin, K, K], 偏置)
+        self._fold("conv1.", "bn1.")
+        for prefix, cin, cout, stride in BLOCKS:
+            self._fold(prefix + "conv1.", prefix + "bn1.")
+            self._fold(prefix + "conv2.", prefix + "bn2.")
+            if stride != 1 or cin != cout:
+                self._fold(prefix + "downsample.0.", prefix + "downsample.1.")
+        self.input_scales = {}  # 卷积名 -> 输入量化系数
+        self.quantized = {}     # 卷积名 -> (int 权重, 每通道 输入系数*权重系数)
+
+    def _fold(self, conv, bn):
+        t = self.tensors
+        scale = t[bn + "weight"].astype(np.float64) / np.sqrt(t[bn + "running_var"].astype(np.float64) + self.eps)
+        weight = (t[conv + "weight"].astype(np.float64) * scale[:, None, None, None]).astype(np.float32)
+        bias = (t[bn + "bias"] - t[bn + "running_mean"] * scale).astype(np.float32)
+        self.convs[conv] = (weight, bias)
+
+    def quantized_convs(self):
+        """需要量化的卷积(conv1 保持 float)"""
+        return [name for name in self.convs if name != "conv1."]
+
+    def set_input_scales(self, input_scales):
+        self.input_scales = dict(input_scales)
+        self.quantized = {}
+        for name in self.quantized_convs():
+            weight, _ = self.convs[name]
+            max_abs = np.abs(weight).reshape(weight.shape[0], -1).max(axis=1)
+            weight_scale = np.where(max_abs > 0, max_abs / np.float32(WEIGHT_LEVELS), np.float32(1.0)).astype(np.float32)
+            q = np.clip(np.rint(weight / weight_scale[:, None, None, None]), -WEIGHT_LEVELS, WEIGHT_LEVELS)
+            qscale = (np.float32(self.input_scales[name]) * weight_scale).astype(np.float32)
+            self.quantized[name] = (q.astype(np.int64), qscale)
+
+    def _conv(self, name, x, stride, int8):
+        weight, bias = self.convs[name]
+        k = weight.shape[2]
+        pad = k // 2
+        if int8:
+            qweight, qscale = self.quantized[name]
+            inv_scale = np.float32(1.0) / np.float32(self.input_scales[name])
+            x = np.rint(np.minimum(x * inv_scale, ACTIVATION_LEVELS)).astype(np.int64)
+            weight = qweight
+        n, _, h, w = x.shape
+        oh = (h + 2 * pad - k) // stride + 1
+        ow = (w + 2 * pad - k) // stride + 1
+        xp = np.pad(x, ((0, 0), (0, 0), (pad, pad), (pad, pad)))
+        out = np.zeros((n, weight.shape[0], oh, ow), dtype=np.int64 if int8 else np.float32)
+        for ky in range(k):
+            for kx in range(k):
+                patch = xp[:, :, ky:ky + stride * oh:stride, kx:kx + stride * ow:stride]
+                out += np.einsum("oi,nihw->nohw", weight[:, :, ky, kx], patch)
+        if int8:
+            out = out.astype(np.float32) * qscale[None, :, None, None]
+        return out + bias[None, :, None, None]
+
+    def forward(self, x, int8=False, record=None):
+        """
+        x: [N, 3, 9, 13] -> logits [N, 13]
+        record: 字典，传入时记录各卷积的输入激活(用于标定)
+        """
+        relu = lambda v: np.maximum(v, 0)
+
+        def conv(name, v, stride=1):
+            if record is not None:
+                record.setdefault(name, []).append(v)
+            return self._conv(name, v, stride, int8 and name != "conv1.")
+
+        h = relu(conv("conv1.", x.astype(np.float32)))
+        for prefix, cin, cout, stride in BLOCKS:
+            t = relu(conv(prefix + "conv1.", h, stride))
+            t = conv(prefix + "conv2.", t)
+            if stride != 1 or cin != cout:
+                identity = conv(prefix + "downsample.0.", h, stride)
+            else:
+                identity = h
+            h = relu(t + identity)
+        features = h.mean(axis=(2, 3))
+        return features @ self.tensors["fc.weight"].T + self.tensors["fc.bias"]
+
+
+def load_collect_windows(collect_dir, max_windows):
+    """
+    读取 Collect 模式生成的 <标签>.rec(或旧版 <标签>.csv)，每 FRAME_LENGTH 点为一个样本(与 dataset.py 一致)，
+    返回 (MFCC 特征 [N, 3, 9, 13], 类别索引 [N])，文件名不是已知类别的文件跳过
+    """
+    mfcc = MFCC(samplerate=SAMPLE_RATE, numcep=13, nfilt=26, nfft=1024)
+    features, labels = [], []
+    for filename in sorted(os.listdir(collect_dir)):
+        label, ext = os.path.splitext(filename)
+        if ext not in (".rec", ".csv"):
+            continue
+        if label not in CLASS_NAMES:
+            print(f"Python: 跳过未知标签的文件 '{filename}'", flush=True)
+            continue
+        path = os.path.join(collect_dir, filename)
+        if ext == ".rec":
+            _, _, values = read_record(path)
+        else:
+            values = pd.read_csv(path, header=0, usecols=[1, 2, 3]).values
+        num_windows = min(len(values) // FRAME_LENGTH, max_windows)
+        values = values[:num_windows * FRAME_LENGTH].astype(np.float32)
+        # 整个文件的所有窗口一次计算: [N, FRAME_LENGTH, 3] -> [N, 3, FRAME_LENGTH] -> [N, 3, 9, 13]
+        windows = values.reshape(num_windows, FRAME_LENGTH, 3).transpose(0, 2, 1)
+        features.extend(mfcc(windows))
+        labels.extend([CLASS_NAMES.index(label)] * num_windows)
+        print(f"Python: '{filename}' 读取 {num_windows} 个样本", flush=True)
+    if not features:
+        raise ValueError(f"目录 {collect_dir} 中没有可用的标定数据")
+    return np.stack(features).astype(np.float32), np.array(labels)
+
+
+def calibrate(model, features, percentile, batch_size=256):
+    """以各卷积输入激活的 percentile 分位数作为量化上限"""
+    values = {}
+    for start in range(0, len(features), batch_size):
+        record = {}
+        model.forward(features[start:start + batch_size], record=record)
+        for name, tensors in record.items():
+            values.setdefault(name, []).extend(t.ravel() for t in tensors)
+    scales = {}
+    for name in model.quantized_convs():
+        v = np.concatenate(values[name])
+        limit = np.percentile(v, percentile) if percentile < 100 else v.max()
+        scales[name] = np.float32(max(limit, 1e-6) / ACTIVATION_LEVELS)
+    return scales
+
+
+def evaluate(model, features, labels, batch_size=256):
+    """返回 float 与 int8 的逐类准确率报告"""
+    float_logits, int8_logits = [], []
+    for start in range(0, len(features), batch_size):
+        batch = features[start:start + batch_size]
+        float_logits.append(model.forward(batch))
+        int8_logits.append(model.forward(batch, int8=True))
+    float_logits = np.concatenate(float_logits)
+    int8_logits = np.concatenate(int8_logits)
+    float_pred = float_logits.argmax(axis=1)
+    int8_pred = int8_logits.argmax(axis=1)
+
+    lines = [f"{'类别':<10}{'样本数':>8}{'float准确率':>14}{'int8准确率':>14}{'差值':>10}{'一致率':>10}"]
+    for index, name in enumerate(CLASS_NAMES):
+        mask = labels == index
+        count = int(mask.sum())
+        if count == 0:
+            continue
+        float_acc = 100.0 * np.mean(float_pred[mask] == index)
+        int8_acc = 100.0 * np.mean(int8_pred[mask] == index)
+        agree = 100.0 * np.mean(float_pred[mask] == int8_pred[mask])
+        lines.append(f"{name:<10}{count:>8}{float_acc:>13.2f}%{int8_acc:>13.2f}%{int8_acc - float_acc:>+9.2f}%{agree:>9.2f}%")
+    float_acc = 100.0 * np.mean(float_pred == labels)
+    int8_acc = 100.0 * np.mean(int8_pred == labels)
+    agree = 100.0 * np.mean(float_pred == int8_pred)
+    lines.append(f"{'总计':<10}{len(labels):>8}{float_acc:>13.2f}%{int8_acc:>13.2f}%{int8_acc - float_acc:>+9.2f}%{agree:>9.2f}%")
+    lines.append(f"logits 最大绝对误差: {np.abs(float_logits - int8_logits).max():.4f}")
+    return "\n".join(lines)
+
+
+if __name__ == "__main__":
+    # 在开发机或目标板上运行(只需 numpy/pandas)，输入为 export_weights.py 导出的权重文件
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="以 Collect 模式采集的 CSV 标定 int8 量化系数并评估精度损失。")
+    parser.add_argument("collect_dir", type=str, help="Collect 模式数据目录(<标签>.rec 或 <标签>.csv)。")
+    parser.add_argument("--weights", type=str, default=os.path.join(script_dir, "resnet_weights.bin"),
+                        help="export_weights.py 导出的权重文件。")
+    parser.add_argument("--output", type=str, default=None,
+                        help="写入量化系数后的权重文件(默认覆盖 --weights)。")
+    parser.add_argument("--eval-dir", type=str, default=None,
+                        help="评估数据目录(默认与标定数据相同)。")
+    parser.add_argument("--percentile", type=float, default=99.99,
+                        help="激活量化上限取的分位数，100 表示最大值。")
+    parser.add_argument("--max-windows", type=int, default=200,
+                        help="每个文件最多使用的样本数。")
+    parser.add_argument("--report", type=str, default=None, help="精度报告输出文件。")
+    args = parser.parse_args()
+
+    try:
+        named_arrays, eps = read_weights(args.weights)
+        # 重新标定时丢弃旧的量化系数
+        named_arrays = [(name, array) for name, array in named_arrays if not name.endswith(".input_scale")]
+        model = FoldedResNet(dict(named_arrays), eps)
+
+        features, labels = load_collect_windows(args.collect_dir, args.max_windows)
+        scales = calibrate(model, features, args.percentile)
+        model.set_input_scales(scales)
+
+        if args.eval_dir:
+            features, labels = load_collect_windows(args.eval_dir, args.max_windows)
+        report = evaluate(model, features, labels)
+    except (OSError, ValueError, KeyError) as e:
+        print(f"Python Error: 量化失败: {e}", file=sys.stderr, flush=True)
+        sys.exit(1)
+
+    print(report, flush=True)
+    if args.report:
+        with open(args.report, "w", encoding="utf-8") as f:
+            f.write(report + "\n")
+
+    output = args.output or args.weights
+    named_arrays += [(name + "input_scale", np.array([scale], dtype=np.float32)) for name, scale in scales.items()]
+    write_weights(output, named_arrays, eps)
+    print(f"Python: 已写入 {len(scales)} 个量化系数到 '{output}'", flush=True)
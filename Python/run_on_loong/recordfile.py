@@ -0,0 +1,204 @@
+import os
+import sys
+import struct
+import zlib
+import argparse # 用于解析命令行参数
+import datetime
+import numpy as np
+
+# 与 Qt_Loong/recordfile.h 中的定义保持一致，数据均为小端
+FILE_MAGIC = 0x4352534C   # "LSRC"
+BLOCK_MAGIC = 0x4B4C4252  # "RBLK"
+RECORD_VERSION = 1
+FILE_HEADER_SIZE = 256
+BLOCK_HEADER_SIZE = 32
+FORMAT_RAW10 = 1     # uint16 码值，value = raw * scale + offset
+FORMAT_FLOAT32 = 2
+FORMAT_PACKED10 = 3  # 码值经 AdcCodec(Qt_Loong/adccodec.h) 无损压缩，块长可变
+NUM_AXES = 3
+CODEC_GROUP_SIZE = 128
+CODEC_LANES = 8
+
+# 文件头: magic | version | headerSize | format | axes | sampleRate | samplesPerBlock | reserved |
+#         startTimeMs | scale[3] | offset[3] | label[64] | reserved[132] | crc
+FILE_HEADER = struct.Struct("<IHHHHIIIq3f3f64s132xI")
+# 块头: magic | index | frameSequence | timeMs | count | payloadBytes | crc
+BLOCK_HEADER = struct.Struct("<IIQqHHI")
+
+
+def codec_decode(data, offset, count):
+    """
+    解码一轴 AdcCodec 码流(与 AdcCodec::decode 一致)
+
+    返回:
+        codes: uint16 数组 [count]
+        offset: 码流之后的偏移
+    """
+    codes = np.empty(count, dtype=np.uint16)
+    prev1 = prev2 = 0
+    rows = CODEC_GROUP_SIZE // CODEC_LANES
+    for start in range(0, count, CODEC_GROUP_SIZE):
+        if offset >= len(data):
+            raise ValueError("压缩数据不完整")
+        tag = data[offset]
+        order, w = tag >> 5, tag & 0x1F
+        if order > 2 or w > 16 or offset + 1 + w * 16 > len(data):
+            raise ValueError("压缩数据格式错误")
+        # 8 路交织: 第 k 个字的第 l 路位于 words[k, l]，每路 16 个值按低位在前拼接
+        words = np.frombuffer(data, dtype="<u2", count=w * CODEC_LANES, offset=offset + 1).reshape(w, CODEC_LANES)
+        offset += 1 + w * 16
+        if w:
+            bits = np.unpackbits(np.ascontiguousarray(words.T).view(np.uint8), axis=1, bitorder="little")
+            lanes = bits.reshape(CODEC_LANES, rows, w).astype(np.int64) @ (1 << np.arange(w, dtype=np.int64))
+            z = lanes.T.reshape(CODEC_GROUP_SIZE)
+        else:
+            z = np.zeros(CODEC_GROUP_SIZE, dtype=np.int64)
+        if order == 0:
+            x = z
+        else:
+            r = (z >> 1) ^ -(z & 1)
+            if order == 2:
+                r = (prev1 - prev2) + np.cumsum(r)
+            x = prev1 + np.cumsum(r)
+        x = (x & 0xFFFF).astype(np.uint16)
+        n = min(CODEC_GROUP_SIZE, count - start)
+        codes[start:start + n] = x[:n]
+        prev1, prev2 = int(x[-1]), int(x[-2])
+    return codes, offset
+
+
+def read_record(path, verify=True):
+    """
+    读取 Qt 端 RecordWriter 写出的录制文件(.rec)
+
+    返回:
+        header: dict(sample_rate, samples_per_block, format, start_time_ms, scale, offset, label)
+        blocks: dict(index, frame_sequence, time_ms, count)，每项为按块排列的 numpy 数组
+        samples: float32 数组 [总点数, 3]，各块有效点按顺序拼接; CRC 错误的块被跳过
+    """
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < FILE_HEADER_SIZE:
+        raise ValueError(f"文件 {path} 过短，不是录制文件")
+    (magic, version, header_size, fmt, axes, sample_rate, samples_per_block, _, start_time_ms,
+     sx, sy, sz, ox, oy, oz, label, crc) = FILE_HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC:
+        raise ValueError(f"文件 {path} 不是录制文件")
+    if version != RECORD_VERSION or header_size != FILE_HEADER_SIZE:
+        raise ValueError(f"文件 {path} 的版本 ({version}) 不受支持")
+    if verify and zlib.crc32(data[:FILE_HEADER_SIZE - 4]) != crc:
+        raise ValueError(f"文件 {path} 的文件头校验失败")
+    if axes != NUM_AXES or fmt not in (FORMAT_RAW10, FORMAT_FLOAT32, FORMAT_PACKED10):
+        raise ValueError(f"文件 {path} 的数据格式 ({fmt}, {axes} 轴) 不受支持")
+
+    header = {
+        "sample_rate": sample_rate,
+        "samples_per_block": samples_per_block,
+        "format": fmt,
+        "start_time_ms": start_time_ms,
+        "scale": np.array([sx, sy, sz], dtype=np.float32),
+        "offset": np.array([ox, oy, oz], dtype=np.float32),
+        "label": label.split(b"\0", 1)[0].decode("utf-8", errors="replace"),
+    }
+
+    dtype = "<f4" if fmt == FORMAT_FLOAT32 else "<u2"
+    fixed_bytes = BLOCK_HEADER_SIZE + samples_per_block * NUM_AXES * np.dtype(dtype).itemsize
+    meta = {"index": [], "frame_sequence": [], "time_ms": [], "count": []}
+    chunks = []
+    start = FILE_HEADER_SIZE
+    i = 0
+    while start + BLOCK_HEADER_SIZE <= len(data):
+        b_magic, index, frame_sequence, time_ms, count, payload_bytes, b_crc = BLOCK_HEADER.unpack_from(data, start)
+        block_bytes = BLOCK_HEADER_SIZE + payload_bytes if fmt == FORMAT_PACKED10 else fixed_bytes
+        if start + block_bytes > len(data):
+            break
+        block_start, start, i = start, start + block_bytes, i + 1
+        if b_magic != BLOCK_MAGIC or count > samples_per_block:
+            print(f"Python: 文件 {path} 第 {i - 1} 块已损坏，跳过", file=sys.stderr, flush=True)
+            if fmt == FORMAT_PACKED10:
+                break  # 块长由块头给出，块头损坏时无法定位后续块
+            continue
+        if verify:
+            crc = zlib.crc32(data[block_start:block_start + BLOCK_HEADER_SIZE - 4])
+            if zlib.crc32(data[block_start + BLOCK_HEADER_SIZE:start], crc) != b_crc:
+                print(f"Python: 文件 {path} 第 {i - 1} 块校验失败，跳过", file=sys.stderr, flush=True)
+                continue
+        if fmt == FORMAT_PACKED10:
+            # 各轴码流依次存放
+            offset = block_start + BLOCK_HEADER_SIZE
+            columns = []
+            for _ in range(NUM_AXES):
+                codes, offset = codec_decode(data[:start], offset, count)
+                columns.append(codes)
+            chunks.append(np.stack(columns, axis=1))
+        else:
+            # 各轴按列存放: [3, samples_per_block]
+            columns = np.frombuffer(data, dtype=dtype, count=NUM_AXES * samples_per_block,
+                                    offset=block_start + BLOCK_HEADER_SIZE).reshape(NUM_AXES, samples_per_block)
+            chunks.append(columns[:, :count].T)
+        for key, value in (("index", index), ("frame_sequence", frame_sequence), ("time_ms", time_ms),
+                           ("count", count)):
+            meta[key].append(value)
+
+    raw = np.concatenate(chunks) if chunks else np.zeros((0, NUM_AXES), dtype=dtype)
+    if fmt != FORMAT_FLOAT32:
+        # 与 AdcDecoder/RecordReader 相同: 先乘后加，float32 运算
+        samples = raw.astype(np.float32) * header["scale"]
+        samples += header["offset"]
+    else:
+        samples = raw.astype(np.float32)
+    blocks = {key: np.array(value) for key, value in meta.items()}
+    return header, blocks, samples
+
+
+def export_csv(path, csv_path):
+    """
+    将录制文件导出为 Collect 模式旧格式的 CSV(Time Stamp,X-axis,Y-axis,Z-axis)，
+    可直接用于 dataset.py / Trainer_For_Client 等按 usecols=[1, 2, 3] 读取的训练脚本
+    """
+    header, blocks, samples = read_record(path)
+    sample_rate = header["sample_rate"]
+    # 每点时间 = 所在块的采集时刻 + 块内偏移
+    offsets = np.concatenate([np.arange(count) for count in blocks["count"]]) if len(samples) else np.zeros(0)
+    block_times = np.repeat(blocks["time_ms"], blocks["count"]) if len(samples) else np.zeros(0)
+    times_ms = block_times + offsets * 1000.0 / sample_rate
+    with open(csv_path, "w", encoding="utf-8") as f:
+        f.write("Time Stamp,X-axis,Y-axis,Z-axis\n")
+        for t, (x, y, z) in zip(times_ms, samples):
+            stamp = datetime.datetime.fromtimestamp(t / 1000.0).strftime("%H:%M:%S.%f")[:-3]
+            f.write(f"{stamp},{x:.6f},{y:.6f},{z:.6f}\n")
+    return len(samples)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="将 Qt 端的录制文件(.rec)导出为训练脚本使用的 CSV。")
+    parser.add_argument("inputs", nargs="+", type=str, help="录制文件或包含录制文件的目录(如 Collect 目录)。")
+    parser.add_argument("--output-dir", type=str, default=None, help="CSV 输出目录(默认与录制文件相同)。")
+    parser.add_argument("--info", action="store_true", help="只打印文件头和块信息，不导出。")
+    args = parser.parse_args()
+
+    paths = []
+    for item in args.inputs:
+        if os.path.isdir(item):
+            paths += [os.path.join(item, name) for name in sorted(os.listdir(item)) if name.endswith(".rec")]
+        else:
+            paths.append(item)
+
+    failed = 0
+    for path in paths:
+        try:
+            if args.info:
+                header, blocks, samples = read_record(path)
+                lost = int(np.sum(np.diff(blocks["frame_sequence"].astype(np.int64)) - 1)) if len(samples) else 0
+                print(f"{path}: 标签 '{header['label']}', {header['sample_rate']} Hz, {len(blocks['index'])} 块, "
+                      f"{len(samples)} 点, 帧序号间隙 {lost}", flush=True)
+                continue
+            output_dir = args.output_dir or os.path.dirname(os.path.abspath(path))
+            os.makedirs(output_dir, exist_ok=True)
+            csv_path = os.path.join(output_dir, os.path.splitext(os.path.basename(path))[0] + ".csv")
+            rows = export_csv(path, csv_path)
+            print(f"Python: '{path}' -> '{csv_path}' ({rows} 行)", flush=True)
+        except (OSError, ValueError) as e:
+            failed += 1
+            print(f"Python Error: 导出 '{path}' 失败: {e}", file=sys.stderr, flush=True)
+    sys.exit(1 if failed else 0)
@@ -8,13 +8,20 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# 与板端共用的 AdcCodec(压缩三轴数据解码)和滑动平均滤波
+INCLUDEPATH += ../Qt_Loong
+
 SOURCES += \
+    ../Qt_Loong/adccodec.cpp \
+    ../Qt_Loong/movingaverage.cpp \
     main.cpp \
     mainwindows.cpp \
     qcustomplot.cpp \
     widget.cpp
 
 HEADERS += \
+    ../Qt_Loong/adccodec.h \
+    ../Qt_Loong/movingaverage.h \
     mainwindows.h \
     qcustomplot.h \
     widget.h
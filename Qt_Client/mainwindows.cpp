@@ -1,6 +1,7 @@
 #include "mainwindows.h"
 #include "ui_mainwindows.h"
 #include "qcustomplot.h"
+#include "adccodec.h"
 #include <QDataStream>
 #include <QDebug>
 #include <QDateTime>
@@ -330,8 +331,15 @@ void mainWindows::parseBuffer()
         // --- 5. 根据数据类型分发 ---
         switch (static_cast<Protocol::DataType>(dataType)) {
         case Protocol::ThreeAxisData:
+            if (m_compressedStream) {
+                m_compressedStream = false;
+                logMessage(LogLevel::Info, "服务器已切换为未压缩传输");
+            }
             parseThreeAxisData(payload);
             break;
+        case Protocol::CompressedThreeAxisData:
+            parseCompressedThreeAxisData(payload);
+            break;
         case Protocol::ModelOut:
             parseModelOutput(payload);
             break;
@@ -382,6 +390,61 @@ void mainWindows::parseThreeAxisData(const QByteArray& payload)
     updateMultiAxisPlot(xData,yData,zData);
 }
 
+/**
+ * @brief (专门解析) 解析压缩的三轴数据体，码值按各轴标定还原: value = code * scale + offset，
+ *        再按服务器的滑动平均窗口滤波(服务器在压缩前不滤波)，与 ThreeAxisData 的绘图数据一致
+ *        数据体: [点数(4B)] [滤波窗口(4B)] 之后每轴 [scale(8B)] [offset(8B)] [压缩长度(4B)] [AdcCodec 码流]
+ */
+void mainWindows::parseCompressedThreeAxisData(const QByteArray& payload)
+{
+    QDataStream payloadStream(payload);
+    payloadStream.setVersion(QDataStream::Qt_5_12);
+    payloadStream.setByteOrder(QDataStream::BigEndian);
+
+    quint32 pointCount = 0, smoothWindow = 0;
+    payloadStream >> pointCount >> smoothWindow;
+    if (pointCount == 0 || pointCount > static_cast<quint32>(payload.size()) * 16) {
+        qWarning() << "Invalid CompressedThreeAxisData point count:" << pointCount;
+        return;
+    }
+
+    QVector<double> axes[3];
+    QVector<quint16> codes(static_cast<int>(pointCount));
+    QByteArray encoded;
+    for (QVector<double>& axisData : axes) {
+        double scale, offset;
+        quint32 bytes;
+        payloadStream >> scale >> offset >> bytes;
+        if (payloadStream.status() != QDataStream::Ok || bytes > static_cast<quint32>(payload.size())) {
+            qWarning() << "Error while parsing CompressedThreeAxisData payload.";
+            return;
+        }
+        encoded.resize(static_cast<int>(bytes));
+        if (payloadStream.readRawData(encoded.data(), encoded.size()) != encoded.size()
+                || AdcCodec::decode(encoded.constData(), encoded.size(), codes.data(), codes.size()) < 0) {
+            qWarning() << "Corrupt CompressedThreeAxisData payload.";
+            return;
+        }
+        axisData.resize(codes.size());
+        for (int i = 0; i < codes.size(); ++i) {
+            axisData[i] = codes[i] * scale + offset;
+        }
+    }
+
+    if (m_compressedSmooth.windowSize() != static_cast<int>(smoothWindow)) {
+        m_compressedSmooth.setWindowSize(static_cast<int>(smoothWindow));
+    }
+    m_compressedSmooth.apply(axes[0].data(), axes[1].data(), axes[2].data(), axes[0].size());
+    if (!m_compressedStream) {
+        m_compressedStream = true;
+        logMessage(LogLevel::Info, QString("服务器已切换为压缩传输，客户端解码后按窗口 %1 滑动平均").arg(m_compressedSmooth.windowSize()));
+    }
+
+    qDebug() << "Successfully parsed CompressedThreeAxisData with" << pointCount << "points ("
+             << payload.size() << "bytes).";
+    updateMultiAxisPlot(axes[0], axes[1], axes[2]);
+}
+
 /**
  * @brief (专门解析) 解析模型输出的数据体 (className 和 confidence)。
  * @param payload 包含一个QString和一个double的数据体。
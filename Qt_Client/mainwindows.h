@@ -4,6 +4,7 @@
 #include <QWidget>
 #include <qcustomplot.h>
 #include <QProcess>
+#include "movingaverage.h"
 
 QT_BEGIN_NAMESPACE
 namespace QtCharts {
@@ -25,7 +26,8 @@ const quint32 HEADER_MAGIC = 0xAA55AA55;
 enum DataType : quint16 {
     ThreeAxisData = 0x0001, // 三轴加速度数据
     ModelOut = 0x0002,
-    State = 0x0003
+    State = 0x0003,
+    CompressedThreeAxisData = 0x0004 // 三轴 10 位码值，AdcCodec 无损压缩; 为滤波前的原始数据，解码后按包内窗口做滑动平均
     // ... 其他数据类型
 };
 }
@@ -69,6 +71,10 @@ private:
 
     // --- 专门解析三轴数据的函数 ---
     void parseThreeAxisData(const QByteArray& payload);
+    // --- 解析压缩三轴数据的函数 ---
+    void parseCompressedThreeAxisData(const QByteArray& payload);
+    MovingAverageFilter m_compressedSmooth; // 压缩数据为滤波前的原始值，按包内窗口滤波后与 ThreeAxisData 一致
+    bool m_compressedStream = false;        // 最近收到的三轴数据是否为压缩格式，切换时写日志
     // --- 专门解析模型输出数据的函数 ---
     void parseModelOutput(const QByteArray& payload);
     // --- 专门解析服务器模式的函数 ---
@@ -8,21 +8,60 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# FPGA_SPI 驱动与用户程序共用的 ioctl/mmap 接口定义
+INCLUDEPATH += $$PWD/../LS2K_Driver/FPGA_SPI
+
+# 龙芯向量扩展: 目标板支持时以 qmake CONFIG+=lsx (或 CONFIG+=lasx) 构建，解码器运行时仍按 hwcap 选择路径
+lsx: QMAKE_CXXFLAGS += -mlsx
+lasx: QMAKE_CXXFLAGS += -mlsx -mlasx
+
 SOURCES += \
+    acquisitionthread.cpp \
+    adccodec.cpp \
+    adcdecoder.cpp \
     beepctl.cpp \
     datareader.cpp \
     datasender.cpp \
+    enginecheck.cpp \
+    historystore.cpp \
+    inferencethread.cpp \
     main.cpp \
+    mfccengine.cpp \
+    modelipc.cpp \
+    movingaverage.cpp \
     qcustomplot.cpp \
+    realfft.cpp \
+    recordfile.cpp \
+    recordwriterthread.cpp \
+    replayloader.cpp \
+    resnetengine.cpp \
+    spikefilter.cpp \
     widget.cpp \
     widget_2.cpp
 
 HEADERS += \
+    acquisitionthread.h \
+    adccodec.h \
+    adcdecoder.h \
+    adcframe.h \
     beepctl.h \
     datareader.h \
     datasender.h \
+    enginecheck.h \
+    historystore.h \
+    inferencethread.h \
     inhibit_manager.h \
+    mfccengine.h \
+    modelipc.h \
+    movingaverage.h \
     qcustomplot.h \
+    realfft.h \
+    recordfile.h \
+    recordwriterthread.h \
+    replayloader.h \
+    resnetengine.h \
+    spikefilter.h \
+    spscring.h \
     widget.h \
     widget_2.h
 
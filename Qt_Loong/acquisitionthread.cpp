@@ -0,0 +1,238 @@
+#include "acquisitionthread.h"
+#include <QDateTime>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace {
+// 驱动节拍模式下连续多少次读不到帧后开始短暂休眠，防止驱动异常立即返回时以实时优先级空转
+const int IDLE_READS_BEFORE_BACKOFF = 8;
+const unsigned long IDLE_BACKOFF_MS = 10;
+const unsigned long REOPEN_INTERVAL_MS = 1000;
+
+qint64 monotonicNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void addNs(struct timespec& ts, qint64 ns)
+{
+    ts.tv_sec += static_cast<time_t>(ns / 1000000000LL);
+    ts.tv_nsec += static_cast<long>(ns % 1000000000LL);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+}
+}
+
+AcquisitionThread::AcquisitionThread(QObject *parent)
+    : QThread(parent)
+    , m_scratch(new AdcFrame[MAX_BATCH_FRAMES])
+    , m_stopRequested(false)
+    , m_framesCaptured(0)
+    , m_readErrors(0)
+    , m_framesLost(0)
+    , m_samplesRejected(0)
+    , m_framePeriodUs(static_cast<qint64>(SAMPLES_PER_AXIS) * 1000000 / SAMPLE_RATE_HZ) // 1024点@10kHz = 102.4ms
+{
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        m_axisRejected[axis].store(0, std::memory_order_relaxed);
+    }
+}
+
+AcquisitionThread::~AcquisitionThread()
+{
+    stop();
+    wait();
+}
+
+AcquisitionThread::FrameRing* AcquisitionThread::addConsumer()
+{
+    if (isRunning()) {
+        qWarning() << "AcquisitionThread: addConsumer() must be called before start().";
+        return nullptr;
+    }
+    m_rings.emplace_back(new FrameRing);
+    return m_rings.back().get();
+}
+
+void AcquisitionThread::setDevicePath(const QString& path)
+{
+    if (isRunning()) {
+        qWarning() << "AcquisitionThread: setDevicePath() must be called before start().";
+        return;
+    }
+    m_reader.setDevicePath(path);
+}
+
+void AcquisitionThread::setRealtime(int priority, MemoryLock memoryLock)
+{
+    m_rtPriority = priority;
+    m_memoryLock = memoryLock;
+}
+
+qint64 AcquisitionThread::wallTimeMs(qint64 monotonicNs)
+{
+    return QDateTime::currentMSecsSinceEpoch() - (monotonicNowNs() - monotonicNs) / 1000000;
+}
+
+void AcquisitionThread::lockBuffer(const void* address, size_t bytes)
+{
+    if (mlock(address, bytes) != 0) {
+        qWarning() << "AcquisitionThread: mlock of" << bytes << "bytes failed:" << strerror(errno);
+    }
+}
+
+void AcquisitionThread::setFramePeriodUs(qint64 periodUs)
+{
+    m_framePeriodUs = periodUs;
+}
+
+void AcquisitionThread::stop()
+{
+    m_stopRequested.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 在采集线程内应用 SCHED_FIFO 和内存锁定设置，失败时仅告警并以普通方式继续运行
+ */
+void AcquisitionThread::applyRealtimeSettings()
+{
+    if (m_memoryLock == LockAll) {
+        // * 锁定当前及以后分配的全部内存(包括界面线程之后映射的文件)
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            qWarning() << "AcquisitionThread: mlockall failed:" << strerror(errno);
+        }
+    } else if (m_memoryLock == LockBuffers) {
+        // * 只锁定采集路径在每帧都要写入的缓冲区，它们在 start() 之前已分配，此后不会再发生缺页;
+        // * 驱动的 mmap 环由驱动分配，本身不会换出
+        for (const std::unique_ptr<FrameRing>& ring : m_rings) {
+            lockBuffer(ring->storage(), FrameRing::storageBytes());
+        }
+        lockBuffer(m_scratch.get(), sizeof(AdcFrame) * MAX_BATCH_FRAMES);
+        m_reader.lockBuffers();
+    }
+    if (m_rtPriority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = qBound(sched_get_priority_min(SCHED_FIFO), m_rtPriority, sched_get_priority_max(SCHED_FIFO));
+        int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (ret != 0) {
+            qWarning() << "AcquisitionThread: Failed to set SCHED_FIFO priority" << param.sched_priority << ":" << strerror(ret);
+        } else {
+            qDebug() << "AcquisitionThread: Running with SCHED_FIFO priority" << param.sched_priority;
+        }
+    }
+}
+
+/**
+ * @brief 把一帧复制到每个消费者的环中，环满的消费者丢弃该帧并计数
+ */
+void AcquisitionThread::publishFrame(const AdcFrame& frame)
+{
+    for (const std::unique_ptr<FrameRing>& ring : m_rings) {
+        AdcFrame* slot = ring->writeSlot();
+        if (!slot) {
+            ring->markDropped();
+            continue;
+        }
+        *slot = frame;
+        ring->publish();
+    }
+}
+
+/**
+ * @brief 采集主循环: 连续读取设备，解析后发布给各消费者
+ * 驱动支持 mmap 环时由驱动负责采样节拍，本线程阻塞在 poll() 上等待新帧; 否则按帧周期定时读取.
+ */
+void AcquisitionThread::run()
+{
+    applyRealtimeSettings();
+
+    bool deviceOk = false;
+    bool haveLast = false;
+    int idleReads = 0; // 连续读不到帧的次数
+    quint64 lastSequence = 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!m_stopRequested.load(std::memory_order_acquire)) {
+        // * 设备未打开时每秒重试一次
+        if (m_reader.fd == -1 && !m_reader.openDevice()) {
+            if (deviceOk) {
+                deviceOk = false;
+                emit deviceStateChanged(false);
+            }
+            msleep(REOPEN_INTERVAL_MS);
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+
+        // * 一次取回驱动中积压的全部帧(最多 MAX_BATCH_FRAMES)，落后时一次系统调用即可追上
+        int count = m_reader.readFrames(m_scratch.get(), MAX_BATCH_FRAMES);
+        // * 设备失效(解除绑定等)时关闭设备，按上面的每秒重试重新打开; 重新打开后序号重新开始，不计为丢帧
+        if (count == READ_DEVICE_LOST) {
+            qWarning() << "AcquisitionThread: device lost, closing" << m_reader.devicePath();
+            m_readErrors.fetch_add(1, std::memory_order_relaxed);
+            m_reader.closeDevice();
+            haveLast = false;
+            idleReads = 0;
+            if (deviceOk) {
+                deviceOk = false;
+                emit deviceStateChanged(false);
+            }
+            msleep(REOPEN_INTERVAL_MS);
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+        for (int i = 0; i < count; ++i) {
+            const AdcFrame& frame = m_scratch[i];
+            // * 序号跳变即为采集端丢帧(FPGA 覆盖或驱动环满)
+            if (haveLast && frame.sequence > lastSequence + 1) {
+                m_framesLost.fetch_add(frame.sequence - lastSequence - 1, std::memory_order_relaxed);
+            }
+            lastSequence = frame.sequence;
+            haveLast = true;
+            m_samplesRejected.fetch_add(frame.rejected[0] + frame.rejected[1] + frame.rejected[2], std::memory_order_relaxed);
+            for (int axis = 0; axis < NUM_AXES; ++axis) {
+                m_axisRejected[axis].fetch_add(frame.rejected[axis], std::memory_order_relaxed);
+            }
+            publishFrame(frame);
+        }
+        if (count > 0) {
+            idleReads = 0;
+            m_framesCaptured.fetch_add(static_cast<quint64>(count), std::memory_order_relaxed);
+            if (!deviceOk) {
+                deviceOk = true;
+                emit deviceStateChanged(true);
+            }
+        } else {
+            m_readErrors.fetch_add(1, std::memory_order_relaxed);
+            ++idleReads;
+        }
+
+        if (m_reader.isDriverPaced()) {
+            // 节拍由驱动决定，直接回到 poll()/read() 等待下一帧; 连续读不到帧说明驱动没有阻塞，稍作休眠
+            if (idleReads >= IDLE_READS_BEFORE_BACKOFF) {
+                msleep(IDLE_BACKOFF_MS);
+            }
+            continue;
+        }
+        // * 以绝对时间节拍休眠，避免误差累积; 若已落后超过一个周期则重新对齐，不做追赶
+        addNs(next, m_framePeriodUs * 1000);
+        if (monotonicNowNs() - (static_cast<qint64>(next.tv_sec) * 1000000000LL + next.tv_nsec) > m_framePeriodUs * 1000) {
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+
+    m_reader.closeDevice();
+}
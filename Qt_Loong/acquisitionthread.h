@@ -0,0 +1,98 @@
+#ifndef ACQUISITIONTHREAD_H
+#define ACQUISITIONTHREAD_H
+
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "datareader.h"
+#include "adcdecoder.h"
+#include "adcframe.h"
+#include "spikefilter.h"
+#include "spscring.h"
+
+/**
+ * @brief 实时采集线程
+ * 在独立线程中连续读取一块采集板(/dev/FPGA_SPI_devN)，把解析后的帧写入每个消费者各自的无锁环形缓冲区.
+ * 每个消费者(界面绘图、存储、网络、模型)拥有一条独立的 SPSC 环，按各自节奏取数据;
+ * 某个消费者处理不过来时只会丢弃它自己的帧(并计数)，不会阻塞采集线程.
+ * 可选以 SCHED_FIFO 优先级运行并锁定采集用到的内存，避免缺页和调度抖动造成采样间隙.
+ * 监测多个轴承时为每块采集板各创建一个采集线程.
+ */
+class AcquisitionThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    typedef SpscRing<AdcFrame, 32> FrameRing;
+
+    // 内存锁定范围
+    enum MemoryLock {
+        LockNone,
+        LockBuffers,    // 只锁定采集路径上的缓冲区(各消费者的环、批量读取帧、读取和解码缓冲区)
+        LockAll         // mlockall(MCL_CURRENT | MCL_FUTURE): 锁定整个进程，包括之后的历史/回放文件映射，仅在内存充足时使用
+    };
+
+    explicit AcquisitionThread(QObject *parent = nullptr);
+    ~AcquisitionThread();
+
+    // * 注册一个消费者并返回其专用环，必须在 start() 之前调用
+    FrameRing* addConsumer();
+
+    // * 采集的设备节点，默认 DEVICE_NAME，必须在 start() 之前调用
+    void setDevicePath(const QString& path);
+
+    // * 采集使用的解码器(标定)，须在 start() 之前配置，之后只读(录制文件头据此记录标定)
+    AdcDecoder& decoder() { return m_reader.decoder(); }
+    // * 脉冲抑制参数(使能、窗口、阈值，或按轴手动设置最小偏差)，须在 start() 之前配置
+    SpikeFilter& spikeFilter() { return m_reader.spikeFilter(); }
+    // * 各轴最小判定偏差按该轴标定换算为 codes 个 ADC 量化间隔，<= 0 时使用 spikeFilter() 中按轴设置的值; 须在 start() 之前调用
+    void setSpikeMinDeviationCodes(float codes) { m_reader.setSpikeMinDeviationCodes(codes); }
+
+    // * 实时调度设置: priority 为 SCHED_FIFO 优先级(1~99, 0 表示普通调度); memoryLock 为内存锁定范围
+    void setRealtime(int priority, MemoryLock memoryLock);
+    // * 两次读取之间的最小间隔(us)，默认为一帧的采样时长，使每次读取都拿到新的一帧
+    // * 仅在驱动不支持 mmap 环(由用户触发采样)时使用
+    void setFramePeriodUs(qint64 periodUs);
+
+    // * 请求线程退出(线程安全)，随后可调用 wait()
+    void stop();
+
+    quint64 framesCaptured() const { return m_framesCaptured.load(std::memory_order_relaxed); }
+    quint64 readErrors() const { return m_readErrors.load(std::memory_order_relaxed); }
+    // 根据帧序号跳变统计的丢帧数(采集端: FPGA 覆盖或驱动环满)
+    quint64 framesLost() const { return m_framesLost.load(std::memory_order_relaxed); }
+    // * CLOCK_MONOTONIC 时刻(AdcFrame::timestampNs)换算为系统时间(ms since epoch)
+    static qint64 wallTimeMs(qint64 monotonicNs);
+    // 脉冲抑制替换的采样点总数(三轴合计)
+    quint64 samplesRejected() const { return m_samplesRejected.load(std::memory_order_relaxed); }
+    // 第 axis 轴被替换的采样点数
+    quint64 samplesRejected(int axis) const { return m_axisRejected[axis].load(std::memory_order_relaxed); }
+
+signals:
+    // 设备打开/读取状态变化时发出(跨线程，排队连接)
+    void deviceStateChanged(bool ok);
+
+protected:
+    void run() override;
+
+private:
+    void applyRealtimeSettings();
+    void lockBuffer(const void* address, size_t bytes);
+    void publishFrame(const AdcFrame& frame);
+
+    DataReader m_reader;    // 仅在采集线程内使用
+    std::vector<std::unique_ptr<FrameRing>> m_rings;
+    std::unique_ptr<AdcFrame[]> m_scratch; // 批量读取用的临时帧，避免在栈上放置大对象
+    std::atomic<bool> m_stopRequested;
+    std::atomic<quint64> m_framesCaptured;
+    std::atomic<quint64> m_readErrors;
+    std::atomic<quint64> m_framesLost;
+    std::atomic<quint64> m_samplesRejected;
+    std::atomic<quint64> m_axisRejected[NUM_AXES];
+    int m_rtPriority = 0;
+    MemoryLock m_memoryLock = LockNone;
+    qint64 m_framePeriodUs;
+};
+
+#endif // ACQUISITIONTHREAD_H
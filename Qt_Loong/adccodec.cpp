@@ -0,0 +1,490 @@
+#include "adccodec.h"
+#include <cstring>
+
+// 客户端(PC)也使用本文件解码，非 GCC/Clang 编译器只编译标量路径
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ADC_CODEC_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__loongarch__)
+#include <sys/auxv.h>
+#ifndef HWCAP_LOONGARCH_LSX
+#define HWCAP_LOONGARCH_LSX  (1 << 4)
+#endif
+// 龙芯向量扩展需要以 -mlsx 编译(见 LoongQt.pro)，运行时再按 hwcap 确认
+#if defined(__loongarch_sx)
+#include <lsxintrin.h>
+#endif
+#endif
+
+namespace {
+const int ROWS = AdcCodec::GROUP_SIZE / AdcCodec::LANES; // 每路 16 个值
+const int MAX_ORDER = 2;
+// 编码缓冲区中组数据之前保留的点数，前两点存放上一组末尾的两个码值，并使组数据 16 字节对齐
+const int HISTORY = AdcCodec::LANES;
+
+inline int bitWidth(quint16 bits)
+{
+#if defined(__GNUC__)
+    return bits ? 32 - __builtin_clz(bits) : 0;
+#else
+    int w = 0;
+    for (; bits; bits >>= 1) {
+        w++;
+    }
+    return w;
+#endif
+}
+
+/*
+ * 各路径实现相同的四个步骤(均按 GROUP_SIZE 点处理一组):
+ * residuals:   x[-2..] -> 残差(1/2 阶做 zigzag)，返回所有残差的按位或(用于求位宽)
+ * pack/unpack: 8 路交织定长打包，w 为 1~16
+ * reconstruct: 残差 -> 码值，prev1/prev2 为上一组末尾的两个码值
+ * 均为 16 位整数运算(按 2^16 取模)，与标量路径逐位一致.
+ */
+struct Kernels {
+    quint16 (*residuals)(const quint16* x, int order, quint16* zz);
+    void (*pack)(const quint16* zz, int w, quint16* out);
+    void (*unpack)(const quint16* in, int w, quint16* zz);
+    void (*reconstruct)(const quint16* zz, int order, quint16 prev1, quint16 prev2, quint16* x);
+};
+
+// --- 标量参考实现 ---
+quint16 residualsScalar(const quint16* x, int order, quint16* zz)
+{
+    quint16 bits = 0;
+    for (int i = 0; i < AdcCodec::GROUP_SIZE; ++i) {
+        quint16 z = x[i];
+        if (order > 0) {
+            quint16 r = static_cast<quint16>(x[i] - x[i - 1]);
+            if (order == 2) {
+                r = static_cast<quint16>(r - static_cast<quint16>(x[i - 1] - x[i - 2]));
+            }
+            const qint16 s = static_cast<qint16>(r);
+            z = static_cast<quint16>((r << 1) ^ static_cast<quint16>(s >> 15));
+        }
+        zz[i] = z;
+        bits |= z;
+    }
+    return bits;
+}
+
+void packScalar(const quint16* zz, int w, quint16* out)
+{
+    for (int lane = 0; lane < AdcCodec::LANES; ++lane) {
+        quint32 acc = 0;
+        int bits = 0;
+        int k = 0;
+        for (int row = 0; row < ROWS; ++row) {
+            acc |= static_cast<quint32>(zz[row * AdcCodec::LANES + lane]) << bits;
+            bits += w;
+            while (bits >= 16) {
+                out[k++ * AdcCodec::LANES + lane] = static_cast<quint16>(acc);
+                acc >>= 16;
+                bits -= 16;
+            }
+        }
+    }
+}
+
+void unpackScalar(const quint16* in, int w, quint16* zz)
+{
+    const quint32 mask = (1u << w) - 1;
+    for (int lane = 0; lane < AdcCodec::LANES; ++lane) {
+        quint32 acc = 0;
+        int bits = 0;
+        int k = 0;
+        for (int row = 0; row < ROWS; ++row) {
+            if (bits < w) {
+                acc |= static_cast<quint32>(in[k++ * AdcCodec::LANES + lane]) << bits;
+                bits += 16;
+            }
+            zz[row * AdcCodec::LANES + lane] = static_cast<quint16>(acc & mask);
+            acc >>= w;
+            bits -= w;
+        }
+    }
+}
+
+void reconstructScalar(const quint16* zz, int order, quint16 prev1, quint16 prev2, quint16* x)
+{
+    if (order == 0) {
+        memcpy(x, zz, AdcCodec::GROUP_SIZE * sizeof(quint16));
+        return;
+    }
+    quint16 last = prev1;
+    quint16 delta = static_cast<quint16>(prev1 - prev2);
+    for (int i = 0; i < AdcCodec::GROUP_SIZE; ++i) {
+        quint16 r = static_cast<quint16>((zz[i] >> 1) ^ static_cast<quint16>(0 - (zz[i] & 1)));
+        if (order == 2) {
+            delta = static_cast<quint16>(delta + r);
+            r = delta;
+        }
+        last = static_cast<quint16>(last + r);
+        x[i] = last;
+    }
+}
+
+const Kernels kScalar = { residualsScalar, packScalar, unpackScalar, reconstructScalar };
+
+#if defined(ADC_CODEC_X86)
+__attribute__((target("sse2")))
+quint16 residualsSse2(const quint16* x, int order, quint16* zz)
+{
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < AdcCodec::GROUP_SIZE; i += AdcCodec::LANES) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(x + i));
+        if (order > 0) {
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 1));
+            __m128i r = _mm_sub_epi16(v, v1);
+            if (order == 2) {
+                __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 2));
+                r = _mm_sub_epi16(r, _mm_sub_epi16(v1, v2));
+            }
+            v = _mm_xor_si128(_mm_slli_epi16(r, 1), _mm_srai_epi16(r, 15));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(zz + i), v);
+        acc = _mm_or_si128(acc, v);
+    }
+    acc = _mm_or_si128(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_or_si128(acc, _mm_srli_si128(acc, 4));
+    acc = _mm_or_si128(acc, _mm_srli_si128(acc, 2));
+    return static_cast<quint16>(_mm_cvtsi128_si32(acc));
+}
+
+/*
+ * 8 路同时打包: 每行 8 个值左移 bits 后并入累加字，凑满 16 位即写出，
+ * 溢出的高位(v >> (16 - 原bits))作为下一个字的开头.
+ */
+__attribute__((target("sse2")))
+void packSse2(const quint16* zz, int w, quint16* out)
+{
+    __m128i acc = _mm_setzero_si128();
+    int bits = 0;
+    int k = 0;
+    for (int row = 0; row < ROWS; ++row) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(zz + row * AdcCodec::LANES));
+        acc = _mm_or_si128(acc, _mm_sll_epi16(v, _mm_cvtsi32_si128(bits)));
+        bits += w;
+        if (bits >= 16) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(out + k++ * AdcCodec::LANES), acc);
+            bits -= 16;
+            acc = bits ? _mm_srl_epi16(v, _mm_cvtsi32_si128(w - bits)) : _mm_setzero_si128();
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+void unpackSse2(const quint16* in, int w, quint16* zz)
+{
+    const __m128i mask = _mm_set1_epi16(static_cast<short>((1u << w) - 1));
+    __m128i cur = _mm_load_si128(reinterpret_cast<const __m128i*>(in));
+    int bits = 0;
+    int k = 0;
+    for (int row = 0; row < ROWS; ++row) {
+        __m128i v = _mm_srl_epi16(cur, _mm_cvtsi32_si128(bits));
+        bits += w;
+        if (bits >= 16) {
+            bits -= 16;
+            if (++k < w) {
+                cur = _mm_load_si128(reinterpret_cast<const __m128i*>(in + k * AdcCodec::LANES));
+                if (bits) {
+                    v = _mm_or_si128(v, _mm_sll_epi16(cur, _mm_cvtsi32_si128(w - bits)));
+                }
+            }
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(zz + row * AdcCodec::LANES), _mm_and_si128(v, mask));
+    }
+}
+
+// 8 路 16 位前缀和(3 次移位相加)
+__attribute__((target("sse2")))
+inline __m128i prefixSumSse2(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+    return _mm_add_epi16(v, _mm_slli_si128(v, 8));
+}
+
+// 最后一路广播到全部 8 路，作为下一行的进位
+__attribute__((target("sse2")))
+inline __m128i broadcastLastSse2(__m128i v)
+{
+    v = _mm_shufflehi_epi16(v, 0xff);
+    return _mm_unpackhi_epi64(v, v);
+}
+
+__attribute__((target("sse2")))
+void reconstructSse2(const quint16* zz, int order, quint16 prev1, quint16 prev2, quint16* x)
+{
+    if (order == 0) {
+        memcpy(x, zz, AdcCodec::GROUP_SIZE * sizeof(quint16));
+        return;
+    }
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i last = _mm_set1_epi16(static_cast<short>(prev1));
+    __m128i delta = _mm_set1_epi16(static_cast<short>(prev1 - prev2));
+    for (int i = 0; i < AdcCodec::GROUP_SIZE; i += AdcCodec::LANES) {
+        __m128i z = _mm_load_si128(reinterpret_cast<const __m128i*>(zz + i));
+        __m128i r = _mm_xor_si128(_mm_srli_epi16(z, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(z, one)));
+        if (order == 2) {
+            r = _mm_add_epi16(prefixSumSse2(r), delta);
+            delta = broadcastLastSse2(r);
+        }
+        __m128i v = _mm_add_epi16(prefixSumSse2(r), last);
+        last = broadcastLastSse2(v);
+        _mm_store_si128(reinterpret_cast<__m128i*>(x + i), v);
+    }
+}
+
+const Kernels kSse2 = { residualsSse2, packSse2, unpackSse2, reconstructSse2 };
+#endif
+
+#if defined(__loongarch_sx)
+quint16 residualsLsx(const quint16* x, int order, quint16* zz)
+{
+    __m128i acc = __lsx_vreplgr2vr_h(0);
+    for (int i = 0; i < AdcCodec::GROUP_SIZE; i += AdcCodec::LANES) {
+        __m128i v = __lsx_vld(x + i, 0);
+        if (order > 0) {
+            __m128i v1 = __lsx_vld(x + i - 1, 0);
+            __m128i r = __lsx_vsub_h(v, v1);
+            if (order == 2) {
+                __m128i v2 = __lsx_vld(x + i - 2, 0);
+                r = __lsx_vsub_h(r, __lsx_vsub_h(v1, v2));
+            }
+            v = __lsx_vxor_v(__lsx_vslli_h(r, 1), __lsx_vsrai_h(r, 15));
+        }
+        __lsx_vst(v, zz + i, 0);
+        acc = __lsx_vor_v(acc, v);
+    }
+    acc = __lsx_vor_v(acc, __lsx_vbsrl_v(acc, 8));
+    acc = __lsx_vor_v(acc, __lsx_vbsrl_v(acc, 4));
+    acc = __lsx_vor_v(acc, __lsx_vbsrl_v(acc, 2));
+    return static_cast<quint16>(__lsx_vpickve2gr_hu(acc, 0));
+}
+
+// vsll_h / vsrl_h 的移位数按 16 取模，调用处保证移位数在 0~15
+void packLsx(const quint16* zz, int w, quint16* out)
+{
+    __m128i acc = __lsx_vreplgr2vr_h(0);
+    int bits = 0;
+    int k = 0;
+    for (int row = 0; row < ROWS; ++row) {
+        __m128i v = __lsx_vld(zz + row * AdcCodec::LANES, 0);
+        acc = __lsx_vor_v(acc, __lsx_vsll_h(v, __lsx_vreplgr2vr_h(bits)));
+        bits += w;
+        if (bits >= 16) {
+            __lsx_vst(acc, out + k++ * AdcCodec::LANES, 0);
+            bits -= 16;
+            acc = bits ? __lsx_vsrl_h(v, __lsx_vreplgr2vr_h(w - bits)) : __lsx_vreplgr2vr_h(0);
+        }
+    }
+}
+
+void unpackLsx(const quint16* in, int w, quint16* zz)
+{
+    const __m128i mask = __lsx_vreplgr2vr_h(static_cast<int>((1u << w) - 1));
+    __m128i cur = __lsx_vld(in, 0);
+    int bits = 0;
+    int k = 0;
+    for (int row = 0; row < ROWS; ++row) {
+        __m128i v = __lsx_vsrl_h(cur, __lsx_vreplgr2vr_h(bits));
+        bits += w;
+        if (bits >= 16) {
+            bits -= 16;
+            if (++k < w) {
+                cur = __lsx_vld(in + k * AdcCodec::LANES, 0);
+                if (bits) {
+                    v = __lsx_vor_v(v, __lsx_vsll_h(cur, __lsx_vreplgr2vr_h(w - bits)));
+                }
+            }
+        }
+        __lsx_vst(__lsx_vand_v(v, mask), zz + row * AdcCodec::LANES, 0);
+    }
+}
+
+inline __m128i prefixSumLsx(__m128i v)
+{
+    v = __lsx_vadd_h(v, __lsx_vbsll_v(v, 2));
+    v = __lsx_vadd_h(v, __lsx_vbsll_v(v, 4));
+    return __lsx_vadd_h(v, __lsx_vbsll_v(v, 8));
+}
+
+void reconstructLsx(const quint16* zz, int order, quint16 prev1, quint16 prev2, quint16* x)
+{
+    if (order == 0) {
+        memcpy(x, zz, AdcCodec::GROUP_SIZE * sizeof(quint16));
+        return;
+    }
+    const __m128i one = __lsx_vreplgr2vr_h(1);
+    const __m128i zero = __lsx_vreplgr2vr_h(0);
+    __m128i last = __lsx_vreplgr2vr_h(prev1);
+    __m128i delta = __lsx_vreplgr2vr_h(static_cast<quint16>(prev1 - prev2));
+    for (int i = 0; i < AdcCodec::GROUP_SIZE; i += AdcCodec::LANES) {
+        __m128i z = __lsx_vld(zz + i, 0);
+        __m128i r = __lsx_vxor_v(__lsx_vsrli_h(z, 1), __lsx_vsub_h(zero, __lsx_vand_v(z, one)));
+        if (order == 2) {
+            r = __lsx_vadd_h(prefixSumLsx(r), delta);
+            delta = __lsx_vreplvei_h(r, 7);
+        }
+        __m128i v = __lsx_vadd_h(prefixSumLsx(r), last);
+        last = __lsx_vreplvei_h(v, 7);
+        __lsx_vst(v, x + i, 0);
+    }
+}
+
+const Kernels kLsx = { residualsLsx, packLsx, unpackLsx, reconstructLsx };
+#endif
+
+bool isaSupported(AdcCodec::Isa isa)
+{
+    switch (isa) {
+    case AdcCodec::IsaScalar:
+        return true;
+#if defined(ADC_CODEC_X86)
+    case AdcCodec::IsaSse2:
+        return __builtin_cpu_supports("sse2");
+#endif
+#if defined(__loongarch_sx)
+    case AdcCodec::IsaLsx:
+        return (getauxval(AT_HWCAP) & HWCAP_LOONGARCH_LSX) != 0;
+#endif
+    default:
+        return false;
+    }
+}
+
+const Kernels* kernelsFor(AdcCodec::Isa isa)
+{
+    switch (isa) {
+#if defined(ADC_CODEC_X86)
+    case AdcCodec::IsaSse2: return &kSse2;
+#endif
+#if defined(__loongarch_sx)
+    case AdcCodec::IsaLsx:  return &kLsx;
+#endif
+    default:                return &kScalar;
+    }
+}
+
+AdcCodec::Isa detectIsa()
+{
+    static const AdcCodec::Isa preferred[] = { AdcCodec::IsaLsx, AdcCodec::IsaSse2 };
+    for (AdcCodec::Isa isa : preferred) {
+        if (isaSupported(isa)) {
+            return isa;
+        }
+    }
+    return AdcCodec::IsaScalar;
+}
+
+AdcCodec::Isa g_isa = detectIsa();
+const Kernels* g_kernels = kernelsFor(g_isa);
+}
+
+AdcCodec::Isa AdcCodec::isa()
+{
+    return g_isa;
+}
+
+bool AdcCodec::forceIsa(Isa isa)
+{
+    if (!isaSupported(isa)) {
+        return false;
+    }
+    g_isa = isa;
+    g_kernels = kernelsFor(isa);
+    return true;
+}
+
+const char* AdcCodec::isaName(Isa isa)
+{
+    switch (isa) {
+    case IsaSse2: return "SSE2";
+    case IsaLsx:  return "LSX";
+    default:      return "scalar";
+    }
+}
+
+/**
+ * @brief 逐组选择残差位宽最小的预测阶数并打包
+ */
+int AdcCodec::encode(const quint16* codes, int count, char* out)
+{
+    const Kernels& k = *g_kernels;
+    alignas(16) quint16 x[HISTORY + GROUP_SIZE];
+    alignas(16) quint16 zz[MAX_ORDER + 1][GROUP_SIZE];
+    alignas(16) quint16 words[GROUP_SIZE];
+    char* p = out;
+    x[HISTORY - 2] = 0;
+    x[HISTORY - 1] = 0;
+    for (int start = 0; start < count; start += GROUP_SIZE) {
+        const int n = qMin(GROUP_SIZE, count - start);
+        memcpy(x + HISTORY, codes + start, n * sizeof(quint16));
+        for (int i = n; i < GROUP_SIZE; ++i) {
+            x[HISTORY + i] = x[HISTORY + n - 1];
+        }
+
+        int order = 0;
+        int width = 17;
+        for (int o = 0; o <= MAX_ORDER; ++o) {
+            const int w = bitWidth(k.residuals(x + HISTORY, o, zz[o]));
+            if (w < width) {
+                order = o;
+                width = w;
+            }
+        }
+        *p++ = static_cast<char>((order << 5) | width);
+        if (width > 0) {
+            k.pack(zz[order], width, words);
+            memcpy(p, words, width * LANES * sizeof(quint16));
+            p += width * LANES * sizeof(quint16);
+        }
+
+        // 下一组的预测上下文: 本组最后两点(n 为 1 时倒数第二点是上一组的最后一点)
+        x[HISTORY - 2] = x[HISTORY + n - 2];
+        x[HISTORY - 1] = x[HISTORY + n - 1];
+    }
+    return static_cast<int>(p - out);
+}
+
+int AdcCodec::decode(const char* data, int size, quint16* codes, int count)
+{
+    const Kernels& k = *g_kernels;
+    alignas(16) quint16 x[GROUP_SIZE];
+    alignas(16) quint16 zz[GROUP_SIZE];
+    alignas(16) quint16 words[GROUP_SIZE];
+    const char* p = data;
+    const char* end = data + size;
+    quint16 prev1 = 0;
+    quint16 prev2 = 0;
+    for (int start = 0; start < count; start += GROUP_SIZE) {
+        if (p >= end) {
+            return -1;
+        }
+        const quint8 tag = static_cast<quint8>(*p++);
+        const int order = tag >> 5;
+        const int width = tag & 0x1f;
+        const int bytes = width * LANES * static_cast<int>(sizeof(quint16));
+        if (order > MAX_ORDER || width > 16 || end - p < bytes) {
+            return -1;
+        }
+        if (width > 0) {
+            memcpy(words, p, bytes);
+            k.unpack(words, width, zz);
+        } else {
+            memset(zz, 0, sizeof(zz));
+        }
+        p += bytes;
+        k.reconstruct(zz, order, prev1, prev2, x);
+
+        const int n = qMin(GROUP_SIZE, count - start);
+        memcpy(codes + start, x, n * sizeof(quint16));
+        prev2 = n >= 2 ? x[n - 2] : prev1;
+        prev1 = x[n - 1];
+    }
+    return static_cast<int>(p - data);
+}
@@ -0,0 +1,39 @@
+#ifndef ADCCODEC_H
+#define ADCCODEC_H
+
+#include <QtGlobal>
+
+/**
+ * @brief 10 位 ADC 码值的单轴无损压缩
+ * 数据按 GROUP_SIZE 点分组，每组在 0/1/2 阶固定预测(原值/一阶差分/二阶差分)中选残差位宽最小的一种，
+ * 1/2 阶残差经 zigzag 映射为无符号数，再按该组的最大位宽 w 定长打包.
+ * 打包为 8 路交织布局: 第 i 点属于第 i % 8 路，每路 16 个值依次拼成 w 个 16 位字，8 路同序号的字相邻存放，
+ * 因此 SSE2(x86) / LSX(龙芯) 一条 128 位指令即可同时处理 8 路; 运行时按 CPU 能力选择，否则使用标量路径，各路径输出逐字节相同.
+ * 组格式: [1 字节: 阶数 << 5 | w(0~16)] [w * 16 字节(小端 16 位字)]; 末组不足 GROUP_SIZE 点时用最后一点补齐.
+ * 预测跨组连续(首点之前视为 0)，只能从一轴数据的开头顺序解码.
+ * 码值须小于 4096，保证二阶残差不超出 16 位.
+ */
+namespace AdcCodec {
+const int GROUP_SIZE = 128;
+const int LANES = 8;
+
+enum Isa { IsaScalar, IsaSse2, IsaLsx };
+
+// * count 点编码后的最大字节数(全部按 16 位打包)
+constexpr int maxEncodedSize(int count)
+{
+    return (count + GROUP_SIZE - 1) / GROUP_SIZE * (1 + GROUP_SIZE * 2);
+}
+
+// * 编码 count 个码值，out 至少 maxEncodedSize(count) 字节; 返回写入的字节数
+int encode(const quint16* codes, int count, char* out);
+// * 解码 count 个码值; 返回消耗的字节数，数据不足或格式错误返回 -1
+int decode(const char* data, int size, quint16* codes, int count);
+
+Isa isa();
+// * 强制使用指定路径(不受 CPU 支持时忽略并返回 false)，便于对比测试
+bool forceIsa(Isa isa);
+const char* isaName(Isa isa);
+}
+
+#endif // ADCCODEC_H
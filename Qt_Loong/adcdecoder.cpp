@@ -0,0 +1,256 @@
+#include "adcdecoder.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ADC_DECODER_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__loongarch__)
+#include <sys/auxv.h>
+#ifndef HWCAP_LOONGARCH_LSX
+#define HWCAP_LOONGARCH_LSX  (1 << 4)
+#endif
+#ifndef HWCAP_LOONGARCH_LASX
+#define HWCAP_LOONGARCH_LASX (1 << 5)
+#endif
+// 龙芯向量扩展需要以 -mlsx / -mlasx 编译(见 LoongQt.pro)，运行时再按 hwcap 确认
+#if defined(__loongarch_sx)
+#include <lsxintrin.h>
+#endif
+#if defined(__loongarch_asx)
+#include <lasxintrin.h>
+#endif
+#endif
+
+namespace {
+// 各轴数据在有效数据中的偏移: X SEP1 Y SEP2 Z
+const size_t kAxisOffset[NUM_AXES] = {
+    0,
+    ADC_BYTES_PER_AXIS + DELIMITER_BYTES,
+    (ADC_BYTES_PER_AXIS + DELIMITER_BYTES) * 2,
+};
+
+// 默认标定: 0~1023 对应 -5V~+5V
+const float kVoltsPerCode = 10.0f / 1023.0f;
+const float kVoltsOffset = -5.0f;
+
+/*
+ * 向量化路径: 每个采样点为 (b1, b2) 两个字节，按小端16位整体读入后
+ * raw = ((w & 0xff) << 2) | (w >> 8)，零扩展为32位整数转 float，再乘 scale 加 offset.
+ * 乘加分两步完成，不使用 FMA，使各路径结果一致.
+ */
+#if defined(ADC_DECODER_X86)
+__attribute__((target("sse2")))
+void decodeAxisSse2(const unsigned char* src, float* dst, float scale, float offset)
+{
+    const __m128i lowMask = _mm_set1_epi16(0x00ff);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 vs = _mm_set1_ps(scale);
+    const __m128 vo = _mm_set1_ps(offset);
+    for (int i = 0; i < SAMPLES_PER_AXIS; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+        __m128i raw = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, lowMask), 2), _mm_srli_epi16(v, 8));
+        __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero));
+        __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero));
+        _mm_store_ps(dst + i, _mm_add_ps(_mm_mul_ps(f0, vs), vo));
+        _mm_store_ps(dst + i + 4, _mm_add_ps(_mm_mul_ps(f1, vs), vo));
+    }
+}
+
+__attribute__((target("avx2")))
+void decodeAxisAvx2(const unsigned char* src, float* dst, float scale, float offset)
+{
+    const __m256i lowMask = _mm256_set1_epi16(0x00ff);
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256 vo = _mm256_set1_ps(offset);
+    for (int i = 0; i < SAMPLES_PER_AXIS; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i));
+        __m256i raw = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(v, lowMask), 2), _mm256_srli_epi16(v, 8));
+        // unpack 指令在两个128位通道内各自交织，会打乱顺序，因此按半边零扩展
+        __m256 f0 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(raw)));
+        __m256 f1 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(raw, 1)));
+        _mm256_store_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(f0, vs), vo));
+        _mm256_store_ps(dst + i + 8, _mm256_add_ps(_mm256_mul_ps(f1, vs), vo));
+    }
+}
+#endif
+
+#if defined(__loongarch_sx)
+void decodeAxisLsx(const unsigned char* src, float* dst, float scale, float offset)
+{
+    const __m128i lowMask = __lsx_vreplgr2vr_h(0x00ff);
+    const __m128i zero = __lsx_vreplgr2vr_w(0);
+    const __m128 vs = {scale, scale, scale, scale};
+    const __m128 vo = {offset, offset, offset, offset};
+    for (int i = 0; i < SAMPLES_PER_AXIS; i += 8) {
+        __m128i v = __lsx_vld(src + 2 * i, 0);
+        __m128i raw = __lsx_vor_v(__lsx_vslli_h(__lsx_vand_v(v, lowMask), 2), __lsx_vsrli_h(v, 8));
+        __m128 f0 = __lsx_vffint_s_w(__lsx_vilvl_h(zero, raw));
+        __m128 f1 = __lsx_vffint_s_w(__lsx_vilvh_h(zero, raw));
+        __lsx_vst((__m128i)__lsx_vfadd_s(__lsx_vfmul_s(f0, vs), vo), dst + i, 0);
+        __lsx_vst((__m128i)__lsx_vfadd_s(__lsx_vfmul_s(f1, vs), vo), dst + i + 4, 0);
+    }
+}
+#endif
+
+#if defined(__loongarch_asx)
+void decodeAxisLasx(const unsigned char* src, float* dst, float scale, float offset)
+{
+    const __m256i lowMask = __lasx_xvreplgr2vr_h(0x00ff);
+    const __m256 vs = {scale, scale, scale, scale, scale, scale, scale, scale};
+    const __m256 vo = {offset, offset, offset, offset, offset, offset, offset, offset};
+    for (int i = 0; i < SAMPLES_PER_AXIS; i += 16) {
+        __m256i v = __lasx_xvld(src + 2 * i, 0);
+        __m256i raw = __lasx_xvor_v(__lasx_xvslli_h(__lasx_xvand_v(v, lowMask), 2), __lasx_xvsrli_h(v, 8));
+        // vext2xv 只扩展低128位，高半部分先用 xvpermi_d 移到低位
+        __m256 f0 = __lasx_xvffint_s_w(__lasx_vext2xv_wu_hu(raw));
+        __m256 f1 = __lasx_xvffint_s_w(__lasx_vext2xv_wu_hu(__lasx_xvpermi_d(raw, 0x0e)));
+        __lasx_xvst((__m256i)__lasx_xvfadd_s(__lasx_xvfmul_s(f0, vs), vo), dst + i, 0);
+        __lasx_xvst((__m256i)__lasx_xvfadd_s(__lasx_xvfmul_s(f1, vs), vo), dst + i + 8, 0);
+    }
+}
+#endif
+
+bool isaSupported(AdcDecoder::Isa isa)
+{
+    switch (isa) {
+    case AdcDecoder::IsaScalar:
+        return true;
+#if defined(ADC_DECODER_X86)
+    case AdcDecoder::IsaSse2:
+        return __builtin_cpu_supports("sse2");
+    case AdcDecoder::IsaAvx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__loongarch_sx)
+    case AdcDecoder::IsaLsx:
+        return (getauxval(AT_HWCAP) & HWCAP_LOONGARCH_LSX) != 0;
+#endif
+#if defined(__loongarch_asx)
+    case AdcDecoder::IsaLasx:
+        return (getauxval(AT_HWCAP) & HWCAP_LOONGARCH_LASX) != 0;
+#endif
+    default:
+        return false;
+    }
+}
+}
+
+AdcDecoder::AdcDecoder()
+    : m_isa(detectIsa())
+{
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        setLinear(axis, kVoltsPerCode, kVoltsOffset);
+    }
+}
+
+void AdcDecoder::setLinear(int axis, float scale, float offset)
+{
+    m_scale[axis] = scale;
+    m_offset[axis] = offset;
+    m_customTable[axis] = false;
+    rebuildTable(axis);
+}
+
+void AdcDecoder::setSensitivity(int axis, float voltsPerG, float zeroVolts)
+{
+    setLinear(axis, kVoltsPerCode / voltsPerG, (kVoltsOffset - zeroVolts) / voltsPerG);
+}
+
+void AdcDecoder::setTable(int axis, const float* table)
+{
+    memcpy(m_table[axis], table, sizeof(m_table[axis]));
+    m_customTable[axis] = true;
+}
+
+void AdcDecoder::rebuildTable(int axis)
+{
+    for (int raw = 0; raw < ADC_RAW_LEVELS; ++raw) {
+        float v = static_cast<float>(raw) * m_scale[axis];
+        m_table[axis][raw] = v + m_offset[axis];
+    }
+}
+
+quint16 AdcDecoder::toRaw(float value, float scale, float offset)
+{
+    long raw = lrintf((value - offset) / scale);
+    return static_cast<quint16>(qBound(0L, raw, static_cast<long>(ADC_RAW_LEVELS - 1)));
+}
+
+AdcDecoder::Isa AdcDecoder::detectIsa()
+{
+    static const Isa preferred[] = { IsaLasx, IsaLsx, IsaAvx2, IsaSse2 };
+    for (Isa isa : preferred) {
+        if (isaSupported(isa)) {
+            return isa;
+        }
+    }
+    return IsaScalar;
+}
+
+bool AdcDecoder::forceIsa(Isa isa)
+{
+    if (!isaSupported(isa)) {
+        return false;
+    }
+    m_isa = isa;
+    return true;
+}
+
+const char* AdcDecoder::isaName(Isa isa)
+{
+    switch (isa) {
+    case IsaSse2: return "SSE2";
+    case IsaAvx2: return "AVX2";
+    case IsaLsx:  return "LSX";
+    case IsaLasx: return "LASX";
+    default:      return "scalar";
+    }
+}
+
+/**
+ * @brief 标量参考实现: 逐点拼出 10 位码值后查各轴标定表
+ * 与向量化路径的差异仅来自浮点舍入(不超过 1 ulp)
+ */
+void AdcDecoder::decodeScalar(const char* payload, float* x, float* y, float* z) const
+{
+    float* out[NUM_AXES] = { x, y, z };
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        const unsigned char* src = reinterpret_cast<const unsigned char*>(payload) + kAxisOffset[axis];
+        const float* table = m_table[axis];
+        float* dst = out[axis];
+        for (int i = 0; i < SAMPLES_PER_AXIS; ++i) {
+            dst[i] = table[(src[2 * i] << 2) | src[2 * i + 1]];
+        }
+    }
+}
+
+void AdcDecoder::decode(const char* payload, float* x, float* y, float* z) const
+{
+    void (*kernel)(const unsigned char*, float*, float, float) = nullptr;
+    if (isLinear()) {
+        switch (m_isa) {
+#if defined(ADC_DECODER_X86)
+        case IsaSse2: kernel = decodeAxisSse2; break;
+        case IsaAvx2: kernel = decodeAxisAvx2; break;
+#endif
+#if defined(__loongarch_sx)
+        case IsaLsx:  kernel = decodeAxisLsx; break;
+#endif
+#if defined(__loongarch_asx)
+        case IsaLasx: kernel = decodeAxisLasx; break;
+#endif
+        default: break;
+        }
+    }
+    if (!kernel) {
+        decodeScalar(payload, x, y, z);
+        return;
+    }
+    float* out[NUM_AXES] = { x, y, z };
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        kernel(reinterpret_cast<const unsigned char*>(payload) + kAxisOffset[axis], out[axis], m_scale[axis], m_offset[axis]);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef ADCDECODER_H
+#define ADCDECODER_H
+
+#include "datareader.h"
+
+#define ADC_RAW_LEVELS 1024 // 10位ADC码值个数: raw = (b1 << 2) | b2
+
+/**
+ * @brief FPGA 帧有效数据(X SEP1 Y SEP2 Z)到三轴 float 数组的解码器
+ * 每个轴各有一张 ADC_RAW_LEVELS 项的标定表，raw 码值查表得到物理量.
+ * 标定为线性(setLinear/setSensitivity)时使用向量化路径一次处理 8/16 个点，
+ * 运行时按 CPU 能力选择 SSE2/AVX2(x86) 或 LSX/LASX(龙芯)，否则使用标量查表路径.
+ * 默认标定与旧版一致: raw * 10 / 1023 - 5 (V).
+ * 输出数组需按 32 字节对齐(AdcFrame 已保证)，长度为 SAMPLES_PER_AXIS.
+ */
+class AdcDecoder
+{
+public:
+    enum Isa { IsaScalar, IsaSse2, IsaAvx2, IsaLsx, IsaLasx };
+
+    AdcDecoder();
+
+    // * 线性标定: value = raw * scale + offset
+    void setLinear(int axis, float scale, float offset);
+    // * 按传感器灵敏度换算为 g: value = (电压 - zeroVolts) / voltsPerG
+    void setSensitivity(int axis, float voltsPerG, float zeroVolts = 0.0f);
+    // * 非线性标定表(ADC_RAW_LEVELS 项)，设置后该解码器改用标量查表路径
+    void setTable(int axis, const float* table);
+    const float* table(int axis) const { return m_table[axis]; }
+    // * 各轴均为线性标定(未设置非线性表)时，value = raw * scale(axis) + offset(axis)
+    bool isLinear() const { return !m_customTable[0] && !m_customTable[1] && !m_customTable[2]; }
+    float scale(int axis) const { return m_scale[axis]; }
+    float offset(int axis) const { return m_offset[axis]; }
+    // * 线性标定的逆运算: 数值 -> 码值(四舍五入，限制在 0 ~ ADC_RAW_LEVELS-1)，用于录制和压缩传输
+    static quint16 toRaw(float value, float scale, float offset);
+
+    // * 解码一帧，payload 指向 X 轴第一个字节
+    void decode(const char* payload, float* x, float* y, float* z) const;
+    // * 标量参考实现(查表)，用于校验向量化路径
+    void decodeScalar(const char* payload, float* x, float* y, float* z) const;
+
+    Isa isa() const { return m_isa; }
+    // * 强制使用指定路径(不受 CPU 支持时忽略并返回 false)，便于对比测试
+    bool forceIsa(Isa isa);
+    static Isa detectIsa();
+    static const char* isaName(Isa isa);
+
+private:
+    void rebuildTable(int axis);
+
+    alignas(64) float m_table[NUM_AXES][ADC_RAW_LEVELS];
+    float m_scale[NUM_AXES];
+    float m_offset[NUM_AXES];
+    bool m_customTable[NUM_AXES] = { false, false, false }; // 有任一轴使用非线性表时走标量路径
+    Isa m_isa = IsaScalar;
+};
+
+#endif // ADCDECODER_H
@@ -0,0 +1,22 @@
+#ifndef ADCFRAME_H
+#define ADCFRAME_H
+
+#include <QtGlobal>
+#include "datareader.h"
+
+/**
+ * @brief 一帧已解析的三轴采样数据(每轴 SAMPLES_PER_AXIS 点)
+ * 由采集线程填充，经 SpscRing 发布给界面、存储、网络和模型等消费者.
+ * 三轴为按 64 字节对齐的 float 数组(SoA)，可直接用于向量化处理.
+ */
+struct alignas(64) AdcFrame
+{
+    quint64 sequence = 0;    // 帧序号(流水模式下为 FPGA 帧计数)，不连续表示丢帧
+    qint64 timestampNs = 0;  // 帧传输完成时刻(CLOCK_MONOTONIC, ns)
+    quint16 rejected[NUM_AXES] = { 0, 0, 0 }; // 各轴被脉冲抑制替换的点数，反映数据质量
+    alignas(64) float x[SAMPLES_PER_AXIS];
+    alignas(64) float y[SAMPLES_PER_AXIS];
+    alignas(64) float z[SAMPLES_PER_AXIS];
+};
+
+#endif // ADCFRAME_H
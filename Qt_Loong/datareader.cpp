@@ -1,12 +1,28 @@
 #include "datareader.h"
+#include "adcframe.h"
+#include "adcdecoder.h"
+#include "spikefilter.h"
+#include "fpga_spi_uapi.h"
 #include <fcntl.h>   // For open
 #include <unistd.h>  // For read, close
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <poll.h>
 #include <QDebug>
 #include <vector>    // std::vector for char buffer
 #include <cstdio>    // perror, fprintf (can be replaced with qDebug)
+#include <cmath>     // std::abs
+#include <cerrno>
+#include <cstring>   // strerror
+#include <ctime>     // clock_gettime
 
 DataReader::DataReader(QObject *parent) : QObject(parent)
+    , m_readBuffer(MAX_BATCH_FRAMES * FPGA_BATCH_RECORD_SIZE)
+    , m_decoder(new AdcDecoder)
+    , m_spikeFilter(new SpikeFilter)
 {
+    updateSpikeThresholds();
+    qDebug() << "ADC decoder using" << AdcDecoder::isaName(m_decoder->isa());
 }
 
 DataReader::~DataReader()
@@ -20,18 +36,27 @@ bool DataReader::openDevice()
         qDebug() << "Device already open.";
         return true; // 或者根据逻辑决定是否重新打开
     }
-    fd = open(DEVICE_NAME, O_RDWR);
+    fd = open(m_devicePath.toLocal8Bit().constData(), O_RDWR);
     if (fd == -1) {
-        qDebug("Failed to open device %s", DEVICE_NAME);
+        qDebug() << "Failed to open device" << m_devicePath;
         return false;
     }
-    qDebug() << "Device" << DEVICE_NAME << "opened successfully.";
+    qDebug() << "Device" << m_devicePath << "opened successfully.";
+    updateSpikeThresholds(); // 标定可能在构造之后才设置
+    if (!mapRing()) {
+        // 不能映射时优先使用批量 read() 格式，旧驱动不支持则每次读取一帧
+        __u32 format = FPGA_READ_FORMAT_BATCH;
+        m_batchRead = (ioctl(fd, FPGA_SPI_IOC_SET_READ_FORMAT, &format) == 0);
+        qDebug() << "Device ring buffer not available, falling back to" << (m_batchRead ? "batched read()." : "read().");
+    }
     return true;
 }
 
 void DataReader::closeDevice()
 {
     if (fd != -1) {
+        unmapRing();
+        m_batchRead = false;
         if (close(fd) == -1) {
             qDebug("Failed to close device");
         } else {
@@ -41,14 +66,77 @@ void DataReader::closeDevice()
     }
 }
 
-bool DataReader::readDeviceData(QVector<double>& timeKeys,
-                                QVector<double>& xValues,
-                                QVector<double>& yValues,
-                                QVector<double>& zValues,
-                                int batchNumber)
+void DataReader::lockBuffers()
 {
+    const struct { const void* address; size_t bytes; } buffers[] = {
+        { m_readBuffer.data(), m_readBuffer.size() },
+        { m_decoder.get(), sizeof(AdcDecoder) },
+        { m_spikeFilter.get(), sizeof(SpikeFilter) },
+    };
+    for (const auto& buffer : buffers) {
+        if (mlock(buffer.address, buffer.bytes) != 0) {
+            qDebug() << "DataReader: mlock of" << buffer.bytes << "bytes failed:" << strerror(errno);
+        }
+    }
+}
 
-    // --- 实际的 Linux 设备读取逻辑 ---
+/**
+ * @brief 按各轴标定表的平均量化间隔设置脉冲抑制的最小判定偏差(m_spikeMinCodes 个间隔)
+ * m_spikeMinCodes <= 0 时保留通过 spikeFilter().setMinDeviation() 设置的值
+ */
+void DataReader::updateSpikeThresholds()
+{
+    if (m_spikeMinCodes <= 0.0f) {
+        return;
+    }
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        const float* table = m_decoder->table(axis);
+        const float step = std::abs(table[ADC_RAW_LEVELS - 1] - table[0]) / (ADC_RAW_LEVELS - 1);
+        m_spikeFilter->setMinDeviation(axis, m_spikeMinCodes * step);
+    }
+}
+
+/**
+ * @brief 查询驱动环形缓冲区布局并映射到本进程，之后帧数据直接在映射区中解析，不再经过 read() 拷贝
+ */
+bool DataReader::mapRing()
+{
+    struct fpga_ring_info info;
+    if (ioctl(fd, FPGA_SPI_IOC_RING_INFO, &info) == -1) {
+        return false;
+    }
+    void* base = mmap(nullptr, info.mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        qDebug("Failed to mmap device ring buffer");
+        return false;
+    }
+    const fpga_ring_ctrl* ctrl = static_cast<const fpga_ring_ctrl*>(base);
+    if (ctrl->magic != FPGA_RING_MAGIC || ctrl->version != FPGA_RING_VERSION) {
+        qDebug("Device ring buffer magic/version mismatch");
+        munmap(base, info.mmap_size);
+        return false;
+    }
+    m_ringBase = static_cast<char*>(base);
+    m_ringSize = info.mmap_size;
+    m_ringSlotCount = info.slot_count;
+    m_ringSlotSize = info.slot_size;
+    m_ringDataOffset = info.data_offset;
+    m_ringPayloadOffset = info.payload_offset;
+    qDebug() << "Device ring buffer mapped:" << m_ringSlotCount << "slots of" << m_ringSlotSize << "bytes.";
+    return true;
+}
+
+void DataReader::unmapRing()
+{
+    if (m_ringBase) {
+        munmap(m_ringBase, m_ringSize);
+        m_ringBase = nullptr;
+        m_ringSize = 0;
+    }
+}
+
+bool DataReader::ensureOpen()
+{
     if (fd == -1) { // 尝试打开设备，如果尚未打开
         qDebug("FPGA Driver open:Start");
         if (!openDevice()) {
@@ -57,65 +145,168 @@ bool DataReader::readDeviceData(QVector<double>& timeKeys,
         }
         qDebug("FPGA Driver open:Successful");
     }
-    std::vector<char> read_buffer_vec(BUFFER_SIZE_CALC); // 使用 std::vector
-    ssize_t bytes_read;
-    qDebug("Data Read:Start");
-    bytes_read = read(fd, read_buffer_vec.data(), BUFFER_SIZE_CALC);
+    return true;
+}
 
-    if (bytes_read == -1) {
-        qDebug("Failed to read from device");
-        // closeDevice(); // 可选：是否在此处关闭
-        return false;
+/**
+ * @brief 映射模式下返回环中已就绪的帧数，没有时用 poll() 休眠等待，超时或被信号打断返回 0
+ * 驱动解除绑定后 poll() 立即返回 POLLERR | POLLHUP，此时返回 READ_DEVICE_LOST，不能再当作超时重试
+ */
+int DataReader::waitRingFrames()
+{
+    fpga_ring_ctrl* ctrl = reinterpret_cast<fpga_ring_ctrl*>(m_ringBase);
+    quint32 tail = ctrl->tail; // tail 只由本进程写入
+    quint32 ready = __atomic_load_n(&ctrl->head, __ATOMIC_ACQUIRE) - tail;
+    if (ready == 0) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, m_pollTimeoutMs);
+        if (ret == -1 && errno != EINTR) {
+            const int error = errno;
+            qDebug("Failed to poll device: %s", strerror(error));
+            if (error == ENODEV) {
+                return READ_DEVICE_LOST;
+            }
+        }
+        ready = __atomic_load_n(&ctrl->head, __ATOMIC_ACQUIRE) - tail;
+        if (ready == 0 && ret > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+            qDebug("Device reported POLLERR/POLLHUP, treating it as lost");
+            return READ_DEVICE_LOST;
+        }
     }
+    return static_cast<int>(ready);
+}
 
-    if (bytes_read != BUFFER_SIZE_CALC) {
-        qDebug("Read data length (%zd) does not match expected size (%d).", bytes_read, BUFFER_SIZE_CALC);
-        return false;
+const char* DataReader::ringSlot(quint32 index) const
+{
+    return m_ringBase + m_ringDataOffset + static_cast<size_t>(index & (m_ringSlotCount - 1)) * m_ringSlotSize;
+}
+
+/**
+ * @brief 读取一帧并解析到 AdcFrame，供采集线程循环调用
+ */
+bool DataReader::readFrame(AdcFrame& frame)
+{
+    return readFrames(&frame, 1) == 1;
+}
+
+/**
+ * @brief 一次读取并解析多帧，返回实际解析的帧数(0 表示超时或可重试的失败，READ_DEVICE_LOST 表示设备已失效)
+ * 映射模式: 环中所有已就绪的帧(最多 maxFrames)直接在映射区解析，一次性归还;
+ * 批量 read(): 一次系统调用取回最多 maxFrames 帧，每帧带驱动帧头;
+ * 旧驱动: 每次只读一帧.
+ * 帧序号和时间戳取自驱动帧头(流水模式下序号即 FPGA 帧计数，跳变表示丢帧);
+ * 旧驱动时使用本地递增序号和读取完成时刻.
+ */
+int DataReader::readFrames(AdcFrame* frames, int maxFrames)
+{
+    if (maxFrames <= 0 || !ensureOpen()) {
+        return 0;
+    }
+
+    if (m_ringBase) {
+        const int ready = waitRingFrames();
+        if (ready == READ_DEVICE_LOST) {
+            return READ_DEVICE_LOST;
+        }
+        int count = qMin(ready, maxFrames);
+        fpga_ring_ctrl* ctrl = reinterpret_cast<fpga_ring_ctrl*>(m_ringBase);
+        quint32 tail = ctrl->tail;
+        for (int i = 0; i < count; ++i) {
+            const char* slot = ringSlot(tail + i);
+            const fpga_frame_hdr* hdr = reinterpret_cast<const fpga_frame_hdr*>(slot);
+            frames[i].sequence = hdr->seq;
+            frames[i].timestampNs = static_cast<qint64>(hdr->timestamp_ns);
+            decodeFrame(slot + m_ringPayloadOffset, frames[i]);
+        }
+        if (count > 0) {
+            __atomic_store_n(&ctrl->tail, tail + count, __ATOMIC_RELEASE);
+        }
+        return count;
     }
-    qDebug("Data Read:Successful");
-    timeKeys.resize(SAMPLES_PER_AXIS);
-    xValues.resize(SAMPLES_PER_AXIS);
-    yValues.resize(SAMPLES_PER_AXIS);
-    zValues.resize(SAMPLES_PER_AXIS);
-
-    double timeOffset = static_cast<double>(batchNumber * SAMPLES_PER_AXIS);
-
-    // 解析采样数据
-    // X轴数据: 0 to (ADC_BYTES_PER_AXIS - 1)
-    // Y轴数据: ADC_BYTES_PER_AXIS + DELIMITER_BYTES to (ADC_BYTES_PER_AXIS*2 + DELIMITER_BYTES - 1)
-    // Z轴数据: ADC_BYTES_PER_AXIS*2 + DELIMITER_BYTES*2 to (ADC_BYTES_PER_AXIS*3 + DELIMITER_BYTES*2 - 1)
-
-    const char* buffer_ptr = read_buffer_vec.data();
-
-    for (int i = 0; i < SAMPLES_PER_AXIS; ++i) {
-        timeKeys[i] = timeOffset + i; // 或者使用实际的时间戳
-
-        unsigned char x_byte1 = static_cast<unsigned char>(buffer_ptr[2 * i]);
-        unsigned char x_byte2 = static_cast<unsigned char>(buffer_ptr[2 * i + 1]);
-        xValues[i] = static_cast<double>(((x_byte1 << 2) | x_byte2))*10.0/1023.0 - 5.0;
-        // 此处通过观察数据，发现x轴在固定一些时刻出现了不正常的噪声数据，因此手动消除这些异常点.
-        if(i > 0)
-        {
-            if(abs(xValues[i] - xValues[i - 1])>=0.55) // 异常抖动
-            {
-                xValues[i] = xValues[i - 1];
+
+    if (m_batchRead) {
+        int wanted = qMin(maxFrames, MAX_BATCH_FRAMES);
+        ssize_t bytes_read = read(fd, m_readBuffer.data(), static_cast<size_t>(wanted) * FPGA_BATCH_RECORD_SIZE);
+        if (bytes_read <= 0) {
+            const int error = errno;
+            if (bytes_read == -1 && error != EINTR && error != EAGAIN) {
+                qDebug("Failed to read from device: %s", strerror(error));
+                if (error == ENODEV) {
+                    return READ_DEVICE_LOST;
+                }
             }
+            return 0;
+        }
+        int count = static_cast<int>(bytes_read / FPGA_BATCH_RECORD_SIZE);
+        for (int i = 0; i < count; ++i) {
+            const char* record = m_readBuffer.data() + static_cast<size_t>(i) * FPGA_BATCH_RECORD_SIZE;
+            const fpga_read_hdr* hdr = reinterpret_cast<const fpga_read_hdr*>(record);
+            frames[i].sequence = hdr->seq;
+            frames[i].timestampNs = static_cast<qint64>(hdr->timestamp_ns);
+            decodeFrame(record + sizeof(fpga_read_hdr), frames[i]);
         }
-        // Y-axis data
-        size_t y_offset = ADC_BYTES_PER_AXIS + DELIMITER_BYTES;
-        unsigned char y_byte1 = static_cast<unsigned char>(buffer_ptr[y_offset + 2 * i]);
-        unsigned char y_byte2 = static_cast<unsigned char>(buffer_ptr[y_offset + 2 * i + 1]);
-        yValues[i] = static_cast<double>(((y_byte1 << 2) | y_byte2))*10.0/1023.0 - 5.0;
-
-        // Z-axis data
-        size_t z_offset = ADC_BYTES_PER_AXIS * 2 + DELIMITER_BYTES * 2;
-        unsigned char z_byte1 = static_cast<unsigned char>(buffer_ptr[z_offset + 2 * i]);
-        unsigned char z_byte2 = static_cast<unsigned char>(buffer_ptr[z_offset + 2 * i + 1]);
-        zValues[i] = static_cast<double>(((z_byte1 << 2) | z_byte2))*10.0/1023.0 - 5.0;
-
-        // qDebug() << "Raw ADC:" << xValues[i] << yValues[i] << zValues[i];
-        // **重要**: 您可能需要将这些原始ADC值转换为实际的加速度单位 (e.g., g)
-        // 例如: xValues[i] = (xValues[i] - offset) * scale_factor;
+        return count;
     }
-    return true;
+
+    const char* buffer_ptr = readRawBuffer();
+    if (!buffer_ptr) {
+        return errno == ENODEV ? READ_DEVICE_LOST : 0;
+    }
+    frames[0].sequence = m_frameSequence;
+    frames[0].timestampNs = m_frameTimestampNs;
+    decodeFrame(buffer_ptr, frames[0]);
+    return 1;
+}
+
+/**
+ * @brief 用 read() 从设备读取一帧到 m_readBuffer，返回有效数据起始地址，失败返回 nullptr
+ * 批量格式下读取一条记录(帧头 + 有效数据)，否则读取一帧有效数据并使用本地序号和时间戳
+ */
+const char* DataReader::readRawBuffer()
+{
+    // --- 实际的 Linux 设备读取逻辑 ---
+    const size_t expected = m_batchRead ? FPGA_BATCH_RECORD_SIZE : BUFFER_SIZE_CALC;
+    ssize_t bytes_read = read(fd, m_readBuffer.data(), expected);
+
+    if (bytes_read == -1) {
+        const int error = errno;
+        qDebug("Failed to read from device: %s", strerror(error));
+        errno = error; // 保留给调用者区分 ENODEV
+        return nullptr;
+    }
+
+    if (static_cast<size_t>(bytes_read) != expected) {
+        errno = 0;
+        qDebug("Read data length (%zd) does not match expected size (%zu).", bytes_read, expected);
+        return nullptr;
+    }
+    if (m_batchRead) {
+        const fpga_read_hdr* hdr = reinterpret_cast<const fpga_read_hdr*>(m_readBuffer.data());
+        m_frameSequence = hdr->seq;
+        m_frameTimestampNs = static_cast<qint64>(hdr->timestamp_ns);
+        return m_readBuffer.data() + sizeof(fpga_read_hdr);
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    m_frameSequence = m_localSequence++;
+    m_frameTimestampNs = static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    return m_readBuffer.data();
+}
+
+/**
+ * @brief 解析一帧原始字节为三轴数据(默认单位 V，可通过 decoder() 设置标定换算为 g)
+ * X轴数据: 0 to (ADC_BYTES_PER_AXIS - 1)
+ * Y轴数据: ADC_BYTES_PER_AXIS + DELIMITER_BYTES to (ADC_BYTES_PER_AXIS*2 + DELIMITER_BYTES - 1)
+ * Z轴数据: ADC_BYTES_PER_AXIS*2 + DELIMITER_BYTES*2 to (ADC_BYTES_PER_AXIS*3 + DELIMITER_BYTES*2 - 1)
+ */
+void DataReader::decodeFrame(const char* buffer_ptr, AdcFrame& frame)
+{
+    m_decoder->decode(buffer_ptr, frame.x, frame.y, frame.z);
+    // * 三轴均做脉冲抑制(取代原先只针对X轴、与前一点比较 0.55V 的处理)
+    frame.rejected[0] = static_cast<quint16>(m_spikeFilter->apply(0, frame.x));
+    frame.rejected[1] = static_cast<quint16>(m_spikeFilter->apply(1, frame.y));
+    frame.rejected[2] = static_cast<quint16>(m_spikeFilter->apply(2, frame.z));
 }
@@ -4,14 +4,23 @@
 #include <QObject>
 #include <QVector>
 #include <QString>
+#include <memory>
+#include <vector>
 
-#define DEVICE_NAME "/dev/FPGA_SPI_dev" // 仅在目标Linux系统上有效
+#define DEVICE_NAME "/dev/FPGA_SPI_dev0" // 默认设备(第一块采集板)，仅在目标Linux系统上有效
 #define ADC_BYTES_PER_AXIS 2048         // 每个轴的原始字节数
 #define SAMPLES_PER_AXIS (ADC_BYTES_PER_AXIS / 2) // 每个轴的采样点数 (1024)
 #define NUM_AXES 3                      //三轴数据
 #define DELIMITER_BYTES 2               // 每个分隔符的字节数
 // 计算总缓冲区大小
 #define BUFFER_SIZE_CALC (ADC_BYTES_PER_AXIS * NUM_AXES + DELIMITER_BYTES * (NUM_AXES - 1))
+#define SAMPLE_RATE_HZ 10000            // FPGA默认采样率(div_cfg = 500)
+#define MAX_BATCH_FRAMES 16             // readFrames() 单次系统调用最多读取的帧数(与驱动环的槽数一致)
+#define READ_DEVICE_LOST (-1)           // readFrames() 返回值: 设备已失效(解除绑定、驱动标记 dead)，须关闭后重新打开
+
+struct AdcFrame;
+class AdcDecoder;
+class SpikeFilter;
 
 class DataReader : public QObject
 {
@@ -20,19 +29,59 @@ public:
     explicit DataReader(QObject *parent = nullptr);
     ~DataReader();
     int fd = -1; // 文件描述符
+    // 设置设备节点(/dev/FPGA_SPI_devN)，下次 openDevice() 时生效
+    void setDevicePath(const QString& path) { m_devicePath = path; }
+    QString devicePath() const { return m_devicePath; }
     bool openDevice();
     void closeDevice();
-    // 这个函数将执行实际的读取和解析
-    // 返回值: true 表示成功, false 表示失败
-    // 输出参数: timeKeys, xValues, yValues, zValues 将被填充
-    bool readDeviceData(QVector<double>& timeKeys,
-                        QVector<double>& xValues,
-                        QVector<double>& yValues,
-                        QVector<double>& zValues,
-                        int batchNumber); // batchNumber 用于生成时间戳
+    // 读取一帧并解析到 frame 的三轴数组中，不做任何内存分配，供采集线程使用
+    bool readFrame(AdcFrame& frame);
+    // 一次读取并解析最多 maxFrames 帧，返回实际帧数; 积压的帧在一次调用中全部取回
+    // 超时或可重试的错误返回 0，poll() 报告 POLLERR/POLLHUP 或读取返回 ENODEV 时返回 READ_DEVICE_LOST
+    int readFrames(AdcFrame* frames, int maxFrames);
+    // 是否正在使用驱动的 mmap 环形缓冲区(否则退回 read() 拷贝方式)
+    // 映射模式下驱动自行连续采样，readFrame() 会阻塞到新帧就绪，调用者无需再定时
+    bool isRingMapped() const { return m_ringBase != nullptr; }
+    // 读取是否由驱动阻塞到新帧就绪(映射模式或批量 read())
+    bool isDriverPaced() const { return m_ringBase != nullptr || m_batchRead; }
+    // 映射模式下等待新帧的最长时间(ms)，超时 readFrame() 返回 false
+    void setPollTimeoutMs(int timeoutMs) { m_pollTimeoutMs = timeoutMs; }
+    // 解码器(标定表、向量化路径)，须在采集线程启动前配置
+    AdcDecoder& decoder() { return *m_decoder; }
+    // 脉冲抑制(Hampel)参数，须在采集线程启动前配置
+    SpikeFilter& spikeFilter() { return *m_spikeFilter; }
+    // 锁定(mlock)读取、解码和脉冲抑制用到的缓冲区，失败时仅告警; 由采集线程在开始读取前调用
+    void lockBuffers();
+    // 各轴最小判定偏差取该轴 codes 个 ADC 量化间隔(默认 4)，打开设备时按当前标定换算; <= 0 时使用 spikeFilter() 中手动设置的值
+    void setSpikeMinDeviationCodes(float codes) { m_spikeMinCodes = codes; updateSpikeThresholds(); }
+    float spikeMinDeviationCodes() const { return m_spikeMinCodes; }
 
 private:
+    bool mapRing();       // 查询环布局并映射，旧驱动不支持时返回 false
+    void unmapRing();
+    bool ensureOpen();
+    int waitRingFrames();       // 映射模式下等待并返回已就绪的帧数，设备失效时返回 READ_DEVICE_LOST
+    const char* ringSlot(quint32 index) const;
+    const char* readRawBuffer(); // 用 read() 读取一帧到 m_readBuffer，返回有效数据起始地址
+    void decodeFrame(const char* buffer_ptr, AdcFrame& frame);
+    void updateSpikeThresholds();
 
+    QString m_devicePath = QStringLiteral(DEVICE_NAME);
+    std::vector<char> m_readBuffer; // 读取缓冲区，构造时一次性分配
+    std::unique_ptr<AdcDecoder> m_decoder;
+    std::unique_ptr<SpikeFilter> m_spikeFilter;
+    char* m_ringBase = nullptr;     // mmap 映射起始地址
+    size_t m_ringSize = 0;
+    quint32 m_ringSlotCount = 0;
+    quint32 m_ringSlotSize = 0;
+    quint32 m_ringDataOffset = 0;
+    quint32 m_ringPayloadOffset = 0;
+    bool m_batchRead = false;       // 未映射时是否使用批量 read() 格式
+    quint64 m_frameSequence = 0;    // readRawBuffer() 读取的帧的序号与时间戳
+    qint64 m_frameTimestampNs = 0;
+    quint64 m_localSequence = 0;
+    int m_pollTimeoutMs = 500;
+    float m_spikeMinCodes = 4.0f;   // 平稳信号上的量化噪声不会被当作脉冲
 };
 
 #endif // DATAREADER_H
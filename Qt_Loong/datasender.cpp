@@ -2,6 +2,7 @@
 #include <QDataStream>
 #include <QThread>
 #include <QHostAddress>
+#include "adccodec.h"
 DataSender::DataSender(QObject *parent)
     : QObject(parent), m_clientSocket(nullptr)
 {
@@ -11,6 +12,20 @@ DataSender::~DataSender()
 {
 }
 
+void DataSender::setCalibration(const AdcDecoder& decoder)
+{
+    m_linear = decoder.isLinear();
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        m_scale[axis] = decoder.scale(axis);
+        m_offset[axis] = decoder.offset(axis);
+    }
+}
+
+void DataSender::setSmoothWindow(int windowSize)
+{
+    m_smooth.setWindowSize(windowSize);
+}
+
 void DataSender::setSocket(QTcpSocket* socket)
 {
     m_clientSocket = socket;
@@ -95,6 +110,78 @@ void DataSender::sendData(const QVector<double>& xData, const QVector<double>& y
     }
 }
 
+/**
+ * @brief (封包版) 将三轴原始数据压缩后封包发送，客户端按 value = code * scale + offset 还原，与采集值逐点相同，
+ *        再按包内的滑动平均窗口滤波，得到与 ThreeAxisData 相同的绘图数据.
+ *        数据体: [点数(4B)] [滤波窗口(4B)] 之后每轴 [scale(8B)] [offset(8B)] [压缩长度(4B)] [AdcCodec 码流]
+ *        Wi-Fi 带宽紧张时使用; 标定为非线性时无法换算回码值，在本端滤波后按 ThreeAxisData 发送.
+ * @param xData X轴原始数据(AdcDecoder 输出)
+ * @param yData Y轴原始数据
+ * @param zData Z轴原始数据
+ */
+void DataSender::sendCompressedData(const QVector<double>& xData, const QVector<double>& yData, const QVector<double>& zData)
+{
+    if (!m_clientSocket || m_clientSocket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    if (!m_linear) {
+        QVector<double> x = xData, y = yData, z = zData;
+        if (x.size() == y.size() && x.size() == z.size()) {
+            m_smooth.apply(x.data(), y.data(), z.data(), x.size());
+        }
+        sendData(x, y, z);
+        return;
+    }
+    const quint32 pointCount = static_cast<quint32>(xData.size());
+    if (pointCount == 0 || xData.size() != yData.size() || xData.size() != zData.size()) {
+        emit dataSentStatus("错误: 数据为空或三轴数据长度不一致。");
+        return;
+    }
+
+    // --- 1. 准备数据体 (Payload) ---
+    QByteArray payloadBlock;
+    QDataStream payloadStream(&payloadBlock, QIODevice::WriteOnly);
+    payloadStream.setVersion(QDataStream::Qt_5_12);
+    payloadStream.setByteOrder(QDataStream::BigEndian);
+    payloadStream << pointCount << static_cast<quint32>(m_smooth.windowSize());
+    const QVector<double>* const axes[NUM_AXES] = { &xData, &yData, &zData };
+    m_codes.resize(static_cast<int>(pointCount));
+    m_encoded.resize(AdcCodec::maxEncodedSize(static_cast<int>(pointCount)));
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        const QVector<double>& src = *axes[axis];
+        for (quint32 i = 0; i < pointCount; ++i) {
+            m_codes[i] = AdcDecoder::toRaw(static_cast<float>(src[i]), m_scale[axis], m_offset[axis]);
+        }
+        const int bytes = AdcCodec::encode(m_codes.constData(), static_cast<int>(pointCount), m_encoded.data());
+        payloadStream << static_cast<double>(m_scale[axis]) << static_cast<double>(m_offset[axis])
+                      << static_cast<quint32>(bytes);
+        payloadStream.writeRawData(m_encoded.constData(), bytes);
+    }
+
+    // --- 2. 组装完整的数据包 ---
+    QByteArray finalPacket;
+    QDataStream packetStream(&finalPacket, QIODevice::WriteOnly);
+    packetStream.setVersion(QDataStream::Qt_5_12);
+    packetStream.setByteOrder(QDataStream::BigEndian);
+    packetStream << Protocol::HEADER_MAGIC;
+    packetStream << static_cast<quint16>(Protocol::CompressedThreeAxisData);
+    packetStream << static_cast<quint32>(payloadBlock.size());
+    finalPacket.append(payloadBlock);
+
+    // --- 3. 发送数据包 ---
+    qint64 bytesWritten = m_clientSocket->write(finalPacket);
+    if (bytesWritten == finalPacket.size()) {
+        qDebug() << "DataSender (thread" << QThread::currentThreadId() << "): 成功发送压缩三轴数据"
+                 << pointCount << "个点, 共" << finalPacket.size() << "字节";
+    } else if (bytesWritten == -1) {
+        emit dataSentStatus(QString("错误: 数据发送失败 - %1").arg(m_clientSocket->errorString()));
+        qDebug() << "DataSender send error:" << m_clientSocket->errorString();
+    } else {
+        emit dataSentStatus(QString("错误: 数据发送不完整 (%1 / %2 字节)").arg(bytesWritten).arg(finalPacket.size()));
+        qDebug() << "DataSender send incomplete.";
+    }
+}
+
 /**
  * @brief (封包版) 将模型的输出结果（类别名和置信度）进行封包后发送。
  *        数据包结构: [包头(4B)] [类型(2B)] [长度(4B)] [数据体(...B)]
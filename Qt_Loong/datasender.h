@@ -5,6 +5,8 @@
 #include <QVector>
 #include <QTcpSocket>
 #include <QtGlobal>
+#include "adcdecoder.h"
+#include "movingaverage.h"
 
 namespace Protocol {
 // 包头魔术数字，选择一个不容易在随机数据中出现的值
@@ -14,7 +16,8 @@ const quint32 HEADER_MAGIC = 0xAA55AA55;
 enum DataType : quint16 {
     ThreeAxisData = 0x0001, // 三轴加速度数据
     ModelOut = 0x0002,
-    State = 0x0003
+    State = 0x0003,
+    CompressedThreeAxisData = 0x0004 // 三轴 10 位码值，AdcCodec 无损压缩; 为滤波前的原始数据，客户端按包内窗口做滑动平均后与 ThreeAxisData 一致
     // ... 其他数据类型
 };
 }
@@ -27,9 +30,16 @@ public:
     explicit DataSender(QObject *parent = nullptr);
     ~DataSender();
 
+    // * 压缩传输使用的标定(须在移入发送线程之前调用); 非线性标定时 sendCompressedData 退回 sendData
+    void setCalibration(const AdcDecoder& decoder);
+    // * 板端绘图使用的滑动平均窗口，随压缩数据发给客户端(须在移入发送线程之前调用)
+    void setSmoothWindow(int windowSize);
+
 public slots:
     // 从主线程接收数据并开始发送
     void sendData(const QVector<double>& xData, const QVector<double>& yData, const QVector<double>& zData);
+    // 原始数据按标定换算回 10 位码值，经 AdcCodec 压缩后发送(约为 sendData 的 1/10); 滤波由客户端完成
+    void sendCompressedData(const QVector<double>& xData, const QVector<double>& yData, const QVector<double>& zData);
     void sendModelOutput(const QString& className, double confidence);
     void sendState(const QString& state);
     // 从主线程接收一个新的、已连接的socket
@@ -44,6 +54,12 @@ signals:
 
 private:
     QTcpSocket* m_clientSocket; // 指向由主线程创建和管理的socket
+    bool m_linear = false;
+    float m_scale[NUM_AXES] = {};
+    float m_offset[NUM_AXES] = {};
+    QVector<quint16> m_codes;   // 复用的码值缓冲区
+    QByteArray m_encoded;       // 复用的压缩缓冲区
+    MovingAverageFilter m_smooth; // 与板端绘图相同的滤波，非线性标定退回 sendData 时使用
 };
 
 #endif // DATASENDER_H
@@ -0,0 +1,188 @@
+#include "enginecheck.h"
+#include "mfccengine.h"
+#include "resnetengine.h"
+#include "replayloader.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <vector>
+
+namespace {
+const int kWindowFloats = NUM_AXES * SAMPLES_PER_AXIS;
+
+struct Options {
+    QString dataPath;
+    QString outputPath;
+    QString weightsPath;
+    int maxWindows = 1000;
+    int repeat = 3;
+};
+
+bool parseOptions(const QStringList& arguments, Options& options, QString& error)
+{
+    // arguments[0] 为程序名，arguments[1] 为 EngineCheck::OPTION
+    QStringList positional;
+    for (int i = 2; i < arguments.size(); ++i) {
+        const QString& arg = arguments[i];
+        if (arg == "--weights") {
+            if (i + 1 >= arguments.size()) {
+                error = QString("%1 需要参数").arg(arg);
+                return false;
+            }
+            options.weightsPath = arguments[++i];
+        } else if (arg == "--windows" || arg == "--repeat") {
+            if (i + 1 >= arguments.size()) {
+                error = QString("%1 需要参数").arg(arg);
+                return false;
+            }
+            bool ok = false;
+            const int value = arguments[++i].toInt(&ok);
+            if (!ok || value <= 0) {
+                error = QString("%1 的参数无效: %2").arg(arg, arguments[i]);
+                return false;
+            }
+            (arg == "--windows" ? options.maxWindows : options.repeat) = value;
+        } else {
+            positional << arg;
+        }
+    }
+    if (positional.size() != 2) {
+        error = QString("用法: %1 <数据.rec|.csv> <结果文件> [--weights <resnet_weights.bin>] [--windows N] [--repeat R]")
+                    .arg(QString::fromLatin1(EngineCheck::OPTION));
+        return false;
+    }
+    options.dataPath = positional[0];
+    options.outputPath = positional[1];
+    return true;
+}
+
+// * 对 count 个窗口各调用一次 fn(窗口序号)，重复 repeat 遍，返回每个窗口的平均耗时(us)
+template <typename Fn>
+double timeWindows(int count, int repeat, Fn fn)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < repeat; ++r) {
+        for (int i = 0; i < count; ++i) {
+            fn(i);
+        }
+    }
+    return timer.nsecsElapsed() / 1000.0 / (double(count) * repeat);
+}
+
+void printTiming(QTextStream& out, const char* stage, double us)
+{
+    out << QString("%1: %2 us/窗口 (%3 窗口/s, 单线程)")
+               .arg(QString::fromLatin1(stage), -12)
+               .arg(us, 0, 'f', 1)
+               .arg(us > 0 ? 1e6 / us : 0.0, 0, 'f', 0)
+           << "\n";
+}
+
+bool writeValue(QFile& file, quint32 value)
+{
+    const char bytes[4] = { char(value), char(value >> 8), char(value >> 16), char(value >> 24) };
+    return file.write(bytes, sizeof(bytes)) == sizeof(bytes);
+}
+}
+
+int runEngineCheck(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    Options options;
+    QString error;
+    if (!parseOptions(arguments, options, error)) {
+        err << error << "\n";
+        return 2;
+    }
+
+    // * 读取数据: 第 i 个窗口为第 i*1024 ~ (i+1)*1024-1 点，按 [3][1024] 存放
+    ReplayLoader loader;
+    if (!loader.open(options.dataPath)) {
+        err << "无法打开数据文件 " << options.dataPath << ": " << loader.errorString() << "\n";
+        return 1;
+    }
+    const int windows = static_cast<int>(qMin<qint64>(options.maxWindows, loader.sampleCount() / SAMPLES_PER_AXIS));
+    if (windows <= 0) {
+        err << "数据文件 " << options.dataPath << " 不足一个窗口(" << SAMPLES_PER_AXIS << " 点)" << "\n";
+        return 1;
+    }
+    std::vector<float> samples(static_cast<size_t>(windows) * kWindowFloats);
+    for (int i = 0; i < windows; ++i) {
+        float* x = samples.data() + static_cast<size_t>(i) * kWindowFloats;
+        if (loader.read(qint64(i) * SAMPLES_PER_AXIS, SAMPLES_PER_AXIS, x, x + SAMPLES_PER_AXIS,
+                        x + 2 * SAMPLES_PER_AXIS) != SAMPLES_PER_AXIS) {
+            err << "读取第 " << i << " 个窗口失败: " << loader.errorString() << "\n";
+            return 1;
+        }
+    }
+    out << "数据: " << options.dataPath << ", " << windows << " 个窗口" << "\n";
+
+    // * MFCC 特征，三个轴依次计算，与 MfccEngine::computeFrame 相同
+    MfccEngine mfcc;
+    std::vector<float> features(static_cast<size_t>(windows) * MFCC_TENSOR_SIZE);
+    const int axisFeatures = MFCC_NUM_FRAMES * MFCC_NUM_CEP;
+    const double mfccUs = timeWindows(windows, options.repeat, [&](int i) {
+        const float* x = samples.data() + static_cast<size_t>(i) * kWindowFloats;
+        float* f = features.data() + static_cast<size_t>(i) * MFCC_TENSOR_SIZE;
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            mfcc.compute(x + axis * SAMPLES_PER_AXIS, f + axis * axisFeatures);
+        }
+    });
+    printTiming(out, "MFCC", mfccUs);
+
+    // * 网络 logits(指定权重文件时)，输入为上面的 C++ 特征; 权重带量化系数时 float 和 int8 路径各算一遍
+    quint32 sections = 0;
+    std::vector<float> floatLogits;
+    std::vector<float> int8Logits;
+    if (!options.weightsPath.isEmpty()) {
+        ResNetEngine engine;
+        if (!engine.load(options.weightsPath)) {
+            err << "无法加载权重文件 " << options.weightsPath << ": " << engine.errorString() << "\n";
+            return 1;
+        }
+        floatLogits.resize(static_cast<size_t>(windows) * RESNET_NUM_CLASSES);
+        const double floatUs = timeWindows(windows, options.repeat, [&](int i) {
+            engine.forward(features.data() + static_cast<size_t>(i) * MFCC_TENSOR_SIZE,
+                           floatLogits.data() + static_cast<size_t>(i) * RESNET_NUM_CLASSES);
+        });
+        printTiming(out, "ResNet", floatUs);
+        printTiming(out, "MFCC+ResNet", mfccUs + floatUs);
+        sections |= EngineCheck::SectionFloatLogits;
+
+        if (engine.setInt8(true)) {
+            int8Logits.resize(floatLogits.size());
+            const double int8Us = timeWindows(windows, options.repeat, [&](int i) {
+                engine.forward(features.data() + static_cast<size_t>(i) * MFCC_TENSOR_SIZE,
+                               int8Logits.data() + static_cast<size_t>(i) * RESNET_NUM_CLASSES);
+            });
+            printTiming(out, "ResNet int8", int8Us);
+            printTiming(out, "MFCC+int8", mfccUs + int8Us);
+            out << QString("int8/float: %1").arg(floatUs > 0 ? int8Us / floatUs : 0.0, 0, 'f', 2) << "\n";
+            sections |= EngineCheck::SectionInt8Logits;
+        } else {
+            out << "权重文件不带 int8 量化系数(quantize_model.py)，跳过 int8 路径" << "\n";
+        }
+    }
+
+    QFile file(options.outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << "无法写入结果文件 " << options.outputPath << ": " << file.errorString() << "\n";
+        return 1;
+    }
+    // 目标平台(龙芯/x86)均为小端，float 数组直接写出
+    bool ok = file.write(EngineCheck::MAGIC, sizeof(EngineCheck::MAGIC)) == sizeof(EngineCheck::MAGIC)
+              && writeValue(file, EngineCheck::VERSION) && writeValue(file, windows) && writeValue(file, sections);
+    const qint64 featureBytes = qint64(features.size()) * sizeof(float);
+    ok = ok && file.write(reinterpret_cast<const char*>(features.data()), featureBytes) == featureBytes;
+    for (const std::vector<float>* logits : { &floatLogits, &int8Logits }) {
+        const qint64 logitBytes = qint64(logits->size()) * sizeof(float);
+        ok = ok && file.write(reinterpret_cast<const char*>(logits->data()), logitBytes) == logitBytes;
+    }
+    if (!ok) {
+        err << "写入结果文件 " << options.outputPath << " 失败: " << file.errorString() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef ENGINECHECK_H
+#define ENGINECHECK_H
+
+#include <QStringList>
+#include <QtGlobal>
+
+namespace EngineCheck {
+// 与 Python/run_on_loong/check_engine.py 中的定义保持一致，数据均为小端
+const char MAGIC[8] = { 'L', 'S', 'E', 'N', 'G', 'C', 'H', 'K' };
+const quint32 VERSION = 1;
+const char OPTION[] = "--engine-check"; // 命令行第一个参数为该选项时不启动界面
+
+// 结果文件中 MFCC 特征之后依次出现的段
+enum Sections : quint32 {
+    SectionFloatLogits = 0x0001, // ResNetEngine float 路径的 logits [N][13]
+    SectionInt8Logits = 0x0002   // ResNetEngine int8 路径的 logits [N][13]
+};
+}
+
+/**
+ * @brief 命令行模式 LoongQt --engine-check，不创建界面，也不打开采集设备:
+ * 读取录制文件(.rec)或 CSV 中连续、不重叠的 1024 点窗口(与 quantize_model.py 的样本划分一致)，
+ * 用界面中推理时相同的 C++ 代码(MfccEngine、ResNetEngine)计算特征和 logits(权重带量化系数时另算 int8 路径)，
+ * 写入结果文件，并在标准输出打印每个窗口各阶段的平均耗时(目标板上即为 float 与 int8 的实测对比). check_engine.py 调用本模式，再与 pure_python_mfcc.MFCC
+ * 和 PyTorch 模型(best_model.pth)逐项比较.
+ * 用法: LoongQt --engine-check <数据.rec|.csv> <结果文件> [--weights <resnet_weights.bin>] [--windows N] [--repeat R]
+ * 结果文件: magic[8] | u32 version | u32 窗口数 | u32 段标志(EngineCheck::Sections) | f32 特征[N][3][9][13] | 各段
+ * @return 进程退出码，0 为成功
+ */
+int runEngineCheck(const QStringList& arguments);
+
+#endif // ENGINECHECK_H
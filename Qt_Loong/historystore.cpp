@@ -0,0 +1,517 @@
+#include "historystore.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const char* const TOMBSTONE_FILE = "deleted.log";
+
+// 同一分段中的块须使用相同的格式和标定
+bool sameLayout(const Record::FileHeader& a, const Record::FileHeader& b)
+{
+    return a.format == b.format && a.axes == b.axes && a.sampleRate == b.sampleRate
+            && a.samplesPerBlock == b.samplesPerBlock
+            && memcmp(a.scale, b.scale, sizeof(a.scale)) == 0 && memcmp(a.offset, b.offset, sizeof(a.offset)) == 0;
+}
+}
+
+HistoryStore::HistoryStore()
+{
+}
+
+HistoryStore::~HistoryStore()
+{
+    close();
+}
+
+void HistoryStore::setSegmentLimits(qint64 maxBytes, qint64 maxSpanMs)
+{
+    m_segmentBytes = qMax<qint64>(Record::FILE_HEADER_SIZE * 2, maxBytes);
+    m_segmentSpanMs = qMax<qint64>(1, maxSpanMs);
+}
+
+void HistoryStore::setRetention(qint64 maxBytes, qint64 maxAgeMs)
+{
+    m_retentionBytes = qMax<qint64>(0, maxBytes);
+    m_retentionAgeMs = qMax<qint64>(0, maxAgeMs);
+}
+
+QString HistoryStore::segmentPath(qint64 startTimeMs) const
+{
+    // 固定 13 位，文件名顺序即时间顺序
+    return QString("%1/seg_%2.rec").arg(m_dir).arg(startTimeMs, 13, 10, QChar('0'));
+}
+
+QString HistoryStore::indexPath(const QString& segmentPath)
+{
+    return segmentPath.left(segmentPath.size() - 4) + ".idx";
+}
+
+/**
+ * @brief 打开存储目录: 列出一次已有分段，加载文件头和稀疏索引; 最新一段按块头重建索引并截掉不完整的块
+ */
+bool HistoryStore::open(const QString& dir)
+{
+    close();
+    m_error.clear();
+    QDir storeDir(dir);
+    if (!storeDir.exists() && !storeDir.mkpath(".")) {
+        m_error = QString("cannot create %1").arg(dir);
+        return false;
+    }
+    m_dir = storeDir.absolutePath();
+
+    const QStringList names = storeDir.entryList(QStringList() << "seg_*.rec", QDir::Files, QDir::Name);
+    for (const QString& name : names) {
+        Segment segment;
+        if (!loadSegment(storeDir.filePath(name), segment)) {
+            qWarning() << "HistoryStore: Skipping unreadable segment" << name << m_error;
+            continue;
+        }
+        m_segments.append(segment);
+        m_totalBytes += segment.bytes;
+    }
+    // * 最新一段可能在写入中断时留下不完整的块; 没有完整块的分段直接删除
+    while (!m_segments.isEmpty()) {
+        Segment& last = m_segments.last();
+        m_totalBytes -= last.bytes;
+        if (rebuildIndex(last, &m_lastTimeMs) && !last.index.isEmpty()) {
+            m_totalBytes += last.bytes;
+            break;
+        }
+        qWarning() << "HistoryStore: Removing empty segment" << last.path;
+        removeSegmentFiles(last);
+        m_segments.removeLast();
+    }
+    loadTombstones();
+    qDebug() << "HistoryStore: Opened" << m_dir << "with" << m_segments.size() << "segments," << m_totalBytes << "bytes";
+    return true;
+}
+
+void HistoryStore::close()
+{
+    m_writer.close();
+    m_indexFile.close();
+    m_reader.close();
+    m_tombstones.close();
+    m_segments.clear();
+    m_deleted.clear();
+    m_dir.clear();
+    m_lastTimeMs = 0;
+    m_totalBytes = 0;
+}
+
+/**
+ * @brief 读取分段文件头和 .idx; 索引缺失或损坏时按块头重建
+ */
+bool HistoryStore::loadSegment(const QString& path, Segment& segment)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = file.errorString();
+        return false;
+    }
+    QByteArray raw = file.read(Record::FILE_HEADER_SIZE);
+    if (!RecordReader::parseHeader(raw.constData(), raw.size(), segment.header, &m_error)) {
+        return false;
+    }
+    segment.path = path;
+    segment.startTimeMs = segment.header.startTimeMs;
+    segment.bytes = file.size();
+    file.close();
+
+    QFile indexFile(indexPath(path));
+    if (indexFile.open(QIODevice::ReadOnly)) {
+        QByteArray data = indexFile.readAll();
+        const int count = data.size() / History::INDEX_ENTRY_SIZE;
+        segment.index.resize(count);
+        memcpy(segment.index.data(), data.constData(), static_cast<size_t>(count) * History::INDEX_ENTRY_SIZE);
+        bool valid = count > 0 && data.size() % History::INDEX_ENTRY_SIZE == 0;
+        for (int i = 0; valid && i < count; ++i) {
+            const History::IndexEntry& entry = segment.index[i];
+            valid = entry.block == static_cast<quint32>(i * History::INDEX_INTERVAL) && entry.offset < segment.bytes
+                    && (i == 0 || entry.timeMs > segment.index[i - 1].timeMs);
+        }
+        if (valid) {
+            return true;
+        }
+    }
+    qWarning() << "HistoryStore: Rebuilding index of" << path;
+    return rebuildIndex(segment, nullptr);
+}
+
+/**
+ * @brief 按块头重建分段的稀疏索引并重写 .idx，截掉末尾不完整的块
+ * @param lastTimeMs 非空时返回最后一块的时刻
+ */
+bool HistoryStore::rebuildIndex(Segment& segment, qint64* lastTimeMs)
+{
+    QFile file(segment.path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        m_error = file.errorString();
+        return false;
+    }
+    QVector<qint64> offsets;
+    const qint64 end = RecordReader::scanBlocks(file, segment.header, &offsets);
+    if (end < file.size()) {
+        qWarning() << "HistoryStore: Truncating partial block at end of" << segment.path;
+        file.resize(end);
+    }
+    segment.bytes = end;
+    segment.index.clear();
+    Record::BlockHeader bh;
+    for (int i = 0; i < offsets.size(); ++i) {
+        const bool indexed = i % History::INDEX_INTERVAL == 0;
+        if (!indexed && i != offsets.size() - 1) {
+            continue;
+        }
+        if (!file.seek(offsets[i]) || file.read(reinterpret_cast<char*>(&bh), sizeof(bh)) != sizeof(bh)) {
+            m_error = file.errorString();
+            return false;
+        }
+        if (indexed) {
+            segment.index.append(History::IndexEntry{ bh.timeMs, offsets[i], static_cast<quint32>(i), 0 });
+        }
+        if (lastTimeMs && i == offsets.size() - 1) {
+            *lastTimeMs = bh.timeMs;
+        }
+    }
+    file.close();
+
+    QFile indexFile(indexPath(segment.path));
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = indexFile.errorString();
+        return false;
+    }
+    const qint64 bytes = qint64(segment.index.size()) * History::INDEX_ENTRY_SIZE;
+    if (indexFile.write(reinterpret_cast<const char*>(segment.index.constData()), bytes) != bytes) {
+        m_error = indexFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 新开一个分段(当前分段写满、超过时间跨度或格式/标定变化时)
+ */
+bool HistoryStore::startSegment(const Record::FileHeader& header, qint64 timeMs)
+{
+    m_writer.close();
+    m_indexFile.close();
+    Segment segment;
+    segment.header = header;
+    segment.header.startTimeMs = timeMs;
+    segment.startTimeMs = timeMs;
+    segment.path = segmentPath(timeMs);
+    if (!m_writer.open(segment.path, segment.header, false)) {
+        m_error = m_writer.errorString();
+        return false;
+    }
+    m_indexFile.setFileName(indexPath(segment.path));
+    if (!m_indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = m_indexFile.errorString();
+        m_writer.close();
+        return false;
+    }
+    segment.header = m_writer.header();
+    segment.bytes = m_writer.size();
+    m_totalBytes += segment.bytes;
+    m_segments.append(segment);
+    return true;
+}
+
+/**
+ * @brief 打开启动时已存在的最新分段继续追加
+ */
+bool HistoryStore::openWriter(Segment& segment)
+{
+    if (!m_writer.open(segment.path, segment.header, true)) {
+        m_error = m_writer.errorString();
+        return false;
+    }
+    m_indexFile.setFileName(indexPath(segment.path));
+    if (!m_indexFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        m_error = m_indexFile.errorString();
+        m_writer.close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 追加一帧到当前分段，必要时新开分段，随后按淘汰条件删除最旧的分段; 不扫描目录
+ */
+bool HistoryStore::append(const Record::FileHeader& header, const double* x, const double* y, const double* z,
+                          int count, quint64 frameSequence, qint64 timeMs)
+{
+    if (!isOpen() || count <= 0 || count > static_cast<int>(header.samplesPerBlock)) {
+        return false;
+    }
+    if (timeMs <= m_lastTimeMs) {
+        qWarning() << "HistoryStore: Timestamp" << timeMs << "is not after the last entry" << m_lastTimeMs
+                   << ", using" << m_lastTimeMs + 1;
+        timeMs = m_lastTimeMs + 1;
+    }
+
+    bool roll = m_segments.isEmpty();
+    if (!roll) {
+        const Segment& current = m_segments.last();
+        roll = !sameLayout(current.header, header) || current.bytes + header.blockBytes() > m_segmentBytes
+                || timeMs - current.startTimeMs >= m_segmentSpanMs;
+    }
+    if (roll ? !startSegment(header, timeMs) : (!m_writer.isOpen() && !openWriter(m_segments.last()))) {
+        qWarning() << "HistoryStore: Cannot open segment for writing:" << m_error;
+        return false;
+    }
+
+    Segment& segment = m_segments.last();
+    const qint64 offset = m_writer.size();
+    const quint32 block = m_writer.blockCount();
+    if (!m_writer.appendBlock(x, y, z, count, frameSequence, timeMs) || !m_writer.flush()) {
+        m_error = m_writer.errorString();
+        m_writer.close(); // 不完整的块在下次打开时截掉
+        return false;
+    }
+    if (block % History::INDEX_INTERVAL == 0) {
+        const History::IndexEntry entry{ timeMs, offset, block, 0 };
+        segment.index.append(entry);
+        if (m_indexFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry)) != sizeof(entry)
+                || !m_indexFile.flush()) {
+            qWarning() << "HistoryStore: Index write failed, will rebuild on next open:" << m_indexFile.errorString();
+        }
+    }
+    m_totalBytes += m_writer.size() - segment.bytes;
+    segment.bytes = m_writer.size();
+    m_lastTimeMs = timeMs;
+    applyRetention(timeMs);
+    return true;
+}
+
+/**
+ * @brief 整段删除最旧的分段，直到总字节数和保存时间都满足要求; 正在写入的分段保留
+ *        按时间淘汰时，下一段的首块时刻已超出保存时间才删除该段(即该段全部数据都已过期)
+ */
+void HistoryStore::applyRetention(qint64 nowMs)
+{
+    while (m_segments.size() > 1) {
+        const bool overBytes = m_retentionBytes > 0 && m_totalBytes > m_retentionBytes;
+        const bool overAge = m_retentionAgeMs > 0 && m_segments[1].startTimeMs <= nowMs - m_retentionAgeMs;
+        if (!overBytes && !overAge) {
+            break;
+        }
+        const Segment oldest = m_segments.takeFirst();
+        m_totalBytes -= oldest.bytes;
+        if (!removeSegmentFiles(oldest)) {
+            qWarning() << "HistoryStore: Failed to remove expired segment" << oldest.path;
+        }
+    }
+}
+
+bool HistoryStore::removeSegmentFiles(const Segment& segment)
+{
+    if (m_reader.path() == segment.path) {
+        m_reader.close();
+    }
+    QFile::remove(indexPath(segment.path));
+    return QFile::remove(segment.path);
+}
+
+/**
+ * @brief 映射分段; 已映射的正在写入的分段在追加后重新映射
+ */
+bool HistoryStore::openForRead(const Segment& segment)
+{
+    const bool mapped = m_reader.isOpen() && m_reader.path() == segment.path;
+    if (mapped ? (m_reader.mappedBytes() >= segment.bytes || m_reader.refresh()) : m_reader.open(segment.path)) {
+        return true;
+    }
+    m_error = m_reader.errorString();
+    return false;
+}
+
+bool HistoryStore::readBlockHeader(qint64 offset, Record::BlockHeader& blockHeader)
+{
+    const char* p = m_reader.data(offset, sizeof(blockHeader));
+    if (!p) {
+        return false;
+    }
+    memcpy(&blockHeader, p, sizeof(blockHeader));
+    return blockHeader.magic == Record::BLOCK_MAGIC;
+}
+
+/**
+ * @brief 二分查找分段和分段内的稀疏索引，再从索引项起顺序读取块头(至多 INDEX_INTERVAL 个)
+ */
+bool HistoryStore::seek(qint64 timeMs, History::Location& location)
+{
+    auto segmentIt = std::upper_bound(m_segments.cbegin(), m_segments.cend(), timeMs,
+                                      [](qint64 t, const Segment& s) { return t < s.startTimeMs; });
+    for (int s = qMax(0, int(segmentIt - m_segments.cbegin()) - 1); s < m_segments.size(); ++s) {
+        const Segment& segment = m_segments[s];
+        auto indexIt = std::upper_bound(segment.index.cbegin(), segment.index.cend(), timeMs,
+                                        [](qint64 t, const History::IndexEntry& e) { return t < e.timeMs; });
+        const int i = qMax(0, int(indexIt - segment.index.cbegin()) - 1);
+        qint64 pos = segment.index.isEmpty() ? Record::FILE_HEADER_SIZE : segment.index[i].offset;
+        if (!openForRead(segment)) {
+            return false;
+        }
+        Record::BlockHeader bh;
+        while (pos < segment.bytes && readBlockHeader(pos, bh)) {
+            const qint64 bytes = RecordReader::blockBytes(segment.header, bh);
+            if (bytes < 0) {
+                break;
+            }
+            if (bh.timeMs >= timeMs) {
+                location.path = segment.path;
+                location.header = segment.header;
+                location.offset = pos;
+                location.bytes = bytes;
+                location.block = bh;
+                return true;
+            }
+            pos += bytes;
+        }
+    }
+    return false;
+}
+
+bool HistoryStore::contains(qint64 timeMs)
+{
+    History::Location location;
+    return !m_deleted.contains(timeMs) && seek(timeMs, location) && location.block.timeMs == timeMs;
+}
+
+int HistoryStore::readFrame(qint64 timeMs, float* x, float* y, float* z, Record::BlockHeader* blockHeader)
+{
+    History::Location location;
+    if (m_deleted.contains(timeMs) || !seek(timeMs, location) || location.block.timeMs != timeMs) {
+        return -1;
+    }
+    // * seek() 已映射该分段，直接从映射区解码
+    const int count = m_reader.decodeBlockAt(location.offset, x, y, z, blockHeader);
+    if (count < 0) {
+        m_error = QString("block at %1 in %2 is corrupt").arg(location.offset).arg(location.path);
+    }
+    return count;
+}
+
+/**
+ * @brief 读取分段中 [from, to) 范围内各块的块头
+ */
+void HistoryStore::scanEntries(const Segment& segment, qint64 from, qint64 to, QVector<History::Entry>& out)
+{
+    if (!openForRead(segment)) {
+        return;
+    }
+    Record::BlockHeader bh;
+    for (qint64 pos = from; pos < to && readBlockHeader(pos, bh); ) {
+        const qint64 bytes = RecordReader::blockBytes(segment.header, bh);
+        if (bytes < 0) {
+            break;
+        }
+        out.append(History::Entry{ bh.timeMs, bh.frameSequence });
+        pos += bytes;
+    }
+}
+
+/**
+ * @brief 从最新分段的最后一个索引区间开始向前读取块头，凑够 n 条为止
+ */
+QVector<History::Entry> HistoryStore::recent(int n)
+{
+    QVector<History::Entry> result;
+    QVector<History::Entry> range;
+    for (int s = m_segments.size() - 1; s >= 0 && result.size() < n; --s) {
+        const Segment& segment = m_segments[s];
+        for (int i = segment.index.size() - 1; i >= 0 && result.size() < n; --i) {
+            const qint64 to = i + 1 < segment.index.size() ? segment.index[i + 1].offset : segment.bytes;
+            range.clear();
+            scanEntries(segment, segment.index[i].offset, to, range);
+            for (int k = range.size() - 1; k >= 0 && result.size() < n; --k) {
+                if (!m_deleted.contains(range[k].timeMs)) {
+                    result.append(range[k]);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool HistoryStore::remove(qint64 timeMs)
+{
+    if (!contains(timeMs)) {
+        return false;
+    }
+    if (m_tombstones.write(reinterpret_cast<const char*>(&timeMs), sizeof(timeMs)) != sizeof(timeMs)
+            || !m_tombstones.flush()) {
+        m_error = m_tombstones.errorString();
+        return false;
+    }
+    m_deleted.insert(timeMs);
+    return true;
+}
+
+int HistoryStore::clear()
+{
+    if (!isOpen()) {
+        return -1;
+    }
+    m_writer.close();
+    m_indexFile.close();
+    m_reader.close();
+    m_tombstones.close();
+    int removed = 0;
+    bool ok = true;
+    while (!m_segments.isEmpty()) {
+        if (removeSegmentFiles(m_segments.first())) {
+            removed++;
+        } else {
+            ok = false;
+            qWarning() << "HistoryStore: Failed to remove segment" << m_segments.first().path;
+        }
+        m_segments.removeFirst();
+    }
+    QFile::remove(m_dir + "/" + TOMBSTONE_FILE);
+    m_deleted.clear();
+    m_lastTimeMs = 0;
+    m_totalBytes = 0;
+    loadTombstones();
+    return ok ? removed : -1;
+}
+
+/**
+ * @brief 加载墓碑文件; 早于最旧分段的墓碑已随分段淘汰，重写文件时丢弃
+ */
+void HistoryStore::loadTombstones()
+{
+    m_tombstones.close();
+    m_tombstones.setFileName(m_dir + "/" + TOMBSTONE_FILE);
+    QVector<qint64> kept;
+    bool stale = false;
+    if (m_tombstones.open(QIODevice::ReadOnly)) {
+        QByteArray data = m_tombstones.readAll();
+        const int count = data.size() / static_cast<int>(sizeof(qint64));
+        for (int i = 0; i < count; ++i) {
+            qint64 timeMs;
+            memcpy(&timeMs, data.constData() + i * sizeof(qint64), sizeof(timeMs));
+            if (timeMs >= firstTimeMs() && !m_segments.isEmpty()) {
+                kept.append(timeMs);
+                m_deleted.insert(timeMs);
+            } else {
+                stale = true;
+            }
+        }
+        stale = stale || data.size() % sizeof(qint64) != 0;
+        m_tombstones.close();
+    }
+    if (!m_tombstones.open(stale ? (QIODevice::WriteOnly | QIODevice::Truncate) : (QIODevice::WriteOnly | QIODevice::Append))) {
+        qWarning() << "HistoryStore: Cannot open" << m_tombstones.fileName() << m_tombstones.errorString();
+        return;
+    }
+    if (stale) {
+        m_tombstones.write(reinterpret_cast<const char*>(kept.constData()), qint64(kept.size()) * sizeof(qint64));
+        m_tombstones.flush();
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "recordfile.h"
+#include "replayloader.h"
+
+namespace History {
+const int INDEX_INTERVAL = 16;      // [可调] 每隔多少块记录一个稀疏索引项
+const int INDEX_ENTRY_SIZE = 24;
+
+// 稀疏索引项(.idx 文件中按内存布局直接读写，小端)
+struct IndexEntry {
+    qint64 timeMs;      // 该块的采集时刻
+    qint64 offset;      // 该块在分段文件中的偏移
+    quint32 block;      // 该块在分段中的序号
+    quint32 reserved;
+};
+static_assert(sizeof(IndexEntry) == INDEX_ENTRY_SIZE, "History::IndexEntry layout");
+
+// 一条历史记录(一块)，timeMs 在整个存储中唯一且递增，作为记录的键
+struct Entry {
+    qint64 timeMs;
+    quint64 frameSequence;
+};
+
+// 一块在存储中的位置
+struct Location {
+    QString path;               // 分段文件
+    Record::FileHeader header;  // 分段文件头
+    qint64 offset = 0;          // 块在分段文件中的偏移
+    qint64 bytes = 0;           // 块长
+    Record::BlockHeader block;
+};
+}
+
+/**
+ * @brief 分段追加写入的历史数据存储，替代 processed_csv 中每次预测一个文件的归档方式
+ * 记录按时间顺序追加到当前分段(seg_<首块时刻>.rec，录制文件格式，每块一帧)，分段达到大小或时间跨度上限后新开一段;
+ * 每段每 INDEX_INTERVAL 块记录一个稀疏索引项(seg_<首块时刻>.idx，追加写入)，按时间定位只需两次二分查找
+ * 再顺序读取至多 INDEX_INTERVAL 个块头. 淘汰按总字节数和保存时间整段删除最旧的分段.
+ * 只在 open() 时列出一次目录，之后追加、淘汰、查找都不扫描目录.
+ * 单条删除记入追加写入的墓碑文件(deleted.log)，数据随所在分段淘汰时回收.
+ * 读取经 ReplayLoader 内存映射最近访问的分段，反复回放同一段内的记录不再读文件.
+ * 非线程安全，由界面线程使用.
+ */
+class HistoryStore
+{
+public:
+    HistoryStore();
+    ~HistoryStore();
+
+    // * 分段大小(字节)和时间跨度(ms)上限，达到任一上限时新开一段
+    void setSegmentLimits(qint64 maxBytes, qint64 maxSpanMs);
+    // * 淘汰条件: 总字节数和保存时间(ms)上限，0 为不限; 正在写入的分段不会被淘汰
+    void setRetention(qint64 maxBytes, qint64 maxAgeMs);
+
+    // * 打开(必要时创建)存储目录: 加载各分段的稀疏索引，最新一段按块头重建索引(忽略末尾不完整的块)
+    bool open(const QString& dir);
+    void close();
+    bool isOpen() const { return !m_dir.isEmpty(); }
+    QString errorString() const { return m_error; }
+
+    // * 追加一帧; header 的格式、块长或标定与当前分段不同时新开一段
+    // * timeMs 不晚于上一条记录时(系统时间回拨)改为上一条 + 1ms，保证键唯一递增; 实际的键由 lastTimeMs() 返回
+    bool append(const Record::FileHeader& header, const double* x, const double* y, const double* z, int count,
+                quint64 frameSequence, qint64 timeMs);
+
+    bool isEmpty() const { return m_lastTimeMs == 0; }
+    qint64 firstTimeMs() const { return m_segments.isEmpty() ? 0 : m_segments.first().startTimeMs; }
+    qint64 lastTimeMs() const { return m_lastTimeMs; }
+    qint64 totalBytes() const { return m_totalBytes; }
+    int segmentCount() const { return m_segments.size(); }
+
+    // * 定位时刻不早于 timeMs 的第一块(含已删除的记录)，O(log n); 没有时返回 false
+    bool seek(qint64 timeMs, History::Location& location);
+    // * 是否存在时刻为 timeMs 且未删除的记录
+    bool contains(qint64 timeMs);
+    // * 读取时刻为 timeMs 的记录，x/y/z 至少 samplesPerBlock 点; 返回点数，不存在或已损坏返回 -1
+    int readFrame(qint64 timeMs, float* x, float* y, float* z, Record::BlockHeader* blockHeader = nullptr);
+    // * 最新的 n 条未删除的记录，新的在前
+    QVector<History::Entry> recent(int n);
+
+    // * 删除一条记录(写入墓碑)
+    bool remove(qint64 timeMs);
+    // * 删除全部分段和墓碑，返回删除的记录所在分段数，失败返回 -1
+    int clear();
+
+private:
+    struct Segment {
+        QString path;
+        qint64 startTimeMs = 0;
+        qint64 bytes = 0;               // 有效数据的结束偏移(文件头 + 完整的块)
+        Record::FileHeader header;
+        QVector<History::IndexEntry> index;
+    };
+
+    QString segmentPath(qint64 startTimeMs) const;
+    static QString indexPath(const QString& segmentPath);
+    bool loadSegment(const QString& path, Segment& segment);
+    bool rebuildIndex(Segment& segment, qint64* lastTimeMs);
+    bool startSegment(const Record::FileHeader& header, qint64 timeMs);
+    bool openWriter(Segment& segment);
+    void applyRetention(qint64 nowMs);
+    bool removeSegmentFiles(const Segment& segment);
+    bool openForRead(const Segment& segment);
+    bool readBlockHeader(qint64 offset, Record::BlockHeader& blockHeader);
+    void scanEntries(const Segment& segment, qint64 from, qint64 to, QVector<History::Entry>& out);
+    void loadTombstones();
+
+    QString m_dir;
+    QString m_error;
+    QVector<Segment> m_segments;        // 按首块时刻升序，最后一段为当前写入段
+    RecordWriter m_writer;              // 当前写入段，第一次追加时打开
+    QFile m_indexFile;                  // 当前写入段的 .idx
+    ReplayLoader m_reader;              // 读取用，保持映射上一次访问的分段
+    QSet<qint64> m_deleted;
+    QFile m_tombstones;
+    qint64 m_lastTimeMs = 0;
+    qint64 m_totalBytes = 0;
+
+    qint64 m_segmentBytes = 4 * 1024 * 1024;    // [可调] 约 1500 帧(压缩后)
+    qint64 m_segmentSpanMs = 3600 * 1000;       // [可调] 1 小时
+    qint64 m_retentionBytes = 256 * 1024 * 1024; // [可调]
+    qint64 m_retentionAgeMs = 0;                // [可调] 0 为不限
+};
+
+#endif // HISTORYSTORE_H
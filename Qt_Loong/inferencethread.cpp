@@ -0,0 +1,156 @@
+#include "inferencethread.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <cstring>
+
+namespace {
+// 无新帧时的最长等待(ms)，用于检查退出请求
+const unsigned long IDLE_WAIT_MS = 100;
+const int kHalf = SAMPLES_PER_AXIS / 2;
+}
+
+InferenceThread::InferenceThread(QObject *parent)
+    : QThread(parent)
+    , m_queue(new JobQueue)
+    , m_inFlight(0)
+    , m_int8Requested(false)
+    , m_stopRequested(false)
+    , m_lastWindowUs(0)
+{
+}
+
+InferenceThread::~InferenceThread()
+{
+    stop();
+    wait();
+}
+
+bool InferenceThread::loadWeights(const QString& path)
+{
+    if (isRunning()) {
+        qWarning() << "InferenceThread: loadWeights() must be called before start().";
+        return false;
+    }
+    return m_engine.load(path);
+}
+
+bool InferenceThread::setInt8(bool enabled)
+{
+    if (enabled && !m_engine.hasInt8()) {
+        return false;
+    }
+    m_int8Requested.store(enabled, std::memory_order_relaxed);
+    return true;
+}
+
+quint32 InferenceThread::sendFrame(const double* x, const double* y, const double* z, int count, quint16 flags)
+{
+    if (!m_engine.isLoaded() || count != SAMPLES_PER_AXIS
+        || m_inFlight.load(std::memory_order_acquire) >= ModelIpc::MAX_IN_FLIGHT) {
+        ++m_dropped;
+        return 0;
+    }
+    Job* job = m_queue->writeSlot(); // 在途帧数不超过队列容量，不会为空
+    if (!job) {
+        ++m_dropped;
+        return 0;
+    }
+    job->sequence = m_nextSequence;
+    job->flags = flags;
+    for (int i = 0; i < SAMPLES_PER_AXIS; ++i) {
+        job->x[i] = static_cast<float>(x[i]);
+        job->y[i] = static_cast<float>(y[i]);
+        job->z[i] = static_cast<float>(z[i]);
+    }
+    m_inFlight.fetch_add(1, std::memory_order_acq_rel);
+    m_queue->publish();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_wakeup.wakeOne();
+    }
+
+    const quint32 sequence = m_nextSequence++;
+    if (m_nextSequence == 0) {
+        m_nextSequence = 1;
+    }
+    return sequence;
+}
+
+void InferenceThread::stop()
+{
+    m_stopRequested.store(true, std::memory_order_release);
+    QMutexLocker locker(&m_mutex);
+    m_wakeup.wakeOne();
+}
+
+void InferenceThread::run()
+{
+    while (!m_stopRequested.load(std::memory_order_acquire)) {
+        const Job* job = m_queue->readSlot();
+        if (!job) {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue->size() == 0 && !m_stopRequested.load(std::memory_order_acquire)) {
+                m_wakeup.wait(&m_mutex, IDLE_WAIT_MS);
+            }
+            continue;
+        }
+        process(*job);
+        m_queue->release();
+        m_inFlight.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+/**
+ * @brief 处理一帧: 需要时先推理与上一帧之间的重叠窗口(与 model_loader.py 的顺序一致)，再推理本帧
+ */
+void InferenceThread::process(const Job& job)
+{
+    const bool int8 = m_int8Requested.load(std::memory_order_relaxed);
+    if (m_engine.isInt8() != int8) {
+        m_engine.setInt8(int8);
+    }
+
+    const quint16 overlapFlags = ModelIpc::FlagContinuous | ModelIpc::FlagOverlap;
+    if ((job.flags & overlapFlags) == overlapFlags && m_hasPrevious) {
+        const float* current[NUM_AXES] = { job.x, job.y, job.z };
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            memcpy(m_joined[axis], m_previous[axis] + kHalf, (SAMPLES_PER_AXIS - kHalf) * sizeof(float));
+            memcpy(m_joined[axis] + SAMPLES_PER_AXIS - kHalf, current[axis], kHalf * sizeof(float));
+        }
+        infer(job.sequence, true, job.flags, m_joined[0], m_joined[1], m_joined[2]);
+    }
+    memcpy(m_previous[0], job.x, sizeof(job.x));
+    memcpy(m_previous[1], job.y, sizeof(job.y));
+    memcpy(m_previous[2], job.z, sizeof(job.z));
+    m_hasPrevious = true;
+
+    infer(job.sequence, false, job.flags, job.x, job.y, job.z);
+}
+
+void InferenceThread::infer(quint32 sequence, bool overlapped, quint16 flags, const float* x, const float* y, const float* z)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const int axisFeatures = MFCC_NUM_FRAMES * MFCC_NUM_CEP;
+    m_mfcc.compute(x, m_features);
+    m_mfcc.compute(y, m_features + axisFeatures);
+    m_mfcc.compute(z, m_features + 2 * axisFeatures);
+    float probabilities[RESNET_NUM_CLASSES];
+    const int classIndex = m_engine.predict(m_features, probabilities);
+    m_lastWindowUs.store(timer.nsecsElapsed() / 1000, std::memory_order_relaxed);
+
+    // * 与 Python 服务的结果相同: 概率为百分比，特征只在帧带 FlagFeatures 时附带
+    QVector<double> percentages(RESNET_NUM_CLASSES);
+    for (int k = 0; k < RESNET_NUM_CLASSES; ++k) {
+        percentages[k] = probabilities[k] * 100.0;
+    }
+    QVector<double> features;
+    if (flags & ModelIpc::FlagFeatures) {
+        features.resize(MFCC_TENSOR_SIZE);
+        for (int i = 0; i < MFCC_TENSOR_SIZE; ++i) {
+            features[i] = m_features[i];
+        }
+    }
+    emit resultReady(sequence, overlapped, classIndex, percentages[classIndex], percentages, features);
+}
@@ -0,0 +1,91 @@
+#ifndef INFERENCETHREAD_H
+#define INFERENCETHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "datareader.h"
+#include "mfccengine.h"
+#include "modelipc.h"
+#include "resnetengine.h"
+#include "spscring.h"
+
+/**
+ * @brief 进程内推理线程: MfccEngine 提取特征，ResNetEngine 推理，代替 Python 模型服务(model_loader.py --ipc)
+ * 接口和结果信号与 ModelIpcServer 相同(帧序号、ModelIpc::Flags、百分比概率)，界面只需选择发送到哪一个.
+ * 界面线程把帧复制到预分配的队列后立即返回，特征提取和推理都在本线程中完成; 未返回结果的帧达到
+ * ModelIpc::MAX_IN_FLIGHT 时丢弃新帧并计数，与 Python 服务的背压一致.
+ * 帧带 FlagContinuous | FlagOverlap 时额外推理上一帧后半与本帧前半组成的重叠窗口(结果带 overlapped).
+ */
+class InferenceThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit InferenceThread(QObject *parent = nullptr);
+    ~InferenceThread();
+
+    // * 加载 export_weights.py 导出的权重文件，须在 start() 之前调用
+    bool loadWeights(const QString& path);
+    QString errorString() const { return m_engine.errorString(); }
+    // * 权重文件带 quantize_model.py 标定的量化系数时可以使用 int8 路径
+    bool hasInt8() const { return m_engine.hasInt8(); }
+
+    // --- 界面线程(唯一生产者)接口，均不阻塞 ---
+    // * 复制一帧(count 须为 SAMPLES_PER_AXIS)入队，返回帧序号; 未加载权重或在途帧已满时返回 0(该帧被丢弃)
+    quint32 sendFrame(const double* x, const double* y, const double* z, int count, quint16 flags = 0);
+    // * 切换 int8 路径，从下一个窗口起生效; 无量化系数时返回 false
+    bool setInt8(bool enabled);
+    bool isInt8() const { return m_int8Requested.load(std::memory_order_relaxed); }
+    quint64 droppedFrames() const { return m_dropped; }
+    // * 最近一个窗口的耗时(特征提取 + 推理，us)
+    qint64 lastWindowUs() const { return m_lastWindowUs.load(std::memory_order_relaxed); }
+
+    // * 请求线程退出(线程安全)，随后可调用 wait()
+    void stop();
+
+signals:
+    // 以下信号均从推理线程发出(跨线程，排队连接)，参数含义与 ModelIpcServer 相同
+    void resultReady(quint32 sequence, bool overlapped, int classIndex, double confidence,
+                     const QVector<double>& probabilities, const QVector<double>& features);
+
+protected:
+    void run() override;
+
+private:
+    // 队列中的一帧(界面线程填充)
+    struct Job {
+        quint32 sequence;
+        quint16 flags;
+        float x[SAMPLES_PER_AXIS];
+        float y[SAMPLES_PER_AXIS];
+        float z[SAMPLES_PER_AXIS];
+    };
+    typedef SpscRing<Job, ModelIpc::MAX_IN_FLIGHT> JobQueue;
+
+    void process(const Job& job);
+    void infer(quint32 sequence, bool overlapped, quint16 flags, const float* x, const float* y, const float* z);
+
+    std::unique_ptr<JobQueue> m_queue;
+    QMutex m_mutex;                      // 与 m_wakeup 配合
+    QWaitCondition m_wakeup;
+    quint32 m_nextSequence = 1;          // 仅界面线程修改，0 表示未发送
+    quint64 m_dropped = 0;               // 仅界面线程修改
+    std::atomic<int> m_inFlight;         // 已入队、结果尚未发出的帧数
+    std::atomic<bool> m_int8Requested;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<qint64> m_lastWindowUs;
+
+    // --- 以下仅在推理线程中使用(loadWeights 除外) ---
+    MfccEngine m_mfcc;
+    ResNetEngine m_engine;
+    float m_features[MFCC_TENSOR_SIZE];
+    float m_previous[NUM_AXES][SAMPLES_PER_AXIS]; // 上一帧，用于拼接重叠窗口
+    bool m_hasPrevious = false;
+    float m_joined[NUM_AXES][SAMPLES_PER_AXIS];
+};
+
+#endif // INFERENCETHREAD_H
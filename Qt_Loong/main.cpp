@@ -1,9 +1,17 @@
 #include "widget.h"
 #include <QApplication>
 #include "inhibit_manager.h"
+#include "enginecheck.h"
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // --- 命令行模式: 推理引擎一致性检查(check_engine.py 调用)，不创建界面 ---
+    if (argc > 1 && strcmp(argv[1], EngineCheck::OPTION) == 0) {
+        QCoreApplication app(argc, argv);
+        return runEngineCheck(app.arguments());
+    }
+
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication a(argc, argv);
 
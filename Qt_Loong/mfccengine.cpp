@@ -0,0 +1,118 @@
+#include "mfccengine.h"
+#include "adcframe.h"
+#include "realfft.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+const double kPi = 3.14159265358979323846;
+const double kEps = 2.220446049250313e-16; // np.finfo(float).eps
+
+double hz2mel(double hz)
+{
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+double mel2hz(double mel)
+{
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+}
+
+MfccEngine::MfccEngine()
+    : m_emph(MFCC_NUM_FRAMES * MFCC_FRAME_STEP + MFCC_FRAME_LEN, 0.0f)
+    , m_frame(MFCC_FRAME_LEN)
+    , m_power(MFCC_NUM_BINS)
+{
+    // * Hamming 窗(np.hamming)
+    for (int n = 0; n < MFCC_FRAME_LEN; ++n) {
+        m_window[n] = 0.54 - 0.46 * std::cos(2.0 * kPi * n / (MFCC_FRAME_LEN - 1));
+    }
+
+    // * 梅尔滤波器组: 在 0 ~ fs/2 的梅尔刻度上等分 nfilt + 2 个点，换算为 FFT 频点后构造三角滤波器
+    const double lowMel = hz2mel(0.0);
+    const double highMel = hz2mel(MFCC_SAMPLE_RATE / 2.0);
+    const double melStep = (highMel - lowMel) / (MFCC_NUM_FILTERS + 1);
+    int bin[MFCC_NUM_FILTERS + 2];
+    for (int i = 0; i < MFCC_NUM_FILTERS + 2; ++i) {
+        double mel = (i == MFCC_NUM_FILTERS + 1) ? highMel : lowMel + i * melStep; // 同 np.linspace
+        bin[i] = static_cast<int>(std::floor((MFCC_NFFT + 1) * mel2hz(mel) / MFCC_SAMPLE_RATE));
+    }
+    for (int j = 0; j < MFCC_NUM_FILTERS; ++j) {
+        MelFilter& f = m_filters[j];
+        f.firstBin = bin[j];
+        f.numBins = bin[j + 2] - bin[j];
+        f.weightOffset = static_cast<int>(m_melWeights.size());
+        for (int i = bin[j]; i < bin[j + 1]; ++i) {
+            m_melWeights.push_back(static_cast<float>(static_cast<double>(i - bin[j]) / (bin[j + 1] - bin[j])));
+        }
+        for (int i = bin[j + 1]; i < bin[j + 2]; ++i) {
+            m_melWeights.push_back(static_cast<float>(static_cast<double>(bin[j + 2] - i) / (bin[j + 2] - bin[j + 1])));
+        }
+    }
+
+    // * DCT: 第 i 行为 cos((i + 1) * pi * (n + 0.5) / nfilt)，并乘以倒谱提升系数
+    for (int i = 0; i < MFCC_NUM_CEP; ++i) {
+        double lift = 1.0 + (MFCC_CEP_LIFTER / 2.0) * std::sin(kPi * i / MFCC_CEP_LIFTER);
+        for (int n = 0; n < MFCC_NUM_FILTERS; ++n) {
+            m_dct[i][n] = static_cast<float>(lift * std::cos((i + 1) * kPi * (n + 0.5) / MFCC_NUM_FILTERS));
+        }
+    }
+}
+
+void MfccEngine::compute(const float* signal, float* out)
+{
+    // * 预加重，超出信号长度的部分保持为 0(与 np.pad 一致)
+    float* emph = m_emph.data();
+    emph[0] = signal[0];
+    for (int i = 1; i < SAMPLES_PER_AXIS; ++i) {
+        emph[i] = signal[i] - MFCC_PREEMPH * signal[i - 1];
+    }
+
+    for (int f = 0; f < MFCC_NUM_FRAMES; ++f) {
+        computeRow(emph + f * MFCC_FRAME_STEP, out + f * MFCC_NUM_CEP);
+    }
+}
+
+void MfccEngine::computeRow(const float* emph, float* row)
+{
+    for (int n = 0; n < MFCC_FRAME_LEN; ++n) {
+        m_frame[n] = static_cast<float>(emph[n] * m_window[n]);
+    }
+    // * 补零到 1024 点的功率谱 |X[k]|^2 / NFFT
+    float* power = m_power.data();
+    RealFft::forSize(MFCC_NFFT)->power(m_frame.data(), MFCC_FRAME_LEN, power, 1.0f / MFCC_NFFT);
+
+    double energy = 0.0;
+    for (int k = 0; k < MFCC_NUM_BINS; ++k) {
+        energy += power[k];
+    }
+
+    float logMel[MFCC_NUM_FILTERS];
+    for (int j = 0; j < MFCC_NUM_FILTERS; ++j) {
+        const MelFilter& filter = m_filters[j];
+        const float* w = m_melWeights.data() + filter.weightOffset;
+        const float* p = power + filter.firstBin;
+        double sum = 0.0;
+        for (int i = 0; i < filter.numBins; ++i) {
+            sum += static_cast<double>(p[i]) * w[i];
+        }
+        logMel[j] = static_cast<float>(20.0 * std::log10(sum == 0.0 ? kEps : sum));
+    }
+
+    for (int i = 0; i < MFCC_NUM_CEP; ++i) {
+        float acc = 0.0f;
+        for (int n = 0; n < MFCC_NUM_FILTERS; ++n) {
+            acc += logMel[n] * m_dct[i][n];
+        }
+        row[i] = acc;
+    }
+    row[0] = static_cast<float>(std::log(energy == 0.0 ? kEps : energy)); // 以帧能量替换第 0 维
+}
+
+void MfccEngine::computeFrame(const AdcFrame& frame, float* out)
+{
+    compute(frame.x, out);
+    compute(frame.y, out + MFCC_NUM_FRAMES * MFCC_NUM_CEP);
+    compute(frame.z, out + 2 * MFCC_NUM_FRAMES * MFCC_NUM_CEP);
+}
@@ -0,0 +1,62 @@
+#ifndef MFCCENGINE_H
+#define MFCCENGINE_H
+
+#include <vector>
+#include "datareader.h"
+
+struct AdcFrame;
+
+#define MFCC_SAMPLE_RATE   10000
+#define MFCC_FRAME_LEN     250   // 25ms @ 10kHz
+#define MFCC_FRAME_STEP    100   // 10ms @ 10kHz
+#define MFCC_NFFT          1024
+#define MFCC_NUM_BINS      (MFCC_NFFT / 2 + 1)
+#define MFCC_NUM_FILTERS   26
+#define MFCC_NUM_CEP       13
+#define MFCC_PREEMPH       0.97f
+#define MFCC_CEP_LIFTER    22
+// 1024 点信号的帧数: ceil((1024 - 250) / 100) + 1 = 9
+#define MFCC_NUM_FRAMES    (((SAMPLES_PER_AXIS - MFCC_FRAME_LEN) + MFCC_FRAME_STEP - 1) / MFCC_FRAME_STEP + 1)
+// 一帧三轴数据的特征张量 [NUM_AXES][MFCC_NUM_FRAMES][MFCC_NUM_CEP]，与 Python 端 [C, H, W] 一致
+#define MFCC_TENSOR_SIZE   (NUM_AXES * MFCC_NUM_FRAMES * MFCC_NUM_CEP)
+
+/**
+ * @brief MFCC 特征提取，与 Python/run_on_loong/pure_python_mfcc.py 中 safe_mfcc 的参数和算法一致:
+ * 预加重 0.97 -> 250 点分帧、100 点帧移(末尾补零) -> Hamming 窗 -> 1024 点实数 FFT 功率谱 ->
+ * 26 个梅尔滤波器 -> 20*log10 -> DCT 取第 1~13 个余弦基 -> 倒谱提升 22 -> 以 ln(帧能量) 替换第 0 维.
+ * 窗函数、滤波器组(只保存非零区间)和 DCT 矩阵(已并入提升系数)在构造时一次性计算，
+ * FFT 使用 RealFft 的线程缓存计划. compute() 不分配内存. 单个对象不可被多个线程同时使用.
+ * 计算以 float 为主(Python 端 FFT 为 double)，与 pure_python_mfcc.MFCC 的最大绝对误差约 4e-3
+ * (特征幅值 1e2~1e3). 一致性由 Python/run_on_loong/check_engine.py 经 LoongQt --engine-check 检查.
+ */
+class MfccEngine
+{
+public:
+    MfccEngine();
+
+    // * 一个轴 SAMPLES_PER_AXIS 点 -> out[MFCC_NUM_FRAMES][MFCC_NUM_CEP]
+    void compute(const float* signal, float* out);
+    // * 三轴一帧 -> out[NUM_AXES][MFCC_NUM_FRAMES][MFCC_NUM_CEP]
+    void computeFrame(const AdcFrame& frame, float* out);
+
+private:
+    // * 单个分析帧: emph 为 MFCC_FRAME_LEN 点已预加重(未加窗)的数据 -> row[MFCC_NUM_CEP]
+    void computeRow(const float* emph, float* row);
+
+    struct MelFilter {
+        int firstBin;
+        int numBins;
+        int weightOffset; // 在 m_melWeights 中的起始位置
+    };
+
+    double m_window[MFCC_FRAME_LEN]; // Python 端以 float64 窗乘 float32 帧后再取 float32，这里保持一致
+    MelFilter m_filters[MFCC_NUM_FILTERS];
+    std::vector<float> m_melWeights;
+    float m_dct[MFCC_NUM_CEP][MFCC_NUM_FILTERS];
+    // 计算缓冲区
+    std::vector<float> m_emph;
+    std::vector<float> m_frame;
+    std::vector<float> m_power;
+};
+
+#endif // MFCCENGINE_H
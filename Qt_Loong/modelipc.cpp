@@ -0,0 +1,235 @@
+#include "modelipc.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+// 龙芯与 x86 均为小端，按内存布局直接读写
+template <typename T>
+T readValue(const char* p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void writeValue(char* p, T value)
+{
+    memcpy(p, &value, sizeof(T));
+}
+}
+
+ModelIpcServer::ModelIpcServer(QObject *parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+    , m_socket(nullptr)
+    , m_nextSequence(1)
+    , m_inFlight(0)
+    , m_dropped(0)
+{
+    connect(m_server, &QLocalServer::newConnection, this, &ModelIpcServer::onNewConnection);
+}
+
+ModelIpcServer::~ModelIpcServer()
+{
+    if (m_socket) {
+        m_socket->abort();
+    }
+    m_server->close();
+}
+
+/**
+ * @brief 开始监听，先删除上次异常退出残留的套接字文件
+ * @param name 套接字名或完整路径
+ */
+bool ModelIpcServer::listen(const QString& name)
+{
+    QLocalServer::removeServer(name);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(name)) {
+        qWarning() << "ModelIpcServer: listen failed:" << name << m_server->errorString();
+        return false;
+    }
+    qDebug() << "ModelIpcServer: listening on" << m_server->fullServerName();
+    return true;
+}
+
+QString ModelIpcServer::serverPath() const
+{
+    return m_server->fullServerName();
+}
+
+QString ModelIpcServer::errorString() const
+{
+    return m_server->errorString();
+}
+
+bool ModelIpcServer::isConnected() const
+{
+    return m_socket && m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+/**
+ * @brief 发送一帧三轴数据
+ *        数据包结构: [包头(16B)] [x(count*4B)] [y(count*4B)] [z(count*4B)]，数据为 float32
+ * @param flags FlagContinuous: 与上一个发送的帧首尾相接，Python 端据此决定能否拼接重叠窗口;
+ *              FlagFeatures: 结果中附带 MFCC 特征
+ * @return 帧序号，未发送时返回 0
+ */
+quint32 ModelIpcServer::sendFrame(const double* x, const double* y, const double* z, int count, quint16 flags)
+{
+    if (!isConnected() || count <= 0) {
+        return 0;
+    }
+    if (m_inFlight >= ModelIpc::MAX_IN_FLIGHT) {
+        m_dropped++;
+        return 0;
+    }
+
+    const quint32 sequence = m_nextSequence++;
+    if (m_nextSequence == 0) {
+        m_nextSequence = 1; // 0 保留为"未发送"
+    }
+    const int payloadSize = 3 * count * static_cast<int>(sizeof(float));
+    m_txBuffer.resize(ModelIpc::HEADER_SIZE + payloadSize);
+    char* p = m_txBuffer.data();
+    writeValue<quint32>(p, ModelIpc::HEADER_MAGIC);
+    writeValue<quint16>(p + 4, ModelIpc::Frame);
+    writeValue<quint16>(p + 6, flags);
+    writeValue<quint32>(p + 8, sequence);
+    writeValue<quint32>(p + 12, static_cast<quint32>(payloadSize));
+
+    float* samples = reinterpret_cast<float*>(p + ModelIpc::HEADER_SIZE);
+    const double* const axes[3] = { x, y, z };
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int i = 0; i < count; ++i) {
+            samples[axis * count + i] = static_cast<float>(axes[axis][i]);
+        }
+    }
+
+    if (m_socket->write(m_txBuffer) != m_txBuffer.size()) {
+        qWarning() << "ModelIpcServer: write failed:" << m_socket->errorString();
+        return 0;
+    }
+    m_inFlight++;
+    return sequence;
+}
+
+void ModelIpcServer::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        if (m_socket) {
+            qWarning() << "ModelIpcServer: replacing existing connection";
+            m_socket->disconnect(this);
+            m_socket->abort();
+            m_socket->deleteLater();
+        }
+        m_socket = socket;
+        m_rxBuffer.clear();
+        m_inFlight = 0;
+        connect(m_socket, &QLocalSocket::readyRead, this, &ModelIpcServer::onReadyRead);
+        connect(m_socket, &QLocalSocket::disconnected, this, &ModelIpcServer::onDisconnected);
+        qDebug() << "ModelIpcServer: model service connected";
+        emit connectionChanged(true);
+    }
+}
+
+void ModelIpcServer::onDisconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket != m_socket) {
+        return;
+    }
+    m_socket->deleteLater();
+    m_socket = nullptr;
+    m_rxBuffer.clear();
+    m_inFlight = 0;
+    qDebug() << "ModelIpcServer: model service disconnected";
+    emit connectionChanged(false);
+}
+
+/**
+ * @brief 接收数据，按包头中的长度拆出完整的数据包(粘包/半包处理)
+ */
+void ModelIpcServer::onReadyRead()
+{
+    m_rxBuffer.append(m_socket->readAll());
+
+    int offset = 0;
+    while (m_rxBuffer.size() - offset >= ModelIpc::HEADER_SIZE) {
+        const char* p = m_rxBuffer.constData() + offset;
+        if (readValue<quint32>(p) != ModelIpc::HEADER_MAGIC) {
+            // * 数据流已错位，无法恢复，断开后由 Python 端重连
+            qWarning() << "ModelIpcServer: bad packet header, dropping connection";
+            m_rxBuffer.clear();
+            m_socket->abort();
+            return;
+        }
+        const quint16 type = readValue<quint16>(p + 4);
+        const quint16 flags = readValue<quint16>(p + 6);
+        const quint32 sequence = readValue<quint32>(p + 8);
+        const quint32 length = readValue<quint32>(p + 12);
+        if (static_cast<quint32>(m_rxBuffer.size() - offset - ModelIpc::HEADER_SIZE) < length) {
+            break; // 半包，等待剩余数据
+        }
+        const QByteArray payload = QByteArray::fromRawData(p + ModelIpc::HEADER_SIZE, static_cast<int>(length));
+        if (type == ModelIpc::Result) {
+            const bool overlapped = flags & ModelIpc::FlagOverlapped;
+            if (!overlapped && m_inFlight > 0) {
+                m_inFlight--;
+            }
+            parseResult(sequence, overlapped, payload);
+        } else {
+            qWarning() << "ModelIpcServer: unknown packet type" << type;
+        }
+        offset += ModelIpc::HEADER_SIZE + static_cast<int>(length);
+    }
+    m_rxBuffer.remove(0, offset);
+}
+
+/**
+ * @brief 解析结果数据包
+ *        成功: i32 status(0) | i32 类别索引 | f32 置信度(%) | f32 各类别概率(%)[13] | f32 MFCC 特征[3*9*13]
+ *              (MFCC 特征仅在数据帧带 FlagFeatures 时附带)
+ *        失败: i32 status(1) | UTF-8 错误信息
+ */
+void ModelIpcServer::parseResult(quint32 sequence, bool overlapped, const QByteArray& payload)
+{
+    if (payload.size() < static_cast<int>(sizeof(qint32))) {
+        emit errorReceived(sequence, QStringLiteral("结果数据包过短"));
+        return;
+    }
+    const char* p = payload.constData();
+    const qint32 status = readValue<qint32>(p);
+    if (status != ModelIpc::StatusOk) {
+        if (overlapped) {
+            qWarning() << "ModelIpcServer: overlapped window failed:" << QString::fromUtf8(p + 4, payload.size() - 4);
+        } else {
+            emit errorReceived(sequence, QString::fromUtf8(p + 4, payload.size() - 4));
+        }
+        return;
+    }
+
+    const int withoutFeatures = 3 * 4 + ModelIpc::NUM_CLASSES * 4;
+    const int withFeatures = withoutFeatures + ModelIpc::FEATURE_SIZE * 4;
+    if (payload.size() != withoutFeatures && payload.size() != withFeatures) {
+        emit errorReceived(sequence, QString("结果数据包长度错误: %1").arg(payload.size()));
+        return;
+    }
+    const int classIndex = readValue<qint32>(p + 4);
+    const double confidence = readValue<float>(p + 8);
+    const char* values = p + 12;
+    QVector<double> probabilities(ModelIpc::NUM_CLASSES);
+    for (int i = 0; i < ModelIpc::NUM_CLASSES; ++i) {
+        probabilities[i] = readValue<float>(values + 4 * i);
+    }
+    values += 4 * ModelIpc::NUM_CLASSES;
+    QVector<double> features;
+    if (payload.size() == withFeatures) {
+        features.resize(ModelIpc::FEATURE_SIZE);
+        for (int i = 0; i < ModelIpc::FEATURE_SIZE; ++i) {
+            features[i] = readValue<float>(values + 4 * i);
+        }
+    }
+    emit resultReady(sequence, overlapped, classIndex, confidence, probabilities, features);
+}
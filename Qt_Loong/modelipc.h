@@ -0,0 +1,90 @@
+#ifndef MODELIPC_H
+#define MODELIPC_H
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtGlobal>
+
+namespace ModelIpc {
+// 与 Python/run_on_loong/model_loader.py 中的定义保持一致，本机通信，数据均为小端
+const quint32 HEADER_MAGIC = 0x4D50534C; // "LSPM"
+const int HEADER_SIZE = 16;              // magic(4) | type(2) | flags(2) | sequence(4) | length(4)
+const int NUM_CLASSES = 13;
+const int FEATURE_SIZE = 3 * 9 * 13;     // MFCC 特征 [3][9][13]
+const int MAX_IN_FLIGHT = 8;             // 未返回结果的帧数上限(与 Python 端 --batch-size 默认值一致)，超过时丢弃新帧
+
+// 包头 flags
+enum Flags : quint16 {
+    FlagContinuous = 0x0001, // Frame: 与上一个发送的帧在采集流中首尾相接，Python 可拼接 50% 重叠窗口
+    FlagOverlapped = 0x0002, // Result: 上一帧后半与本帧前半组成的重叠窗口的结果，不对应已发送的帧
+    FlagFeatures = 0x0004,   // Frame: 需要显示 MFCC 特征，结果中附带特征(否则省略)
+    FlagOverlap = 0x0008     // Frame: 请求上一帧后半与本帧前半组成的重叠窗口(需同时带 FlagContinuous)
+};
+
+enum MessageType : quint16 {
+    Frame = 0x0001,  // Qt -> Python: float32 x[n], y[n], z[n]
+    Result = 0x0002  // Python -> Qt: 见 ModelIpcServer::parseResult
+};
+
+enum ResultStatus : qint32 {
+    StatusOk = 0,
+    StatusError = 1
+};
+}
+
+/**
+ * @brief 与 Python 模型服务之间的二进制通信通道(Unix 域套接字，QLocalServer)
+ * Qt 端监听，model_loader.py --ipc <路径> 连接. Qt 发送原始 float32 三轴数据帧(带序号)，
+ * Python 直接返回二进制结果，不再经过 CSV 文件、目录轮询和 JSON 文本.
+ * Python 端把积压的帧合并为一个批次推理，结果仍按帧序号逐个返回.
+ * 只接受一个连接，新连接会替换旧连接.
+ */
+class ModelIpcServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ModelIpcServer(QObject *parent = nullptr);
+    ~ModelIpcServer();
+
+    // * 开始监听，name 为套接字名(Linux 下位于 /tmp)或完整路径
+    bool listen(const QString& name);
+    // * Python 端连接用的完整路径
+    QString serverPath() const;
+    QString errorString() const;
+    bool isConnected() const;
+
+    // * 发送一帧三轴数据，返回帧序号; 未连接或在途帧已满时返回 0(该帧被丢弃)
+    // * flags: ModelIpc::Flags 中 Frame 可用的标志
+    quint32 sendFrame(const double* x, const double* y, const double* z, int count, quint16 flags = 0);
+    quint64 droppedFrames() const { return m_dropped; }
+
+signals:
+    // probabilities 为各类别百分比，features 为 [3][9][13] MFCC 特征(行优先，未请求时为空)
+    // overlapped 为 true 时是 sequence 帧与其上一帧之间的重叠窗口的结果
+    void resultReady(quint32 sequence, bool overlapped, int classIndex, double confidence,
+                     const QVector<double>& probabilities, const QVector<double>& features);
+    void errorReceived(quint32 sequence, const QString& message);
+    void connectionChanged(bool connected);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    void parseResult(quint32 sequence, bool overlapped, const QByteArray& payload);
+
+    QLocalServer* m_server;
+    QLocalSocket* m_socket;
+    QByteArray m_rxBuffer;   // 未处理完的接收数据
+    QByteArray m_txBuffer;   // 复用的发送缓冲区
+    quint32 m_nextSequence;
+    int m_inFlight;
+    quint64 m_dropped;
+};
+
+#endif // MODELIPC_H
@@ -0,0 +1,111 @@
+#include "movingaverage.h"
+#include <algorithm>
+
+MovingAverageFilter::MovingAverageFilter(int windowSize)
+{
+    setWindowSize(windowSize);
+}
+
+void MovingAverageFilter::setWindowSize(int windowSize)
+{
+    if (windowSize < 1) {
+        windowSize = 1;
+    }
+    // * 确保窗口大小是奇数，这样中心点才明确
+    if (windowSize % 2 == 0) {
+        windowSize++;
+    }
+    m_windowSize = windowSize;
+    m_halfWindow = windowSize / 2;
+    m_history.assign(static_cast<size_t>(m_halfWindow + 1) * NUM_AXES, 0.0);
+}
+
+/*
+ * 计算第 begin ~ end-1 点. Add: 窗口右端 i + k 仍在数据内; Remove: 窗口左端 i - k - 1 已离开窗口.
+ * i - k - 1 点的原始值与 i 点使用同一个环形槽位，先取出再写入.
+ */
+template <bool Add, bool Remove>
+void MovingAverageFilter::run(const double* const in[NUM_AXES], double* const out[NUM_AXES], int begin, int end)
+{
+    const int k = m_halfWindow;
+    const int numSlots = k + 1;
+    // 两端窗口截断时点数逐点变化，中间段点数恒为窗口大小
+    const bool fixed = Add == Remove;
+    const double inv = 1.0 / m_count;
+    for (int i = begin; i < end; ++i) {
+        double* history = m_history.data() + m_slot * NUM_AXES;
+        if (!fixed) {
+            if (Add) {
+                m_count++;
+            }
+            if (Remove) {
+                m_count--;
+            }
+        }
+#pragma GCC unroll 3
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            double sum = m_sum[axis];
+            if (Add) {
+                sum += in[axis][i + k];
+            }
+            if (Remove) {
+                sum -= history[axis];
+            }
+            m_sum[axis] = sum;
+            history[axis] = in[axis][i];
+            out[axis][i] = fixed ? sum * inv : sum / m_count;
+        }
+        if (++m_slot == numSlots) {
+            m_slot = 0;
+        }
+    }
+}
+
+void MovingAverageFilter::process(const double* const in[NUM_AXES], double* const out[NUM_AXES], int n)
+{
+    if (n <= 0) {
+        return;
+    }
+    if (m_halfWindow == 0) {
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            if (in[axis] != out[axis]) {
+                std::copy(in[axis], in[axis] + n, out[axis]);
+            }
+        }
+        return;
+    }
+    const int k = m_halfWindow;
+
+    // * 第 0 点的窗口为 [0, min(k, n - 1)]
+    m_count = std::min(k, n - 1) + 1;
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        double sum = 0.0;
+        for (int j = 0; j < m_count; ++j) {
+            sum += in[axis][j];
+        }
+        m_sum[axis] = sum;
+        m_history[axis] = in[axis][0];
+        out[axis][0] = sum / m_count;
+    }
+    m_slot = 1 % (k + 1);
+
+    // * 其余各点按窗口两端是否越界分为三段，段内不再做边界判断:
+    // * i < n - k 时右端有新点进入，i >= k + 1 时左端有点离开
+    const int addEnd = std::max(n - k, 1);
+    const int removeBegin = std::min(k + 1, n);
+    if (addEnd <= removeBegin) {
+        run<true, false>(in, out, 1, addEnd);
+        run<false, false>(in, out, addEnd, removeBegin);
+        run<false, true>(in, out, removeBegin, n);
+    } else {
+        run<true, false>(in, out, 1, removeBegin);
+        run<true, true>(in, out, removeBegin, addEnd);
+        run<false, true>(in, out, addEnd, n);
+    }
+}
+
+void MovingAverageFilter::apply(double* x, double* y, double* z, int n)
+{
+    double* const data[NUM_AXES] = { x, y, z };
+    process(data, data, n);
+}
@@ -0,0 +1,42 @@
+#ifndef MOVINGAVERAGE_H
+#define MOVINGAVERAGE_H
+
+#include <vector>
+#include "datareader.h"
+
+/**
+ * @brief 三轴滑动平均滤波器(居中窗口)
+ * 输出点 i 为 [i - k, i + k] 内有效采样点的平均值，k = 窗口 / 2; 两端窗口截断，
+ * 只对落在数据范围内的点求平均，与原 Widget::applyMovingAverageFilter 的边界处理一致.
+ * 使用滑动求和，每个点只做一次加、一次减，复杂度 O(n) 且与窗口长度无关;
+ * 三个轴在同一趟循环中处理. 被覆盖的输入保存在内部环形缓冲中，因此支持原地处理.
+ * 处理过程不分配内存(缓冲区在 setWindowSize 时分配). 单个对象不可被多个线程同时使用.
+ */
+class MovingAverageFilter
+{
+public:
+    explicit MovingAverageFilter(int windowSize = 3);
+
+    // * 窗口大小，偶数自动加一使中心点明确; <= 1 时不滤波
+    void setWindowSize(int windowSize);
+    int windowSize() const { return m_windowSize; }
+
+    // * 三轴各 n 点，in 与 out 可以指向同一缓冲区
+    void process(const double* const in[NUM_AXES], double* const out[NUM_AXES], int n);
+    // * 原地处理三轴各 n 点
+    void apply(double* x, double* y, double* z, int n);
+
+private:
+    template <bool Add, bool Remove>
+    void run(const double* const in[NUM_AXES], double* const out[NUM_AXES], int begin, int end);
+
+    int m_windowSize = 1;
+    int m_halfWindow = 0;
+    // 运行状态
+    double m_sum[NUM_AXES];
+    int m_count = 0;
+    int m_slot = 0;
+    std::vector<double> m_history; // 最近 halfWindow + 1 个输入点 [slot][axis]，减去离开窗口的点时使用
+};
+
+#endif // MOVINGAVERAGE_H
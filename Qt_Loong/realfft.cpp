@@ -0,0 +1,34 @@
+#include "realfft.h"
+
+namespace {
+template <int N>
+RealFft* createPlan()
+{
+    return new RealFftN<N>();
+}
+}
+
+/**
+ * @brief 每个线程各自缓存一份计划(工作缓冲区不可共享)，按 log2(n) 索引
+ */
+RealFft* RealFft::forSize(int n)
+{
+    thread_local std::unique_ptr<RealFft> plans[realfft_detail::log2Of(REALFFT_MAX_SIZE) + 1];
+
+    if (n < REALFFT_MIN_SIZE || n > REALFFT_MAX_SIZE || (n & (n - 1)) != 0) {
+        return nullptr;
+    }
+    const int index = realfft_detail::log2Of(n);
+    if (!plans[index]) {
+        switch (n) {
+        case 256:  plans[index].reset(createPlan<256>()); break;
+        case 512:  plans[index].reset(createPlan<512>()); break;
+        case 1024: plans[index].reset(createPlan<1024>()); break;
+        case 2048: plans[index].reset(createPlan<2048>()); break;
+        case 4096: plans[index].reset(createPlan<4096>()); break;
+        case 8192: plans[index].reset(createPlan<8192>()); break;
+        default: return nullptr;
+        }
+    }
+    return plans[index].get();
+}
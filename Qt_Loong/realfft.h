@@ -0,0 +1,276 @@
+#ifndef REALFFT_H
+#define REALFFT_H
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define REALFFT_MIN_SIZE 256
+#define REALFFT_MAX_SIZE 8192
+
+/**
+ * @brief 实数 FFT
+ * N 点实数序列通过 N/2 点复数 FFT 计算(偶数点作实部、奇数点作虚部，变换后拆分).
+ * 复数 FFT 为按时间抽取的基4算法(log2(N/2) 为奇数时先做一级基2)，位反转在读入输入时完成.
+ * 每级的旋转因子按连续顺序预先计算，蝶形运算的内层循环连续访存，子变换长度 >= 4 时
+ * 以 GCC 向量扩展一次处理 4 个点(x86 上为 SSE，龙芯以 -mlsx 编译时为 LSX)，
+ * 定义 REALFFT_SCALAR 可强制使用标量路径.
+ * 输出为 N/2 + 1 个频点的实部/虚部两个数组，不做归一化(与 np.fft.rfft 一致).
+ *
+ * 各长度(256 ~ 8192 的 2 的幂)分别由模板 RealFftN<N> 在编译期特化;
+ * RealFft::forSize() 返回当前线程缓存的计划，计划内含工作缓冲区，因此不能跨线程共用.
+ * 使用者为 MfccEngine(每个分析帧一次 1024 点变换): 界面中在 InferenceThread 中逐帧调用，
+ * LoongQt --engine-check 单独输出 MFCC 阶段的耗时.
+ */
+class RealFft
+{
+public:
+    virtual ~RealFft() {}
+
+    int size() const { return m_size; }
+    int bins() const { return m_size / 2 + 1; }
+
+    // * 单帧变换: in 前 inLen 点有效，其余按 0 处理(inLen <= N)
+    virtual void forward(const float* in, int inLen, float* re, float* im) = 0;
+    // * 功率谱 |X[k]|^2 * scale，k = 0 ~ N/2
+    virtual void power(const float* in, int inLen, float* out, float scale) = 0;
+
+    // * 批量变换 count 帧: 第 i 帧输入为 in + i * inStride，输出为 re/im + i * bins()
+    void forwardBatch(const float* in, int inLen, int inStride, int count, float* re, float* im)
+    {
+        for (int i = 0; i < count; ++i) {
+            forward(in + static_cast<size_t>(i) * inStride, inLen,
+                    re + static_cast<size_t>(i) * bins(), im + static_cast<size_t>(i) * bins());
+        }
+    }
+    void powerBatch(const float* in, int inLen, int inStride, int count, float* out, float scale)
+    {
+        for (int i = 0; i < count; ++i) {
+            power(in + static_cast<size_t>(i) * inStride, inLen, out + static_cast<size_t>(i) * bins(), scale);
+        }
+    }
+
+    // * 当前线程中长度为 n 的计划(首次调用时创建)，n 不是 256 ~ 8192 的 2 的幂时返回 nullptr
+    static RealFft* forSize(int n);
+
+protected:
+    explicit RealFft(int size) : m_size(size) {}
+
+private:
+    int m_size;
+};
+
+namespace realfft_detail {
+
+#if !defined(REALFFT_SCALAR) && defined(__GNUC__)
+#define REALFFT_VECTOR 1
+typedef float Vec4 __attribute__((vector_size(16)));
+
+inline Vec4 load4(const float* p)
+{
+    Vec4 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void store4(float* p, Vec4 v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+#endif
+
+constexpr int log2Of(int n)
+{
+    return n <= 1 ? 0 : 1 + log2Of(n / 2);
+}
+
+/*
+ * 基4蝶形(两级基2合并): 子变换长度 q -> 4q
+ *   y0 = x0 + w1 x1, y1 = x0 - w1 x1, y2 = x2 + w1 x3, y3 = x2 - w1 x3
+ *   z0 = y0 + w2 y2, z2 = y0 - w2 y2, z1 = y1 - i w2 y3, z3 = y1 + i w2 y3
+ * 其中 w1 = e^{-2πij/2q}, w2 = e^{-2πij/4q}
+ */
+inline void radix4Scalar(float* re, float* im, int a, int q, float w1r, float w1i, float w2r, float w2i)
+{
+    const int b = a + q, c = a + 2 * q, d = a + 3 * q;
+    float t1r = w1r * re[b] - w1i * im[b], t1i = w1r * im[b] + w1i * re[b];
+    float t3r = w1r * re[d] - w1i * im[d], t3i = w1r * im[d] + w1i * re[d];
+    float y0r = re[a] + t1r, y0i = im[a] + t1i;
+    float y1r = re[a] - t1r, y1i = im[a] - t1i;
+    float y2r = re[c] + t3r, y2i = im[c] + t3i;
+    float y3r = re[c] - t3r, y3i = im[c] - t3i;
+    float ur = w2r * y2r - w2i * y2i, ui = w2r * y2i + w2i * y2r;
+    float vr = w2r * y3r - w2i * y3i, vi = w2r * y3i + w2i * y3r;
+    // -i * v = (vi, -vr)
+    re[a] = y0r + ur; im[a] = y0i + ui;
+    re[c] = y0r - ur; im[c] = y0i - ui;
+    re[b] = y1r + vi; im[b] = y1i - vr;
+    re[d] = y1r - vi; im[d] = y1i + vr;
+}
+
+} // namespace realfft_detail
+
+template <int N>
+class RealFftN : public RealFft
+{
+    static_assert(N >= REALFFT_MIN_SIZE && N <= REALFFT_MAX_SIZE && (N & (N - 1)) == 0, "unsupported FFT size");
+    static constexpr int M = N / 2;                        // 复数 FFT 长度
+    static constexpr int L = realfft_detail::log2Of(M);
+    static constexpr bool kRadix2First = (L & 1) != 0;     // 先做一级基2
+
+public:
+    RealFftN()
+        : RealFft(N)
+        , m_bitrev(M)
+        , m_tw1r(M), m_tw1i(M), m_tw2r(M), m_tw2i(M)
+        , m_splitR(M + 1), m_splitI(M + 1)
+        , m_re(M), m_im(M)
+    {
+        const double pi = 3.14159265358979323846;
+        for (int i = 0; i < M; ++i) {
+            int r = 0;
+            for (int b = 0; b < L; ++b) {
+                r |= ((i >> b) & 1) << (L - 1 - b);
+            }
+            m_bitrev[i] = r;
+        }
+        // * 每个基4级的旋转因子在表中连续存放: w1 = e^{-2πij/2q}, w2 = e^{-2πij/4q}, j < q
+        int offset = 0;
+        for (int q = kRadix2First ? 2 : 1; q < M; q *= 4) {
+            for (int j = 0; j < q; ++j) {
+                m_tw1r[offset + j] = static_cast<float>(std::cos(-pi * j / q));
+                m_tw1i[offset + j] = static_cast<float>(std::sin(-pi * j / q));
+                m_tw2r[offset + j] = static_cast<float>(std::cos(-pi * j / (2 * q)));
+                m_tw2i[offset + j] = static_cast<float>(std::sin(-pi * j / (2 * q)));
+            }
+            offset += q;
+        }
+        for (int k = 0; k <= M; ++k) {
+            m_splitR[k] = static_cast<float>(std::cos(-2.0 * pi * k / N));
+            m_splitI[k] = static_cast<float>(std::sin(-2.0 * pi * k / N));
+        }
+    }
+
+    void forward(const float* in, int inLen, float* re, float* im) override
+    {
+        transform(in, inLen);
+        const float* zr = m_re.data();
+        const float* zi = m_im.data();
+        // * 拆分: X[k] = E[k] + W^k O[k]，E = (Z[k] + conj(Z[M-k])) / 2，O = -i (Z[k] - conj(Z[M-k])) / 2
+        for (int k = 0; k <= M; ++k) {
+            const int a = k & (M - 1);
+            const int b = (M - k) & (M - 1);
+            const float er = 0.5f * (zr[a] + zr[b]);
+            const float ei = 0.5f * (zi[a] - zi[b]);
+            const float orr = 0.5f * (zi[a] + zi[b]);
+            const float oi = -0.5f * (zr[a] - zr[b]);
+            re[k] = er + m_splitR[k] * orr - m_splitI[k] * oi;
+            im[k] = ei + m_splitR[k] * oi + m_splitI[k] * orr;
+        }
+    }
+
+    void power(const float* in, int inLen, float* out, float scale) override
+    {
+        transform(in, inLen);
+        const float* zr = m_re.data();
+        const float* zi = m_im.data();
+        for (int k = 0; k <= M; ++k) {
+            const int a = k & (M - 1);
+            const int b = (M - k) & (M - 1);
+            const float er = 0.5f * (zr[a] + zr[b]);
+            const float ei = 0.5f * (zi[a] - zi[b]);
+            const float orr = 0.5f * (zi[a] + zi[b]);
+            const float oi = -0.5f * (zr[a] - zr[b]);
+            const float xr = er + m_splitR[k] * orr - m_splitI[k] * oi;
+            const float xi = ei + m_splitR[k] * oi + m_splitI[k] * orr;
+            out[k] = (xr * xr + xi * xi) * scale;
+        }
+    }
+
+private:
+    // * 位反转读入 + 复数 FFT，结果在 m_re/m_im
+    void transform(const float* in, int inLen)
+    {
+        float* re = m_re.data();
+        float* im = m_im.data();
+        for (int i = 0; i < M; ++i) {
+            const int n = 2 * m_bitrev[i];
+            re[i] = n < inLen ? in[n] : 0.0f;
+            im[i] = n + 1 < inLen ? in[n + 1] : 0.0f;
+        }
+
+        int q = 1;
+        if (kRadix2First) {
+            for (int a = 0; a < M; a += 2) {
+                const float tr = re[a + 1], ti = im[a + 1];
+                re[a + 1] = re[a] - tr; im[a + 1] = im[a] - ti;
+                re[a] += tr; im[a] += ti;
+            }
+            q = 2;
+        }
+        int offset = 0;
+        for (; q < M; q *= 4) {
+            const float* w1r = m_tw1r.data() + offset;
+            const float* w1i = m_tw1i.data() + offset;
+            const float* w2r = m_tw2r.data() + offset;
+            const float* w2i = m_tw2i.data() + offset;
+#if defined(REALFFT_VECTOR)
+            if (q >= 4) {
+                radix4Vector(re, im, q, w1r, w1i, w2r, w2i);
+                offset += q;
+                continue;
+            }
+#endif
+            for (int start = 0; start < M; start += 4 * q) {
+                for (int j = 0; j < q; ++j) {
+                    realfft_detail::radix4Scalar(re, im, start + j, q, w1r[j], w1i[j], w2r[j], w2i[j]);
+                }
+            }
+            offset += q;
+        }
+    }
+
+#if defined(REALFFT_VECTOR)
+    static void radix4Vector(float* re, float* im, int q,
+                             const float* w1r, const float* w1i, const float* w2r, const float* w2i)
+    {
+        using realfft_detail::Vec4;
+        using realfft_detail::load4;
+        using realfft_detail::store4;
+        for (int start = 0; start < M; start += 4 * q) {
+            float* r0 = re + start; float* i0 = im + start;
+            float* r1 = r0 + q;     float* i1 = i0 + q;
+            float* r2 = r1 + q;     float* i2 = i1 + q;
+            float* r3 = r2 + q;     float* i3 = i2 + q;
+            for (int j = 0; j < q; j += 4) {
+                const Vec4 a1r = load4(w1r + j), a1i = load4(w1i + j);
+                const Vec4 a2r = load4(w2r + j), a2i = load4(w2i + j);
+                const Vec4 x0r = load4(r0 + j), x0i = load4(i0 + j);
+                const Vec4 x1r = load4(r1 + j), x1i = load4(i1 + j);
+                const Vec4 x2r = load4(r2 + j), x2i = load4(i2 + j);
+                const Vec4 x3r = load4(r3 + j), x3i = load4(i3 + j);
+                const Vec4 t1r = a1r * x1r - a1i * x1i, t1i = a1r * x1i + a1i * x1r;
+                const Vec4 t3r = a1r * x3r - a1i * x3i, t3i = a1r * x3i + a1i * x3r;
+                const Vec4 y0r = x0r + t1r, y0i = x0i + t1i;
+                const Vec4 y1r = x0r - t1r, y1i = x0i - t1i;
+                const Vec4 y2r = x2r + t3r, y2i = x2i + t3i;
+                const Vec4 y3r = x2r - t3r, y3i = x2i - t3i;
+                const Vec4 ur = a2r * y2r - a2i * y2i, ui = a2r * y2i + a2i * y2r;
+                const Vec4 vr = a2r * y3r - a2i * y3i, vi = a2r * y3i + a2i * y3r;
+                store4(r0 + j, y0r + ur); store4(i0 + j, y0i + ui);
+                store4(r2 + j, y0r - ur); store4(i2 + j, y0i - ui);
+                store4(r1 + j, y1r + vi); store4(i1 + j, y1i - vr);
+                store4(r3 + j, y1r - vi); store4(i3 + j, y1i + vr);
+            }
+        }
+    }
+#endif
+
+    std::vector<int> m_bitrev;
+    std::vector<float> m_tw1r, m_tw1i, m_tw2r, m_tw2i; // 各基4级的旋转因子(连续存放)
+    std::vector<float> m_splitR, m_splitI;             // 拆分用 e^{-2πik/N}
+    std::vector<float> m_re, m_im;                     // 工作缓冲区
+};
+
+#endif // REALFFT_H
@@ -0,0 +1,431 @@
+#include "recordfile.h"
+#include "adcdecoder.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+struct Crc32Table {
+    quint32 entries[256];
+    Crc32Table()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+quint32 headerCrc(const Record::FileHeader& header)
+{
+    return Record::crc32(&header, offsetof(Record::FileHeader, crc));
+}
+
+// 块 CRC: 块头中 crc 之前的字段 + 数据
+quint32 blockCrc(const char* block, qint64 blockBytes)
+{
+    quint32 crc = Record::crc32(block, offsetof(Record::BlockHeader, crc));
+    return Record::crc32(block + Record::BLOCK_HEADER_SIZE, static_cast<size_t>(blockBytes - Record::BLOCK_HEADER_SIZE), crc);
+}
+
+// FormatPacked10 编解码时的码值缓冲区(每线程一份，避免逐块分配)
+quint16* codeScratch(int count)
+{
+    thread_local std::vector<quint16> scratch;
+    if (static_cast<int>(scratch.size()) < count) {
+        scratch.resize(count);
+    }
+    return scratch.data();
+}
+}
+
+quint32 Record::crc32(const void* data, size_t size, quint32 crc)
+{
+    static const Crc32Table table;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table.entries[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+RecordWriter::RecordWriter()
+{
+}
+
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+/**
+ * @brief 打开录制文件
+ *        追加时要求已有文件头的格式、轴数、块长与 header 一致，文件末尾不完整的块(写入中断)被截掉;
+ *        标定、标签和起始时间沿用已有文件头
+ */
+bool RecordWriter::open(const QString& path, const Record::FileHeader& header, bool append)
+{
+    close();
+    m_error.clear();
+    m_header = header;
+    if (m_header.startTimeMs == 0) {
+        m_header.startTimeMs = QDateTime::currentMSecsSinceEpoch();
+    }
+    m_nextIndex = 0;
+    m_file.setFileName(path);
+
+    const bool existing = append && QFileInfo(path).size() > 0;
+    if (!m_file.open(existing ? QIODevice::ReadWrite : (QIODevice::WriteOnly | QIODevice::Truncate))) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (existing) {
+        QByteArray raw = m_file.read(Record::FILE_HEADER_SIZE);
+        Record::FileHeader onDisk;
+        if (!RecordReader::parseHeader(raw.constData(), raw.size(), onDisk, &m_error)) {
+            m_file.close();
+            return false;
+        }
+        if (onDisk.format != header.format || onDisk.axes != header.axes
+                || onDisk.samplesPerBlock != header.samplesPerBlock) {
+            m_error = QStringLiteral("existing file has a different sample format or block size");
+            m_file.close();
+            return false;
+        }
+        m_header = onDisk;
+        QVector<qint64> offsets;
+        const qint64 end = RecordReader::scanBlocks(m_file, m_header, &offsets);
+        if (end != m_file.size()) {
+            qWarning() << "RecordWriter: truncating partial block at end of" << path;
+            m_file.resize(end);
+        }
+        m_nextIndex = static_cast<quint32>(offsets.size());
+        m_size = end;
+        m_file.seek(end);
+    } else {
+        m_header.crc = headerCrc(m_header);
+        if (m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header)) != sizeof(m_header)) {
+            m_error = m_file.errorString();
+            m_file.close();
+            return false;
+        }
+        m_size = Record::FILE_HEADER_SIZE;
+    }
+    m_block.resize(static_cast<int>(m_header.blockBytes()));
+    return true;
+}
+
+void RecordWriter::close()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+        m_file.close();
+    }
+}
+
+/**
+ * @brief 编码一块; FormatPacked10 只编码 count 个有效点，各轴码流依次存放，长度写入块头 payloadBytes
+ */
+template <typename T>
+int RecordWriter::encodeBlock(const Record::FileHeader& header, quint32 index, const T* x, const T* y, const T* z,
+                              int count, quint64 frameSequence, qint64 timeMs, char* out)
+{
+    Record::BlockHeader blockHeader;
+    blockHeader.index = index;
+    blockHeader.frameSequence = frameSequence;
+    blockHeader.timeMs = timeMs;
+    blockHeader.count = static_cast<quint16>(count);
+
+    // 各轴按列存放，不足 samplesPerBlock 的部分补 0
+    const T* const axes[NUM_AXES] = { x, y, z };
+    const int n = static_cast<int>(header.samplesPerBlock);
+    char* payload = out + Record::BLOCK_HEADER_SIZE;
+    qint64 bytes = header.blockBytes();
+    if (header.format == Record::FormatPacked10) {
+        quint16* codes = codeScratch(count);
+        int payloadBytes = 0;
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            const T* src = axes[axis];
+            for (int i = 0; i < count; ++i) {
+                codes[i] = AdcDecoder::toRaw(static_cast<float>(src[i]), header.scale[axis], header.offset[axis]);
+            }
+            payloadBytes += AdcCodec::encode(codes, count, payload + payloadBytes);
+        }
+        blockHeader.payloadBytes = static_cast<quint16>(payloadBytes);
+        bytes = Record::BLOCK_HEADER_SIZE + payloadBytes;
+    }
+    memcpy(out, &blockHeader, sizeof(blockHeader));
+
+    for (int axis = 0; axis < NUM_AXES && header.fixedBlocks(); ++axis) {
+        const T* src = axes[axis];
+        if (header.format == Record::FormatRaw10) {
+            quint16* dst = reinterpret_cast<quint16*>(payload) + axis * n;
+            const float scale = header.scale[axis];
+            const float offset = header.offset[axis];
+            for (int i = 0; i < count; ++i) {
+                dst[i] = AdcDecoder::toRaw(static_cast<float>(src[i]), scale, offset);
+            }
+            memset(dst + count, 0, (n - count) * sizeof(quint16));
+        } else {
+            float* dst = reinterpret_cast<float*>(payload) + axis * n;
+            for (int i = 0; i < count; ++i) {
+                dst[i] = static_cast<float>(src[i]);
+            }
+            memset(dst + count, 0, (n - count) * sizeof(float));
+        }
+    }
+    const quint32 crc = blockCrc(out, bytes);
+    memcpy(out + offsetof(Record::BlockHeader, crc), &crc, sizeof(crc));
+    return static_cast<int>(bytes);
+}
+
+template int RecordWriter::encodeBlock<float>(const Record::FileHeader&, quint32, const float*, const float*,
+                                              const float*, int, quint64, qint64, char*);
+template int RecordWriter::encodeBlock<double>(const Record::FileHeader&, quint32, const double*, const double*,
+                                               const double*, int, quint64, qint64, char*);
+
+template <typename T>
+bool RecordWriter::appendEncoded(const T* x, const T* y, const T* z, int count, quint64 frameSequence, qint64 timeMs)
+{
+    if (!m_file.isOpen() || count < 0 || count > static_cast<int>(m_header.samplesPerBlock)) {
+        return false;
+    }
+    const int bytes = encodeBlock(m_header, m_nextIndex, x, y, z, count, frameSequence,
+                                  timeMs ? timeMs : QDateTime::currentMSecsSinceEpoch(), m_block.data());
+    if (m_file.write(m_block.constData(), bytes) != bytes) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_nextIndex++;
+    m_size += bytes;
+    return true;
+}
+
+bool RecordWriter::appendBlock(const float* x, const float* y, const float* z, int count,
+                               quint64 frameSequence, qint64 timeMs)
+{
+    return appendEncoded(x, y, z, count, frameSequence, timeMs);
+}
+
+bool RecordWriter::appendBlock(const double* x, const double* y, const double* z, int count,
+                               quint64 frameSequence, qint64 timeMs)
+{
+    return appendEncoded(x, y, z, count, frameSequence, timeMs);
+}
+
+bool RecordWriter::flush()
+{
+    if (!m_file.isOpen() || !m_file.flush()) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool RecordWriter::writeEncoded(const char* data, qint64 size, quint32 completedBlocks)
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (m_file.write(data, size) != size || !m_file.flush()) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_size += size;
+    m_nextIndex += completedBlocks;
+    return true;
+}
+
+bool RecordWriter::sync()
+{
+    if (!flush()) {
+        return false;
+    }
+    if (fdatasync(m_file.handle()) != 0) {
+        m_error = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool RecordReader::parseHeader(const char* data, qint64 size, Record::FileHeader& header, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    if (size < Record::FILE_HEADER_SIZE) {
+        return fail(QStringLiteral("file too short for header"));
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != Record::FILE_MAGIC) {
+        return fail(QStringLiteral("not a record file"));
+    }
+    if (header.version != Record::VERSION || header.headerSize != Record::FILE_HEADER_SIZE) {
+        return fail(QStringLiteral("unsupported record version %1").arg(header.version));
+    }
+    if (headerCrc(header) != header.crc) {
+        return fail(QStringLiteral("header CRC mismatch"));
+    }
+    if (header.axes != NUM_AXES || header.samplesPerBlock == 0 || header.samplesPerBlock > 65535
+            || (header.format != Record::FormatRaw10 && header.format != Record::FormatFloat32
+                && header.format != Record::FormatPacked10)
+            || header.blockBytes() - Record::BLOCK_HEADER_SIZE > 65535) {
+        return fail(QStringLiteral("unsupported layout (format %1, %2 axes, %3 samples per block)")
+                        .arg(header.format).arg(header.axes).arg(header.samplesPerBlock));
+    }
+    return true;
+}
+
+bool RecordReader::open(const QString& path)
+{
+    m_file.close();
+    m_error.clear();
+    m_blockCount = 0;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    QByteArray raw = m_file.read(Record::FILE_HEADER_SIZE);
+    if (!parseHeader(raw.constData(), raw.size(), m_header, &m_error)) {
+        m_file.close();
+        return false;
+    }
+    m_offsets.clear();
+    const qint64 end = scanBlocks(m_file, m_header, m_header.fixedBlocks() ? nullptr : &m_offsets);
+    m_blockCount = static_cast<quint32>(m_header.fixedBlocks()
+                                            ? (end - Record::FILE_HEADER_SIZE) / m_header.blockBytes()
+                                            : m_offsets.size());
+    m_block.resize(static_cast<int>(m_header.blockBytes()));
+    return true;
+}
+
+qint64 RecordReader::blockOffset(quint32 index) const
+{
+    return m_header.fixedBlocks() ? Record::FILE_HEADER_SIZE + qint64(index) * m_header.blockBytes() : m_offsets[index];
+}
+
+qint64 RecordReader::blockBytes(const Record::FileHeader& header, const Record::BlockHeader& blockHeader)
+{
+    if (header.fixedBlocks()) {
+        return header.blockBytes();
+    }
+    const qint64 bytes = Record::BLOCK_HEADER_SIZE + qint64(blockHeader.payloadBytes);
+    return bytes <= header.blockBytes() ? bytes : -1;
+}
+
+/**
+ * @brief 定位文件中的完整块; 变长格式逐个读取块头(不读数据，不校验 CRC)，遇到序号不连续或越过文件末尾时停止
+ */
+qint64 RecordReader::scanBlocks(QFile& file, const Record::FileHeader& header, QVector<qint64>* offsets)
+{
+    const qint64 fileSize = file.size();
+    if (header.fixedBlocks()) {
+        const qint64 blocks = qMax<qint64>(0, fileSize - Record::FILE_HEADER_SIZE) / header.blockBytes();
+        if (offsets) {
+            offsets->resize(static_cast<int>(blocks));
+            for (qint64 i = 0; i < blocks; ++i) {
+                (*offsets)[static_cast<int>(i)] = Record::FILE_HEADER_SIZE + i * header.blockBytes();
+            }
+        }
+        return Record::FILE_HEADER_SIZE + blocks * header.blockBytes();
+    }
+    qint64 pos = Record::FILE_HEADER_SIZE;
+    for (quint32 index = 0; pos + Record::BLOCK_HEADER_SIZE <= fileSize; ++index) {
+        Record::BlockHeader bh;
+        if (!file.seek(pos) || file.read(reinterpret_cast<char*>(&bh), sizeof(bh)) != sizeof(bh)) {
+            break;
+        }
+        const qint64 bytes = blockBytes(header, bh);
+        if (bh.magic != Record::BLOCK_MAGIC || bh.index != index || bytes < 0 || pos + bytes > fileSize) {
+            break;
+        }
+        if (offsets) {
+            offsets->append(pos);
+        }
+        pos += bytes;
+    }
+    return pos;
+}
+
+int RecordReader::readBlock(quint32 index, float* x, float* y, float* z, Record::BlockHeader* blockHeader)
+{
+    if (!m_file.isOpen() || index >= m_blockCount) {
+        return -1;
+    }
+    const qint64 offset = blockOffset(index);
+    const qint64 bytes = (index + 1 < m_blockCount ? blockOffset(index + 1) : m_file.size()) - offset;
+    const qint64 length = qMin(bytes, qint64(m_block.size()));
+    if (!m_file.seek(offset) || m_file.read(m_block.data(), length) != length) {
+        m_error = m_file.errorString();
+        return -1;
+    }
+    int count = decodeBlock(m_header, m_block.constData(), x, y, z, blockHeader);
+    if (count < 0) {
+        m_error = QStringLiteral("block %1 is corrupt").arg(index);
+    }
+    return count;
+}
+
+/**
+ * @brief 校验并解码一块; Raw10/Packed10 的换算与 AdcDecoder::rebuildTable 相同(先乘后加)，与采集时的 float 值一致
+ */
+int RecordReader::decodeBlock(const Record::FileHeader& header, const char* data, float* x, float* y, float* z,
+                              Record::BlockHeader* blockHeader)
+{
+    Record::BlockHeader bh;
+    memcpy(&bh, data, sizeof(bh));
+    const qint64 bytes = blockBytes(header, bh);
+    if (bh.magic != Record::BLOCK_MAGIC || bh.count > header.samplesPerBlock || bytes < 0
+            || blockCrc(data, bytes) != bh.crc) {
+        return -1;
+    }
+    if (blockHeader) {
+        *blockHeader = bh;
+    }
+    float* const out[NUM_AXES] = { x, y, z };
+    const int n = static_cast<int>(header.samplesPerBlock);
+    const char* payload = data + Record::BLOCK_HEADER_SIZE;
+    if (header.format == Record::FormatPacked10) {
+        quint16* codes = codeScratch(bh.count);
+        int used = 0;
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            const int consumed = AdcCodec::decode(payload + used, bh.payloadBytes - used, codes, bh.count);
+            if (consumed < 0) {
+                return -1;
+            }
+            used += consumed;
+            for (int i = 0; i < bh.count; ++i) {
+                float v = static_cast<float>(codes[i]) * header.scale[axis];
+                out[axis][i] = v + header.offset[axis];
+            }
+        }
+        return bh.count;
+    }
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        float* dst = out[axis];
+        if (header.format == Record::FormatRaw10) {
+            const quint16* src = reinterpret_cast<const quint16*>(payload) + axis * n;
+            const float scale = header.scale[axis];
+            const float offset = header.offset[axis];
+            for (int i = 0; i < bh.count; ++i) {
+                float v = static_cast<float>(src[i]) * scale;
+                dst[i] = v + offset;
+            }
+        } else {
+            memcpy(dst, payload + axis * n * sizeof(float), bh.count * sizeof(float));
+        }
+    }
+    return bh.count;
+}
@@ -0,0 +1,168 @@
+#ifndef RECORDFILE_H
+#define RECORDFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+#include <cstddef>
+#include "adccodec.h"
+#include "datareader.h"
+
+namespace Record {
+// 与 Python/run_on_loong/recordfile.py 中的定义保持一致，数据均为小端
+const quint32 FILE_MAGIC = 0x4352534C;   // "LSRC"
+const quint32 BLOCK_MAGIC = 0x4B4C4252;  // "RBLK"
+const quint16 VERSION = 1;
+const int FILE_HEADER_SIZE = 256;
+const int BLOCK_HEADER_SIZE = 32;        // magic(4) | index(4) | frameSequence(8) | timeMs(8) | count(2) | payloadBytes(2) | crc(4)
+const int LABEL_SIZE = 64;               // 标签(UTF-8，末尾补 0)
+
+enum SampleFormat : quint16 {
+    FormatRaw10 = 1,   // 10 位 ADC 码值，每点 uint16，value = raw * scale + offset
+    FormatFloat32 = 2, // 已换算的 float32(非线性标定或外部数据)
+    FormatPacked10 = 3 // 10 位码值经 AdcCodec 无损压缩，各轴码流依次存放，块长可变
+};
+
+/**
+ * @brief 文件头(FILE_HEADER_SIZE 字节，按内存布局直接读写)
+ * 定长格式(Raw10/Float32)的第 i 块位于 FILE_HEADER_SIZE + i * blockBytes()，可随机访问;
+ * FormatPacked10 的块长由块头 payloadBytes 给出，需顺序扫描块头建立偏移表.
+ */
+struct FileHeader {
+    quint32 magic = FILE_MAGIC;
+    quint16 version = VERSION;
+    quint16 headerSize = FILE_HEADER_SIZE;
+    quint16 format = FormatRaw10;
+    quint16 axes = NUM_AXES;
+    quint32 sampleRate = SAMPLE_RATE_HZ;
+    quint32 samplesPerBlock = SAMPLES_PER_AXIS; // 每块每轴的点数
+    quint32 reserved0 = 0;
+    qint64 startTimeMs = 0;                     // 文件创建时刻(UTC, ms)
+    float scale[NUM_AXES] = { 10.0f / 1023.0f, 10.0f / 1023.0f, 10.0f / 1023.0f };
+    float offset[NUM_AXES] = { -5.0f, -5.0f, -5.0f };
+    char label[LABEL_SIZE] = {};
+    quint8 reserved[FILE_HEADER_SIZE - 32 - 8 * NUM_AXES - LABEL_SIZE - 4] = {};
+    quint32 crc = 0;                            // 以上全部字节的 CRC32
+
+    bool fixedBlocks() const { return format != FormatPacked10; }
+    int bytesPerSample() const { return format == FormatFloat32 ? 4 : 2; }
+    // 每块在文件中的字节数(块头 + 各轴按列存放的数据); FormatPacked10 为最大块长(按未压缩估计)
+    qint64 blockBytes() const
+    {
+        return BLOCK_HEADER_SIZE + (fixedBlocks() ? qint64(samplesPerBlock) * axes * bytesPerSample()
+                                                  : qint64(axes) * AdcCodec::maxEncodedSize(int(samplesPerBlock)));
+    }
+};
+static_assert(sizeof(FileHeader) == FILE_HEADER_SIZE, "Record::FileHeader layout");
+
+struct BlockHeader {
+    quint32 magic = BLOCK_MAGIC;
+    quint32 index = 0;          // 块在文件中的序号，从 0 连续递增
+    quint64 frameSequence = 0;  // 采集帧序号(AdcFrame::sequence)，不连续表示采集丢帧
+    qint64 timeMs = 0;          // 块首点的采集时刻(UTC, ms)
+    quint16 count = 0;          // 有效点数(<= samplesPerBlock)，定长格式其余补 0
+    quint16 payloadBytes = 0;   // FormatPacked10: 块头之后的数据字节数; 定长格式为 0
+    quint32 crc = 0;            // 块头(不含 crc)与数据的 CRC32
+};
+static_assert(sizeof(BlockHeader) == BLOCK_HEADER_SIZE, "Record::BlockHeader layout");
+
+// * IEEE 802.3 CRC32(与 zlib.crc32 相同)，crc 为前一段的结果，用于分段计算
+quint32 crc32(const void* data, size_t size, quint32 crc = 0);
+}
+
+/**
+ * @brief 块结构二进制录制文件的写入端，替代 Monitor 归档和 Collect 模式的文本 CSV
+ * 每块保存一帧三轴数据(按列存放)，FormatRaw10 下每点 2 字节(文本 CSV 约 40 字节)，
+ * 写入时只做整数换算和 CRC，不做浮点格式化. 追加到已有文件时校验文件头并从最后一个完整块之后继续.
+ * FormatRaw10 按文件头中的线性标定把数值换算回码值(四舍五入)，与 AdcDecoder 的线性路径互为逆运算;
+ * FormatPacked10 在此基础上经 AdcCodec 压缩，平稳的振动信号每点约 6~9 位.
+ */
+class RecordWriter
+{
+public:
+    RecordWriter();
+    ~RecordWriter();
+
+    // * 新建或追加: 文件已存在且文件头与 header 的格式、轴数、块长一致时追加，否则返回 false
+    // * header.startTimeMs 为 0 时取当前时间
+    bool open(const QString& path, const Record::FileHeader& header, bool append = true);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString fileName() const { return m_file.fileName(); }
+    QString errorString() const { return m_error; }
+    const Record::FileHeader& header() const { return m_header; }
+    quint32 blockCount() const { return m_nextIndex; }
+
+    // * 写入一块，count <= samplesPerBlock; timeMs 为 0 时取当前时间
+    bool appendBlock(const float* x, const float* y, const float* z, int count,
+                     quint64 frameSequence, qint64 timeMs = 0);
+    bool appendBlock(const double* x, const double* y, const double* z, int count,
+                     quint64 frameSequence, qint64 timeMs = 0);
+    bool flush();
+    // * 写入已编码的数据并立即交给内核(一次 write)，可以在块中间截断，剩余部分随下一次写入;
+    // * 供自行合并写入的后台写入线程使用，completedBlocks 为本次写入后新完整落盘的块数
+    bool writeEncoded(const char* data, qint64 size, quint32 completedBlocks);
+    // * 刷新并把文件数据同步到存储介质(fdatasync)
+    bool sync();
+    // 当前文件长度(文件头 + 已写入的数据)
+    qint64 size() const { return m_size; }
+
+    // * 把一块编码到 out(至少 Record::FileHeader::blockBytes() 字节)，供后台写入线程等自行管理 I/O 的调用者使用;
+    // * 返回该块的实际字节数
+    template <typename T>
+    static int encodeBlock(const Record::FileHeader& header, quint32 index, const T* x, const T* y, const T* z,
+                            int count, quint64 frameSequence, qint64 timeMs, char* out);
+
+private:
+    template <typename T>
+    bool appendEncoded(const T* x, const T* y, const T* z, int count, quint64 frameSequence, qint64 timeMs);
+
+    QFile m_file;
+    Record::FileHeader m_header;
+    QByteArray m_block;     // 复用的块缓冲区
+    quint32 m_nextIndex = 0;
+    qint64 m_size = 0;
+    QString m_error;
+};
+
+/**
+ * @brief 录制文件的读取端，按块随机访问
+ */
+class RecordReader
+{
+public:
+    bool open(const QString& path);
+    void close() { m_file.close(); }
+    QString errorString() const { return m_error; }
+    const Record::FileHeader& header() const { return m_header; }
+    // 完整块的个数(末尾不完整的块忽略)
+    quint32 blockCount() const { return m_blockCount; }
+
+    // * 读取第 index 块并换算为 float，x/y/z 至少 samplesPerBlock 点; 返回有效点数，CRC 错误或读取失败返回 -1
+    int readBlock(quint32 index, float* x, float* y, float* z, Record::BlockHeader* blockHeader = nullptr);
+
+    // * 解码内存中的一块，data 至少包含 blockBytes(header, 块头) 字节，供 mmap 等直接访问文件内容的调用者使用
+    static int decodeBlock(const Record::FileHeader& header, const char* data, float* x, float* y, float* z,
+                           Record::BlockHeader* blockHeader = nullptr);
+    // * 块在文件中的实际字节数; 块头损坏(payloadBytes 超出最大块长)时返回 -1
+    static qint64 blockBytes(const Record::FileHeader& header, const Record::BlockHeader& blockHeader);
+    // * 从文件头之后逐个检查块头，返回最后一个完整块的结束偏移; offsets 非空时填入各块的起始偏移
+    // * 定长格式直接按文件长度计算，不读取块头
+    static qint64 scanBlocks(QFile& file, const Record::FileHeader& header, QVector<qint64>* offsets = nullptr);
+    // * 校验并解析文件头
+    static bool parseHeader(const char* data, qint64 size, Record::FileHeader& header, QString* error = nullptr);
+
+private:
+    qint64 blockOffset(quint32 index) const;
+
+    QFile m_file;
+    Record::FileHeader m_header;
+    QByteArray m_block;
+    QVector<qint64> m_offsets;  // FormatPacked10 各块的起始偏移
+    quint32 m_blockCount = 0;
+    QString m_error;
+};
+
+#endif // RECORDFILE_H
@@ -0,0 +1,420 @@
+#include "recordwriterthread.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <cstring>
+
+namespace {
+// 合并缓冲区需要容纳的最大块长(Float32 格式，大于 Packed10 的最大块长)
+const qint64 MAX_BLOCK_BYTES = Record::BLOCK_HEADER_SIZE + qint64(SAMPLES_PER_AXIS) * NUM_AXES * sizeof(float);
+static_assert(qint64(NUM_AXES) * AdcCodec::maxEncodedSize(SAMPLES_PER_AXIS) + Record::BLOCK_HEADER_SIZE <= MAX_BLOCK_BYTES,
+              "staging buffer too small for packed blocks");
+// 无新数据时的最长等待(ms)，用于检查延迟写入和定时同步
+const unsigned long IDLE_WAIT_MS = 100;
+// 设置了消费者环时查询新帧的间隔(ms)，远小于一帧的时长(102.4ms)
+const unsigned long SOURCE_POLL_MS = 20;
+}
+
+RecordWriterThread::RecordWriterThread(QObject *parent)
+    : QThread(parent)
+    , m_queue(new BlockQueue)
+    , m_captureRemaining(0)
+    , m_stopRequested(false)
+    , m_blocksQueued(0)
+    , m_blocksWritten(0)
+    , m_blocksDropped(0)
+    , m_framesCaptured(0)
+    , m_bytesWritten(0)
+    , m_writes(0)
+    , m_syncs(0)
+    , m_stalls(0)
+    , m_errors(0)
+    , m_peakBacklog(0)
+    , m_maxWriteUs(0)
+{
+}
+
+RecordWriterThread::~RecordWriterThread()
+{
+    stop();
+    wait();
+}
+
+void RecordWriterThread::setSyncPolicy(SyncPolicy policy, int intervalMs)
+{
+    m_syncPolicy = policy;
+    m_syncIntervalMs = qMax(1, intervalMs);
+}
+
+void RecordWriterThread::setCoalescing(int bytes, int maxLatencyMs)
+{
+    if (isRunning()) {
+        qWarning() << "RecordWriterThread: setCoalescing() must be called before start().";
+        return;
+    }
+    m_coalesceBytes = qMax(WRITE_ALIGN, bytes);
+    m_maxLatencyMs = qMax(0, maxLatencyMs);
+}
+
+void RecordWriterThread::setStallThresholdMs(int ms)
+{
+    m_stallThresholdMs = ms;
+}
+
+void RecordWriterThread::setSource(AcquisitionThread::FrameRing* ring)
+{
+    if (isRunning()) {
+        qWarning() << "RecordWriterThread: setSource() must be called before start().";
+        return;
+    }
+    m_source = ring;
+}
+
+void RecordWriterThread::startCapture(int frames)
+{
+    m_captureRemaining.store(frames > 0 ? frames : -1, std::memory_order_release);
+    wake();
+}
+
+void RecordWriterThread::stopCapture()
+{
+    m_captureRemaining.store(0, std::memory_order_release);
+}
+
+void RecordWriterThread::wake()
+{
+    QMutexLocker locker(&m_mutex);
+    m_wakeup.wakeOne();
+}
+
+void RecordWriterThread::openFile(const QString& path, const Record::FileHeader& header)
+{
+    Command command;
+    command.kind = Command::Open;
+    command.path = path;
+    command.header = header;
+    QMutexLocker locker(&m_mutex);
+    command.position = m_enqueued;
+    m_commands.append(command);
+    m_wakeup.wakeOne();
+}
+
+void RecordWriterThread::closeFile()
+{
+    Command command;
+    command.kind = Command::Close;
+    QMutexLocker locker(&m_mutex);
+    command.position = m_enqueued;
+    m_commands.append(command);
+    m_wakeup.wakeOne();
+}
+
+/**
+ * @brief 复制一帧到队列的空槽中，不做任何 I/O; 队列满说明存储跟不上采集，丢弃该帧并计数
+ */
+bool RecordWriterThread::enqueue(quint64 frameSequence, qint64 timeMs,
+                                 const double* x, const double* y, const double* z, int count)
+{
+    if (count <= 0 || count > SAMPLES_PER_AXIS) {
+        return false;
+    }
+    Block* slot = m_queue->writeSlot();
+    if (!slot) {
+        m_blocksDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slot->frameSequence = frameSequence;
+    slot->timeMs = timeMs;
+    slot->count = count;
+    for (int i = 0; i < count; ++i) {
+        slot->x[i] = static_cast<float>(x[i]);
+        slot->y[i] = static_cast<float>(y[i]);
+        slot->z[i] = static_cast<float>(z[i]);
+    }
+    m_queue->publish();
+    m_blocksQueued.fetch_add(1, std::memory_order_relaxed);
+    const int backlog = static_cast<int>(m_queue->size());
+    if (backlog > m_peakBacklog.load(std::memory_order_relaxed)) {
+        m_peakBacklog.store(backlog, std::memory_order_relaxed);
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_enqueued++;
+        m_wakeup.wakeOne();
+    }
+    return true;
+}
+
+void RecordWriterThread::stop()
+{
+    m_stopRequested.store(true, std::memory_order_release);
+    wake();
+}
+
+RecordWriterThread::Stats RecordWriterThread::stats() const
+{
+    Stats s;
+    s.blocksQueued = m_blocksQueued.load(std::memory_order_relaxed);
+    s.blocksWritten = m_blocksWritten.load(std::memory_order_relaxed);
+    s.blocksDropped = m_blocksDropped.load(std::memory_order_relaxed);
+    s.framesCaptured = m_framesCaptured.load(std::memory_order_relaxed);
+    s.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    s.writes = m_writes.load(std::memory_order_relaxed);
+    s.syncs = m_syncs.load(std::memory_order_relaxed);
+    s.stalls = m_stalls.load(std::memory_order_relaxed);
+    s.errors = m_errors.load(std::memory_order_relaxed);
+    s.backlog = static_cast<int>(m_queue->size());
+    s.peakBacklog = m_peakBacklog.load(std::memory_order_relaxed);
+    s.maxWriteUs = m_maxWriteUs.load(std::memory_order_relaxed);
+    return s;
+}
+
+/**
+ * @brief 取出已到期(之前入队的帧均已消费)的第一个打开/关闭请求
+ */
+bool RecordWriterThread::takeCommand(Command& command)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_commands.isEmpty() || m_commands.first().position > m_consumed) {
+        return false;
+    }
+    command = m_commands.takeFirst();
+    return true;
+}
+
+void RecordWriterThread::applyCommand(const Command& command)
+{
+    closeCurrent();
+    if (command.kind != Command::Open) {
+        return;
+    }
+    if (!m_writer.open(command.path, command.header, true)) {
+        m_errors.fetch_add(1, std::memory_order_relaxed);
+        qWarning() << "RecordWriterThread: Cannot open" << command.path << m_writer.errorString();
+        emit writeError(command.path, m_writer.errorString());
+        return;
+    }
+    m_nextIndex = m_writer.blockCount();
+    m_lastSyncMs = m_clock.elapsed();
+    m_dirty = false;
+    emit fileOpened(command.path, m_nextIndex);
+}
+
+/**
+ * @brief 把一帧编码到合并缓冲区末尾; 没有打开的文件时丢弃并计数
+ */
+bool RecordWriterThread::stageBlock(quint64 frameSequence, qint64 timeMs, const float* x, const float* y, const float* z, int count)
+{
+    if (!m_writer.isOpen()) {
+        m_blocksDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const qint64 maxBlockBytes = m_writer.header().blockBytes();
+    if (m_staged + maxBlockBytes > m_stagingCapacity && !writeStaged(true)) {
+        m_blocksDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (m_staged == 0) {
+        m_stagedSinceMs = m_clock.elapsed();
+    }
+    m_staged += RecordWriter::encodeBlock(m_writer.header(), m_nextIndex++, x, y, z, count,
+                                          frameSequence, timeMs, m_staging.get() + m_staged);
+    m_stagedEnds.append(m_staged);
+    return true;
+}
+
+/**
+ * @brief 消费者环中的一帧: 采集期间写入当前文件并计数，写满请求的帧数时停止采集; 其余时间丢弃
+ */
+void RecordWriterThread::captureFrame(const AdcFrame& frame)
+{
+    int remaining = m_captureRemaining.load(std::memory_order_acquire);
+    if (remaining == 0) {
+        return;
+    }
+    if (!m_writer.isOpen()) {
+        // startCapture 之前的 openFile 请求可能在本轮取命令之后才到达
+        Command command;
+        while (takeCommand(command)) {
+            applyCommand(command);
+        }
+    }
+    if (!stageBlock(frame.sequence, AcquisitionThread::wallTimeMs(frame.timestampNs), frame.x, frame.y, frame.z, SAMPLES_PER_AXIS)) {
+        return;
+    }
+    const quint64 captured = m_framesCaptured.fetch_add(1, std::memory_order_relaxed) + 1;
+    while (remaining > 0 && !m_captureRemaining.compare_exchange_weak(remaining, remaining - 1, std::memory_order_acq_rel)) {
+    }
+    if (remaining == 1) {
+        emit captureFinished(captured);
+    }
+}
+
+/**
+ * @brief 把合并缓冲区写入文件
+ * @param all 为 false 时只写到文件偏移的 WRITE_ALIGN 边界，剩余不足一页的部分留在缓冲区开头
+ */
+bool RecordWriterThread::writeStaged(bool all)
+{
+    if (m_staged == 0 || !m_writer.isOpen()) {
+        return m_writer.isOpen();
+    }
+    qint64 length = m_staged;
+    if (!all) {
+        const qint64 alignedEnd = (m_writer.size() + m_staged) & ~qint64(WRITE_ALIGN - 1);
+        length = alignedEnd - m_writer.size();
+        if (length <= 0) {
+            return true;
+        }
+    }
+
+    // 本次写入后完整落盘的块
+    int completed = 0;
+    while (completed < m_stagedEnds.size() && m_stagedEnds[completed] <= length) {
+        completed++;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_writer.writeEncoded(m_staging.get(), length, static_cast<quint32>(completed))) {
+        fail(m_writer.errorString());
+        return false;
+    }
+    recordLatency(timer.nsecsElapsed() / 1000);
+    m_dirty = true;
+    m_writes.fetch_add(1, std::memory_order_relaxed);
+    m_bytesWritten.fetch_add(static_cast<quint64>(length), std::memory_order_relaxed);
+    m_blocksWritten.fetch_add(static_cast<quint64>(completed), std::memory_order_relaxed);
+
+    m_staged -= length;
+    if (m_staged > 0) {
+        memmove(m_staging.get(), m_staging.get() + length, static_cast<size_t>(m_staged));
+    }
+    m_stagedEnds.erase(m_stagedEnds.begin(), m_stagedEnds.begin() + completed);
+    for (qint64& end : m_stagedEnds) {
+        end -= length;
+    }
+    return m_syncPolicy != SyncEveryWrite || syncFile();
+}
+
+/**
+ * @brief 记录一次写入或同步的耗时，超过 m_stallThresholdMs 时计为卡顿
+ */
+void RecordWriterThread::recordLatency(qint64 elapsedUs)
+{
+    if (elapsedUs > m_maxWriteUs.load(std::memory_order_relaxed)) {
+        m_maxWriteUs.store(elapsedUs, std::memory_order_relaxed);
+    }
+    if (elapsedUs >= qint64(m_stallThresholdMs) * 1000) {
+        m_stalls.fetch_add(1, std::memory_order_relaxed);
+        emit stalled(elapsedUs / 1000, static_cast<int>(m_queue->size()));
+    }
+}
+
+bool RecordWriterThread::syncFile()
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_writer.sync()) {
+        fail(m_writer.errorString());
+        return false;
+    }
+    recordLatency(timer.nsecsElapsed() / 1000);
+    m_syncs.fetch_add(1, std::memory_order_relaxed);
+    m_lastSyncMs = m_clock.elapsed();
+    m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief 写出合并缓冲区剩余数据，按同步策略同步后关闭文件
+ */
+void RecordWriterThread::closeCurrent()
+{
+    if (!m_writer.isOpen()) {
+        return;
+    }
+    if (writeStaged(true) && m_dirty && m_syncPolicy != SyncNever) {
+        syncFile();
+    }
+    if (m_writer.isOpen()) {
+        m_writer.close();
+    }
+}
+
+/**
+ * @brief 写入失败: 报告错误，丢弃缓冲区中尚未写入的块并关闭文件(末尾不完整的块在下次追加打开时被截掉)
+ */
+void RecordWriterThread::fail(const QString& message)
+{
+    const QString path = m_writer.fileName();
+    qWarning() << "RecordWriterThread: Write to" << path << "failed:" << message;
+    m_errors.fetch_add(1, std::memory_order_relaxed);
+    m_blocksDropped.fetch_add(m_nextIndex - m_writer.blockCount(), std::memory_order_relaxed);
+    m_staged = 0;
+    m_stagedEnds.clear();
+    m_writer.close();
+    emit writeError(path, message);
+}
+
+/**
+ * @brief 写盘主循环: 按顺序执行打开/关闭请求并编码队列中的帧，攒够 m_coalesceBytes 或超过 m_maxLatencyMs 时写入
+ */
+void RecordWriterThread::run()
+{
+    m_clock.start();
+    m_stagingCapacity = m_coalesceBytes + MAX_BLOCK_BYTES + WRITE_ALIGN;
+    m_staging.reset(new char[m_stagingCapacity]);
+    m_staged = 0;
+    m_stagedEnds.clear();
+    m_stagedEnds.reserve(static_cast<int>(m_stagingCapacity / Record::BLOCK_HEADER_SIZE));
+
+    for (;;) {
+        // * 先读取退出标志，保证 stop() 之前入队的帧都会被写入
+        const bool stopping = m_stopRequested.load(std::memory_order_acquire);
+
+        Command command;
+        for (;;) {
+            while (takeCommand(command)) {
+                applyCommand(command);
+            }
+            const Block* block = m_queue->readSlot();
+            if (block) {
+                stageBlock(block->frameSequence, block->timeMs, block->x, block->y, block->z, block->count);
+                m_queue->release();
+                QMutexLocker locker(&m_mutex);
+                m_consumed++;
+            } else if (const AdcFrame* frame = m_source ? m_source->readSlot() : nullptr) {
+                captureFrame(*frame);
+                m_source->release();
+            } else {
+                break;
+            }
+            if (m_staged >= m_coalesceBytes) {
+                writeStaged(false);
+            }
+        }
+
+        const qint64 now = m_clock.elapsed();
+        if (m_staged > 0 && now - m_stagedSinceMs >= m_maxLatencyMs) {
+            writeStaged(true);
+        }
+        if (m_syncPolicy == SyncPeriodic && m_dirty && m_writer.isOpen() && now - m_lastSyncMs >= m_syncIntervalMs) {
+            syncFile();
+        }
+        if (stopping) {
+            break;
+        }
+
+        QMutexLocker locker(&m_mutex);
+        const bool commandDue = !m_commands.isEmpty() && m_commands.first().position <= m_consumed;
+        if (!m_stopRequested.load(std::memory_order_acquire) && m_queue->isEmpty() && !commandDue) {
+            m_wakeup.wait(&m_mutex, m_source ? SOURCE_POLL_MS : IDLE_WAIT_MS);
+        }
+    }
+
+    closeCurrent();
+    m_staging.reset();
+    const Stats s = stats();
+    qDebug() << "RecordWriterThread: Stopped. written" << s.blocksWritten << "blocks," << s.bytesWritten << "bytes in"
+             << s.writes << "writes," << s.syncs << "syncs; dropped" << s.blocksDropped << ", stalls" << s.stalls
+             << ", max write" << s.maxWriteUs << "us";
+}
@@ -0,0 +1,166 @@
+#ifndef RECORDWRITERTHREAD_H
+#define RECORDWRITERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "datareader.h"
+#include "acquisitionthread.h"
+#include "recordfile.h"
+#include "spscring.h"
+
+/**
+ * @brief Collect 模式的后台写盘线程
+ * 界面线程把每帧复制到预分配的有界队列后立即返回，编码(码值换算、压缩、CRC)和文件 I/O 都在本线程中完成，
+ * SD 卡写入卡顿不会阻塞界面和采集. 队列与合并缓冲区构成双缓冲: 本线程写盘期间界面线程继续向队列放帧.
+ * 多个块在合并缓冲区中攒成大块后一次 write()，写入长度对齐到文件偏移的 WRITE_ALIGN 边界(末尾不足的部分留到下一次);
+ * 按 SyncPolicy 调用 fdatasync. 队列满时丢弃新帧并计数(enqueue 返回 false)，不会阻塞调用者.
+ * 打开/关闭文件的请求与数据帧按调用顺序生效，失败通过 writeError 信号报告.
+ * 设置了采集线程的消费者环(setSource)时，本线程直接按自己的节奏取帧，界面线程只负责 startCapture/stopCapture:
+ * 不在采集期间的帧被取出后丢弃，采集期间的帧写入当前文件. 采集数据不经过界面线程，界面卡顿不会造成录制间隙.
+ */
+class RecordWriterThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum SyncPolicy {
+        SyncNever,      // 只 write()，由内核择机回写
+        SyncOnClose,    // 关闭文件时同步
+        SyncPeriodic,   // 每 syncIntervalMs 同步一次，关闭时同步
+        SyncEveryWrite  // 每次合并写入后同步
+    };
+
+    // 队列中的一帧(界面线程填充)
+    struct Block {
+        quint64 frameSequence;
+        qint64 timeMs;
+        int count;
+        float x[SAMPLES_PER_AXIS];
+        float y[SAMPLES_PER_AXIS];
+        float z[SAMPLES_PER_AXIS];
+    };
+    typedef SpscRing<Block, 64> BlockQueue; // [可调] 64 帧约 6.5 秒数据，约 800KB
+
+    // 运行统计(任意线程读取，近似值)
+    struct Stats {
+        quint64 blocksQueued;    // 成功入队的帧数
+        quint64 blocksWritten;   // 已写入文件的帧数
+        quint64 blocksDropped;   // 队列满或文件未打开而丢弃的帧数
+        quint64 framesCaptured;  // 从消费者环写入文件的帧数(setSource)
+        quint64 bytesWritten;
+        quint64 writes;          // write() 次数
+        quint64 syncs;           // fdatasync 次数
+        quint64 stalls;          // 单次写入或同步超过 stallThresholdMs 的次数
+        quint64 errors;
+        int backlog;             // 当前队列中的帧数
+        int peakBacklog;         // 队列中帧数的峰值
+        qint64 maxWriteUs;       // 单次写入或同步的最长耗时
+    };
+
+    static const int WRITE_ALIGN = 4096;
+
+    explicit RecordWriterThread(QObject *parent = nullptr);
+    ~RecordWriterThread();
+
+    // * 以下设置须在 start() 之前调用
+    void setSyncPolicy(SyncPolicy policy, int intervalMs = 2000);
+    // * 合并缓冲区攒够 bytes 字节时写入; 不足时最多延迟 maxLatencyMs 也写入
+    void setCoalescing(int bytes, int maxLatencyMs);
+    // * 单次写入或同步耗时超过该值时计为一次卡顿并发出 stalled 信号
+    void setStallThresholdMs(int ms);
+    // * 本线程直接消费的采集线程帧环(AcquisitionThread::addConsumer)
+    void setSource(AcquisitionThread::FrameRing* ring);
+
+    // --- 界面线程(唯一生产者)接口，均不阻塞 ---
+    // * 请求打开(已存在时追加)录制文件，之后入队的帧写入该文件
+    void openFile(const QString& path, const Record::FileHeader& header);
+    // * 请求关闭当前文件，之前入队的帧全部写入后关闭
+    void closeFile();
+    // * 复制一帧入队，队列满时丢弃并返回 false; timeMs 为采集时刻
+    bool enqueue(quint64 frameSequence, qint64 timeMs, const double* x, const double* y, const double* z, int count);
+    // * 开始把消费者环中的帧写入当前文件(先调用 openFile)，写满 frames 帧后自动停止并发出 captureFinished; frames <= 0 时不限帧数
+    void startCapture(int frames);
+    void stopCapture();
+    bool isCapturing() const { return m_captureRemaining.load(std::memory_order_acquire) != 0; }
+
+    // * 请求线程退出(线程安全)，退出前写完队列中的帧并关闭文件，随后可调用 wait()
+    void stop();
+
+    Stats stats() const;
+
+signals:
+    // 以下信号均从写盘线程发出(跨线程，排队连接)
+    void fileOpened(const QString& path, quint32 existingBlocks);
+    void writeError(const QString& path, const QString& message);
+    void stalled(qint64 writeMs, int backlog);
+    void captureFinished(quint64 framesCaptured);
+
+protected:
+    void run() override;
+
+private:
+    struct Command {
+        enum Kind { Open, Close } kind;
+        quint64 position;   // 该请求之前入队的帧数，本线程消费到该位置时执行
+        QString path;
+        Record::FileHeader header;
+    };
+
+    void wake();
+    bool takeCommand(Command& command);
+    void applyCommand(const Command& command);
+    bool stageBlock(quint64 frameSequence, qint64 timeMs, const float* x, const float* y, const float* z, int count);
+    void captureFrame(const AdcFrame& frame);
+    bool writeStaged(bool all);
+    bool syncFile();
+    void recordLatency(qint64 elapsedUs);
+    void closeCurrent();
+    void fail(const QString& message);
+
+    std::unique_ptr<BlockQueue> m_queue;
+    AcquisitionThread::FrameRing* m_source = nullptr;
+    std::atomic<int> m_captureRemaining; // 剩余待写帧数，-1 为不限，0 为未在采集
+    QMutex m_mutex;                     // 保护 m_commands，并与 m_wakeup 配合
+    QWaitCondition m_wakeup;
+    QVector<Command> m_commands;
+    quint64 m_enqueued = 0;             // 仅界面线程修改
+
+    // --- 以下仅在写盘线程中使用 ---
+    RecordWriter m_writer;
+    QElapsedTimer m_clock;
+    std::unique_ptr<char[]> m_staging;  // 合并缓冲区，线程启动时按最大块长一次分配
+    qint64 m_stagingCapacity = 0;
+    qint64 m_staged = 0;
+    QVector<qint64> m_stagedEnds;       // 合并缓冲区中各块的结束位置，用于统计已完整写入的块
+    qint64 m_stagedSinceMs = 0;         // 合并缓冲区中最早数据的入缓冲时刻(单调时钟)
+    qint64 m_lastSyncMs = 0;
+    bool m_dirty = false;               // 上次同步后有新写入
+    quint32 m_nextIndex = 0;
+    quint64 m_consumed = 0;
+
+    SyncPolicy m_syncPolicy = SyncPeriodic;
+    int m_syncIntervalMs = 2000;
+    int m_coalesceBytes = 64 * 1024;    // [可调] 约 10 帧
+    int m_maxLatencyMs = 1000;          // [可调]
+    int m_stallThresholdMs = 200;       // [可调] 约两帧的时长
+
+    std::atomic<bool> m_stopRequested;
+    std::atomic<quint64> m_blocksQueued;
+    std::atomic<quint64> m_blocksWritten;
+    std::atomic<quint64> m_blocksDropped;
+    std::atomic<quint64> m_framesCaptured;
+    std::atomic<quint64> m_bytesWritten;
+    std::atomic<quint64> m_writes;
+    std::atomic<quint64> m_syncs;
+    std::atomic<quint64> m_stalls;
+    std::atomic<quint64> m_errors;
+    std::atomic<int> m_peakBacklog;
+    std::atomic<qint64> m_maxWriteUs;
+};
+
+#endif // RECORDWRITERTHREAD_H
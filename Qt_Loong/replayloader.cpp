@@ -0,0 +1,363 @@
+#include "replayloader.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+namespace {
+// 跳过字段前后的空格和制表符
+const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * @brief 从 [p, end) 解析一个浮点数，返回解析结束的位置，失败返回 nullptr
+ * 标准库支持浮点 from_chars(libstdc++ 11 起)时直接在映射区上解析; 否则复制到栈上以 strtof 解析(映射区不以 0 结尾)
+ */
+const char* parseFloat(const char* p, const char* end, float& value)
+{
+    if (p < end && *p == '+') {
+        ++p; // from_chars 不接受前导 '+'
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+    char buffer[64];
+    const size_t n = std::min<size_t>(end - p, sizeof(buffer) - 1);
+    memcpy(buffer, p, n);
+    buffer[n] = '\0';
+    char* stop = nullptr;
+    value = std::strtof(buffer, &stop);
+    return stop != buffer ? p + (stop - buffer) : nullptr;
+#endif
+}
+
+/**
+ * @brief 解析一行 CSV 的第 2~4 列(X,Y,Z)，第 1 列为时间，不解析
+ */
+bool parseCsvLine(const char* p, const char* end, float& x, float& y, float& z)
+{
+    p = static_cast<const char*>(memchr(p, ',', end - p));
+    float* const out[NUM_AXES] = { &x, &y, &z };
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        if (!p || p >= end || *p != ',') {
+            return false;
+        }
+        p = parseFloat(skipBlanks(p + 1, end), end, *out[axis]);
+        if (!p) {
+            return false;
+        }
+        p = skipBlanks(p, end);
+    }
+    return p == end || *p == ',' || *p == '\r';
+}
+}
+
+ReplayLoader::ReplayLoader()
+{
+}
+
+ReplayLoader::~ReplayLoader()
+{
+    close();
+}
+
+/**
+ * @brief 映射文件并识别格式; 不读取数据，索引在访问时建立
+ */
+bool ReplayLoader::open(const QString& path)
+{
+    close();
+    m_error.clear();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (!map()) {
+        close();
+        return false;
+    }
+    quint32 magic = 0;
+    if (m_size >= qint64(sizeof(magic))) {
+        memcpy(&magic, m_data, sizeof(magic));
+    }
+    if (magic == Record::FILE_MAGIC) {
+        if (!RecordReader::parseHeader(m_data, m_size, m_header, &m_error)) {
+            close();
+            return false;
+        }
+        m_format = FormatRecord;
+        m_dataStart = Record::FILE_HEADER_SIZE;
+    } else {
+        // * CSV: 跳过表头，采样率与实时数据一致
+        m_header = Record::FileHeader();
+        m_format = FormatCsv;
+        const char* eol = static_cast<const char*>(memchr(m_data, '\n', m_size));
+        m_dataStart = eol ? eol - m_data + 1 : m_size;
+    }
+    m_blockX.resize(static_cast<int>(m_header.samplesPerBlock));
+    m_blockY.resize(static_cast<int>(m_header.samplesPerBlock));
+    m_blockZ.resize(static_cast<int>(m_header.samplesPerBlock));
+    resetIndex();
+    return true;
+}
+
+void ReplayLoader::close()
+{
+    m_file.close(); // 同时解除映射
+    m_data = nullptr;
+    m_size = 0;
+    m_format = FormatNone;
+    m_dataStart = 0;
+    resetIndex();
+}
+
+bool ReplayLoader::map()
+{
+    m_size = m_file.size();
+    if (m_size <= 0) {
+        m_error = QString("%1 is empty").arg(m_file.fileName());
+        m_data = nullptr;
+        return false;
+    }
+    m_data = reinterpret_cast<const char*>(m_file.map(0, m_size));
+    if (!m_data) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void ReplayLoader::resetIndex()
+{
+    m_blocks.clear();
+    m_lines.clear();
+    m_indexEnd = m_dataStart;
+    m_indexedSamples = 0;
+    m_indexComplete = false;
+    m_cachedBlock = -1;
+    m_cachedCount = 0;
+}
+
+/**
+ * @brief 文件长度变化后重新映射; 文件变长时保留索引从原来的末尾继续，
+ *        变短(如写入端截掉不完整的块)或 CSV 末行原本不完整时重建索引
+ */
+bool ReplayLoader::refresh()
+{
+    if (!isOpen()) {
+        return false;
+    }
+    const qint64 oldSize = m_size;
+    const qint64 newSize = m_file.size();
+    if (newSize == oldSize) {
+        return true;
+    }
+    const bool partialLine = m_format == FormatCsv && m_data[oldSize - 1] != '\n';
+    m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+    if (!map()) {
+        close();
+        return false;
+    }
+    if (newSize < oldSize || newSize < m_indexEnd || partialLine) {
+        resetIndex();
+    } else {
+        m_indexComplete = false;
+    }
+    return true;
+}
+
+const char* ReplayLoader::data(qint64 offset, qint64 bytes) const
+{
+    if (!m_data || offset < 0 || bytes < 0 || offset + bytes > m_size) {
+        return nullptr;
+    }
+    return m_data + offset;
+}
+
+int ReplayLoader::decodeBlockAt(qint64 offset, float* x, float* y, float* z, Record::BlockHeader* blockHeader)
+{
+    const char* p = data(offset, Record::BLOCK_HEADER_SIZE);
+    if (m_format != FormatRecord || !p) {
+        return -1;
+    }
+    Record::BlockHeader bh;
+    memcpy(&bh, p, sizeof(bh));
+    const qint64 bytes = RecordReader::blockBytes(m_header, bh);
+    p = bytes < 0 ? nullptr : data(offset, bytes);
+    return p ? RecordReader::decodeBlock(m_header, p, x, y, z, blockHeader) : -1;
+}
+
+/**
+ * @brief 把索引向后扩展到包含第 sample 个采样点(或到文件末尾)，返回该点是否存在
+ */
+bool ReplayLoader::indexTo(qint64 sample)
+{
+    if (sample < m_indexedSamples) {
+        return true;
+    }
+    if (m_indexComplete) {
+        return false;
+    }
+    return m_format == FormatRecord ? indexRecordTo(sample) : indexCsvTo(sample);
+}
+
+/**
+ * @brief 录制文件: 逐个读取块头(不读数据，不校验 CRC)，记录各块的偏移和首点序号
+ * 定长格式的块头损坏时按 0 点跳过该块; 变长格式无法定位后续块，索引到此为止
+ */
+bool ReplayLoader::indexRecordTo(qint64 sample)
+{
+    Record::BlockHeader bh;
+    while (m_indexedSamples <= sample) {
+        const char* p = data(m_indexEnd, Record::BLOCK_HEADER_SIZE);
+        if (!p) {
+            m_indexComplete = true;
+            break;
+        }
+        memcpy(&bh, p, sizeof(bh));
+        qint64 bytes = RecordReader::blockBytes(m_header, bh);
+        int count = bh.count;
+        if (bh.magic != Record::BLOCK_MAGIC || bytes < 0 || bh.count > m_header.samplesPerBlock) {
+            if (!m_header.fixedBlocks()) {
+                qWarning() << "ReplayLoader: Corrupt block header at" << m_indexEnd << "in" << path() << ", ignoring the rest";
+                m_indexComplete = true;
+                break;
+            }
+            bytes = m_header.blockBytes();
+            count = 0;
+        }
+        if (m_indexEnd + bytes > m_size) {
+            m_indexComplete = true; // 末尾不完整的块
+            break;
+        }
+        m_blocks.append(BlockRef{ m_indexEnd, m_indexedSamples });
+        m_indexedSamples += count;
+        m_indexEnd += bytes;
+    }
+    return sample < m_indexedSamples;
+}
+
+/**
+ * @brief CSV: 用 memchr 逐行查找换行，每 CSV_INDEX_INTERVAL 行记录一个行首偏移; 末行没有换行时也计为一行
+ */
+bool ReplayLoader::indexCsvTo(qint64 row)
+{
+    while (m_indexedSamples <= row) {
+        if (m_indexEnd >= m_size) {
+            m_indexComplete = true;
+            break;
+        }
+        if (m_indexedSamples % Replay::CSV_INDEX_INTERVAL == 0) {
+            m_lines.append(m_indexEnd);
+        }
+        const char* eol = static_cast<const char*>(memchr(m_data + m_indexEnd, '\n', m_size - m_indexEnd));
+        m_indexEnd = eol ? eol - m_data + 1 : m_size;
+        m_indexedSamples++;
+    }
+    return row < m_indexedSamples;
+}
+
+int ReplayLoader::read(qint64 first, int count, float* x, float* y, float* z)
+{
+    if (!isOpen() || first < 0 || count <= 0) {
+        return 0;
+    }
+    indexTo(first + count - 1);
+    const int n = static_cast<int>(qBound<qint64>(0, m_indexedSamples - first, count));
+    if (n == 0) {
+        return 0;
+    }
+    return m_format == FormatRecord ? readRecord(first, n, x, y, z) : readCsv(first, n, x, y, z);
+}
+
+/**
+ * @brief 二分查找首点所在的块，逐块解码到块缓存后复制所需的部分
+ */
+int ReplayLoader::readRecord(qint64 first, int count, float* x, float* y, float* z)
+{
+    auto it = std::upper_bound(m_blocks.cbegin(), m_blocks.cend(), first,
+                               [](qint64 s, const BlockRef& b) { return s < b.firstSample; });
+    int block = int(it - m_blocks.cbegin()) - 1;
+    int done = 0;
+    while (done < count && block < m_blocks.size()) {
+        const qint64 blockFirst = m_blocks[block].firstSample;
+        const qint64 blockEnd = block + 1 < m_blocks.size() ? m_blocks[block + 1].firstSample : m_indexedSamples;
+        if (block != m_cachedBlock) {
+            m_cachedCount = decodeBlockAt(m_blocks[block].offset, m_blockX.data(), m_blockY.data(), m_blockZ.data());
+            if (m_cachedCount < 0) {
+                qWarning() << "ReplayLoader: Corrupt block at" << m_blocks[block].offset << "in" << path() << ", filled with 0";
+                std::fill(m_blockX.begin(), m_blockX.end(), 0.0f);
+                std::fill(m_blockY.begin(), m_blockY.end(), 0.0f);
+                std::fill(m_blockZ.begin(), m_blockZ.end(), 0.0f);
+            }
+            m_cachedBlock = block;
+        }
+        const qint64 from = first + done - blockFirst;
+        const int n = static_cast<int>(qMin<qint64>(count - done, blockEnd - blockFirst - from));
+        if (n > 0) {
+            memcpy(x + done, m_blockX.constData() + from, n * sizeof(float));
+            memcpy(y + done, m_blockY.constData() + from, n * sizeof(float));
+            memcpy(z + done, m_blockZ.constData() + from, n * sizeof(float));
+            done += n;
+        }
+        block++;
+    }
+    return done;
+}
+
+/**
+ * @brief 从稀疏行索引定位到首行(至多向后查找 CSV_INDEX_INTERVAL - 1 个换行)，逐行解析
+ */
+int ReplayLoader::readCsv(qint64 first, int count, float* x, float* y, float* z)
+{
+    const char* const end = m_data + m_size;
+    const char* p = m_data + m_lines[static_cast<int>(first / Replay::CSV_INDEX_INTERVAL)];
+    for (qint64 skip = first % Replay::CSV_INDEX_INTERVAL; skip > 0; --skip) {
+        p = static_cast<const char*>(memchr(p, '\n', end - p)) + 1;
+    }
+    int invalid = 0;
+    for (int i = 0; i < count; ++i) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* lineEnd = eol ? eol : end;
+        if (!parseCsvLine(p, lineEnd, x[i], y[i], z[i])) {
+            x[i] = y[i] = z[i] = 0.0f;
+            invalid++;
+        }
+        p = lineEnd + 1;
+    }
+    if (invalid > 0) {
+        qWarning() << "ReplayLoader:" << invalid << "unparsable lines in" << path() << ", filled with 0";
+    }
+    return count;
+}
+
+int ReplayLoader::readRange(double fromSec, double toSec, QVector<float>& x, QVector<float>& y, QVector<float>& z)
+{
+    const double rate = sampleRate();
+    const qint64 first = qMax<qint64>(0, qRound64(fromSec * rate));
+    const qint64 last = qMax<qint64>(first, qRound64(toSec * rate));
+    const int count = static_cast<int>(qMin<qint64>(last - first, std::numeric_limits<int>::max()));
+    indexTo(first + count - 1);
+    const int n = static_cast<int>(qBound<qint64>(0, m_indexedSamples - first, count));
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    return read(first, n, x.data(), y.data(), z.data());
+}
+
+qint64 ReplayLoader::sampleCount()
+{
+    indexTo(std::numeric_limits<qint64>::max() - 1);
+    return m_indexedSamples;
+}
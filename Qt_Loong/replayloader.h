@@ -0,0 +1,97 @@
+#ifndef REPLAYLOADER_H
+#define REPLAYLOADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "recordfile.h"
+
+namespace Replay {
+const int CSV_INDEX_INTERVAL = 4096; // [可调] CSV 每隔多少行记录一个行偏移
+}
+
+/**
+ * @brief 历史数据回放的读取端: 内存映射录制文件(.rec)或 CSV(Time,X,Y,Z)，按采样点随机访问
+ * open() 只映射文件并解析文件头，不读取数据; 索引(录制文件各块的偏移和首点序号、CSV 每 CSV_INDEX_INTERVAL 行的偏移)
+ * 在访问到相应位置时才向后扩展，之后的访问只做二分查找. 数据直接从映射区解析到调用者预分配的 float 缓冲区:
+ * 录制文件经 RecordReader::decodeBlock 解码，CSV 经 std::from_chars 解析，不经 QString.
+ * 文件保持映射，在同一文件中来回拖动只访问内存; 文件被追加时 refresh() 重新映射并保留已建立的索引.
+ * 非线程安全.
+ */
+class ReplayLoader
+{
+public:
+    enum Format {
+        FormatNone,
+        FormatCsv,
+        FormatRecord
+    };
+
+    ReplayLoader();
+    ~ReplayLoader();
+
+    // * 映射文件: 以 Record::FILE_MAGIC 开头的按录制文件处理，否则按 CSV(首行为表头)处理
+    bool open(const QString& path);
+    void close();
+    // * 文件变长后重新映射(如正在追加的历史分段)，已建立的索引保留
+    bool refresh();
+    bool isOpen() const { return m_data != nullptr; }
+    QString path() const { return m_file.fileName(); }
+    QString errorString() const { return m_error; }
+    Format format() const { return m_format; }
+    // 录制文件的文件头; CSV 为默认文件头(采样率 SAMPLE_RATE_HZ)
+    const Record::FileHeader& header() const { return m_header; }
+    double sampleRate() const { return m_header.sampleRate; }
+    qint64 mappedBytes() const { return m_size; }
+
+    // * 映射区中 [offset, offset + bytes) 的指针，越界返回 nullptr
+    const char* data(qint64 offset, qint64 bytes) const;
+    // * 解码 offset 处的一块(录制文件)，x/y/z 至少 samplesPerBlock 点; 返回有效点数，越界或损坏返回 -1
+    int decodeBlockAt(qint64 offset, float* x, float* y, float* z, Record::BlockHeader* blockHeader = nullptr);
+
+    // * 从第 first 个采样点起读取至多 count 点; 返回实际读取的点数(到文件末尾为止)
+    // * 录制文件中 CRC 错误的块、CSV 中无法解析的行以 0 填充，保持采样点位置不变
+    int read(qint64 first, int count, float* x, float* y, float* z);
+    // * 读取 [fromSec, toSec) 内的数据(相对首点的时间，与回放波形的横轴一致)，x/y/z 按点数 resize(容量足够时不重新分配)
+    int readRange(double fromSec, double toSec, QVector<float>& x, QVector<float>& y, QVector<float>& z);
+    // * 总点数; 需要把索引建到文件末尾(录制文件逐个读取块头，CSV 逐行查找换行)
+    qint64 sampleCount();
+
+private:
+    struct BlockRef {
+        qint64 offset;      // 块在文件中的偏移
+        qint64 firstSample; // 块首点的采样点序号
+    };
+
+    bool map();
+    void resetIndex();
+    bool indexTo(qint64 sample);
+    bool indexRecordTo(qint64 sample);
+    bool indexCsvTo(qint64 row);
+    int readRecord(qint64 first, int count, float* x, float* y, float* z);
+    int readCsv(qint64 first, int count, float* x, float* y, float* z);
+
+    QFile m_file;
+    const char* m_data = nullptr;
+    qint64 m_size = 0;
+    Format m_format = FormatNone;
+    Record::FileHeader m_header;
+    QString m_error;
+    qint64 m_dataStart = 0;             // 首块(录制文件)或首个数据行(CSV)的偏移
+
+    // 录制文件: 已索引的块，m_indexEnd 为下一块的偏移
+    QVector<BlockRef> m_blocks;
+    // CSV: 第 k * CSV_INDEX_INTERVAL 个数据行的起始偏移; m_indexEnd 为第 m_indexedSamples 行的起始偏移
+    QVector<qint64> m_lines;
+    qint64 m_indexEnd = 0;
+    qint64 m_indexedSamples = 0;        // 已索引的采样点数(录制文件)或行数(CSV)
+    bool m_indexComplete = false;       // 已索引到当前映射区的末尾
+
+    // 最近解码的一块，小步拖动时不重复解码
+    QVector<float> m_blockX, m_blockY, m_blockZ;
+    int m_cachedBlock = -1;
+    int m_cachedCount = 0;
+};
+
+#endif // REPLAYLOADER_H
@@ -0,0 +1,696 @@
+#include "resnetengine.h"
+#include "adcdecoder.h"
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RESNET_ENGINE_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__loongarch_sx)
+#include <lsxintrin.h>
+#endif
+#if defined(__loongarch_asx)
+#include <lasxintrin.h>
+#endif
+
+namespace {
+typedef float Vec4 __attribute__((vector_size(16)));
+
+const int kFeatures = 64; // layer3 输出通道数，即 fc 输入维数
+const int kMaxActivation = RESNET_INPUT_H * RESNET_INPUT_W * 16;
+const int kMaxPatches = RESNET_INPUT_H * RESNET_INPUT_W * 3 * 3 * 16; // layer1 的展开输入块最大
+const int kWeightLevels = 127;     // int8 权重 [-127, 127]
+const int kActivationLevels = 255; // ReLU 输出量化为 [0, 255]
+
+const char* const kClassNames[RESNET_NUM_CLASSES] = {
+    "0.7inner", "0.7outer", "0.9inner", "0.9outer", "1.1inner",
+    "1.1outer", "1.3inner", "1.3outer", "1.5inner", "1.5outer",
+    "1.7inner", "1.7outer", "healthy"
+};
+
+// 每个块的 state_dict 前缀及输入/输出通道数、步长
+struct BlockSpec {
+    const char* prefix;
+    int cin;
+    int cout;
+    int stride;
+};
+const BlockSpec kBlockSpecs[6] = {
+    { "layer1.0.", 16, 16, 1 }, { "layer1.1.", 16, 16, 1 },
+    { "layer2.0.", 16, 32, 2 }, { "layer2.1.", 32, 32, 1 },
+    { "layer3.0.", 32, 64, 2 }, { "layer3.1.", 64, 64, 1 },
+};
+
+inline Vec4 loadVec(const float* p)
+{
+    Vec4 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void storeVec(float* p, Vec4 v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+/*
+ * KxK 卷积(补零 K/2)，输入 in[H][W][Cin]，输出 out[OH][OW][Cout]，weight 为 [ky][kx][Cin][Cout].
+ * 每个输出点的 Cout 个累加值常驻向量寄存器，逐个输入值广播后与一行权重相乘累加.
+ * Residual 时输出前加上 residual[OH][OW][Cout](可与 out 为同一缓冲区)，Relu 时再截断负值.
+ */
+template <int Cin, int Cout, int H, int W, int K, int S, bool Relu, bool Residual>
+void conv(const float* in, float* out, const float* weight, const float* bias, const float* residual)
+{
+    const int P = K / 2;
+    const int OH = (H + 2 * P - K) / S + 1;
+    const int OW = (W + 2 * P - K) / S + 1;
+    const int NV = Cout / 4;
+    const Vec4 zero = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (int oy = 0; oy < OH; ++oy) {
+        for (int ox = 0; ox < OW; ++ox) {
+            Vec4 acc[NV];
+#pragma GCC unroll 16
+            for (int j = 0; j < NV; ++j) {
+                acc[j] = loadVec(bias + 4 * j);
+            }
+            for (int ky = 0; ky < K; ++ky) {
+                const int iy = oy * S + ky - P;
+                if (iy < 0 || iy >= H) {
+                    continue;
+                }
+                for (int kx = 0; kx < K; ++kx) {
+                    const int ix = ox * S + kx - P;
+                    if (ix < 0 || ix >= W) {
+                        continue;
+                    }
+                    const float* pixel = in + (iy * W + ix) * Cin;
+                    const float* w = weight + (ky * K + kx) * Cin * Cout;
+                    for (int ci = 0; ci < Cin; ++ci) {
+                        const float x = pixel[ci];
+                        const Vec4 v = { x, x, x, x };
+#pragma GCC unroll 16
+                        for (int j = 0; j < NV; ++j) {
+                            acc[j] += v * loadVec(w + 4 * j);
+                        }
+                        w += Cout;
+                    }
+                }
+            }
+            const int offset = (oy * OW + ox) * Cout;
+#pragma GCC unroll 16
+            for (int j = 0; j < NV; ++j) {
+                Vec4 a = acc[j];
+                if (Residual) {
+                    a += loadVec(residual + offset + 4 * j);
+                }
+                if (Relu) {
+                    a = a > zero ? a : zero;
+                }
+                storeVec(out + offset + 4 * j, a);
+            }
+        }
+    }
+}
+
+/*
+ * int8 卷积的核心: 一个输出点的 K x K x Cin 输入块与 16 个输出通道的权重相乘，acc[0..15] 为整数结果.
+ * 权重按 [len/2][Cout][2] 交织存放(weight 已偏移到该组通道，stride 为相邻两对之间的间隔):
+ * 输入块相邻两个值作为一个 32 位数广播到各通道，与每个通道对应的两个权重做 16 位乘、
+ * 相邻两项相加(pmaddwd / vmaddwev + vmaddwod)，累加值直接按通道排列，不需要水平求和.
+ * 每步处理多对输入，保证有 8 组独立的累加器. len 为 16 的倍数.
+ * 操作数为 16 位，|a * b| <= 255 * 127，两项之和不会溢出 32 位.
+ */
+void gemvScalar(const qint16* patch, const qint16* weight, int len, int stride, int* acc)
+{
+    for (int co = 0; co < 16; ++co) {
+        acc[co] = 0;
+    }
+    for (int i = 0; i < len; i += 2) {
+        const int p0 = patch[i];
+        const int p1 = patch[i + 1];
+        const qint16* w = weight + (i / 2) * stride;
+        for (int co = 0; co < 16; ++co) {
+            acc[co] += p0 * w[2 * co] + p1 * w[2 * co + 1];
+        }
+    }
+}
+
+inline int loadPair(const qint16* p)
+{
+    int pair;
+    memcpy(&pair, p, sizeof(pair));
+    return pair;
+}
+
+#if defined(RESNET_ENGINE_X86)
+__attribute__((target("sse2")))
+void gemvSse2(const qint16* patch, const qint16* weight, int len, int stride, int* acc)
+{
+    __m128i a[2][4];
+#pragma GCC unroll 8
+    for (int j = 0; j < 8; ++j) {
+        a[j / 4][j % 4] = _mm_setzero_si128();
+    }
+    for (int i = 0; i < len; i += 4) {
+#pragma GCC unroll 2
+        for (int k = 0; k < 2; ++k) {
+            const __m128i p = _mm_set1_epi32(loadPair(patch + i + 2 * k));
+            const __m128i* w = reinterpret_cast<const __m128i*>(weight + (i / 2 + k) * stride);
+#pragma GCC unroll 4
+            for (int j = 0; j < 4; ++j) {
+                a[k][j] = _mm_add_epi32(a[k][j], _mm_madd_epi16(p, _mm_loadu_si128(w + j)));
+            }
+        }
+    }
+#pragma GCC unroll 4
+    for (int j = 0; j < 4; ++j) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 4 * j), _mm_add_epi32(a[0][j], a[1][j]));
+    }
+}
+
+__attribute__((target("avx2")))
+void gemvAvx2(const qint16* patch, const qint16* weight, int len, int stride, int* acc)
+{
+    __m256i a[4][2];
+#pragma GCC unroll 8
+    for (int j = 0; j < 8; ++j) {
+        a[j / 2][j % 2] = _mm256_setzero_si256();
+    }
+    for (int i = 0; i < len; i += 8) {
+#pragma GCC unroll 4
+        for (int k = 0; k < 4; ++k) {
+            const __m256i p = _mm256_set1_epi32(loadPair(patch + i + 2 * k));
+            const __m256i* w = reinterpret_cast<const __m256i*>(weight + (i / 2 + k) * stride);
+            a[k][0] = _mm256_add_epi32(a[k][0], _mm256_madd_epi16(p, _mm256_loadu_si256(w)));
+            a[k][1] = _mm256_add_epi32(a[k][1], _mm256_madd_epi16(p, _mm256_loadu_si256(w + 1)));
+        }
+    }
+#pragma GCC unroll 2
+    for (int j = 0; j < 2; ++j) {
+        const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(a[0][j], a[1][j]), _mm256_add_epi32(a[2][j], a[3][j]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 8 * j), sum);
+    }
+}
+#endif
+
+#if defined(__loongarch_sx)
+void gemvLsx(const qint16* patch, const qint16* weight, int len, int stride, int* acc)
+{
+    __m128i a[2][4];
+#pragma GCC unroll 8
+    for (int j = 0; j < 8; ++j) {
+        a[j / 4][j % 4] = __lsx_vreplgr2vr_w(0);
+    }
+    for (int i = 0; i < len; i += 4) {
+#pragma GCC unroll 2
+        for (int k = 0; k < 2; ++k) {
+            const __m128i p = __lsx_vreplgr2vr_w(loadPair(patch + i + 2 * k));
+            const qint16* w = weight + (i / 2 + k) * stride;
+#pragma GCC unroll 4
+            for (int j = 0; j < 4; ++j) {
+                const __m128i v = __lsx_vld(w + 8 * j, 0);
+                a[k][j] = __lsx_vmaddwod_w_h(__lsx_vmaddwev_w_h(a[k][j], p, v), p, v);
+            }
+        }
+    }
+#pragma GCC unroll 4
+    for (int j = 0; j < 4; ++j) {
+        __lsx_vst(__lsx_vadd_w(a[0][j], a[1][j]), acc + 4 * j, 0);
+    }
+}
+#endif
+
+#if defined(__loongarch_asx)
+void gemvLasx(const qint16* patch, const qint16* weight, int len, int stride, int* acc)
+{
+    __m256i a[4][2];
+#pragma GCC unroll 8
+    for (int j = 0; j < 8; ++j) {
+        a[j / 2][j % 2] = __lasx_xvreplgr2vr_w(0);
+    }
+    for (int i = 0; i < len; i += 8) {
+#pragma GCC unroll 4
+        for (int k = 0; k < 4; ++k) {
+            const __m256i p = __lasx_xvreplgr2vr_w(loadPair(patch + i + 2 * k));
+            const qint16* w = weight + (i / 2 + k) * stride;
+            const __m256i v0 = __lasx_xvld(w, 0);
+            const __m256i v1 = __lasx_xvld(w, 32);
+            a[k][0] = __lasx_xvmaddwod_w_h(__lasx_xvmaddwev_w_h(a[k][0], p, v0), p, v0);
+            a[k][1] = __lasx_xvmaddwod_w_h(__lasx_xvmaddwev_w_h(a[k][1], p, v1), p, v1);
+        }
+    }
+#pragma GCC unroll 2
+    for (int j = 0; j < 2; ++j) {
+        const __m256i sum = __lasx_xvadd_w(__lasx_xvadd_w(a[0][j], a[1][j]), __lasx_xvadd_w(a[2][j], a[3][j]));
+        __lasx_xvst(sum, acc + 8 * j, 0);
+    }
+}
+#endif
+
+typedef void (*GemvFn)(const qint16*, const qint16*, int, int, int*);
+
+GemvFn selectGemv()
+{
+    switch (AdcDecoder::detectIsa()) {
+#if defined(__loongarch_asx)
+    case AdcDecoder::IsaLasx: return gemvLasx;
+#endif
+#if defined(__loongarch_sx)
+    case AdcDecoder::IsaLsx:  return gemvLsx;
+#endif
+#if defined(RESNET_ENGINE_X86)
+    case AdcDecoder::IsaAvx2: return gemvAvx2;
+    case AdcDecoder::IsaSse2: return gemvSse2;
+#endif
+    default:                  return gemvScalar;
+    }
+}
+
+/*
+ * int8 卷积，参数含义同 conv(). 输入先按 inputScale 量化到 qin，再把每个输出点的 K x K x Cin 输入块
+ * (越界处补 0)展开到 patches[OH * OW][K * K * Cin]. 之后按 16 个输出通道一组遍历全部输出点，
+ * 一组权重(<= 576 x 16 x 2 字节)在处理该层所有输出点期间常驻 L1 缓存. 整数结果乘系数还原为 float.
+ */
+template <int Cin, int Cout, int H, int W, int K, int S, bool Relu, bool Residual>
+void convInt8(const float* in, float* out, const qint16* qweight, const float* qscale, const float* bias,
+              float inputScale, const float* residual, qint16* qin, qint16* patches, int* acc, GemvFn gemv)
+{
+    const int P = K / 2;
+    const int OH = (H + 2 * P - K) / S + 1;
+    const int OW = (W + 2 * P - K) / S + 1;
+    const int Len = K * K * Cin;
+
+    // 输入均为 ReLU 输出(>= 0)，先截断到 255 再用 1.5 * 2^23 舍入(就近偶数，同 np.rint)
+    const float inv = 1.0f / inputScale;
+    const float kRound = 12582912.0f;
+    for (int i = 0; i < H * W * Cin; ++i) {
+        float v = in[i] * inv;
+        v = v < kActivationLevels ? v : kActivationLevels;
+        qin[i] = static_cast<qint16>((v + kRound) - kRound);
+    }
+
+    for (int oy = 0; oy < OH; ++oy) {
+        for (int ox = 0; ox < OW; ++ox) {
+            qint16* patch = patches + (oy * OW + ox) * Len;
+            for (int ky = 0; ky < K; ++ky) {
+                const int iy = oy * S + ky - P;
+                for (int kx = 0; kx < K; ++kx) {
+                    const int ix = ox * S + kx - P;
+                    qint16* dst = patch + (ky * K + kx) * Cin;
+                    if (iy < 0 || iy >= H || ix < 0 || ix >= W) {
+                        memset(dst, 0, Cin * sizeof(qint16));
+                    } else {
+                        memcpy(dst, qin + (iy * W + ix) * Cin, Cin * sizeof(qint16));
+                    }
+                }
+            }
+        }
+    }
+
+    for (int cb = 0; cb < Cout; cb += 16) {
+        for (int p = 0; p < OH * OW; ++p) {
+            gemv(patches + p * Len, qweight + 2 * cb, Len, 2 * Cout, acc + p * Cout + cb);
+        }
+    }
+
+    for (int p = 0; p < OH * OW; ++p) {
+        const int offset = p * Cout;
+        for (int co = 0; co < Cout; ++co) {
+            float v = static_cast<float>(acc[offset + co]) * qscale[co] + bias[co];
+            if (Residual) {
+                v += residual[offset + co];
+            }
+            if (Relu) {
+                v = v > 0.0f ? v : 0.0f;
+            }
+            out[offset + co] = v;
+        }
+    }
+}
+
+template <typename T>
+bool readValue(const QByteArray& data, int& pos, T& value)
+{
+    if (pos + static_cast<int>(sizeof(T)) > data.size()) {
+        return false;
+    }
+    memcpy(&value, data.constData() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+std::string shapeString(const std::vector<int>& shape)
+{
+    std::string s = "[";
+    for (size_t i = 0; i < shape.size(); ++i) {
+        s += (i ? ", " : "") + std::to_string(shape[i]);
+    }
+    return s + "]";
+}
+}
+
+ResNetEngine::ResNetEngine()
+    : m_bufA(kMaxActivation)
+    , m_bufB(kMaxActivation)
+    , m_bufC(kMaxActivation)
+    , m_qinput(kMaxActivation)
+    , m_patches(kMaxPatches)
+    , m_acc(kMaxActivation)
+    , m_gemv(selectGemv())
+{
+}
+
+bool ResNetEngine::setInt8(bool enabled)
+{
+    m_int8 = enabled && m_hasInt8;
+    return m_int8 == enabled;
+}
+
+bool ResNetEngine::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = QString("Cannot open %1: %2").arg(path, file.errorString());
+        qWarning() << "ResNetEngine:" << m_error;
+        return false;
+    }
+    return loadFromData(file.readAll());
+}
+
+/**
+ * @brief 解析权重文件并把 BatchNorm 并入卷积
+ * 文件格式(小端): magic[8] "LSRESNET" | u32 version | u32 张量个数 | f32 BatchNorm eps |
+ * 每个张量: u32 名称长度 | 名称(state_dict 键名) | u32 维数 | u32 各维大小 | f32 数据(行优先).
+ */
+bool ResNetEngine::loadFromData(const QByteArray& data)
+{
+    int pos = 0;
+    char magic[8];
+    quint32 version = 0;
+    quint32 count = 0;
+    float eps = 0.0f;
+    if (data.size() < static_cast<int>(sizeof(magic)) || memcmp(data.constData(), RESNET_WEIGHTS_MAGIC, sizeof(magic)) != 0) {
+        m_error = "Not a ResNet weights file";
+        qWarning() << "ResNetEngine:" << m_error;
+        return false;
+    }
+    pos += sizeof(magic);
+    if (!readValue(data, pos, version) || !readValue(data, pos, count) || !readValue(data, pos, eps)
+            || version != RESNET_WEIGHTS_VERSION) {
+        m_error = QString("Unsupported weights file version %1").arg(version);
+        qWarning() << "ResNetEngine:" << m_error;
+        return false;
+    }
+
+    TensorMap tensors;
+    for (quint32 t = 0; t < count; ++t) {
+        quint32 nameLen = 0;
+        quint32 ndim = 0;
+        if (!readValue(data, pos, nameLen) || pos + static_cast<qint64>(nameLen) > data.size()) {
+            m_error = "Truncated weights file";
+            qWarning() << "ResNetEngine:" << m_error;
+            return false;
+        }
+        std::string name(data.constData() + pos, nameLen);
+        pos += nameLen;
+        Tensor tensor;
+        qint64 elements = 1;
+        bool ok = readValue(data, pos, ndim) && ndim <= 4;
+        for (quint32 d = 0; ok && d < ndim; ++d) {
+            quint32 dim = 0;
+            ok = readValue(data, pos, dim) && dim <= 4096;
+            tensor.shape.push_back(static_cast<int>(dim));
+            elements *= dim;
+        }
+        if (!ok || pos + elements * static_cast<qint64>(sizeof(float)) > data.size()) {
+            m_error = QString("Truncated weights file at tensor %1").arg(QString::fromStdString(name));
+            qWarning() << "ResNetEngine:" << m_error;
+            return false;
+        }
+        tensor.data.resize(elements);
+        memcpy(tensor.data.data(), data.constData() + pos, elements * sizeof(float));
+        pos += elements * sizeof(float);
+        tensors[name] = std::move(tensor);
+    }
+
+    // * 先在临时对象中完成折叠，全部成功后再替换当前权重
+    ConvLayer conv1;
+    Block blocks[6];
+    if (!foldConv(tensors, "conv1.", "bn1.", RESNET_INPUT_C, 16, 3, eps, conv1)) {
+        return false;
+    }
+    for (int b = 0; b < 6; ++b) {
+        const BlockSpec& spec = kBlockSpecs[b];
+        const std::string prefix = spec.prefix;
+        if (!foldConv(tensors, prefix + "conv1.", prefix + "bn1.", spec.cin, spec.cout, 3, eps, blocks[b].conv1)
+                || !foldConv(tensors, prefix + "conv2.", prefix + "bn2.", spec.cout, spec.cout, 3, eps, blocks[b].conv2)) {
+            return false;
+        }
+        if (spec.stride != 1 || spec.cin != spec.cout) {
+            if (!foldConv(tensors, prefix + "downsample.0.", prefix + "downsample.1.",
+                          spec.cin, spec.cout, 1, eps, blocks[b].downsample)) {
+                return false;
+            }
+        }
+    }
+    const Tensor* fcWeight = findTensor(tensors, "fc.weight", { RESNET_NUM_CLASSES, kFeatures });
+    const Tensor* fcBias = findTensor(tensors, "fc.bias", { RESNET_NUM_CLASSES });
+    if (!fcWeight || !fcBias) {
+        return false;
+    }
+
+    // * 残差块各卷积的输入量化系数(quantize_model.py 标定)，全部存在时才启用 int8 路径
+    int scalesFound = 0;
+    int scalesNeeded = 0;
+    for (int b = 0; b < 6; ++b) {
+        const BlockSpec& spec = kBlockSpecs[b];
+        const std::string prefix = spec.prefix;
+        struct { ConvLayer* layer; const char* name; int cin; int kernel; } convs[3] = {
+            { &blocks[b].conv1, "conv1.", spec.cin, 3 },
+            { &blocks[b].conv2, "conv2.", spec.cout, 3 },
+            { &blocks[b].downsample, "downsample.0.", spec.cin, 1 },
+        };
+        for (auto& c : convs) {
+            if (c.layer->weight.empty()) {
+                continue;
+            }
+            scalesNeeded++;
+            auto it = tensors.find(prefix + c.name + "input_scale");
+            if (it == tensors.end() || it->second.data.size() != 1 || !(it->second.data[0] > 0.0f)) {
+                continue;
+            }
+            quantizeConv(*c.layer, c.cin, spec.cout, c.kernel, it->second.data[0]);
+            scalesFound++;
+        }
+    }
+    if (scalesFound != 0 && scalesFound != scalesNeeded) {
+        qWarning() << "ResNetEngine: incomplete int8 calibration," << scalesFound << "of" << scalesNeeded
+                   << "input scales present, int8 path disabled";
+    }
+
+    m_conv1 = std::move(conv1);
+    for (int b = 0; b < 6; ++b) {
+        m_blocks[b] = std::move(blocks[b]);
+    }
+    m_fcWeight = fcWeight->data;
+    m_fcBias = fcBias->data;
+    m_loaded = true;
+    m_hasInt8 = scalesFound == scalesNeeded;
+    m_int8 = m_int8 && m_hasInt8;
+    m_error.clear();
+    return true;
+}
+
+const ResNetEngine::Tensor* ResNetEngine::findTensor(const TensorMap& tensors, const std::string& name,
+                                                     const std::vector<int>& shape)
+{
+    auto it = tensors.find(name);
+    if (it == tensors.end()) {
+        m_error = QString("Missing tensor %1").arg(QString::fromStdString(name));
+        qWarning() << "ResNetEngine:" << m_error;
+        return nullptr;
+    }
+    if (it->second.shape != shape) {
+        m_error = QString("Tensor %1 has shape %2, expected %3").arg(QString::fromStdString(name),
+                                                                     QString::fromStdString(shapeString(it->second.shape)),
+                                                                     QString::fromStdString(shapeString(shape)));
+        qWarning() << "ResNetEngine:" << m_error;
+        return nullptr;
+    }
+    return &it->second;
+}
+
+/**
+ * @brief 卷积 + BatchNorm(推理模式)合并为带偏置的卷积:
+ * s = gamma / sqrt(var + eps)，w' = w * s，b' = beta - mean * s.
+ * 权重从 PyTorch 的 [Cout][Cin][K][K] 重排为 [K][K][Cin][Cout].
+ */
+bool ResNetEngine::foldConv(const TensorMap& tensors, const std::string& conv, const std::string& bn,
+                            int cin, int cout, int kernel, float eps, ConvLayer& out)
+{
+    const Tensor* weight = findTensor(tensors, conv + "weight", { cout, cin, kernel, kernel });
+    const Tensor* gamma = findTensor(tensors, bn + "weight", { cout });
+    const Tensor* beta = findTensor(tensors, bn + "bias", { cout });
+    const Tensor* mean = findTensor(tensors, bn + "running_mean", { cout });
+    const Tensor* var = findTensor(tensors, bn + "running_var", { cout });
+    if (!weight || !gamma || !beta || !mean || !var) {
+        return false;
+    }
+
+    out.weight.assign(static_cast<size_t>(kernel) * kernel * cin * cout, 0.0f);
+    out.bias.resize(cout);
+    for (int co = 0; co < cout; ++co) {
+        const double scale = gamma->data[co] / std::sqrt(static_cast<double>(var->data[co]) + eps);
+        out.bias[co] = static_cast<float>(beta->data[co] - mean->data[co] * scale);
+        for (int ci = 0; ci < cin; ++ci) {
+            for (int k = 0; k < kernel * kernel; ++k) {
+                const float w = weight->data[(static_cast<size_t>(co) * cin + ci) * kernel * kernel + k];
+                out.weight[(static_cast<size_t>(k) * cin + ci) * cout + co] = static_cast<float>(w * scale);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按输出通道对称量化已折叠的权重: s = max|w| / 127，q = round(w / s)，
+ * 并按输入块([ky][kx][Cin])中的相邻两项交织为 [len/2][Cout][2]，见 gemvScalar()
+ */
+void ResNetEngine::quantizeConv(ConvLayer& layer, int cin, int cout, int kernel, float inputScale)
+{
+    const int len = kernel * kernel * cin;
+    layer.inputScale = inputScale;
+    layer.qweight.assign(static_cast<size_t>(cout) * len, 0);
+    layer.qscale.resize(cout);
+    for (int co = 0; co < cout; ++co) {
+        float maxAbs = 0.0f;
+        for (int k = 0; k < len; ++k) {
+            maxAbs = std::max(maxAbs, std::fabs(layer.weight[static_cast<size_t>(k) * cout + co]));
+        }
+        const float weightScale = maxAbs > 0.0f ? maxAbs / kWeightLevels : 1.0f;
+        for (int k = 0; k < len; ++k) {
+            const float q = std::nearbyint(layer.weight[static_cast<size_t>(k) * cout + co] / weightScale);
+            layer.qweight[(static_cast<size_t>(k & ~1) * cout + 2 * co) + (k & 1)] =
+                    static_cast<qint16>(std::max(-127.0f, std::min(127.0f, q)));
+        }
+        layer.qscale[co] = inputScale * weightScale;
+    }
+}
+
+template <int Cin, int Cout, int H, int W, int K, int S, bool Relu, bool Residual>
+void ResNetEngine::convLayer(const float* in, float* out, const ConvLayer& layer, const float* residual)
+{
+    if (m_int8) {
+        convInt8<Cin, Cout, H, W, K, S, Relu, Residual>(in, out, layer.qweight.data(), layer.qscale.data(),
+                                                        layer.bias.data(), layer.inputScale, residual,
+                                                        m_qinput.data(), m_patches.data(), m_acc.data(), m_gemv);
+    } else {
+        conv<Cin, Cout, H, W, K, S, Relu, Residual>(in, out, layer.weight.data(), layer.bias.data(), residual);
+    }
+}
+
+void ResNetEngine::forward(const float* input, float* logits)
+{
+    if (!m_loaded) {
+        std::fill(logits, logits + RESNET_NUM_CLASSES, 0.0f);
+        return;
+    }
+    float* a = m_bufA.data();
+    float* b = m_bufB.data();
+    float* c = m_bufC.data();
+
+    // * [C][H][W] -> [H][W][C]
+    for (int ch = 0; ch < RESNET_INPUT_C; ++ch) {
+        for (int i = 0; i < RESNET_INPUT_H * RESNET_INPUT_W; ++i) {
+            a[i * RESNET_INPUT_C + ch] = input[ch * RESNET_INPUT_H * RESNET_INPUT_W + i];
+        }
+    }
+
+    // * conv1 + bn1 + relu: a -> b (9x13x16)
+    conv<3, 16, 9, 13, 3, 1, true, false>(a, b, m_conv1.weight.data(), m_conv1.bias.data(), nullptr);
+
+    // * layer1: 输出在 b，残差直接加到输入所在的缓冲区
+    for (int i = 0; i < 2; ++i) {
+        const Block& blk = m_blocks[i];
+        convLayer<16, 16, 9, 13, 3, 1, true, false>(b, c, blk.conv1, nullptr);
+        convLayer<16, 16, 9, 13, 3, 1, true, true>(c, b, blk.conv2, b);
+    }
+
+    // * layer2: b (9x13x16) -> a (5x7x32)
+    {
+        const Block& blk = m_blocks[2];
+        convLayer<16, 32, 9, 13, 1, 2, false, false>(b, a, blk.downsample, nullptr);
+        convLayer<16, 32, 9, 13, 3, 2, true, false>(b, c, blk.conv1, nullptr);
+        convLayer<32, 32, 5, 7, 3, 1, true, true>(c, a, blk.conv2, a);
+    }
+    {
+        const Block& blk = m_blocks[3];
+        convLayer<32, 32, 5, 7, 3, 1, true, false>(a, c, blk.conv1, nullptr);
+        convLayer<32, 32, 5, 7, 3, 1, true, true>(c, a, blk.conv2, a);
+    }
+
+    // * layer3: a (5x7x32) -> b (3x4x64)
+    {
+        const Block& blk = m_blocks[4];
+        convLayer<32, 64, 5, 7, 1, 2, false, false>(a, b, blk.downsample, nullptr);
+        convLayer<32, 64, 5, 7, 3, 2, true, false>(a, c, blk.conv1, nullptr);
+        convLayer<64, 64, 3, 4, 3, 1, true, true>(c, b, blk.conv2, b);
+    }
+    {
+        const Block& blk = m_blocks[5];
+        convLayer<64, 64, 3, 4, 3, 1, true, false>(b, c, blk.conv1, nullptr);
+        convLayer<64, 64, 3, 4, 3, 1, true, true>(c, b, blk.conv2, b);
+    }
+
+    // * 全局平均池化 + fc
+    const int pixels = 3 * 4;
+    float features[kFeatures];
+    for (int ch = 0; ch < kFeatures; ++ch) {
+        float sum = 0.0f;
+        for (int p = 0; p < pixels; ++p) {
+            sum += b[p * kFeatures + ch];
+        }
+        features[ch] = sum / pixels;
+    }
+    for (int k = 0; k < RESNET_NUM_CLASSES; ++k) {
+        const float* w = m_fcWeight.data() + k * kFeatures;
+        float sum = m_fcBias[k];
+        for (int ch = 0; ch < kFeatures; ++ch) {
+            sum += w[ch] * features[ch];
+        }
+        logits[k] = sum;
+    }
+}
+
+int ResNetEngine::predict(const float* input, float* probabilities)
+{
+    float logits[RESNET_NUM_CLASSES];
+    forward(input, logits);
+
+    const int best = static_cast<int>(std::max_element(logits, logits + RESNET_NUM_CLASSES) - logits);
+    if (probabilities) {
+        // * softmax，减去最大值避免溢出
+        float sum = 0.0f;
+        for (int k = 0; k < RESNET_NUM_CLASSES; ++k) {
+            probabilities[k] = std::exp(logits[k] - logits[best]);
+            sum += probabilities[k];
+        }
+        for (int k = 0; k < RESNET_NUM_CLASSES; ++k) {
+            probabilities[k] /= sum;
+        }
+    }
+    return best;
+}
+
+const char* ResNetEngine::className(int index)
+{
+    if (index < 0 || index >= RESNET_NUM_CLASSES) {
+        return "";
+    }
+    return kClassNames[index];
+}
@@ -0,0 +1,107 @@
+#ifndef RESNETENGINE_H
+#define RESNETENGINE_H
+
+#include <QString>
+#include <QByteArray>
+#include <map>
+#include <string>
+#include <vector>
+#include "mfccengine.h"
+
+#define RESNET_NUM_CLASSES   13
+#define RESNET_INPUT_C       NUM_AXES          // 3
+#define RESNET_INPUT_H       MFCC_NUM_FRAMES   // 9
+#define RESNET_INPUT_W       MFCC_NUM_CEP      // 13
+#define RESNET_WEIGHTS_MAGIC "LSRESNET"        // 权重文件头(8 字节)，由 Python/run_on_loong/export_weights.py 生成
+#define RESNET_WEIGHTS_VERSION 1
+
+/**
+ * @brief model_loader.py 中 ResNet(BasicBlock, [2, 2, 2]) 的 C++ 推理实现
+ * 输入为 MfccEngine 输出的 [3, 9, 13] 特征，网络结构:
+ *   conv1 3->16 (9x13) -> layer1 16 (9x13) -> layer2 32 (5x7) -> layer3 64 (3x4) -> 全局平均池化 -> fc 64->13.
+ * 权重文件由 export_weights.py 从 best_model.pth 导出(state_dict 原样保存)，加载时把 BatchNorm
+ * 并入前一层卷积的权重和偏置. 激活按 [H][W][C] 存放，各层卷积以模板按通道数、特征图尺寸和步长
+ * 在编译期特化，输出通道为最内层循环(GCC 向量扩展一次计算 4 个通道)，ReLU 和残差相加在卷积输出时完成.
+ * 激活缓冲区在对象内预先分配，forward() 不分配内存. 单个对象不可被多个线程同时使用.
+ * 界面中由 InferenceThread 调用. 与 PyTorch 模型的一致性由 Python/run_on_loong/check_engine.py 检查
+ * (同一份特征输入时 logits 误差 <= 1e-3 + 1e-3*|logit|，见 LoongQt --engine-check).
+ *
+ * int8 推理: 权重文件中带有 quantize_model.py 标定的各卷积输入量化系数(<conv>.input_scale)时可用.
+ * 残差块中的卷积(conv1 和 fc 仍为 float)权重按输出通道对称量化为 [-127, 127]，
+ * 输入激活(均为 ReLU 输出)按标定系数量化为 [0, 255]，整数点积后乘两者系数还原为 float，
+ * 再加偏置、残差并做 ReLU. 8 位数据以 16 位存放，整数乘加使用 SSE2/AVX2 的 pmaddwd 或 LSX/LASX 的
+ * vmaddwev/vmaddwod(按 AdcDecoder::detectIsa() 选择)，每组 16 个输出通道的权重在一层内常驻 L1 缓存. 精度损失见 quantize_model.py 输出的报告.
+ * 界面中由 Int8CheckBox 切换. x86(AVX2)上 int8 与 float 每窗口耗时相当(约 0.3 ms，量化输入和展开输入块的开销
+ * 抵消了整数乘加的收益); LSX/LASX 实现尚未在目标板上编译计时，以 LoongQt --engine-check 输出的 int8/float 为准.
+ */
+class ResNetEngine
+{
+public:
+    ResNetEngine();
+
+    // * 加载 export_weights.py 导出的权重文件，失败时返回 false 并保留原有权重
+    bool load(const QString& path);
+    bool loadFromData(const QByteArray& data);
+    bool isLoaded() const { return m_loaded; }
+    QString errorString() const { return m_error; }
+
+    // * input[3][9][13](与 Python 端 [C, H, W] 一致) -> logits[RESNET_NUM_CLASSES]
+    void forward(const float* input, float* logits);
+    // * 推理并做 softmax，返回概率最大的类别; probabilities 可为 nullptr
+    int predict(const float* input, float* probabilities);
+
+    static const char* className(int index);
+
+    // * 权重文件是否带有 int8 量化系数
+    bool hasInt8() const { return m_hasInt8; }
+    // * 使用 int8 路径(无量化系数时忽略并返回 false)
+    bool setInt8(bool enabled);
+    bool isInt8() const { return m_int8; }
+
+private:
+    // BatchNorm 已并入的卷积层，权重按 [ky][kx][Cin][Cout] 重排
+    struct ConvLayer {
+        std::vector<float> weight;
+        std::vector<float> bias;
+        // int8 路径
+        float inputScale = 0.0f;
+        std::vector<qint16> qweight; // [ky][kx][Cin] 两两交织: [K*K*Cin/2][Cout][2]
+        std::vector<float> qscale;   // [Cout] 输入系数 * 权重系数
+    };
+    struct Block {
+        ConvLayer conv1;
+        ConvLayer conv2;
+        ConvLayer downsample; // 仅 layer2/layer3 的第一个块使用
+    };
+    struct Tensor {
+        std::vector<int> shape;
+        std::vector<float> data;
+    };
+    typedef std::map<std::string, Tensor> TensorMap;
+
+    bool foldConv(const TensorMap& tensors, const std::string& conv, const std::string& bn,
+                  int cin, int cout, int kernel, float eps, ConvLayer& out);
+    const Tensor* findTensor(const TensorMap& tensors, const std::string& name, const std::vector<int>& shape);
+    static void quantizeConv(ConvLayer& layer, int cin, int cout, int kernel, float inputScale);
+    template <int Cin, int Cout, int H, int W, int K, int S, bool Relu, bool Residual>
+    void convLayer(const float* in, float* out, const ConvLayer& layer, const float* residual);
+
+    ConvLayer m_conv1;
+    Block m_blocks[6]; // layer1.0, layer1.1, layer2.0, layer2.1, layer3.0, layer3.1
+    std::vector<float> m_fcWeight; // [RESNET_NUM_CLASSES][64]
+    std::vector<float> m_fcBias;
+    bool m_loaded = false;
+    bool m_hasInt8 = false;
+    bool m_int8 = false;
+    QString m_error;
+    // 激活缓冲区，每个可容纳最大的特征图(layer1: 9 x 13 x 16)
+    std::vector<float> m_bufA;
+    std::vector<float> m_bufB;
+    std::vector<float> m_bufC;
+    std::vector<qint16> m_qinput; // 量化后的卷积输入
+    std::vector<qint16> m_patches; // 各输出点对应的 K x K x Cin 输入块
+    std::vector<int> m_acc;        // 整数卷积结果
+    void (*m_gemv)(const qint16* patch, const qint16* weight, int len, int stride, int* acc); // 按 CPU 选择的整数乘加
+};
+
+#endif // RESNETENGINE_H
@@ -0,0 +1,119 @@
+#include "spikefilter.h"
+#include <cstring>
+
+namespace {
+typedef float VecF __attribute__((vector_size(16)));
+typedef int VecI __attribute__((vector_size(16)));
+const int kLanes = 4;
+
+const float kMadToSigma = 1.4826f; // 正态分布下 MAD 到标准差的换算系数
+
+inline VecF loadVec(const float* p)
+{
+    VecF v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline VecF splat(float f)
+{
+    return VecF{ f, f, f, f };
+}
+
+inline VecF vabs(VecF v)
+{
+    return v < 0 ? -v : v;
+}
+
+inline void compareExchange(VecF& a, VecF& b)
+{
+    VecF lo = a < b ? a : b;
+    VecF hi = a < b ? b : a;
+    a = lo;
+    b = hi;
+}
+
+// 逐列求 W 行的中位数: 冒泡网络(W 在编译期确定，完全展开)每一趟把最大值移到末尾，
+// W/2 + 1 趟后第 W/2 行即为中位数，其余部分无需排好
+template <int W>
+inline VecF medianOf(VecF (&v)[W])
+{
+#pragma GCC unroll 8
+    for (int i = 0; i < W / 2 + 1; ++i) {
+#pragma GCC unroll 8
+        for (int j = 0; j < W - 1 - i; ++j) {
+            compareExchange(v[j], v[j + 1]);
+        }
+    }
+    return v[W / 2];
+}
+
+/*
+ * padded 为边界延拓后的输入，输出点 i 的窗口为 padded[i .. i + 2K]
+ */
+template <int K>
+int hampel(const float* padded, float* out, float nSigma, float minDeviation)
+{
+    const int W = 2 * K + 1;
+    const VecF scale = splat(nSigma * kMadToSigma);
+    const VecF floor = splat(minDeviation);
+    VecI rejected = VecI{ 0, 0, 0, 0 };
+
+    for (int i = 0; i < SAMPLES_PER_AXIS; i += kLanes) {
+        VecF v[W];
+#pragma GCC unroll 9
+        for (int r = 0; r < W; ++r) {
+            v[r] = loadVec(padded + i + r);
+        }
+        const VecF x = v[K];
+        const VecF med = medianOf<W>(v);
+#pragma GCC unroll 9
+        for (int r = 0; r < W; ++r) {
+            v[r] = vabs(v[r] - med);
+        }
+        const VecF mad = medianOf<W>(v);
+        VecF limit = mad * scale;
+        limit = limit > floor ? limit : floor;
+        const VecI spike = vabs(x - med) > limit;
+        const VecF result = spike ? med : x;
+        memcpy(out + i, &result, sizeof(result));
+        rejected -= spike; // 比较结果为 -1/0
+    }
+
+    int count = 0;
+    for (int lane = 0; lane < kLanes; ++lane) {
+        count += rejected[lane];
+    }
+    return count;
+}
+}
+
+SpikeFilter::SpikeFilter()
+{
+    memset(m_padded, 0, sizeof(m_padded));
+}
+
+void SpikeFilter::setHalfWindow(int halfWindow)
+{
+    m_halfWindow = qBound(1, halfWindow, SPIKE_MAX_HALF_WINDOW);
+}
+
+int SpikeFilter::apply(int axis, float* data)
+{
+    if (!m_enabled) {
+        return 0;
+    }
+    const int k = m_halfWindow;
+    for (int i = 0; i < k; ++i) {
+        m_padded[i] = data[0];
+        m_padded[k + SAMPLES_PER_AXIS + i] = data[SAMPLES_PER_AXIS - 1];
+    }
+    memcpy(m_padded + k, data, SAMPLES_PER_AXIS * sizeof(float));
+
+    switch (k) {
+    case 1: return hampel<1>(m_padded, data, m_nSigma, m_minDeviation[axis]);
+    case 2: return hampel<2>(m_padded, data, m_nSigma, m_minDeviation[axis]);
+    case 3: return hampel<3>(m_padded, data, m_nSigma, m_minDeviation[axis]);
+    default: return hampel<4>(m_padded, data, m_nSigma, m_minDeviation[axis]);
+    }
+}
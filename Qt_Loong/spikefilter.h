@@ -0,0 +1,47 @@
+#ifndef SPIKEFILTER_H
+#define SPIKEFILTER_H
+
+#include "datareader.h"
+
+#define SPIKE_MAX_HALF_WINDOW 4 // 最大半窗长，窗口 = 2 * halfWindow + 1 <= 9 点
+
+/**
+ * @brief Hampel 脉冲抑制滤波器
+ * 对每个采样点取以其为中心的 2k+1 点窗口，求中位数 med 和绝对中位差 MAD，
+ * 若 |x - med| > max(nSigma * 1.4826 * MAD, minDeviation) 则判为脉冲并以 med 替换.
+ * 判定只依据原始输入，被替换的点不会影响后续窗口，不会出现“锁定”在异常值上的情况.
+ * 窗口两端按边界值延拓. 中位数用比较交换网络求得，一次处理 4 个相邻点(16 字节 GCC 向量扩展，
+ * 由编译器映射到 SSE/NEON/LSX 等指令). 处理过程不分配内存.
+ */
+class SpikeFilter
+{
+public:
+    SpikeFilter();
+
+    // * 半窗长 k(1 ~ SPIKE_MAX_HALF_WINDOW)，默认 3，即 7 点窗口
+    void setHalfWindow(int halfWindow);
+    int halfWindow() const { return m_halfWindow; }
+    // * 判定阈值(以 MAD 估计的标准差倍数)，默认 3
+    void setThreshold(float nSigma) { m_nSigma = nSigma; }
+    float threshold() const { return m_nSigma; }
+    // * 各轴的最小判定偏差(与该轴数据同单位)，避免在平稳信号(MAD 为 0)上把量化噪声误判为脉冲
+    // * 各轴标定不同时量化间隔也不同，因此按轴设置
+    void setMinDeviation(int axis, float minDeviation) { m_minDeviation[axis] = minDeviation; }
+    float minDeviation(int axis) const { return m_minDeviation[axis]; }
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    // * 原地处理第 axis 轴的 SAMPLES_PER_AXIS 点，返回被替换的点数
+    int apply(int axis, float* data);
+
+private:
+    int m_halfWindow = 3;
+    float m_nSigma = 3.0f;
+    float m_minDeviation[NUM_AXES] = { 0.0f, 0.0f, 0.0f };
+    bool m_enabled = true;
+    // 边界延拓后的输入副本(两端各 halfWindow 点)，按向量宽度(16 字节)对齐;
+    // SAMPLES_PER_AXIS 为 4 的倍数，最后一组 4 点的窗口恰好止于末端延拓区，不需要额外余量
+    alignas(16) float m_padded[SAMPLES_PER_AXIS + 2 * SPIKE_MAX_HALF_WINDOW];
+};
+
+#endif // SPIKEFILTER_H
@@ -0,0 +1,108 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief 单生产者/单消费者无锁环形缓冲区
+ * 生产者线程只写 m_head，消费者线程只写 m_tail，两端之间不需要任何锁。
+ * 槽位在构造时一次性分配，运行期间不再申请内存，适合在实时采集线程中使用。
+ * 生产者: writeSlot() 取得空槽 -> 填充 -> publish() 发布;
+ * 消费者: readSlot()  取得数据 -> 处理 -> release() 归还.
+ * Capacity 必须是2的幂.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscRing() : m_slots(new T[Capacity]), m_head(0), m_tail(0), m_dropped(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // --- 生产者接口 ---
+    // * 返回下一个可写槽位，环满时返回 nullptr
+    T* writeSlot()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= Capacity) {
+            return nullptr;
+        }
+        return &m_slots[head & (Capacity - 1)];
+    }
+
+    // * 发布 writeSlot() 返回的槽位，使其对消费者可见
+    void publish()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // * 拷贝写入，环满时丢弃并计数
+    bool tryPush(const T& item)
+    {
+        T* slot = writeSlot();
+        if (!slot) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        *slot = item;
+        publish();
+        return true;
+    }
+
+    // * 生产者在环满时丢弃数据，需要自行调用该函数计数
+    void markDropped() { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    // --- 消费者接口 ---
+    // * 返回最早的未读槽位，环空时返回 nullptr
+    const T* readSlot() const
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[tail & (Capacity - 1)];
+    }
+
+    // * 归还 readSlot() 返回的槽位
+    void release()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool tryPop(T& item)
+    {
+        const T* slot = readSlot();
+        if (!slot) {
+            return false;
+        }
+        item = *slot;
+        release();
+        return true;
+    }
+
+    // --- 状态查询(任意线程, 近似值) ---
+    size_t size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+    bool isEmpty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+    // * 槽位存储区(Capacity 个 T)，用于 mlock 等按地址范围的操作
+    const T* storage() const { return m_slots.get(); }
+    static constexpr size_t storageBytes() { return sizeof(T) * Capacity; }
+    size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<T[]> m_slots;
+    // 头尾指针分别位于独立的缓存行，避免生产者与消费者之间的伪共享
+    alignas(64) std::atomic<size_t> m_head; // 下一个写入位置(仅生产者修改)
+    alignas(64) std::atomic<size_t> m_tail; // 下一个读取位置(仅消费者修改)
+    alignas(64) std::atomic<size_t> m_dropped;
+};
+
+#endif // SPSCRING_H
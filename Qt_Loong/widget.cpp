@@ -2,29 +2,31 @@
 #include "ui_widget.h"
 #include <QDebug>
 #include <QFile>
-#include <QTextStream>
 #include <QDir>
 #include <QStandardPaths>
 #include <QApplication>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonParseError>
 #include <QtNetwork>
 #include <QPlainTextEdit>
 #include <QComboBox>
 #include <QFileInfo>
 #include <QDirIterator>
 #include <QMessageBox>
+#include <QFileDialog>
 #include <QScreen>
 #include <QGuiApplication> // 包含屏幕信息
+#include <cstring>
+#include "resnetengine.h"
 Widget::Widget(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::Widget)
     , m_pythonModelProcess(nullptr)
+    , m_modelIpc(nullptr)
+    , m_inference(nullptr)
     , m_mfccDisplayWindow(nullptr)
     , m_axisRectX(nullptr), m_axisRectY(nullptr), m_axisRectZ(nullptr)
     , m_graphX(nullptr), m_graphY(nullptr), m_graphZ(nullptr)
+    , m_acquisitionThread(nullptr), m_frameRing(nullptr), m_storageRing(nullptr), m_modelRing(nullptr)
+    , m_recordWriter(nullptr)
 {
     ui->setupUi(this);
     // --- 防止图形界面卡死心跳 ---
@@ -45,6 +47,8 @@ Widget::Widget(QWidget *parent)
     ui->CollectProgressBar->setEnabled(false);
     ui->CollectStopButton->setEnabled(false);
     ui->HistoryBox->setMaxVisibleItems(5);
+    ui->OverlapCheckBox->setChecked(m_overlapWindows);
+    ui->CompressStreamCheckBox->setChecked(m_compressStream);
 
     if (qApp->organizationName().isEmpty()) qApp->setOrganizationName("Loong");
     if (qApp->applicationName().isEmpty()) qApp->setApplicationName("Crazy");
@@ -55,36 +59,157 @@ Widget::Widget(QWidget *parent)
         qWarning() << "Could not get AppDataLocation, using current path:" << m_csvDataPath;
     }
     m_csvDataPath += "/sensor_data_for_python";
-    // --- 清除历史数据 ---
-    QDir dir(getProcessedCsvDir());
-    if (dir.exists()) {
-        qDebug() << "Directory exists, clearing its contents:" << getProcessedCsvDir();
-        dir.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden);
-        for (const QFileInfo &fileInfo : dir.entryInfoList()) {
-            if (fileInfo.isDir()) {
-                QDir subDir(fileInfo.absoluteFilePath());
-                if (!subDir.removeRecursively()) {
-                    qWarning() << "Failed to remove sub-directory:" << fileInfo.absoluteFilePath();
-                }
-            } else {
-                if (!QFile::remove(fileInfo.absoluteFilePath())) {
-                    qWarning() << "Failed to remove file:" << fileInfo.absoluteFilePath();
-                }
-            }
-        }
-    } else {
-        qDebug() << "Directory does not exist, creating it:" << getProcessedCsvDir();
-        if (!dir.mkpath(".")) {
-            qWarning() << "Failed to create directory:" << getProcessedCsvDir();
-        }
+    // --- 打开历史数据存储，只在此处列出一次目录 ---
+    if (!m_history.open(m_csvDataPath + "/history")) {
+        qWarning() << "Failed to open history store:" << m_history.errorString();
     }
+    // --- 旧版本逐帧归档(及 Python 目录模式移入)的 processed_csv 文件导入 m_history，导入成功后才删除 ---
+    importLegacyHistory();
     // --- 初始化 HistoryBox ---
     populateHistoryBox(); // 程序启动时填充一次
 
+    // --- 模型部署: 优先在进程内推理(m_nativeInference)，权重文件不可用时启动 Python 模型服务 ---
+    if (!m_nativeInference || !startNativeModel()) {
+        startPythonModel();
+    }
+    // int8 路径只在进程内推理且权重带量化系数时可选，Python 模型服务始终为 float
+    ui->Int8CheckBox->setEnabled(m_inference && m_inference->hasInt8());
+    ui->Int8CheckBox->setChecked(m_int8Inference && ui->Int8CheckBox->isEnabled());
+
+    // --- 采集线程初始化，SPI读取在独立线程中连续进行 ---
+    // * 绘图(含网络发送)、存储和模型各有一条消费者环，按各自节奏取帧，某个消费者跟不上只丢弃它自己的帧
+    m_acquisitionThread = new AcquisitionThread(this);
+    m_frameRing = m_acquisitionThread->addConsumer();
+    m_storageRing = m_acquisitionThread->addConsumer();
+    m_modelRing = m_acquisitionThread->addConsumer();
+    m_acquisitionThread->spikeFilter().setEnabled(m_spikeFilterEnabled);
+    m_acquisitionThread->spikeFilter().setHalfWindow(m_spikeHalfWindow);
+    m_acquisitionThread->spikeFilter().setThreshold(m_spikeThreshold);
+    m_acquisitionThread->setSpikeMinDeviationCodes(m_spikeMinCodes);
+    m_acquisitionThread->setRealtime(50, m_lockAllMemory ? AcquisitionThread::LockAll : AcquisitionThread::LockBuffers);
+    m_acquisitionThread->start();
+
+    // --- Collect模式写盘线程初始化，编码和文件写入不占用界面线程 ---
+    m_recordWriter = new RecordWriterThread(this);
+    m_recordWriter->setSyncPolicy(RecordWriterThread::SyncPeriodic, 2000); // [可调] 每2秒同步一次到SD卡
+    connect(m_recordWriter, &RecordWriterThread::writeError, this, &Widget::onRecordWriteError);
+    connect(m_recordWriter, &RecordWriterThread::stalled, this, &Widget::onRecordWriteStalled);
+    connect(m_recordWriter, &RecordWriterThread::captureFinished, this, &Widget::onCollectFinished);
+    m_recordWriter->setSource(m_storageRing); // 写盘线程直接消费存储环，采集数据不经过界面线程
+    m_recordWriter->start();
+
+    // --- 数据更新，状态栏更新 ---
+    connect(&m_dataBatchTimer, &QTimer::timeout, this, &Widget::updatePlotWithNewBatch);
+    m_dataBatchTimer.start(500);
+    connect(&m_modelTimer, &QTimer::timeout, this, &Widget::drainModelRing);
+    m_modelTimer.start(m_modelDrainMs);
+    connect(&local_timer, &QTimer::timeout, this, &Widget::get_LocalTime);
+    local_timer.start(10);
+
+
+    // --- TCP/IP线程和数据发送器初始化 ---
+    m_senderThread = new QThread(this);
+    m_dataSender = new DataSender();
+    m_dataSender->setCalibration(m_acquisitionThread->decoder());
+    m_dataSender->setSmoothWindow(m_movingAverage.windowSize());
+    m_dataSender->moveToThread(m_senderThread);
+
+    // --- 建立主线程和TCP/IP副线程之间的通信 ---
+    connect(this, &Widget::newDataReadyToSend, m_dataSender, &DataSender::sendData);
+    connect(this, &Widget::newRawDataReadyToSend, m_dataSender, &DataSender::sendCompressedData);
+    connect(this, &Widget::newModelOutReadyToSend, m_dataSender, &DataSender::sendModelOutput);
+    connect(this, &Widget::newStateToSend, m_dataSender, &DataSender::sendState);
+    connect(this, &Widget::socketReady, m_dataSender, &DataSender::setSocket);
+    connect(this, &Widget::clientHasDisconnected, m_dataSender, &DataSender::clientDisconnected);
+    connect(m_dataSender, &DataSender::dataSentStatus, this, &Widget::onDataSenderStatus);
+    connect(m_dataSender, &DataSender::clientStatusChanged, this, &Widget::onClientStatusChanged);
+    connect(m_senderThread, &QThread::finished, m_dataSender, &QObject::deleteLater);
+    m_senderThread->start();
+
+    // --- TCP/IP网络服务器监听 ---
+    tcpServer = new QTcpServer(this);
+    Port = 0;
+    bool serverStarted = tcpServer->listen(QHostAddress::Any,0);
+    if (serverStarted) {
+        Port = tcpServer->serverPort();
+        qDebug() << "Server started listening on port:" << Port;
+        connect(tcpServer,SIGNAL(newConnection()),this,SLOT(newConnection_SLOT()));
+        setLED(ui->NetworkLabel,3,16);
+    } else {
+        qWarning() << "Server failed to start:" << tcpServer->errorString();
+        setLED(ui->NetworkLabel,1,16);
+    }
+
+    // --- 创建第二窗口初始化 ---
+    m_mfccDisplayWindow = new widget_2();
+    // --- 监听第二窗口放回主窗口信号 ---
+    connect(m_mfccDisplayWindow, &widget_2::backToMainRequested, this, &Widget::showMainWindow);
+    // --- 获取屏幕分辨率 ---
+    checkScreenResolution();
+
+}
+
+/**
+ * @brief 进程内推理: 加载程序目录下的 resnet_weights.bin(export_weights.py 导出)并启动推理线程，
+ * 结果经 onModelResult 处理，与 Python 模型服务相同
+ * @return 是否部署成功，失败时由调用者退回 Python 模型服务
+ */
+bool Widget::startNativeModel()
+{
+    QDate currentDate = QDate::currentDate();
+    QTime currentTime = QTime::currentTime();
+    QString dateTimePrefix = QString("[%1 %2] ")
+                                 .arg(currentDate.toString("yyyy-MM-dd"))
+                                 .arg(currentTime.toString("HH:mm:ss"));
+    const QString weightsPath = QCoreApplication::applicationDirPath() + "/resnet_weights.bin";
+    InferenceThread* inference = new InferenceThread(this);
+    if (!inference->loadWeights(weightsPath)) {
+        qWarning() << dateTimePrefix << "Native inference unavailable, falling back to Python:" << inference->errorString();
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'>进程内推理不可用(%2)，改用Python模型服务.</font>")
+                                        .arg(dateTimePrefix)
+                                        .arg(inference->errorString().toHtmlEscaped()));
+            ui->SysEdit->ensureCursorVisible();
+        }
+        delete inference;
+        return false;
+    }
+    m_inference = inference;
+    connect(m_inference, &InferenceThread::resultReady, this, &Widget::onModelResult);
+    m_inference->start();
+
+    Model_Deploy = true;
+    ui->MfccPlotButton->setEnabled(true);
+    qDebug() << dateTimePrefix << "Native inference started with" << weightsPath;
+    if (ui->SysEdit) {
+        ui->SysEdit->appendHtml(QString("%1<font color='blue'><b>模型部署成功(进程内推理).</b></font>").arg(dateTimePrefix));
+        ui->SysEdit->ensureCursorVisible();
+    }
+    return true;
+}
+
+/**
+ * @brief 启动 Python 模型服务(model_loader.py --ipc)，预测结果经 m_modelIpc 返回
+ */
+void Widget::startPythonModel()
+{
+    // --- 模型通信通道，Python 进程启动后连接 ---
+    m_modelIpc = new ModelIpcServer(this);
+    connect(m_modelIpc, &ModelIpcServer::resultReady, this, &Widget::onModelResult);
+    connect(m_modelIpc, &ModelIpcServer::errorReceived, this, &Widget::onModelError);
+    connect(m_modelIpc, &ModelIpcServer::connectionChanged, this, [this](bool connected){
+        if (!connected) {
+            m_pendingFrames.clear();
+        }
+    });
+    if (!m_modelIpc->listen(QString("loong_model_%1").arg(QCoreApplication::applicationPid()))) {
+        qWarning() << "Failed to start model IPC server:" << m_modelIpc->errorString();
+    }
+
     // --- Python模型部署进程创建 ---
     m_pythonModelProcess = new QProcess(this);
 
-    // --- Python进程端模型输出监听并处理 ---
+    // --- Python进程端模型输出监听并处理，预测结果经 m_modelIpc 返回，stdout 仅为状态信息 ---
     connect(m_pythonModelProcess, &QProcess::readyReadStandardOutput, this, [this](){
         QDate currentDate = QDate::currentDate();
         QTime currentTime = QTime::currentTime();
@@ -96,188 +221,17 @@ Widget::Widget(QWidget *parent)
             QByteArray lineData = m_pythonModelProcess->readLine().trimmed();
             if (lineData.isEmpty()) continue;
             QString messageContent = QString::fromUtf8(lineData);
-            QJsonParseError parseError;
-            QJsonDocument doc = QJsonDocument::fromJson(lineData, &parseError);
-            if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
-                QJsonObject jsonObj = doc.object();
-                if (jsonObj.value("status").toString() == "success") {
-                    // * 解析Json输出，与python端键值对一一对应.
-                    className = jsonObj.value("predicted_class_name").toString();
-                    confidence = jsonObj.value("confidence").toDouble();
-                    QString fileName = jsonObj.value("file_name").toString("N/A");
-
-                    // * 仅当置信度足够大时才确定为轴承状态
-                    if(confidence >= 85)
-                    {
-                        confidence_state = confidence;
-                        className_state = className;
-                        // * TCP/IP发送模型预测类型-置信度
-                        if(tcpSocket != nullptr && tcpSocket->state() == QAbstractSocket::ConnectedState)
-                        {
-                            if(className.contains("healthy")||className.contains("Healthy"))
-                            {
-                                emit newModelOutReadyToSend(QString("Healthy"),confidence);
-                            }else{
-                                emit newModelOutReadyToSend(className,confidence);
-                            }
-                        }
-                        if(className.contains("inner"))
-                        {
-                            setLED(ui->ModelStateLabel,4,16);
-                        }else if(className.contains("outer"))
-                        {
-                            setLED(ui->ModelStateLabel,6,16);
-                        }else
-                        {
-                            setLED(ui->ModelStateLabel,2,16);
-                        }
-                        // * 制定轴承损失级别
-                        if(className.contains("healthy")||className.contains("Healthy")){
-                            rankAlert = 0;
-                            setLED(ui->DeviceStateLabel,2,16); //绿色
-                        }else if(className == "0.7inner" || className == "0.7outer" || className == "0.9inner" || className == "0.9outer"){
-                            rankAlert = 1;
-                            setLED(ui->DeviceStateLabel,3,16); //黄色
-                        }else if(className == "1.1inner" || className == "1.1outer" || className == "1.3inner" || className == "1.3outer"){
-                            rankAlert = 2;
-                            setLED(ui->DeviceStateLabel,5,16); //橙色
-                        }else if(className == "1.5inner" || className == "1.5outer" || className == "1.7inner" || className == "1.7outer"){
-                            rankAlert = 3;
-                            setLED(ui->DeviceStateLabel,1,16); //红色
-                        }
-                        // * 更新蜂鸣器判别缓冲器
-                        for(int i=0;i<9;i++)
-                        {
-                            rankAlert_Buf[i] = rankAlert_Buf[i+1];
-                        }
-                        rankAlert_Buf[9] = rankAlert;
-                        char Light = 0;
-                        char Medium = 0;
-                        char Severe = 0;
-                        for(int i=0;i<9;i++)
-                        {
-                            if(rankAlert_Buf[i] == 1)
-                            {
-                                Light ++;
-                            }else if(rankAlert_Buf[i] == 2)
-                            {
-                                Medium ++;
-                            }else if(rankAlert_Buf[i] == 3)
-                            {
-                                Severe ++;
-                            }
-                        }
-                        // * 蜂鸣器警报
-                        if(Mode == "Monitor")
-                        {
-                            if(rankAlert == 0)
-                            {
-                                beepctl -> stopAlert();
-                            }else if(Light >= 6)
-                            {
-                                beepctl -> alertLightDamage();
-                            }else if(Medium >= 6)
-                            {
-                                beepctl -> alertMediumDamage();
-                            }else if(Severe >= 6)
-                            {
-                                beepctl -> alertSevereDamage();
-                            }
-                        }
-                        // * 将成功预测处理的文件添加到 HistoryBox，即历史数据保存，Python 在处理成功后，文件 fileName 已经被移动到了 processed_csv 目录
-                        if (!fileName.isEmpty() && fileName != "N/A") {
-                            if (ui->HistoryBox->count() == 1 && ui->HistoryBox->itemData(0).toString().isEmpty()) {
-                                if (ui->HistoryBox->itemText(0) == "没有历史数据" || ui->HistoryBox->itemText(0) == "历史数据为空") {
-                                    ui->HistoryBox->removeItem(0);
-                                }
-                            }
-                            // ** 检查文件是否真的在 processed_csv 目录中
-                            QString processedFilePath = getProcessedCsvDir() + "/" + fileName;
-                            if (QFile::exists(processedFilePath)) {
-                                addHistoryItem(fileName);
-                                qDebug() << "Added to HistoryBox from Python success:" << fileName;
-                                // ** 清理超限的历史数据，最多保存50条
-                                cleanupOldHistoryFiles();
-                            } else {
-                                qWarning() << "Python reported success for" << fileName << "but it was not found in processed_csv directory.";
-                            }
-                        }
-
-                        ui->HistoryBox->setEnabled(true);
-                        ui->HistoryBackButton->setEnabled(true);
-                        ui->HistoryCleanButton->setEnabled(true);
-                        ui->HistoryCleanAllButton->setEnabled(true);
-
-                        // * 时间序列图的更新
-                        int classIndex = jsonObj.value("predicted_class_index").toInt();
-                        if (m_mfccDisplayWindow) {
-                            m_mfccDisplayWindow->addClassTimeData(className, classIndex);
-                        }
-
-                        // * 处理 MFCC 特征，3轴-9帧-每帧13个MFCC系数
-                        if (jsonObj.contains("features_to_display") && jsonObj.value("features_to_display").isArray()) {
-                            QJsonArray allAxesJsonArray = jsonObj.value("features_to_display").toArray();
-                            QVector<QVector<QVector<double>>> allAxesMfccData;
-
-                            for (const QJsonValue& axisVal : allAxesJsonArray) {
-                                if (axisVal.isArray()) {
-                                    QVector<QVector<double>> singleAxisMfcc;
-                                    QJsonArray framesArray = axisVal.toArray();
-                                    for (const QJsonValue& frameVal : framesArray) {
-                                        if (frameVal.isArray()) {
-                                            QVector<double> frameCoefficients;
-                                            QJsonArray coeffsArray = frameVal.toArray();
-                                            for (const QJsonValue& coeffVal : coeffsArray) {
-                                                if (coeffVal.isDouble()) {
-                                                    frameCoefficients.append(coeffVal.toDouble());
-                                                }
-                                            }
-                                            singleAxisMfcc.append(frameCoefficients);
-                                        }
-                                    }
-                                    allAxesMfccData.append(singleAxisMfcc);
-                                }
-                            }
-
-                            if (allAxesMfccData.size() == 3 && m_mfccDisplayWindow) {
-                                // ** 将MFCC系数传给第二个窗口显示.
-                                m_mfccDisplayWindow->displayMfccFeatures(allAxesMfccData);
-                            } else if (!m_mfccDisplayWindow) {
-                                qWarning() << "MFCC显示窗口未创建，无法显示特征。";
-                            } else if (allAxesMfccData.size() != 3) {
-                                qWarning() << "解析到的MFCC数据轴数不为3:" << allAxesMfccData.size();
-                            }
-                        }
-
-                        // * 类别概率饼图更新
-                        QJsonObject probabilitiesObj = jsonObj.value("all_class_probabilities").toObject();
-                        if (!probabilitiesObj.isEmpty()) {
-                            QMap<QString, double> probabilitiesMap;
-                            for (auto it = probabilitiesObj.constBegin(); it != probabilitiesObj.constEnd(); ++it) {
-                                probabilitiesMap.insert(it.key(), it.value().toDouble());
-                            }
-
-                            qDebug() << "Map size after parsing:" << probabilitiesMap.size();
-                            if (m_mfccDisplayWindow) {
-                                m_mfccDisplayWindow->updatePieChart(probabilitiesMap);
-                            }
-                        }
-                    }
-
-                    qDebug() << dateTimePrefix << "Prediction for" << fileName << ":" << className << confidence << "%";
-                }
-            } else {
-                if (messageContent.contains("Python: 成功加载模型", Qt::CaseInsensitive)) {
-                    QString deploymentSuccessMsg = QString("%1<font color='blue'><b>模型部署成功.</b></font>")
-                                                       .arg(dateTimePrefix);
-                    Model_Deploy = true;
-                    if (ui->SysEdit) {
-                        ui->SysEdit->appendHtml(deploymentSuccessMsg);
-                        ui->SysEdit->ensureCursorVisible();
-                    }
-                    qDebug() << dateTimePrefix << "Model deployed successfully (from stdout).";
-                    ui->MfccPlotButton->setEnabled(true);
+            qDebug() << dateTimePrefix << messageContent;
+            if (messageContent.contains("Python: 成功加载模型", Qt::CaseInsensitive)) {
+                QString deploymentSuccessMsg = QString("%1<font color='blue'><b>模型部署成功.</b></font>")
+                                                   .arg(dateTimePrefix);
+                Model_Deploy = true;
+                if (ui->SysEdit) {
+                    ui->SysEdit->appendHtml(deploymentSuccessMsg);
+                    ui->SysEdit->ensureCursorVisible();
                 }
+                qDebug() << dateTimePrefix << "Model deployed successfully (from stdout).";
+                ui->MfccPlotButton->setEnabled(true);
             }
         }
     });
@@ -362,7 +316,10 @@ Widget::Widget(QWidget *parent)
     QStringList arguments;
     QString scriptPath = QCoreApplication::applicationDirPath() + "/model_loader.py";
     arguments << scriptPath;
-    arguments << m_csvDataPath;
+    arguments << "--ipc" << m_modelIpc->serverPath();
+    arguments << "--batch-size" << QString::number(ModelIpc::MAX_IN_FLIGHT);
+    arguments << "--jit"; // TorchScript 冻结模型并预热，失败时 Python 端自动退回原模型
+    // 重叠窗口按帧以 FlagOverlap 请求，运行中可由 OverlapCheckBox 切换，不使用 --overlap
 
     qDebug() << "Starting Python model server:" << pythonExecutable << arguments;
     m_pythonModelProcess->start(pythonExecutable, arguments);
@@ -372,58 +329,26 @@ Widget::Widget(QWidget *parent)
     } else {
         qDebug() << "Python model server started successfully.";
     }
-
-    // --- 数据更新，状态栏更新 ---
-    connect(&m_dataBatchTimer, &QTimer::timeout, this, &Widget::updatePlotWithNewBatch);
-    m_dataBatchTimer.start(500);
-    connect(&local_timer, &QTimer::timeout, this, &Widget::get_LocalTime);
-    local_timer.start(10);
-
-
-    // --- TCP/IP线程和数据发送器初始化 ---
-    m_senderThread = new QThread(this);
-    m_dataSender = new DataSender();
-    m_dataSender->moveToThread(m_senderThread);
-
-    // --- 建立主线程和TCP/IP副线程之间的通信 ---
-    connect(this, &Widget::newDataReadyToSend, m_dataSender, &DataSender::sendData);
-    connect(this, &Widget::newModelOutReadyToSend, m_dataSender, &DataSender::sendModelOutput);
-    connect(this, &Widget::newStateToSend, m_dataSender, &DataSender::sendState);
-    connect(this, &Widget::socketReady, m_dataSender, &DataSender::setSocket);
-    connect(this, &Widget::clientHasDisconnected, m_dataSender, &DataSender::clientDisconnected);
-    connect(m_dataSender, &DataSender::dataSentStatus, this, &Widget::onDataSenderStatus);
-    connect(m_dataSender, &DataSender::clientStatusChanged, this, &Widget::onClientStatusChanged);
-    connect(m_senderThread, &QThread::finished, m_dataSender, &QObject::deleteLater);
-    m_senderThread->start();
-
-    // --- TCP/IP网络服务器监听 ---
-    tcpServer = new QTcpServer(this);
-    Port = 0;
-    bool serverStarted = tcpServer->listen(QHostAddress::Any,0);
-    if (serverStarted) {
-        Port = tcpServer->serverPort();
-        qDebug() << "Server started listening on port:" << Port;
-        connect(tcpServer,SIGNAL(newConnection()),this,SLOT(newConnection_SLOT()));
-        setLED(ui->NetworkLabel,3,16);
-    } else {
-        qWarning() << "Server failed to start:" << tcpServer->errorString();
-        setLED(ui->NetworkLabel,1,16);
-    }
-
-    // --- 创建第二窗口初始化 ---
-    m_mfccDisplayWindow = new widget_2();
-    // --- 监听第二窗口放回主窗口信号 ---
-    connect(m_mfccDisplayWindow, &widget_2::backToMainRequested, this, &Widget::showMainWindow);
-    // --- 获取屏幕分辨率 ---
-    checkScreenResolution();
-
 }
 
 Widget::~Widget()
 {
     // --- QT程序退出处理 ---
-    // * 关闭数据读取驱动
-    m_dataReader.closeDevice();
+    // * 停止采集线程，线程退出时关闭数据读取驱动
+    if (m_acquisitionThread) {
+        m_acquisitionThread->stop();
+        m_acquisitionThread->wait();
+    }
+    // * 停止写盘线程，线程退出前写完队列中的帧并关闭收集文件
+    if (m_recordWriter) {
+        m_recordWriter->stop();
+        m_recordWriter->wait();
+    }
+    // * 停止进程内推理线程
+    if (m_inference) {
+        m_inference->stop();
+        m_inference->wait();
+    }
     // * 清除共享目录m_csvDataPath下来不及预测的CSV文件
     if (!m_csvDataPath.isEmpty()) {
         QDir csvDir(m_csvDataPath);
@@ -476,13 +401,227 @@ Widget::~Widget()
 }
 
 /**
- * @brief 获取历史数据所在目录
+ * @brief 模型预测结果处理: 轴承状态与警报、历史数据、MFCC 特征和类别概率显示
+ * @param historyTimeMs 对应的历史记录时刻(存储中的键)，未归档时为 0
+ * @param classIndex 预测类别索引
+ * @param predictedConfidence 置信度 (0.0 - 100.0)
+ * @param probabilities 各类别概率 (0.0 - 100.0)
+ * @param features MFCC 特征，3轴-9帧-每帧13个系数(行优先)，未请求时为空
+ */
+void Widget::applyPrediction(qint64 historyTimeMs, int classIndex, double predictedConfidence,
+                             const QVector<double>& probabilities, const QVector<double>& features)
+{
+    QDate currentDate = QDate::currentDate();
+    QTime currentTime = QTime::currentTime();
+    QString dateTimePrefix = QString("[%1 %2] ")
+                                 .arg(currentDate.toString("yyyy-MM-dd"))
+                                 .arg(currentTime.toString("HH:mm:ss"));
+    className = QString::fromLatin1(ResNetEngine::className(classIndex));
+    confidence = predictedConfidence;
+
+    // * 仅当置信度足够大时才确定为轴承状态
+    if(confidence >= 85)
+    {
+        confidence_state = confidence;
+        className_state = className;
+        // * TCP/IP发送模型预测类型-置信度
+        if(tcpSocket != nullptr && tcpSocket->state() == QAbstractSocket::ConnectedState)
+        {
+            if(className.contains("healthy")||className.contains("Healthy"))
+            {
+                emit newModelOutReadyToSend(QString("Healthy"),confidence);
+            }else{
+                emit newModelOutReadyToSend(className,confidence);
+            }
+        }
+        if(className.contains("inner"))
+        {
+            setLED(ui->ModelStateLabel,4,16);
+        }else if(className.contains("outer"))
+        {
+            setLED(ui->ModelStateLabel,6,16);
+        }else
+        {
+            setLED(ui->ModelStateLabel,2,16);
+        }
+        // * 制定轴承损失级别
+        if(className.contains("healthy")||className.contains("Healthy")){
+            rankAlert = 0;
+            setLED(ui->DeviceStateLabel,2,16); //绿色
+        }else if(className == "0.7inner" || className == "0.7outer" || className == "0.9inner" || className == "0.9outer"){
+            rankAlert = 1;
+            setLED(ui->DeviceStateLabel,3,16); //黄色
+        }else if(className == "1.1inner" || className == "1.1outer" || className == "1.3inner" || className == "1.3outer"){
+            rankAlert = 2;
+            setLED(ui->DeviceStateLabel,5,16); //橙色
+        }else if(className == "1.5inner" || className == "1.5outer" || className == "1.7inner" || className == "1.7outer"){
+            rankAlert = 3;
+            setLED(ui->DeviceStateLabel,1,16); //红色
+        }
+        // * 更新蜂鸣器判别缓冲器
+        for(int i=0;i<9;i++)
+        {
+            rankAlert_Buf[i] = rankAlert_Buf[i+1];
+        }
+        rankAlert_Buf[9] = rankAlert;
+        char Light = 0;
+        char Medium = 0;
+        char Severe = 0;
+        for(int i=0;i<9;i++)
+        {
+            if(rankAlert_Buf[i] == 1)
+            {
+                Light ++;
+            }else if(rankAlert_Buf[i] == 2)
+            {
+                Medium ++;
+            }else if(rankAlert_Buf[i] == 3)
+            {
+                Severe ++;
+            }
+        }
+        // * 蜂鸣器警报
+        if(Mode == "Monitor")
+        {
+            if(rankAlert == 0)
+            {
+                beepctl -> stopAlert();
+            }else if(Light >= 6)
+            {
+                beepctl -> alertLightDamage();
+            }else if(Medium >= 6)
+            {
+                beepctl -> alertMediumDamage();
+            }else if(Severe >= 6)
+            {
+                beepctl -> alertSevereDamage();
+            }
+        }
+        // * 将成功预测处理的记录添加到 HistoryBox，数据已由 onModelResult 追加到历史存储，过期数据由存储按淘汰条件删除
+        if (historyTimeMs > 0) {
+            addHistoryItem(historyTimeMs);
+            qDebug() << "Added to HistoryBox from model result:" << historyDisplayText(historyTimeMs);
+        }
+
+        ui->HistoryBox->setEnabled(true);
+        ui->HistoryBackButton->setEnabled(true);
+        ui->HistoryCleanButton->setEnabled(true);
+        ui->HistoryCleanAllButton->setEnabled(true);
+
+        // * 时间序列图的更新
+        if (m_mfccDisplayWindow) {
+            m_mfccDisplayWindow->addClassTimeData(className, classIndex);
+        }
+
+        // * 处理 MFCC 特征，3轴-9帧-每帧13个MFCC系数
+        if (features.size() == RESNET_INPUT_C * RESNET_INPUT_H * RESNET_INPUT_W) {
+            QVector<QVector<QVector<double>>> allAxesMfccData(RESNET_INPUT_C);
+            for (int axis = 0; axis < RESNET_INPUT_C; ++axis) {
+                allAxesMfccData[axis].resize(RESNET_INPUT_H);
+                for (int frame = 0; frame < RESNET_INPUT_H; ++frame) {
+                    const double* coeffs = features.constData() + (axis * RESNET_INPUT_H + frame) * RESNET_INPUT_W;
+                    allAxesMfccData[axis][frame] = QVector<double>(coeffs, coeffs + RESNET_INPUT_W);
+                }
+            }
+            if (m_mfccDisplayWindow) {
+                // ** 将MFCC系数传给第二个窗口显示.
+                m_mfccDisplayWindow->displayMfccFeatures(allAxesMfccData);
+            } else {
+                qWarning() << "MFCC显示窗口未创建，无法显示特征。";
+            }
+        } else if (!features.isEmpty()) {
+            qWarning() << "MFCC特征长度错误:" << features.size();
+        }
+
+        // * 类别概率饼图更新
+        if (!probabilities.isEmpty()) {
+            QMap<QString, double> probabilitiesMap;
+            for (int i = 0; i < probabilities.size() && i < RESNET_NUM_CLASSES; ++i) {
+                probabilitiesMap.insert(QString::fromLatin1(ResNetEngine::className(i)), probabilities[i]);
+            }
+
+            qDebug() << "Map size after parsing:" << probabilitiesMap.size();
+            if (m_mfccDisplayWindow) {
+                m_mfccDisplayWindow->updatePieChart(probabilitiesMap);
+            }
+        }
+    }
+
+    qDebug() << dateTimePrefix << "Prediction for" << historyTimeMs << ":" << className << confidence << "%";
+}
+
+/**
+ * @brief 获取旧版本历史数据(逐帧归档)所在目录
  */
 QString Widget::getProcessedCsvDir()
 {
     return m_csvDataPath + "/processed_csv";
 }
 
+/**
+ * @brief 把 processed_csv 中的 data_YYYYMMDD_HHMMSS_ZZZ.rec/.csv 按时间顺序导入历史存储，每个文件导入成功后删除
+ * 文件经 ReplayLoader 读取，按每块 SAMPLES_PER_AXIS 点追加; 键取文件名中的时刻(无法解析时取修改时间)，
+ * 之后各块依次加上一块的时长. 早于存储中最新记录的文件由 HistoryStore 顺延为最新记录 + 1ms.
+ * 录制文件沿用其文件头(格式和标定)，CSV 以 float32 保存，不经当前标定量化. 导入失败的文件保留，下次启动时重试.
+ */
+void Widget::importLegacyHistory()
+{
+    QDir dir(getProcessedCsvDir());
+    if (!dir.exists() || !m_history.isOpen()) {
+        return;
+    }
+    const QFileInfoList files = dir.entryInfoList(QStringList() << "data_*.rec" << "data_*.csv",
+                                                  QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+    int imported = 0;
+    QVector<float> x(SAMPLES_PER_AXIS), y(SAMPLES_PER_AXIS), z(SAMPLES_PER_AXIS);
+    QVector<double> xData(SAMPLES_PER_AXIS), yData(SAMPLES_PER_AXIS), zData(SAMPLES_PER_AXIS);
+    for (const QFileInfo& fileInfo : files) {
+        ReplayLoader loader;
+        if (!loader.open(fileInfo.absoluteFilePath())) {
+            qWarning() << "importLegacyHistory: Cannot read" << fileInfo.fileName() << loader.errorString();
+            continue;
+        }
+        Record::FileHeader header = loader.header();
+        header.samplesPerBlock = SAMPLES_PER_AXIS;
+        if (loader.format() == ReplayLoader::FormatCsv) {
+            header.format = Record::FormatFloat32;
+        }
+        QDateTime fileTime = QDateTime::fromString(fileInfo.completeBaseName().mid(5, 19), "yyyyMMdd_HHmmss_zzz");
+        if (!fileTime.isValid()) {
+            fileTime = fileInfo.lastModified();
+        }
+        const qint64 startMs = fileTime.toMSecsSinceEpoch();
+        bool ok = true;
+        qint64 block = 0;
+        for (qint64 first = 0; ok; first += SAMPLES_PER_AXIS, ++block) {
+            const int count = loader.read(first, SAMPLES_PER_AXIS, x.data(), y.data(), z.data());
+            if (count <= 0) {
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                xData[i] = x[i];
+                yData[i] = y[i];
+                zData[i] = z[i];
+            }
+            const qint64 timeMs = startMs + first * 1000 / qMax<quint32>(1, header.sampleRate);
+            ok = m_history.append(header, xData.constData(), yData.constData(), zData.constData(), count,
+                                  static_cast<quint64>(block), timeMs);
+        }
+        loader.close();
+        if (!ok) {
+            qWarning() << "importLegacyHistory: Failed to import" << fileInfo.fileName() << m_history.errorString();
+            continue;
+        }
+        if (!QFile::remove(fileInfo.absoluteFilePath())) {
+            qWarning() << "importLegacyHistory: Imported but could not remove" << fileInfo.fileName();
+        }
+        ++imported;
+    }
+    if (imported > 0) {
+        qDebug() << "importLegacyHistory: Imported" << imported << "legacy files from" << getProcessedCsvDir();
+    }
+}
+
 /**
  * @brief 获取数据存储总目录
  */
@@ -492,79 +631,71 @@ QString Widget::getSensorDataDir()
 }
 
 /**
- * @brief 向HistoryBox中添加已处理数据选项
- * @param fullFileName 数据文件名称
+ * @brief HistoryBox 中的显示格式，例如 1751703094580 -> "2025-07-05 16:11:34.580"
  */
-void Widget::addHistoryItem(const QString& fullFileName)
+QString Widget::historyDisplayText(qint64 timeMs)
+{
+    return QDateTime::fromMSecsSinceEpoch(timeMs).toString("yyyy-MM-dd HH:mm:ss.zzz");
+}
+
+/**
+ * @brief 向HistoryBox顶部添加一条历史记录，超出 m_historyBoxItems 时移除列表中最旧的项(数据仍在存储中)
+ * @param timeMs 记录在历史存储中的时刻
+ */
+void Widget::addHistoryItem(qint64 timeMs)
 {
     if (!ui->HistoryBox) {
         qWarning() << "addHistoryItem: HistoryBox UI element is missing.";
         return;
     }
 
-    if (fullFileName.isEmpty()) {
-        qWarning() << "addHistoryItem: Received an empty filename. Skipping.";
+    // * 检查是否重复添加(历史回放的结果)
+    if (ui->HistoryBox->findData(QVariant(timeMs)) >= 0) {
+        qDebug() << "addHistoryItem: Record" << timeMs << "already exists in HistoryBox. Skipping.";
         return;
     }
 
-    // * 检查是否重复添加
-    for (int i = 0; i < ui->HistoryBox->count(); ++i) {
-        if (ui->HistoryBox->itemData(i).toString() == fullFileName) {
-            qDebug() << "addHistoryItem: File" << fullFileName << "already exists in HistoryBox. Skipping.";
-            return;
-        }
-    }
-
     // * 如果当前只有 "没有历史数据" 占位符，则移除它
-    if (ui->HistoryBox->count() == 1 && ui->HistoryBox->itemData(0).toString().isEmpty()) {
-        if (ui->HistoryBox->itemText(0) == "没有历史数据" || ui->HistoryBox->itemText(0) == "历史数据为空") {
-            ui->HistoryBox->removeItem(0);
-        }
+    if (ui->HistoryBox->count() == 1 && !ui->HistoryBox->itemData(0).isValid()) {
+        ui->HistoryBox->removeItem(0);
     }
 
-    // * 格式化文件名以供显示,数据文件名格式是 "data_YYYYMMDD_HHMMSS_ZZZ.csv"
-    QString displayString;
-    QString tempName = fullFileName;
-    tempName.remove("data_");
-    tempName.remove(".csv");
-
-    if (tempName.length() >= 15) {                        // YYYYMMDD_HHMMSS (ZZZ部分可选)
-        displayString += tempName.left(4) + "-";          // YYYY
-        displayString += tempName.mid(4, 2) + "-";        // MM
-        displayString += tempName.mid(6, 2) + " ";        // DD
-        displayString += tempName.mid(9, 2) + ":";        // HH
-        displayString += tempName.mid(11, 2) + ":";       // MM
-        displayString += tempName.mid(13, 2);             // SS
-        if (tempName.length() >= 19 && tempName.at(15) == '_') { // 检查是否有毫秒部分
-            displayString += "." + tempName.mid(16, 3);   // ZZZ
-        }
-    } else {
-        displayString = fullFileName;                     // 如果格式不符，直接显示完整文件名
+    // * 将新项插入到 ComboBox 的顶部，用户数据存储记录时刻
+    ui->HistoryBox->insertItem(0, historyDisplayText(timeMs), QVariant(timeMs));
+    while (ui->HistoryBox->count() > m_historyBoxItems) {
+        ui->HistoryBox->removeItem(ui->HistoryBox->count() - 1);
     }
 
-    // * 将新项插入到 ComboBox 的顶部
-    ui->HistoryBox->insertItem(0, displayString, QVariant(fullFileName)); // 存储完整文件名作为用户数据
-
     // * 将新添加的项设为当前选中项
     ui->HistoryBox->setCurrentIndex(0);
     ui->HistoryBox->setMaxVisibleItems(5);
-    // * 确保相关控件状态正确
-    if (!ui->HistoryBox->isEnabled()) {
-        ui->HistoryBox->setEnabled(true);
-    }
-    if (ui->HistoryBackButton && !ui->HistoryBackButton->isEnabled()) {
-        ui->HistoryBackButton->setEnabled(true);
-    }
-    if (ui->HistoryCleanButton && !ui->HistoryCleanButton->isEnabled()) {
-        ui->HistoryCleanButton->setEnabled(true);
+    updateHistoryButtons();
+}
+
+/**
+ * @brief 按 HistoryBox 是否有记录启用/禁用历史相关控件，列表为空时显示占位符
+ */
+void Widget::updateHistoryButtons()
+{
+    if (ui->HistoryBox->count() == 0) {
+        ui->HistoryBox->addItem("历史数据为空"); // 占位符，无用户数据
+        ui->HistoryBox->setCurrentIndex(0);
     }
-    if (ui->HistoryCleanAllButton && !ui->HistoryCleanAllButton->isEnabled()) {
-        ui->HistoryCleanAllButton->setEnabled(true);
+    const bool hasItems = ui->HistoryBox->itemData(0).isValid();
+    ui->HistoryBox->setEnabled(hasItems);
+    if (ui->HistoryBackButton) {
+        if (hasItems) {
+            ui->HistoryBackButton->setEnabled(true);
+        } else if (Mode == "Monitor") {
+            ui->HistoryBackButton->setEnabled(false);
+        }
     }
+    if (ui->HistoryCleanButton) ui->HistoryCleanButton->setEnabled(hasItems);
+    if (ui->HistoryCleanAllButton) ui->HistoryCleanAllButton->setEnabled(hasItems);
 }
 
 /**
- * @brief HistoryBox初始化
+ * @brief HistoryBox初始化，从历史存储的稀疏索引读取最新的 m_historyBoxItems 条记录，不扫描目录
  */
 void Widget::populateHistoryBox()
 {
@@ -574,135 +705,125 @@ void Widget::populateHistoryBox()
     }
 
     ui->HistoryBox->clear(); // 清空现有项
-
-    QString processedPath = getProcessedCsvDir();
-    QDir processedDir(processedPath);
-
-    if (!processedDir.exists()) {
-        qWarning() << "populateHistoryBox: Processed CSV directory does not exist:" << processedPath;
-        return;
+    if (!m_history.isOpen()) {
+        qWarning() << "populateHistoryBox: History store is not open.";
     }
 
-    processedDir.setNameFilters(QStringList() << "data_*.csv"); // 只查找 data_ 开头的CSV文件
-    processedDir.setFilter(QDir::Files | QDir::NoDotAndDotDot);
-    processedDir.setSorting(QDir::Name | QDir::Reversed);       // 按名称降序排列（新的在前）
-
-    QFileInfoList fileList = processedDir.entryInfoList();
-    if (fileList.isEmpty()) {
+    const QVector<History::Entry> entries = m_history.recent(m_historyBoxItems); // 新的在前
+    if (entries.isEmpty()) {
         ui->HistoryBox->addItem("没有历史数据");
-        ui->HistoryBox->setEnabled(false);
-        if(ui->HistoryBackButton)
-        {
-            if(Mode == "Monitor")
-            {
-                ui->HistoryBackButton->setEnabled(false);
-            }
-        }
-        if(ui->HistoryCleanButton) ui->HistoryCleanButton->setEnabled(false);
-    } else {
-        ui->HistoryBox->setEnabled(true);
-        if(ui->HistoryBackButton) ui->HistoryBackButton->setEnabled(true);
-        if(ui->HistoryCleanButton) ui->HistoryCleanButton->setEnabled(true);
-        for (const QFileInfo &fileInfo : fileList) {
-            QString fileName = fileInfo.fileName();
-            QString displayTime = fileName;
-            displayTime.remove("data_");
-            displayTime.remove(".csv");
-            if (displayTime.length() >= 19) {                          // YYYYMMDD_HHMMSS_ZZZ
-                // * 20231027_153005_123 -> 2023-10-27 15:30:05.123
-                QString formattedDisplay;
-                formattedDisplay += displayTime.left(4) + "-";         // YYYY
-                formattedDisplay += displayTime.mid(4,2) + "-";        // MM
-                formattedDisplay += displayTime.mid(6,2) + " ";        // DD
-                formattedDisplay += displayTime.mid(9,2) + ":";        // HH
-                formattedDisplay += displayTime.mid(11,2) + ":";       // MM
-                formattedDisplay += displayTime.mid(13,2);             // SS
-                if (displayTime.length() >= 19 && displayTime.at(15) == '_') { // 检查是否有毫秒
-                    formattedDisplay += "." + displayTime.mid(16,3);   // ZZZ
-                }
-                ui->HistoryBox->addItem(formattedDisplay, fileName); // 显示格式化时间，用户数据存储完整文件名
-            } else {
-                ui->HistoryBox->addItem(fileName, fileName); // 格式不符，直接显示文件名
-            }
-            ui->HistoryBox->setMaxVisibleItems(5);
-        }
     }
+    for (const History::Entry& entry : entries) {
+        ui->HistoryBox->addItem(historyDisplayText(entry.timeMs), QVariant(entry.timeMs)); // 显示格式化时间，用户数据存储记录时刻
+    }
+    ui->HistoryBox->setMaxVisibleItems(5);
+    updateHistoryButtons();
 }
 
 /**
- * @brief 加载历史数据进行回放功能
- * @param csvFilePath 待读取的历史数据文件路径
+ * @brief 从历史存储读取一条记录进行回放，按稀疏索引定位，从内存映射的分段直接解码该记录所在的块
+ * @param timeMs 记录时刻(HistoryBox 的用户数据)
+ * @param submitToModel 是否将原始数据发送给模型重新分析，发送失败时返回 false
  */
-bool Widget::loadAndDisplayCsvData(const QString& csvFilePath)
+bool Widget::loadAndDisplayHistory(qint64 timeMs, bool submitToModel)
 {
-    if (!ui->time || !m_graphX || !m_graphY || !m_graphZ || !m_axisRectX || !m_axisRectY || !m_axisRectZ) {
-        qWarning("Plot, graphs, or axis rects not initialized in updatePlotWithNewBatch!");
+    m_replayX.resize(SAMPLES_PER_AXIS);
+    m_replayY.resize(SAMPLES_PER_AXIS);
+    m_replayZ.resize(SAMPLES_PER_AXIS);
+    Record::BlockHeader blockHeader;
+    const int count = m_history.readFrame(timeMs, m_replayX.data(), m_replayY.data(), m_replayZ.data(), &blockHeader);
+    if (count <= 0) {
+        qWarning() << "loadAndDisplayHistory: Cannot read record" << timeMs << m_history.errorString();
         return false;
     }
+    // * 历史回放: 记录已在存储中，无需再归档
+    bool submitted = displayReplayBuffers(count, 0.0, blockHeader.frameSequence, timeMs, submitToModel);
+    qDebug() << "loadAndDisplayHistory: Successfully loaded and displayed record" << historyDisplayText(timeMs);
+    return submitted;
+}
 
-    QCustomPlot *customPlot = ui->time;
-
-    QFile file(csvFilePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "loadAndDisplayCsvData: Could not open CSV file for reading:" << csvFilePath << file.errorString();
+/**
+ * @brief 加载历史数据文件(录制文件或 CSV)中 fromSec 起 m_replayWindowSec 长的一段进行回放
+ * 文件经 m_replayLoader 内存映射，只解析所需的一段; 同一文件再次回放(拖动到其他时刻)时不重新打开
+ * @param csvFilePath 待读取的历史数据文件路径
+ * @param submitToModel 是否将原始数据发送给模型重新分析，发送失败时返回 false
+ * @param fromSec 回放起点(s，相对文件首点)
+ */
+bool Widget::loadAndDisplayCsvData(const QString& csvFilePath, bool submitToModel, double fromSec)
+{
+    if (m_replayLoader.path() != csvFilePath || !m_replayLoader.isOpen()) {
+        if (!m_replayLoader.open(csvFilePath)) {
+            qWarning() << "loadAndDisplayCsvData: Could not map file for reading:" << csvFilePath << m_replayLoader.errorString();
+            return false;
+        }
+    } else {
+        m_replayLoader.refresh(); // 文件可能已被追加
+    }
+    const int count = m_replayLoader.readRange(fromSec, fromSec + m_replayWindowSec, m_replayX, m_replayY, m_replayZ);
+    if (count <= 0) {
+        qWarning() << "loadAndDisplayCsvData: No valid data at" << fromSec << "s in" << csvFilePath;
         return false;
     }
 
-    QTextStream in(&file);
-    QVector<double> timeKeys, xData, yData, zData;
-    bool firstLine = true;                // 用于跳过表头
-    int sampleIndex = 0;
-    double timePerSample = 1.0 / 10000.0; // 与实时数据采样率一致,10KHz
-
-    // * 遍历csv文件，加载数据, CSV格式是: Time,X,Y,Z
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        if (firstLine) {
-            firstLine = false;
-            continue;
-        }
+    // * 文件不在历史存储中，结果不加入 HistoryBox
+    const double firstTime = qRound64(qMax(0.0, fromSec) * m_replayLoader.sampleRate()) / m_replayLoader.sampleRate();
+    bool submitted = displayReplayBuffers(count, firstTime, 0, 0, submitToModel);
+    qDebug() << "loadAndDisplayCsvData: Successfully loaded and displayed" << count << "samples from" << csvFilePath;
+    return submitted;
+}
 
-        QStringList fields = line.split(',');
-        if (fields.size() >= 3) { // 至少需要X,Y,Z三列数据
-            bool okX, okY, okZ;
-            // 如果CSV就是 X,Y,Z (没有独立时间列)，则是 fields[0], fields[1], fields[2]
-            int xIdx = 1, yIdx = 2, zIdx = 3;
-
-            double xVal = fields[xIdx].toDouble(&okX);
-            double yVal = fields[yIdx].toDouble(&okY);
-            double zVal = fields[zIdx].toDouble(&okZ);
-
-            if (okX && okY && okZ) {
-                xData.append(xVal);
-                yData.append(yVal);
-                zData.append(zVal);
-                timeKeys.append(sampleIndex * timePerSample);
-                sampleIndex++;
-            } else {
-                qWarning() << "loadAndDisplayCsvData: Could not parse line in" << csvFilePath << ":" << line;
-            }
+/**
+ * @brief 将 m_replayX/Y/Z 中的 count 点原始数据按需发送给模型，再滤波显示
+ * @param firstTime 首点在波形横轴上的时刻(s)
+ */
+bool Widget::displayReplayBuffers(int count, double firstTime, quint64 frameSequence, qint64 historyTimeMs, bool submitToModel)
+{
+    const double timePerSample = 1.0 / 10000.0; // 与实时数据采样率一致,10KHz
+    QVector<double> timeKeys(count), xData(count), yData(count), zData(count);
+    for (int i = 0; i < count; ++i) {
+        timeKeys[i] = firstTime + i * timePerSample;
+        xData[i] = m_replayX[i];
+        yData[i] = m_replayY[i];
+        zData[i] = m_replayZ[i];
+    }
+
+    // * 滤波前的原始数据发送给模型; 模型按帧(SAMPLES_PER_AXIS 点)分析，回放文件时发送显示窗口起点处的一帧
+    bool submitted = true;
+    if (submitToModel) {
+        if (count > SAMPLES_PER_AXIS) {
+            submitted = submitFrameToModel(historyTimeMs, frameSequence, xData.mid(0, SAMPLES_PER_AXIS),
+                                           yData.mid(0, SAMPLES_PER_AXIS), zData.mid(0, SAMPLES_PER_AXIS), false);
+        } else {
+            submitted = submitFrameToModel(historyTimeMs, frameSequence, xData, yData, zData, false);
         }
     }
-    file.close();
+    displayReplayData(timeKeys, xData, yData, zData);
+    return submitted;
+}
 
-    if (xData.isEmpty()) {
-        qWarning() << "loadAndDisplayCsvData: No valid data parsed from" << csvFilePath;
-        return false;
+/**
+ * @brief 回放数据滤波(原地)后显示到时域波形
+ */
+void Widget::displayReplayData(QVector<double>& timeKeys, QVector<double>& xData, QVector<double>& yData, QVector<double>& zData)
+{
+    if (!ui->time || !m_graphX || !m_graphY || !m_graphZ || !m_axisRectX || !m_axisRectY || !m_axisRectZ) {
+        qWarning("Plot, graphs, or axis rects not initialized in displayReplayData!");
+        return;
     }
 
-    // * 滤波处理
-    const int filterWindowSize = 3; // [可调] 滤波窗口大小，可以设为3, 5, 7等奇数。值越大越平滑。
-    xData = applyMovingAverageFilter(xData, filterWindowSize);
-    yData = applyMovingAverageFilter(yData, filterWindowSize);
-    zData = applyMovingAverageFilter(zData, filterWindowSize);
-    // * 更新时域波形
+    QCustomPlot *customPlot = ui->time;
+    double timePerSample = 1.0 / 10000.0; // 与实时数据采样率一致,10KHz
+
+    // * 滤波处理(原地)
+    m_movingAverage.apply(xData.data(), yData.data(), zData.data(), xData.size());
+    // * 更新时域波形(横轴已按时间排序)
     m_graphX->data()->clear();
     m_graphY->data()->clear();
     m_graphZ->data()->clear();
 
-    m_graphX->addData(timeKeys, xData);
-    m_graphY->addData(timeKeys, yData);
-    m_graphZ->addData(timeKeys, zData);
+    m_graphX->addData(timeKeys, xData, true);
+    m_graphY->addData(timeKeys, yData, true);
+    m_graphZ->addData(timeKeys, zData, true);
 
     if (!timeKeys.isEmpty()) {
         m_axisRectZ->axis(QCPAxis::atBottom)->setRange(timeKeys.first(), timeKeys.last());
@@ -715,106 +836,6 @@ bool Widget::loadAndDisplayCsvData(const QString& csvFilePath)
     m_graphZ->rescaleValueAxis(false, true);
 
     customPlot->replot();
-    qDebug() << "loadAndDisplayCsvData: Successfully loaded and displayed data from" << csvFilePath;
-    return true;
-}
-
-/**
- * @brief 清理旧的历史文件，并同步更新UI。
- * (修正版 v2：支持文件名与UI显示文本不一致的场景)
- * 最大保留maxFilesToKeep条历史数据，防止无限占用内存。
- */
-void Widget::cleanupOldHistoryFiles()
-{
-    // * 获取已处理文件目录的路径和文件列表
-    QString processedDir = getProcessedCsvDir();
-    QDir dir(processedDir);
-    // * 按修改时间降序排序（最新的在前，最旧的在后）
-    QFileInfoList fileList = dir.entryInfoList({"*.csv"}, QDir::Files, QDir::Time);
-
-    // * 定义要保留的最大文件数
-    const int maxFilesToKeep = 50;
-
-    // * 如果文件数量未超标，则无需清理，直接返回
-    if (fileList.size() <= maxFilesToKeep) {
-        return;
-    }
-
-    // * 计算需要删除的文件数量
-    int filesToRemoveCount = fileList.size() - maxFilesToKeep;
-
-    // * 循环删除多余的、最旧的文件
-    for (int i = 0; i < filesToRemoveCount; ++i)
-    {
-        // ** 从文件列表的末尾获取最旧的文件信息
-        const QFileInfo& oldestFileInfo = fileList.last();
-        QString fileName = oldestFileInfo.fileName();
-        QString filePathToRemove = oldestFileInfo.absoluteFilePath();
-
-        // ** 将文件名转换为UI中的显示文本
-        QString displayFormat = convertFileNameToDisplayFormat(fileName);
-
-        // ** 如果转换失败(返回空)，无法在UI中定位，但仍然可以删除文件
-        if (displayFormat.isEmpty()) {
-            qWarning() << "Skipping UI removal for un-parsable file:" << fileName;
-        } else {
-            // *** 使用转换后的显示文本，在HistoryBox中精确查找
-            int indexInComboBox = ui->HistoryBox->findText(displayFormat);
-
-            // *** 如果在UI中找到了，就删除它
-            if (indexInComboBox != -1) {
-                qDebug() << "Removing item from HistoryBox:" << displayFormat;
-                ui->HistoryBox->removeItem(indexInComboBox);
-            } else {
-                qWarning() << "Could not find display text" << displayFormat << "in HistoryBox.";
-            }
-        }
-
-        // ** 从文件系统中删除最旧的数据文件
-        if (QFile::remove(filePathToRemove)) {
-            qDebug() << "Successfully deleted old history file:" << filePathToRemove;
-        } else {
-            qWarning() << "Failed to delete old history file:" << filePathToRemove;
-            break;
-        }
-
-        // ** 从正在处理的文件列表中也移除它，以便下次循环能获取到下一个最旧的文件
-        fileList.removeLast();
-    }
-}
-
-/**
- * @brief 辅助函数，用于将文件名格式转换为HistoryBox中的显示格式
- * 例如: "data_20250705_161134_580.csv" -> "2025-07-05 16:11:34:580"
- */
-QString Widget::convertFileNameToDisplayFormat(const QString &fileName)
-{
-    // * 使用正则表达式来解析文件名
-    QRegExp rx("data_(\\d{8})_(\\d{6})_(\\d{3})\\.csv");
-
-    if (rx.indexIn(fileName) != -1) {
-        QString datePart = rx.cap(1); // 捕获 "20250705"
-        QString timePart = rx.cap(2); // 捕获 "161134"
-        QString msPart = rx.cap(3);   // 捕获 "580"
-
-        // ** 格式化日期部分: "20250705" -> "2025-07-05"
-        QString formattedDate = QString("%1-%2-%3")
-                                    .arg(datePart.left(4))
-                                    .arg(datePart.mid(4, 2))
-                                    .arg(datePart.right(2));
-
-        // ** 格式化时间部分: "161134" -> "16:11:34"
-        QString formattedTime = QString("%1:%2:%3")
-                                    .arg(timePart.left(2))
-                                    .arg(timePart.mid(2, 2))
-                                    .arg(timePart.right(2));
-
-        return QString("%1 %2:%3").arg(formattedDate).arg(formattedTime).arg(msPart);
-    }
-
-    // * 如果文件名格式不匹配，返回一个空字符串或原始文件名以作标识
-    qWarning() << "Could not parse filename:" << fileName;
-    return QString();
 }
 
 /**
@@ -966,8 +987,8 @@ void Widget::setupMultiAxisPlot()
 /**
  * @brief 在Moniter和Collect模式下，更新采样数据，更新显示波形.(核心)
  * 每批数据有1024个xyz三轴加速度样点.
- * Moniter模式下，将采样数据打包放入总数据目录下，等待模型分析.
- * Collect模式下，将采样数据放入对应标签的csv文件中.
+ * 只消费绘图环中的最新一帧，用于绘图和网络发送; 模型分析由 drainModelRing 消费模型环，
+ * Collect模式的录制由写盘线程消费存储环，这里只更新采集进度.
  */
 void Widget::updatePlotWithNewBatch()
 {
@@ -987,36 +1008,63 @@ void Widget::updatePlotWithNewBatch()
         }
     }
     Mode_Buf = Mode;
-    // * History 不实时更新数据，直接返回.
+    // * Collect模式的数据由写盘线程从存储环直接写入，这里只更新进度.
+    if (Mode == "Collect" && !finish) {
+        updateCollectProgress();
+    }
+    // * History 不实时更新数据，丢弃采集线程发布的帧后直接返回.
     if(Mode == "History")
     {
+        while (m_frameRing && m_frameRing->readSlot()) {
+            m_frameRing->release();
+        }
         return;
     }
     if (!ui->time || !m_graphX || !m_graphY || !m_graphZ || !m_axisRectX || !m_axisRectY || !m_axisRectZ) {
         qWarning("Plot, graphs, or axis rects not initialized in updatePlotWithNewBatch!");
         return;
     }
-    QCustomPlot *customPlot = ui->time;
-    // * 数据读取
-    QVector<double> timeData, xData_raw, yData_raw, zData_raw;
-    bool success = m_dataReader.readDeviceData(timeData, xData_raw, yData_raw, zData_raw, m_currentBatchNumber);
-    if (!success) {
-        qDebug("Failed to read data batch from device. Skipping plot update.");
+    if (!m_frameRing) {
         return;
     }
-
-    // * 滤波处理
-    const int filterWindowSize = 3; // [可调] 滤波窗口大小，可以设为3, 5, 7等奇数。值越大越平滑。
-    QVector<double> xData = applyMovingAverageFilter(xData_raw, filterWindowSize);
-    QVector<double> yData = applyMovingAverageFilter(yData_raw, filterWindowSize);
-    QVector<double> zData = applyMovingAverageFilter(zData_raw, filterWindowSize);
+    QCustomPlot *customPlot = ui->time;
+    // * 绘图和网络发送只使用最新一帧，跳过绘图环中较早的帧.
+    // * 录制(存储环，写盘线程)和模型分析(模型环，drainModelRing)各自消费全部帧.
+    while (m_frameRing->size() > 1) {
+        m_frameRing->readSlot();
+        m_frameRing->release();
+    }
+    const AdcFrame* frame = m_frameRing->readSlot();
+    if (!frame) {
+        return; // 采集线程尚未产生新数据
+    }
+    QVector<double> xData_raw(SAMPLES_PER_AXIS), yData_raw(SAMPLES_PER_AXIS), zData_raw(SAMPLES_PER_AXIS);
+    std::copy(frame->x, frame->x + SAMPLES_PER_AXIS, xData_raw.begin());
+    std::copy(frame->y, frame->y + SAMPLES_PER_AXIS, yData_raw.begin());
+    std::copy(frame->z, frame->z + SAMPLES_PER_AXIS, zData_raw.begin());
+    m_frameRing->release();
+
+    // * 滤波处理: 原始数据仍用于录制和模型分析，滤波结果写入复用的绘图缓冲区
+    QVector<double>& xData = m_filteredX;
+    QVector<double>& yData = m_filteredY;
+    QVector<double>& zData = m_filteredZ;
+    xData.resize(xData_raw.size());
+    yData.resize(yData_raw.size());
+    zData.resize(zData_raw.size());
+    const double* const rawData[NUM_AXES] = { xData_raw.constData(), yData_raw.constData(), zData_raw.constData() };
+    double* const filteredData[NUM_AXES] = { xData.data(), yData.data(), zData.data() };
+    m_movingAverage.process(rawData, filteredData, xData_raw.size());
 
     // * 时间轴生成
     QVector<double> actualTimeKeys;
     if (!xData.isEmpty()) {
         if(tcpSocket != nullptr && tcpSocket->state() == QAbstractSocket::ConnectedState)
         {
-          emit newDataReadyToSend(xData, yData, zData);
+          if (m_compressStream) {
+              emit newRawDataReadyToSend(xData_raw, yData_raw, zData_raw);
+          } else {
+              emit newDataReadyToSend(xData, yData, zData);
+          }
         }
         actualTimeKeys.resize(xData.size());
         double timePerSample = 1.0 / 10000.0;
@@ -1027,281 +1075,367 @@ void Widget::updatePlotWithNewBatch()
         qWarning("Received empty data batch. Skipping plot update.");
         return;
     }
-    // * 模式选择与功能执行
-    if(Mode == "Monitor")
-    {
-        // ** 将数据打包成一个个csv文件供模型预测，也用于历史回溯
-        if(Model_Deploy == true)
-        {
-            if (!timeData.isEmpty()) {
-                if (m_csvDataPath.isEmpty()) {
-                    m_csvDataPath = QDir::currentPath() + "/sensor_data_for_python";
-                    QDir dir;
-                    if (!dir.exists(m_csvDataPath)) dir.mkpath(m_csvDataPath);
-                }
-                QDateTime currentDateTime = QDateTime::currentDateTime();
-                QString timestamp = currentDateTime.toString("yyyyMMdd_HHmmss_zzz");
-                QString csvFilename = m_csvDataPath + QString("/data_%1.csv").arg(timestamp);
-                qDebug() << "Writing data to CSV:" << csvFilename;
-                if (!writeDataToCsv(csvFilename, timeData, xData_raw, yData_raw, zData_raw)) {
-                    qWarning() << "Failed to write data to CSV:" << csvFilename;
-                } else {
-                    qDebug() << "Successfully wrote" << csvFilename;
-                }
-            }
+    // * 波形绘制
+    m_graphX->data()->clear();
+    m_graphY->data()->clear();
+    m_graphZ->data()->clear();
+
+    m_graphX->addData(actualTimeKeys, xData);
+    m_graphY->addData(actualTimeKeys, yData);
+    m_graphZ->addData(actualTimeKeys, zData);
+
+    if (!actualTimeKeys.isEmpty()) {
+        m_axisRectZ->axis(QCPAxis::atBottom)->setRange(actualTimeKeys.first(), actualTimeKeys.last());
+    } else {
+        double timePerSample = 1.0 / 10000.0;
+        m_axisRectZ->axis(QCPAxis::atBottom)->setRange(0, (m_batchSize > 0 ? (m_batchSize - 1) : 0) * timePerSample);
+    }
+
+    m_graphX->rescaleValueAxis(false, true);
+    m_graphY->rescaleValueAxis(false, true);
+    m_graphZ->rescaleValueAxis(false, true);
+
+    customPlot->replot();
+    m_currentBatchNumber++;
+}
+
+/**
+ * @brief Collect模式使用，打开当前标签对应的录制文件(<标签>.rec)，由写盘线程从存储环直接采集 CollectTargetBox 帧.
+ * 采集数据不经过界面线程，界面线程只按写盘线程的统计更新进度.
+ */
+bool Widget::startCollectCapture()
+{
+    QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+    QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+    if (!ui->LabelBox) {
+        qWarning("Collect Mode: LabelBox UI element is missing.");
+        return false;
+    }
+    // * 标签检查
+    QString currentLabel = ui->LabelBox->currentText().trimmed();
+    if (currentLabel.isEmpty()) {
+        qWarning() << "Collect Mode: LabelBox is empty. Cannot determine record filename.";
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'>Collect Mode Warning:</font> LabelBox is empty, data not saved.").arg(dtp));
+            ui->SysEdit->ensureCursorVisible();
         }
-    }else if(Mode == "Collect")
-    {
-        // ** 根据选择的标签将数据放入对应的csv文件中
-        if(!finish)
-        {
-            if (!xData_raw.isEmpty() && ui->LabelBox) {
-                // *** 标签检查
-                QString currentLabel = ui->LabelBox->currentText().trimmed();
-                if (currentLabel.isEmpty()) {
-                    qWarning() << "Collect Mode: LabelBox is empty. Cannot determine CSV filename.";
-                    if (ui->SysEdit) {
-                        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                        ui->SysEdit->appendHtml(QString("%1<font color='orange'>Collect Mode Warning:</font> LabelBox is empty, data not saved.").arg(dtp));
-                        ui->SysEdit->ensureCursorVisible();
-                    }
-                } else {
-                    // *** 数据存放路径检查
-                    QString collectSubPath = m_csvDataPath + "/Collect";
-                    QDir collectDir(collectSubPath);
-                    if (!collectDir.exists()) {
-                        if (!collectDir.mkpath(".")) {
-                            qWarning() << "Collect Mode: Failed to create Collect sub-directory:" << collectSubPath;
-                            if (ui->SysEdit) {
-                                QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                                QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                                ui->SysEdit->appendHtml(QString("%1<font color='red'>Collect Mode Error:</font> Failed to create dir %2.").arg(dtp).arg(collectSubPath.toHtmlEscaped()));
-                                ui->SysEdit->ensureCursorVisible();
-                            }
-                        }
-                    }
-                    // *** 标签裁剪修改(防止出现非法字符)
-                    QString cleanLabel = currentLabel;
-                    cleanLabel.remove(QRegExp(QStringLiteral("[^a-zA-Z0-9_.-]")));
-                    if (cleanLabel.isEmpty()) cleanLabel = "default_collection";
-                    QString targetCsvFilename = collectSubPath + QString("/%1.csv").arg(cleanLabel);
-
-                    // *** 若更换标签，则打开新的标签文件
-                    if (m_currentCollectCsvPath != targetCsvFilename) {
-                        closeCollectCsvFile();
-                        m_currentCollectCsvPath = targetCsvFilename;
-                        if (!openAndPrepareCollectCsvFile(m_currentCollectCsvPath, "Time Stamp,X-axis,Y-axis,Z-axis\n")) {
-                            qWarning() << "Collect Mode: Failed to open CSV for collection:" << m_currentCollectCsvPath;
-                            if (ui->SysEdit) {
-                                QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                                QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                                ui->SysEdit->appendHtml(QString("%1<font color='red'>Collect Mode Error:</font> Failed to open %2.").arg(dtp).arg(m_currentCollectCsvPath.toHtmlEscaped()));
-                                ui->SysEdit->ensureCursorVisible();
-                            }
-                        }
-                    }
+        return false;
+    }
+    // * 数据存放路径检查
+    QString collectSubPath = m_csvDataPath + "/Collect";
+    QDir collectDir(collectSubPath);
+    if (!collectDir.exists() && !collectDir.mkpath(".")) {
+        qWarning() << "Collect Mode: Failed to create Collect sub-directory:" << collectSubPath;
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='red'>Collect Mode Error:</font> Failed to create dir %2.").arg(dtp).arg(collectSubPath.toHtmlEscaped()));
+            ui->SysEdit->ensureCursorVisible();
+        }
+        return false;
+    }
+    // * 标签裁剪修改(防止出现非法字符)
+    QString cleanLabel = currentLabel;
+    cleanLabel.remove(QRegExp(QStringLiteral("[^a-zA-Z0-9_.-]")));
+    if (cleanLabel.isEmpty()) cleanLabel = "default_collection";
+    closeCollectRecord();
+    m_collectLabel = cleanLabel;
+    m_collectTargetPath = collectSubPath + QString("/%1.rec").arg(cleanLabel);
+    openCollectRecord(m_collectTargetPath, m_collectLabel);
+    // * 写满目标帧数后写盘线程自动停止采集并发出 captureFinished
+    const RecordWriterThread::Stats stats = m_recordWriter->stats();
+    m_collectBaseFrames = stats.framesCaptured;
+    m_collectBaseDropped = stats.blocksDropped;
+    m_collectReportedDropped = 0;
+    m_recordWriter->startCapture(ui->CollectTargetBox->value());
+    return true;
+}
 
-                    // *** 写入收集数据
-                    bool batchWrittenSuccessfully = false;
-                    if (m_collectCsvFile.isOpen() && m_collectCsvFile.isWritable()) {
-                        qDebug() << "Collect Mode: Appending to CSV:" << m_currentCollectCsvPath;
-                        QString currentBatchTimeStamp = QTime::currentTime().toString("HH:mm:ss.zzz");
-
-                        for (int i = 0; i < xData_raw.size(); ++i) {
-                            if (m_collectCsvStream.device() == &m_collectCsvFile) {
-                                m_collectCsvStream << currentBatchTimeStamp << ","
-                                                   << QString::number(xData_raw[i], 'f', 6) << ","
-                                                   << QString::number(yData_raw[i], 'f', 6) << ","
-                                                   << QString::number(zData_raw[i], 'f', 6) << "\n";
-                            } else {
-                                qWarning() << "Collect Mode: CSV stream invalid for" << m_currentCollectCsvPath;
-                                break;
-                            }
-                        }
-                        // *** 强制将缓冲区中所有待处理的数据立即写入到关联的设备（即 CSV 文件）中
-                        m_collectCsvStream.flush();
-                        if (m_collectCsvFile.error() == QFile::NoError) {
-                            // *** 本次采集数据写入成功
-                            batchWrittenSuccessfully = true;
-                        } else {
-                            qWarning() << "Collect Mode: Error writing to" << m_currentCollectCsvPath << ":" << m_collectCsvFile.errorString();
-                            if (ui->SysEdit) {
-                                QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                                QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                                ui->SysEdit->appendHtml(QString("%1<font color='red'>Collect Mode Error:</font> Write failed %2. Err: %3")
-                                                            .arg(dtp)
-                                                            .arg(m_currentCollectCsvPath.toHtmlEscaped())
-                                                            .arg(m_collectCsvFile.errorString().toHtmlEscaped()));
-                                ui->SysEdit->ensureCursorVisible();
-                            }
-                        }
-                    } else {
-                        qWarning() << "Collect Mode: CSV" << m_currentCollectCsvPath << "not open for writing.";
-                        if (ui->SysEdit && !m_currentCollectCsvPath.isEmpty()) {
-                            QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                            QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                            ui->SysEdit->appendHtml(QString("%1<font color='red'>Collect Mode Error:</font> File %2 not open.")
-                                                        .arg(dtp).arg(m_currentCollectCsvPath.toHtmlEscaped()));
-                            ui->SysEdit->ensureCursorVisible();
-                        }
-                    }
+/**
+ * @brief Collect模式下每次刷新时调用: 按写盘线程写入的帧数更新进度，报告存储跟不上时丢弃的帧
+ */
+void Widget::updateCollectProgress()
+{
+    const RecordWriterThread::Stats stats = m_recordWriter->stats();
+    const int captured = static_cast<int>(stats.framesCaptured - m_collectBaseFrames);
+    const quint64 dropped = stats.blocksDropped - m_collectBaseDropped;
+    QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+    QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+
+    // * 写入失败后文件已关闭(onRecordWriteError)，重新请求打开，写盘线程仍在采集
+    if (m_currentCollectPath.isEmpty() && !m_collectTargetPath.isEmpty()) {
+        openCollectRecord(m_collectTargetPath, m_collectLabel);
+    }
+    if (dropped > m_collectReportedDropped) {
+        // * 存储跟不上采集速度或文件未打开: 写盘线程丢弃了这些帧(不计入采集进度)
+        qWarning() << "Collect Mode:" << dropped - m_collectReportedDropped << "frames dropped. Total dropped:" << dropped;
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'>Collect Mode Warning:</font> Storage too slow, frame dropped (%2 dropped in total).")
+                                        .arg(dtp).arg(dropped));
+            ui->SysEdit->ensureCursorVisible();
+        }
+        m_collectReportedDropped = dropped;
+    }
+    if (captured > m_collect_cnt && ui->SysEdit) {
+        QString successMsg = QString("%1<font color='DarkCyan'>Collect Mode:</font> %2 records to %3")
+                                 .arg(dtp)
+                                 .arg((captured - m_collect_cnt) * SAMPLES_PER_AXIS)
+                                 .arg(QFileInfo(m_collectTargetPath).fileName().toHtmlEscaped());
+        ui->SysEdit->appendHtml(successMsg);
+        ui->SysEdit->ensureCursorVisible();
+    }
+    m_collect_cnt = captured;
+
+    // * 更新进度条
+    int targetCount = ui->CollectTargetBox->value();
+    if (ui->CollectProgressBar->maximum() != targetCount) {
+        ui->CollectProgressBar->setMaximum(targetCount);
+    }
+    ui->CollectProgressBar->setValue(qMin(m_collect_cnt, targetCount));
+}
+
+/**
+ * @brief 写盘线程已写满目标帧数: 给出反馈，关闭文件并回到 Monitor 模式
+ */
+void Widget::onCollectFinished(quint64 framesCaptured)
+{
+    Q_UNUSED(framesCaptured);
+    if (Mode != "Collect" || finish) {
+        return;
+    }
+    updateCollectProgress();
+    int targetCount = ui->CollectTargetBox->value();
+    finish = true;
+    Mode = "Monitor";
+    closeCollectRecord(); // 写盘线程写完已采集的帧后关闭并同步文件
+    m_collect_cnt = 0;
+    ui->CollectProgressBar->setValue(0);
+    ui->CollectProgressBar->setEnabled(false);
+    ui->CollectStopButton->setEnabled(false);
+    ui->CollectStartButton->setEnabled(true);
+    ui->LabelBox->setEnabled(true);
+    beepctl->notificationSuccess();
+    QMessageBox::information(this, "采集完成", QString("已成功采集 %1 个样本！").arg(targetCount));
+}
 
-                    if (batchWrittenSuccessfully && ui->SysEdit) {
-                        // *** 到此一次数据采集及检查均已通过
-                        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                        QString successMsg = QString("%1<font color='DarkCyan'>Collect Mode:</font> %2 records to %3")
-                                                 .arg(dtp)
-                                                 .arg(xData.size())
-                                                 .arg(QFileInfo(m_currentCollectCsvPath).fileName().toHtmlEscaped());
-                        ui->SysEdit->appendHtml(successMsg);
-                        ui->SysEdit->ensureCursorVisible();
-                        m_collect_cnt ++;
-
-                        // *** 更新进度条
-
-                        // 1. 获取目标数量
-                        int targetCount = ui->CollectTargetBox->value();
-
-                        // 2. 更新进度条的范围（最大值）
-                        if (ui->CollectProgressBar->maximum() != targetCount) {
-                            ui->CollectProgressBar->setMaximum(targetCount);
-                        }
-                        // 3. 更新进度条的当前值
-                        ui->CollectProgressBar->setValue(qMin(m_collect_cnt, targetCount));
-
-                        // 4. 检查是否已达到目标，并给出反馈
-                        if (m_collect_cnt >= targetCount) {
-                            finish = true;
-                            beepctl->notificationSuccess();
-                            QMessageBox::information(this, "采集完成", QString("已成功采集 %1 个样本！").arg(targetCount));
-                            Mode = "Monitor";
-                            m_collect_cnt = 0;
-                            ui->CollectProgressBar->setValue(0);
-                            ui->CollectProgressBar->setEnabled(false);
-                            ui->CollectStopButton->setEnabled(false);
-                            ui->CollectStartButton->setEnabled(true);
-                            ui->LabelBox->setEnabled(true);
-                        }
-                    }
-                }
-            } else if (xData_raw.isEmpty()) {
-                qDebug("Collect Mode: No data to write (xData is empty).");
-            } else if (!ui->LabelBox) {
-                qWarning("Collect Mode: LabelBox UI element is missing.");
+/**
+ * @brief 模型环消费定时器槽: Monitor模式下把采集线程发布的每一帧原始数据经 submitFrameToModel 发送给模型，
+ * 预测可信时追加到历史存储，用于历史回溯. 在途帧已满(MAX_IN_FLIGHT)时 sendFrame 丢弃该帧，即为模型的背压;
+ * 模型环本身满时由采集线程丢弃并计数. 其他模式或模型未部署时取出后丢弃.
+ */
+void Widget::drainModelRing()
+{
+    if (!m_modelRing) {
+        return;
+    }
+    const bool analyse = Mode == "Monitor" && Model_Deploy;
+    while (const AdcFrame* frame = m_modelRing->readSlot()) {
+        if (analyse) {
+            QVector<double> xData(SAMPLES_PER_AXIS), yData(SAMPLES_PER_AXIS), zData(SAMPLES_PER_AXIS);
+            std::copy(frame->x, frame->x + SAMPLES_PER_AXIS, xData.begin());
+            std::copy(frame->y, frame->y + SAMPLES_PER_AXIS, yData.begin());
+            std::copy(frame->z, frame->z + SAMPLES_PER_AXIS, zData.begin());
+            bool continuous = m_hasLastModelFrame && frame->sequence == m_lastModelFrame + 1;
+            if (submitFrameToModel(AcquisitionThread::wallTimeMs(frame->timestampNs), frame->sequence, xData, yData, zData,
+                                   m_archiveHistory, continuous)) {
+                m_lastModelFrame = frame->sequence;
+                m_hasLastModelFrame = true;
+            } else {
+                m_hasLastModelFrame = false; // 丢弃的帧使下一帧与已发送的帧不再相接
             }
         }
+        m_modelRing->release();
     }
-
-    // * 波形绘制
-    m_graphX->data()->clear();
-    m_graphY->data()->clear();
-    m_graphZ->data()->clear();
-
-    m_graphX->addData(actualTimeKeys, xData);
-    m_graphY->addData(actualTimeKeys, yData);
-    m_graphZ->addData(actualTimeKeys, zData);
-
-    if (!actualTimeKeys.isEmpty()) {
-        m_axisRectZ->axis(QCPAxis::atBottom)->setRange(actualTimeKeys.first(), actualTimeKeys.last());
-    } else {
-        double timePerSample = 1.0 / 10000.0;
-        m_axisRectZ->axis(QCPAxis::atBottom)->setRange(0, (m_batchSize > 0 ? (m_batchSize - 1) : 0) * timePerSample);
+    if (!analyse) {
+        m_hasLastModelFrame = false;
     }
-
-    m_graphX->rescaleValueAxis(false, true);
-    m_graphY->rescaleValueAxis(false, true);
-    m_graphZ->rescaleValueAxis(false, true);
-
-    customPlot->replot();
-    m_currentBatchNumber++;
 }
 
 /**
- * @brief Moniter模式使用，打包数据为一个个csv文件，供模型分析和历史回溯
+ * @brief Moniter模式使用，将预测可信的数据作为一块追加到历史存储，供历史回溯
+ * @param timeMs 采集时刻，系统时间回拨时存储会顺延，实际的键由 m_history.lastTimeMs() 给出
  */
-bool Widget::writeDataToCsv(const QString& filename,
-                            const QVector<double>& timeData,
-                            const QVector<double>& xData,
-                            const QVector<double>& yData,
-                            const QVector<double>& zData)
+bool Widget::writeDataToHistory(qint64 timeMs,
+                                quint64 frameSequence,
+                                const QVector<double>& xData,
+                                const QVector<double>& yData,
+                                const QVector<double>& zData)
 {
-    if (timeData.isEmpty()) {
-        qWarning() << "Time data empty for CSV:" << filename;
+    if (xData.isEmpty() || xData.size() > SAMPLES_PER_AXIS) {
+        qWarning() << "Invalid data size for history:" << timeMs << xData.size();
         return false;
     }
-    if (timeData.size() != xData.size() || timeData.size() != yData.size() || timeData.size() != zData.size()) {
-        qWarning() << "Data vector size mismatch for CSV!" << filename;
+    if (xData.size() != yData.size() || xData.size() != zData.size()) {
+        qWarning() << "Data vector size mismatch for history!" << timeMs;
         return false;
     }
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
-        qWarning() << "Cannot open file for writing:" << filename << file.errorString();
+    if (!m_history.append(recordHeader(QString()), xData.constData(), yData.constData(), zData.constData(), xData.size(),
+                          frameSequence, timeMs)) {
+        qWarning() << "Error during history write:" << timeMs << m_history.errorString();
         return false;
     }
-    QTextStream out(&file);
-    out.setRealNumberPrecision(6); // Qt 5
-    out.setRealNumberNotation(QTextStream::FixedNotation); // Qt 5, or use QString::number with 'f'
+    return true;
+}
+
+/**
+ * @brief 录制文件头: 采集线程的解码器为线性标定时保存经 AdcCodec 无损压缩的 10 位码值，否则保存 float32
+ */
+Record::FileHeader Widget::recordHeader(const QString& label)
+{
+    Record::FileHeader header;
+    if (m_acquisitionThread) {
+        AdcDecoder& decoder = m_acquisitionThread->decoder();
+        header.format = decoder.isLinear() ? Record::FormatPacked10 : Record::FormatFloat32;
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            header.scale[axis] = decoder.scale(axis);
+            header.offset[axis] = decoder.offset(axis);
+        }
+    }
+    QByteArray utf8 = label.toUtf8().left(Record::LABEL_SIZE - 1);
+    memcpy(header.label, utf8.constData(), utf8.size());
+    return header;
+}
 
-    out << "Time,X,Y,Z\n";
-    for (int i = 0; i < timeData.size(); ++i) {
-        out << QString::number(timeData[i], 'f', 6) << ","
-            << QString::number(xData[i], 'f', 6) << ","
-            << QString::number(yData[i], 'f', 6) << ","
-            << QString::number(zData[i], 'f', 6) << "\n";
+/**
+ * @brief 将一帧原始数据发送给模型(进程内推理线程 m_inference，或经 m_modelIpc 发送给 Python 服务)，
+ *        记录帧序号以便结果返回时归档
+ * @param timeMs 采集时刻(归档时作为历史记录的键)，历史回放时为回放记录的时刻，回放存储外的文件时为 0
+ * @param frameSequence 采集帧序号，归档时写入数据块
+ * @param archive 预测可信时是否将数据追加到历史存储
+ * @param continuous 该帧紧接上一个发送的帧，模型可在两帧之间拼接重叠窗口
+ * @return 是否已发送(模型服务未连接或在途帧已满时丢弃)
+ */
+bool Widget::submitFrameToModel(qint64 timeMs,
+                                quint64 frameSequence,
+                                const QVector<double>& xData,
+                                const QVector<double>& yData,
+                                const QVector<double>& zData,
+                                bool archive,
+                                bool continuous)
+{
+    if (xData.isEmpty() || xData.size() != yData.size() || xData.size() != zData.size()) {
+        qWarning() << "submitFrameToModel: data vector size mismatch for" << timeMs;
+        return false;
+    }
+    // * MFCC 特征只在显示窗口打开时请求; 重叠窗口只对与上一帧相接的帧有意义
+    quint16 flags = continuous ? ModelIpc::FlagContinuous : 0;
+    if (continuous && m_overlapWindows) {
+        flags |= ModelIpc::FlagOverlap;
     }
-    file.close();
-    if (file.error() != QFile::NoError) {
-        qWarning() << "Error during file write/close:" << filename << file.errorString();
+    if (m_mfccDisplayWindow && m_mfccDisplayWindow->isVisible()) {
+        flags |= ModelIpc::FlagFeatures;
+    }
+    quint32 sequence = m_inference
+                           ? m_inference->sendFrame(xData.constData(), yData.constData(), zData.constData(), xData.size(), flags)
+                           : m_modelIpc->sendFrame(xData.constData(), yData.constData(), zData.constData(), xData.size(), flags);
+    if (sequence == 0) {
+        qDebug() << "submitFrameToModel: frame not sent (model busy or disconnected), dropped so far:"
+                 << modelDroppedFrames();
         return false;
     }
+    PendingFrame& pending = m_pendingFrames[sequence];
+    pending.timeMs = timeMs;
+    pending.archive = archive;
+    pending.frameSequence = frameSequence;
+    if (archive) {
+        pending.xData = xData;
+        pending.yData = yData;
+        pending.zData = zData;
+    }
     return true;
 }
 
 /**
- * @brief Collect模式使用，收集数据到对应标签名字的csv文件中.
+ * @brief 模型结果槽: 可信的结果先将原始数据追加到历史存储，再更新界面
+ * @param overlapped 重叠窗口的结果，不对应已发送的帧，只更新状态和显示
  */
-bool Widget::openAndPrepareCollectCsvFile(const QString& filePath, const QString& headerLine)
+void Widget::onModelResult(quint32 sequence, bool overlapped, int classIndex, double predictedConfidence,
+                           const QVector<double>& probabilities, const QVector<double>& features)
 {
-    if (m_collectCsvFile.isOpen() && m_collectCsvFile.fileName() != filePath) {
-        closeCollectCsvFile();
-    }
-    if (m_collectCsvFile.isOpen() && m_collectCsvFile.fileName() == filePath) {
-        if(m_collectCsvStream.device() != &m_collectCsvFile) m_collectCsvStream.setDevice(&m_collectCsvFile);
-        return true;
-    }
-    m_collectCsvFile.setFileName(filePath);
-    bool fileExisted = QFile::exists(filePath);
-    if (!m_collectCsvFile.open(QIODevice::Append | QIODevice::Text)) {
-        qWarning() << "Collect Mode: Cannot open file for appending:" << filePath << m_collectCsvFile.errorString();
-        m_currentCollectCsvPath.clear();
-        return false;
+    if (overlapped) {
+        applyPrediction(0, classIndex, predictedConfidence, probabilities, features);
+        return;
+    }
+    PendingFrame pending = m_pendingFrames.take(sequence);
+    qint64 historyTimeMs = 0; // 已在历史存储中的记录才加入 HistoryBox
+    if (pending.archive && predictedConfidence >= 85) {
+        if (writeDataToHistory(pending.timeMs, pending.frameSequence, pending.xData, pending.yData, pending.zData)) {
+            historyTimeMs = m_history.lastTimeMs();
+        }
+    } else if (!pending.archive && pending.timeMs > 0 && m_history.contains(pending.timeMs)) {
+        historyTimeMs = pending.timeMs; // 历史回放
     }
-    m_collectCsvStream.setDevice(&m_collectCsvFile);
+    applyPrediction(historyTimeMs, classIndex, predictedConfidence, probabilities, features);
+}
+
+/**
+ * @brief 模型错误槽: 预处理或推理失败的帧
+ */
+void Widget::onModelError(quint32 sequence, const QString& message)
+{
+    PendingFrame pending = m_pendingFrames.take(sequence);
+    qWarning() << "Model error for frame" << sequence << pending.timeMs << ":" << message;
+}
+
+/**
+ * @brief Collect模式使用，收集数据到对应标签名字的录制文件中，文件已存在时追加.
+ */
+void Widget::openCollectRecord(const QString& filePath, const QString& label)
+{
+    // * 打开请求由写盘线程在之前入队的帧写完后执行，失败时经 onRecordWriteError 报告
+    m_recordWriter->openFile(filePath, recordHeader(label));
+    qDebug() << "Collect Mode: Requested record for collection:" << filePath << "(Existed:" << QFile::exists(filePath) << ")";
+    m_currentCollectPath = filePath;
+}
+
+/**
+ * @brief 停止写盘线程的采集并关闭程序中打开的录制文件，结束Collect或更换标签时使用
+ */
+void Widget::closeCollectRecord()
+{
+    m_recordWriter->stopCapture();
+    m_collectTargetPath.clear();
+    if (!m_currentCollectPath.isEmpty()) {
+        m_recordWriter->closeFile();
+        RecordWriterThread::Stats stats = m_recordWriter->stats();
+        qDebug() << "Collect Mode: Closing record file:" << m_currentCollectPath
+                 << "backlog:" << stats.backlog << "peak:" << stats.peakBacklog << "dropped:" << stats.blocksDropped
+                 << "stalls:" << stats.stalls << "max write(us):" << stats.maxWriteUs;
+    }
+    m_currentCollectPath.clear();
+}
 
-    if ((!fileExisted || m_collectCsvFile.size() == 0) && !headerLine.isEmpty()) {
-        m_collectCsvStream << headerLine;
-        m_collectCsvStream.flush();
-        qDebug() << "Collect Mode: Wrote header to new CSV:" << filePath;
+/**
+ * @brief 写盘线程打开或写入收集文件失败: 提示错误，下一次刷新时重新请求打开
+ */
+void Widget::onRecordWriteError(const QString& path, const QString& message)
+{
+    qWarning() << "Collect Mode: Error writing to" << path << ":" << message;
+    if (path == m_currentCollectPath) {
+        m_currentCollectPath.clear();
+    }
+    if (ui->SysEdit) {
+        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+        ui->SysEdit->appendHtml(QString("%1<font color='red'>Collect Mode Error:</font> Write failed %2. Err: %3")
+                                    .arg(dtp)
+                                    .arg(path.toHtmlEscaped())
+                                    .arg(message.toHtmlEscaped()));
+        ui->SysEdit->ensureCursorVisible();
     }
-    qDebug() << "Collect Mode: Opened CSV for collection:" << filePath << "(Existed:" << fileExisted << ")";
-    m_currentCollectCsvPath = filePath;
-    return true;
 }
 
 /**
- * @brief 关闭程序中打开的csv文件，结束Collect或更换标签时使用
+ * @brief 单次写入或同步耗时过长(SD卡卡顿)，提示当前写盘队列积压
  */
-void Widget::closeCollectCsvFile()
+void Widget::onRecordWriteStalled(qint64 writeMs, int backlog)
 {
-    if (m_collectCsvFile.isOpen()) {
-        m_collectCsvStream.flush();
-        m_collectCsvStream.setDevice(nullptr);
-        m_collectCsvFile.close();
-        qDebug() << "Collect Mode: Closed CSV file:" << m_currentCollectCsvPath;
+    qWarning() << "Collect Mode: Storage stalled for" << writeMs << "ms, backlog" << backlog << "frames";
+    if (ui->SysEdit) {
+        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+        ui->SysEdit->appendHtml(QString("%1<font color='orange'>Collect Mode Warning:</font> Storage stalled %2 ms, %3/%4 frames queued.")
+                                    .arg(dtp).arg(writeMs).arg(backlog).arg(static_cast<int>(RecordWriterThread::BlockQueue::capacity())));
+        ui->SysEdit->ensureCursorVisible();
     }
-    m_currentCollectCsvPath.clear();
 }
 
 /**
@@ -1348,11 +1482,49 @@ found_ip_time:;
         CurrentState = QString("State: N/A");
     }
 
-    QString State = dateTimeString + "  |  " + ModeString + " |  " + ipAddressString + "  |  " + portString + "  |  " + CurrentState;
+    QString State = dateTimeString + "  |  " + ModeString + " |  " + ipAddressString + "  |  " + portString + "  |  " + CurrentState
+                    + "  |  " + acquisitionStatusText();
     ui->StateLabel->setText(State);
     m_mfccDisplayWindow->setStateLabel(State);
 }
 
+/**
+ * @brief 模型忙(在途帧已满)或未连接而未发送的帧数
+ */
+quint64 Widget::modelDroppedFrames() const
+{
+    if (m_inference) {
+        return m_inference->droppedFrames();
+    }
+    return m_modelIpc ? m_modelIpc->droppedFrames() : 0;
+}
+
+/**
+ * @brief 采集数据质量统计: 采集端丢帧数、各消费者环(绘图/存储/模型)满时丢弃的帧数、脉冲抑制替换的采样点数(X/Y/Z)
+ */
+QString Widget::acquisitionStatusText() const
+{
+    if (!m_acquisitionThread) {
+        return QString("Lost: N/A");
+    }
+    QString text = QString("Lost: %1  Drop: %2/%3/%4  Model busy: %5")
+                       .arg(m_acquisitionThread->framesLost())
+                       .arg(m_frameRing ? m_frameRing->dropped() : 0)
+                       .arg(m_storageRing ? m_storageRing->dropped() : 0)
+                       .arg(m_modelRing ? m_modelRing->dropped() : 0)
+                       .arg(modelDroppedFrames());
+    if (m_inference) {
+        text += QString("  Infer: %1 %2us").arg(m_inference->isInt8() ? "int8" : "float").arg(m_inference->lastWindowUs());
+    }
+    if (!m_spikeFilterEnabled) {
+        return text + "  Spikes: off";
+    }
+    return text + QString("  Spikes: %1/%2/%3")
+                      .arg(m_acquisitionThread->samplesRejected(0))
+                      .arg(m_acquisitionThread->samplesRejected(1))
+                      .arg(m_acquisitionThread->samplesRejected(2));
+}
+
 /**
  * @brief TCP客户端连接信号槽
  */
@@ -1477,6 +1649,10 @@ void Widget::on_CollectStartButton_clicked()
     setLED(ui->DeviceStateLabel,0,16);
     m_collect_cnt = 0;
     ui->LabelBox->setEnabled(false);
+    if (!startCollectCapture()) {
+        on_CollectStopButton_clicked();
+        return;
+    }
     // * 清理 Monitor 模式可能遗漏的 CSV 文件
     if (!m_csvDataPath.isEmpty()) {
         QDir csvDir(m_csvDataPath);
@@ -1519,7 +1695,7 @@ void Widget::on_CollectStopButton_clicked()
     ui->LabelBox->setEnabled(true);
     ui->CollectStartButton->setEnabled(true);
     ui->CollectStopButton->setEnabled(false);
-    closeCollectCsvFile(); // 确保收集文件已关闭并刷新
+    closeCollectRecord(); // 停止采集，确保收集文件已关闭并刷新
     if(ui->SysEdit){
         QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
         QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
@@ -1581,38 +1757,41 @@ void Widget::on_CollectCleanButton_clicked()
         cleanLabel = "default_collection";
     }
 
-    // * 构建完整的文件路径
-    QString targetCsvFilename = collectSubPath + QString("/%1.csv").arg(cleanLabel);
-    QFile fileToDelete(targetCsvFilename);
+    // * 构建完整的文件路径(没有 .rec 时清理旧版本生成的 <标签>.csv)
+    QString targetFilename = collectSubPath + QString("/%1.rec").arg(cleanLabel);
+    if (!QFile::exists(targetFilename) && QFile::exists(collectSubPath + QString("/%1.csv").arg(cleanLabel))) {
+        targetFilename = collectSubPath + QString("/%1.csv").arg(cleanLabel);
+    }
+    QFile fileToDelete(targetFilename);
 
     QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
     QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
 
     // * 检查文件是否存在并尝试删除
     if (fileToDelete.exists()) {
-        qDebug() << "Clean Button: Attempting to delete file:" << targetCsvFilename;
+        qDebug() << "Clean Button: Attempting to delete file:" << targetFilename;
         if (fileToDelete.remove()) {
-            qInfo() << "Clean Button: Successfully deleted file:" << targetCsvFilename;
+            qInfo() << "Clean Button: Successfully deleted file:" << targetFilename;
             if (ui->SysEdit) {
                 ui->SysEdit->appendHtml(QString("%1<font color='green'><b>清理成功:</b> 文件 '%2' 已删除.</font>")
-                                            .arg(dtp).arg(QFileInfo(targetCsvFilename).fileName().toHtmlEscaped())); // 只显示文件名
+                                            .arg(dtp).arg(QFileInfo(targetFilename).fileName().toHtmlEscaped())); // 只显示文件名
                 ui->SysEdit->ensureCursorVisible();
             }
         } else {
-            qWarning() << "Clean Button: Failed to delete file:" << targetCsvFilename << "Error:" << fileToDelete.errorString();
+            qWarning() << "Clean Button: Failed to delete file:" << targetFilename << "Error:" << fileToDelete.errorString();
             if (ui->SysEdit) {
                 ui->SysEdit->appendHtml(QString("%1<font color='red'><b>清理失败:</b> 无法删除文件 '%2'. 错误: %3</font>")
                                             .arg(dtp)
-                                            .arg(QFileInfo(targetCsvFilename).fileName().toHtmlEscaped())
+                                            .arg(QFileInfo(targetFilename).fileName().toHtmlEscaped())
                                             .arg(fileToDelete.errorString().toHtmlEscaped()));
                 ui->SysEdit->ensureCursorVisible();
             }
         }
     } else {
-        qInfo() << "Clean Button: File to delete does not exist:" << targetCsvFilename;
+        qInfo() << "Clean Button: File to delete does not exist:" << targetFilename;
         if (ui->SysEdit) {
             ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>清理提示:</b> 文件 '%2' 不存在，无需删除.</font>")
-                                        .arg(dtp).arg(QFileInfo(targetCsvFilename).fileName().toHtmlEscaped()));
+                                        .arg(dtp).arg(QFileInfo(targetFilename).fileName().toHtmlEscaped()));
             ui->SysEdit->ensureCursorVisible();
         }
     }
@@ -1637,9 +1816,11 @@ void Widget::on_HistoryBackButton_clicked()
         return;
     }
 
-    QString selectedFileName = ui->HistoryBox->currentData().toString();
-    if (selectedFileName.isEmpty() || ui->HistoryBox->itemText(ui->HistoryBox->currentIndex()) == "没有历史数据") {
-        qWarning() << "History Replay: Invalid file name selected from HistoryBox.";
+    const QVariant selectedData = ui->HistoryBox->currentData();
+    const qint64 selectedTimeMs = selectedData.toLongLong();
+    const QString selectedText = ui->HistoryBox->currentText();
+    if (!selectedData.isValid() || selectedTimeMs <= 0) {
+        qWarning() << "History Replay: Invalid record selected from HistoryBox.";
         if (ui->SysEdit) {
             QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
             QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
@@ -1653,90 +1834,122 @@ void Widget::on_HistoryBackButton_clicked()
     Mode = "History";
     ui->MoniterButton->setEnabled(true);
     if (ui->SysEdit) {
-        ui->SysEdit->appendHtml(QString("%1<font color='purple'><b>模式切换:</b> 进入历史回放模式, 准备分析文件 '%2'.</font>")
-                                    .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
+        ui->SysEdit->appendHtml(QString("%1<font color='purple'><b>模式切换:</b> 进入历史回放模式, 准备分析记录 '%2'.</font>")
+                                    .arg(dtp).arg(selectedText.toHtmlEscaped()));
         ui->SysEdit->ensureCursorVisible();
     }
-    qInfo() << "Mode changed to History for file:" << selectedFileName;
-
-    // * 清理 sensor_data_for_python 目录下的 data_*.csv 文件
-    QString sensorDataDir = getSensorDataDir();
-    QDir dirToClean(sensorDataDir);
-    if (dirToClean.exists()) {
-        dirToClean.setNameFilters(QStringList() << "data_*.csv");
-        dirToClean.setFilter(QDir::Files);
-        QStringList filesToDelete = dirToClean.entryList();
-        for (const QString &file : filesToDelete) {
-            if (dirToClean.remove(file)) {
-                qDebug() << "History Replay: Removed old file from sensor_data_for_python:" << file;
-            } else {
-                qWarning() << "History Replay: Failed to remove old file:" << dirToClean.filePath(file)
-                << "Error:" << QDir(dirToClean.filePath(file)).rmdir("."); //尝试获取更详细的错误
-                if (ui->SysEdit) {
-                    ui->SysEdit->appendHtml(QString("%1<font color='red'><b>历史回放警告:</b> 无法清理旧文件 '%2' 在工作目录中. 可能影响回放.</font>")
-                                                .arg(dtp).arg(file.toHtmlEscaped()));
-                    ui->SysEdit->ensureCursorVisible();
-                }
-                // 根据需求决定是否要因此停止回放
-                // return;
-            }
+    qInfo() << "Mode changed to History for record:" << selectedText;
+
+    // * 记录可能已按淘汰条件从存储中删除
+    if (!m_history.contains(selectedTimeMs)) {
+        qWarning() << "History Replay: Record no longer exists in history store:" << selectedTimeMs;
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>历史回放错误:</b> 记录 '%2' 已过期或不存在.</font>")
+                                        .arg(dtp).arg(selectedText.toHtmlEscaped()));
+            ui->SysEdit->ensureCursorVisible();
         }
+        ui->HistoryBox->removeItem(ui->HistoryBox->currentIndex());
+        updateHistoryButtons();
+        return;
     }
 
-    // * 将选定的历史文件从 processed_csv 移动到 sensor_data_for_python
-    QString sourceFilePath = getProcessedCsvDir() + "/" + selectedFileName;
-    QString targetFilePath = sensorDataDir + "/" + selectedFileName; // 使用原文件名
-
-    QFile sourceFileHandler(sourceFilePath); // 用于检查存在性和执行移动
-    if (!sourceFileHandler.exists()) {
-        qWarning() << "History Replay: Source file does not exist in processed_csv:" << sourceFilePath;
+    // * 读取并显示历史数据到波形图，并重新发送给模型分析; 存储中的记录只有一帧，不使用 ReplaySlider
+    ui->ReplaySlider->setEnabled(false);
+    if (loadAndDisplayHistory(selectedTimeMs, true)) {
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='DarkGreen'><b>历史回放:</b> 记录 '%2' 波形已加载, 已发送给模型分析.</font>")
+                                        .arg(dtp).arg(selectedText.toHtmlEscaped()));
+            ui->SysEdit->ensureCursorVisible();
+        }
+    } else {
         if (ui->SysEdit) {
-            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>历史回放错误:</b> 源文件 '%2' 在历史记录中不存在.</font>")
-                                        .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>历史回放警告:</b> 记录 '%2' 加载失败或模型服务未连接.</font>")
+                                        .arg(dtp).arg(selectedText.toHtmlEscaped()));
             ui->SysEdit->ensureCursorVisible();
         }
+    }
+}
+
+/**
+ * @brief 回放文件按键槽: 选择 Collect 模式录制的 .rec 文件或 CSV，进入历史回放模式，
+ *        显示文件开头 m_replayWindowSec 长的波形，并把第一帧发送给模型分析
+ */
+void Widget::on_ReplayFileButton_clicked()
+{
+    const QString filePath = QFileDialog::getOpenFileName(this, "选择回放文件", getSensorDataDir() + "/Collect",
+                                                          "录制文件 (*.rec *.csv);;所有文件 (*)");
+    if (filePath.isEmpty()) {
         return;
     }
+    QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+    QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+    const QString fileName = QFileInfo(filePath).fileName();
 
-    // * QFile::rename() 可以用于移动文件 (如果源和目标在同一个文件系统分区)
-    // * 它会覆盖目标位置的同名文件（如果存在且可写）
-    bool fileMoveSuccess = sourceFileHandler.rename(targetFilePath);
+    // * 切换模式
+    Mode = "History";
+    ui->MoniterButton->setEnabled(true);
+    qInfo() << "Mode changed to History for file:" << filePath;
 
-    // * 读取并显示历史数据到波形图
-    if (fileMoveSuccess) {
-        qInfo() << "History Replay: Moved" << sourceFilePath << "to" << targetFilePath;
+    if (loadAndDisplayCsvData(filePath, true, 0.0)) {
+        setupReplaySlider();
         if (ui->SysEdit) {
-            ui->SysEdit->appendHtml(QString("%1<font color='blue'><b>历史回放:</b> 文件 '%2' 已准备好供模型分析. 正在加载波形...</font>")
-                                        .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
+            ui->SysEdit->appendHtml(QString("%1<font color='DarkGreen'><b>文件回放:</b> '%2' 波形已加载, 已发送给模型分析.</font>")
+                                        .arg(dtp).arg(fileName.toHtmlEscaped()));
             ui->SysEdit->ensureCursorVisible();
         }
-
-        // ** 从新位置 (targetFilePath) 加载并显示CSV数据
-        if (loadAndDisplayCsvData(targetFilePath)) {
-            if (ui->SysEdit) {
-                ui->SysEdit->appendHtml(QString("%1<font color='DarkGreen'><b>历史回放:</b> 文件 '%2' 波形已加载.</font>")
-                                            .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
-                ui->SysEdit->ensureCursorVisible();
-            }
-        } else {
-            if (ui->SysEdit) {
-                ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>历史回放警告:</b> 文件 '%2' 已移动, 但加载波形失败.</font>")
-                                            .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
-                ui->SysEdit->ensureCursorVisible();
-            }
-        }
-        // ** Python 脚本会检测到 targetFilePath 并处理，处理完后 Python 会将其移回 processed_csv
     } else {
-        qWarning() << "History Replay: Failed to move file. Source:" << sourceFilePath << "Target:" << targetFilePath
-                   << "Error:" << sourceFileHandler.errorString();
         if (ui->SysEdit) {
-            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>历史回放错误:</b> 无法移动文件 '%2' 到工作目录. 错误: %3</font>")
-                                        .arg(dtp).arg(selectedFileName.toHtmlEscaped()).arg(sourceFileHandler.errorString().toHtmlEscaped()));
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>文件回放警告:</b> '%2' 加载失败或模型服务未连接.</font>")
+                                        .arg(dtp).arg(fileName.toHtmlEscaped()));
             ui->SysEdit->ensureCursorVisible();
         }
     }
 }
 
+/**
+ * @brief 按当前回放文件的时长设置 ReplaySlider: 范围为 [0, 总时长 - m_replayWindowSec]，每格 m_replaySliderStepMs
+ */
+void Widget::setupReplaySlider()
+{
+    const double totalSec = m_replayLoader.sampleRate() > 0
+                                ? double(m_replayLoader.sampleCount()) / m_replayLoader.sampleRate() : 0.0;
+    const int maximum = qMax(0, int((totalSec - m_replayWindowSec) * 1000.0 / m_replaySliderStepMs));
+    QSignalBlocker blocker(ui->ReplaySlider); // 重设范围不触发回放
+    ui->ReplaySlider->setRange(0, maximum);
+    ui->ReplaySlider->setPageStep(qMax(1, int(m_replayWindowSec * 1000.0 / m_replaySliderStepMs)));
+    ui->ReplaySlider->setValue(0);
+    ui->ReplaySlider->setEnabled(maximum > 0);
+}
+
+/**
+ * @brief 拖动 ReplaySlider: 从映射的文件中读取并显示该时刻起的一段，不发送给模型
+ */
+void Widget::on_ReplaySlider_valueChanged(int value)
+{
+    if (Mode != "History" || !m_replayLoader.isOpen()) {
+        return;
+    }
+    loadAndDisplayCsvData(m_replayLoader.path(), false, value * m_replaySliderStepMs / 1000.0);
+}
+
+/**
+ * @brief 松开 ReplaySlider: 把当前时段起点的一帧发送给模型分析
+ */
+void Widget::on_ReplaySlider_sliderReleased()
+{
+    if (Mode != "History" || !m_replayLoader.isOpen()) {
+        return;
+    }
+    const double fromSec = ui->ReplaySlider->value() * m_replaySliderStepMs / 1000.0;
+    if (!loadAndDisplayCsvData(m_replayLoader.path(), true, fromSec) && ui->SysEdit) {
+        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+        ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>文件回放警告:</b> %2 s 处加载失败或模型服务未连接.</font>")
+                                    .arg(dtp).arg(fromSec, 0, 'f', 1));
+        ui->SysEdit->ensureCursorVisible();
+    }
+}
+
 /**
  * @brief 清除选中标签历史数据按键槽
  */
@@ -1761,97 +1974,58 @@ void Widget::on_HistoryCleanButton_clicked()
         return;
     }
 
-    // * 从 HistoryBox 的用户数据中获取完整文件名
-    QString selectedFileName = ui->HistoryBox->itemData(currentIndex).toString();
-
-    // * 检查获取的文件名是否有效（例如，是否是 "没有历史数据" 占位符对应的数据，该数据应该是空的）
-    if (selectedFileName.isEmpty()) {
-        QString currentItemText = ui->HistoryBox->itemText(currentIndex);
-        if (currentItemText == "没有历史数据") {
-            qInfo() << "History Clean: '没有历史数据' selected, nothing to delete.";
-            if (ui->SysEdit) {
-                QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                ui->SysEdit->appendHtml(QString("%1<font color='gray'><b>历史清理:</b> 当前选择为占位符, 无需操作.</font>").arg(dtp));
-                ui->SysEdit->ensureCursorVisible();
-            }
-        } else {
-            qWarning() << "History Clean: Selected item has empty file data, but text is not placeholder:" << currentItemText;
-            if (ui->SysEdit) {
-                QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
-                QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-                ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>历史清理:</b> 无效的选择项数据.</font>").arg(dtp));
-                ui->SysEdit->ensureCursorVisible();
-            }
-        }
-        return;
-    }
-
-    QString filePathToDelete = getProcessedCsvDir() + "/" + selectedFileName;
-    QFile fileToDelete(filePathToDelete);
+    // * 从 HistoryBox 的用户数据中获取记录时刻，占位符没有用户数据
+    const QVariant selectedData = ui->HistoryBox->itemData(currentIndex);
+    const qint64 selectedTimeMs = selectedData.toLongLong();
+    const QString selectedText = ui->HistoryBox->itemText(currentIndex);
 
     QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
     QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
 
-    if (fileToDelete.exists()) {
-
-        if (fileToDelete.remove()) {
-            qInfo() << "History Clean: Successfully deleted file:" << filePathToDelete;
-            if (ui->SysEdit) {
-                ui->SysEdit->appendHtml(QString("%1<font color='green'><b>历史清理:</b> 文件 '%2' 已从磁盘删除.</font>")
-                                            .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
-                ui->SysEdit->ensureCursorVisible();
-            }
-            // ** 从 HistoryBox 中移除项
-            ui->HistoryBox->removeItem(currentIndex);
+    if (!selectedData.isValid() || selectedTimeMs <= 0) {
+        qInfo() << "History Clean: Placeholder selected, nothing to delete.";
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='gray'><b>历史清理:</b> 当前选择为占位符, 无需操作.</font>").arg(dtp));
+            ui->SysEdit->ensureCursorVisible();
+        }
+        return;
+    }
 
-        } else {
-            // ** 文件存在但删除失败
-            qWarning() << "History Clean: Failed to delete file:" << filePathToDelete << "Error:" << fileToDelete.errorString();
-            if (ui->SysEdit) {
-                ui->SysEdit->appendHtml(QString("%1<font color='red'><b>历史清理错误:</b> 无法删除文件 '%2'. 错误: %3</font>")
-                                            .arg(dtp)
-                                            .arg(selectedFileName.toHtmlEscaped())
-                                            .arg(fileToDelete.errorString().toHtmlEscaped()));
-                ui->SysEdit->ensureCursorVisible();
-            }
-            // ** 此时不应该从 HistoryBox 移除，因为文件还在磁盘上
+    // * 在历史存储中标记删除(墓碑)，数据随所在分段淘汰时回收
+    if (!m_history.contains(selectedTimeMs)) {
+        qWarning() << "History Clean: Record no longer exists in history store:" << selectedTimeMs;
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>历史清理提示:</b> 记录 '%2' 已过期或不存在. 将从列表中移除.</font>")
+                                        .arg(dtp).arg(selectedText.toHtmlEscaped()));
+            ui->SysEdit->ensureCursorVisible();
         }
-    } else {
-            // **文件在磁盘上不存在
-        qWarning() << "History Clean: File to delete does not exist on disk:" << filePathToDelete;
+        ui->HistoryBox->removeItem(currentIndex);
+    } else if (m_history.remove(selectedTimeMs)) {
+        qInfo() << "History Clean: Successfully deleted record:" << selectedTimeMs;
         if (ui->SysEdit) {
-            ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>历史清理提示:</b> 文件 '%2' 在磁盘上已不存在. 将从列表中移除.</font>")
-                                        .arg(dtp).arg(selectedFileName.toHtmlEscaped()));
+            ui->SysEdit->appendHtml(QString("%1<font color='green'><b>历史清理:</b> 记录 '%2' 已删除.</font>")
+                                        .arg(dtp).arg(selectedText.toHtmlEscaped()));
             ui->SysEdit->ensureCursorVisible();
         }
-        // ** 文件在磁盘上不存在，但可能仍在列表中（例如，外部删除了文件），所以也从 HistoryBox 中移除。
+        // ** 从 HistoryBox 中移除项
         ui->HistoryBox->removeItem(currentIndex);
+    } else {
+        // ** 删除失败时保留列表项，因为数据仍在存储中
+        qWarning() << "History Clean: Failed to delete record:" << selectedTimeMs << "Error:" << m_history.errorString();
+        if (ui->SysEdit) {
+            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>历史清理错误:</b> 无法删除记录 '%2'. 错误: %3</font>")
+                                        .arg(dtp)
+                                        .arg(selectedText.toHtmlEscaped())
+                                        .arg(m_history.errorString().toHtmlEscaped()));
+            ui->SysEdit->ensureCursorVisible();
+        }
     }
 
-    // * 统一处理 HistoryBox 在移除项后的状态
-    if (ui->HistoryBox->count() == 0) {
-        ui->HistoryBox->addItem("历史数据为空"); // 添加占位符
-        ui->HistoryBox->setCurrentIndex(0);    // 选中占位符
-        ui->HistoryBox->setEnabled(false);
-        if(ui->HistoryBackButton)
-        {
-            if(Mode == "Monitor")
-            {
-               ui->HistoryBackButton->setEnabled(false);
-            }
-        }
-        if(ui->HistoryCleanButton) ui->HistoryCleanButton->setEnabled(false);
-        if(ui->HistoryCleanAllButton) ui->HistoryCleanAllButton->setEnabled(false);
-    } else {
-        // ** 如果列表不为空，确保按钮是启用的，并选中一个有效的项
-        ui->HistoryBox->setEnabled(true);
-        if(ui->HistoryBackButton) ui->HistoryBackButton->setEnabled(true);
-        if(ui->HistoryCleanButton) ui->HistoryCleanButton->setEnabled(true);
-        if(ui->HistoryCleanAllButton) ui->HistoryCleanAllButton->setEnabled(true);
-        // ** 删除后总是指向最新的一次数据
+    // * 统一处理 HistoryBox 在移除项后的状态，删除后总是指向最新的一次数据
+    if (ui->HistoryBox->count() > 0) {
         ui->HistoryBox->setCurrentIndex(0);
     }
+    updateHistoryButtons();
 }
 
 /**
@@ -1877,87 +2051,33 @@ void Widget::on_HistoryCleanAllButton_clicked()
         return;
     }
 
-    // * 获取 processed_csv 目录路径
-    QString processedPath = getProcessedCsvDir();
-    QDir processedDir(processedPath);
-
-    int deletedFileCount = 0;
-    int failedToDeleteCount = 0;
-    QStringList failedFiles;
-
-    if (processedDir.exists()) {
-        processedDir.setNameFilters(QStringList() << "data_*.csv"); // 目标文件类型
-        processedDir.setFilter(QDir::Files | QDir::NoDotAndDotDot); // 只查找文件
-
-        QFileInfoList fileList = processedDir.entryInfoList();
-
-        if (fileList.isEmpty()) {
-            if (ui->SysEdit) {
-                ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>清除所有历史:</b> 没有找到可删除的历史文件.</font>").arg(dtp));
-                ui->SysEdit->ensureCursorVisible();
-            }
-        } else {
-            for (const QFileInfo &fileInfo : fileList) {
-                QString filePathToDelete = fileInfo.absoluteFilePath();
-                QFile file(filePathToDelete);
-                if (file.remove()) {
-                    deletedFileCount++;
-                    qInfo() << "Clean All History: Deleted" << filePathToDelete;
-                } else {
-                    failedToDeleteCount++;
-                    failedFiles.append(fileInfo.fileName());
-                    qWarning() << "Clean All History: Failed to delete" << filePathToDelete << "Error:" << file.errorString();
-                }
-            }
-        }
-    } else {
-        qWarning() << "Clean All History: Processed CSV directory does not exist:" << processedPath;
-        if (ui->SysEdit) {
-            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>清除所有历史错误:</b> 历史数据目录不存在.</font>").arg(dtp));
-            ui->SysEdit->ensureCursorVisible();
-        }
+    // * 删除历史存储中的全部分段
+    const bool wasEmpty = m_history.isEmpty();
+    const int removedSegments = m_history.clear();
+    if (removedSegments < 0) {
+        qWarning() << "Clean All History: Failed to clear history store:" << m_history.errorString();
     }
 
     // * 清空 ComboBox 并设置占位符
     if (ui->HistoryBox) {
         ui->HistoryBox->clear();
-        ui->HistoryBox->addItem("历史数据为空"); // 或者 "没有历史数据"
-        ui->HistoryBox->setCurrentIndex(0);
-        ui->HistoryBox->setEnabled(false); // 因为没有可选数据了
-    }
-
-    // * 禁用相关按钮
-    if (ui->HistoryBackButton) {
-        ui->HistoryBackButton->setEnabled(false);
-    }
-    if (ui->HistoryCleanButton) {
-        ui->HistoryCleanButton->setEnabled(false);
+        updateHistoryButtons(); // 添加 "历史数据为空" 占位符并禁用相关按钮
     }
 
-    ui->HistoryCleanAllButton->setEnabled(false);
     // * 在 SysEdit 中给出反馈
     if (ui->SysEdit) {
-        if (deletedFileCount > 0 && failedToDeleteCount == 0) {
-            ui->SysEdit->appendHtml(QString("%1<font color='green'><b>清除所有历史成功:</b> 共删除了 %2 个历史文件.</font>")
-                                        .arg(dtp).arg(deletedFileCount));
-        } else if (deletedFileCount > 0 && failedToDeleteCount > 0) {
-            ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>清除所有历史部分成功:</b> 删除了 %2 个文件, %3 个文件删除失败: %4.</font>")
-                                        .arg(dtp).arg(deletedFileCount).arg(failedToDeleteCount).arg(failedFiles.join(", ").toHtmlEscaped()));
-        } else if (deletedFileCount == 0 && failedToDeleteCount > 0) {
-            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>清除所有历史失败:</b> %2 个文件删除失败: %3.</font>")
-                                        .arg(dtp).arg(failedToDeleteCount).arg(failedFiles.join(", ").toHtmlEscaped()));
-        } else if (deletedFileCount == 0 && failedToDeleteCount == 0 && !processedDir.exists()) {
-            // 这个情况已在上面处理目录不存在时给出错误信息
-        } else if (deletedFileCount == 0 && failedToDeleteCount == 0 && processedDir.exists()){
-            // 这个情况是目录存在但里面没有data_*.csv文件，已经在上面处理"没有找到可删除的历史文件"
-        }
-        if(ui->SysEdit->toPlainText().endsWith("操作.\n")) {
-            // ** 检查是否只有取消操作的消息
-            ui->SysEdit->appendHtml(QString("%1<font color='gray'><b>清除所有历史:</b> 操作完成.</font>").arg(dtp));
+        if (removedSegments < 0) {
+            ui->SysEdit->appendHtml(QString("%1<font color='red'><b>清除所有历史失败:</b> 部分历史数据分段删除失败: %2.</font>")
+                                        .arg(dtp).arg(m_history.errorString().toHtmlEscaped()));
+        } else if (wasEmpty) {
+            ui->SysEdit->appendHtml(QString("%1<font color='orange'><b>清除所有历史:</b> 没有找到可删除的历史数据.</font>").arg(dtp));
+        } else {
+            ui->SysEdit->appendHtml(QString("%1<font color='green'><b>清除所有历史成功:</b> 共删除了 %2 个历史数据分段.</font>")
+                                        .arg(dtp).arg(removedSegments));
         }
         ui->SysEdit->ensureCursorVisible();
     }
-    qInfo() << "Clean All History: Finished. Deleted:" << deletedFileCount << "Failed:" << failedToDeleteCount;
+    qInfo() << "Clean All History: Finished. Removed segments:" << removedSegments;
 }
 
 /**
@@ -2005,6 +2125,7 @@ void Widget::on_MoniterButton_clicked()
     {
         Mode = "Monitor";
         ui->MoniterButton->setEnabled(false);
+        ui->ReplaySlider->setEnabled(false);
         if (ui->SysEdit) {
             ui->SysEdit->appendHtml(QString("%1<font color='purple'><b>模式切换:</b> 进入实时监测模式.</font>")
                                         .arg(dtp));
@@ -2014,60 +2135,62 @@ void Widget::on_MoniterButton_clicked()
 }
 
 /**
- * @brief 对一个数据向量应用滑动平均滤波器。
- * @param rawData 原始数据向量。
- * @param windowSize 滤波窗口的大小，必须是正奇数。
- * @return 平滑滤波后的新数据向量。
+ * @brief 关闭蜂鸣器按键槽
  */
-QVector<double> Widget::applyMovingAverageFilter(const QVector<double>& rawData, int windowSize)
+void Widget::on_beepOffButton_clicked()
 {
-    if (rawData.isEmpty() || windowSize <= 0) {
-        return rawData; // 如果数据为空或窗口大小无效，返回原始数据
+    beepctl->stopAlert();
+    if (ui->SysEdit) {
+        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+        ui->SysEdit->appendHtml(QString("%1<font color='orange'>Alert has been closed.").arg(dtp));
+        ui->SysEdit->ensureCursorVisible();
     }
+}
 
-    // * 确保窗口大小是奇数，这样中心点才明确
-    if (windowSize % 2 == 0) {
-        windowSize++;
+/**
+ * @brief 重叠窗口分析开关槽: 之后发送的连续帧按帧携带 FlagOverlap，无需重启模型进程
+ */
+void Widget::on_OverlapCheckBox_toggled(bool checked)
+{
+    m_overlapWindows = checked;
+    if (ui->SysEdit) {
+        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+        ui->SysEdit->appendHtml(QString("%1<font color='purple'>重叠窗口分析: %2</font>")
+                                    .arg(dtp, checked ? "开" : "关"));
+        ui->SysEdit->ensureCursorVisible();
     }
+}
 
-    QVector<double> filteredData;
-    filteredData.reserve(rawData.size()); // 预分配内存以提高效率
-
-    int halfWindow = windowSize / 2;
-
-    for (int i = 0; i < rawData.size(); ++i) {
-        double sum = 0.0;
-        int count = 0;
-        // ** 在当前点的周围取一个窗口
-        for (int j = -halfWindow; j <= halfWindow; ++j) {
-            int index = i + j;
-            // ** 确保窗口索引在有效范围内
-            if (index >= 0 && index < rawData.size()) {
-                sum += rawData[index];
-                count++;
-            }
-        }
-        // ** 计算平均值并添加到结果中
-        if (count > 0) {
-            filteredData.append(sum / count);
-        } else {
-            filteredData.append(rawData[i]);
-        }
+/**
+ * @brief int8 推理开关槽: 从推理线程处理的下一个窗口起生效，每窗口耗时显示在状态栏(Infer)
+ */
+void Widget::on_Int8CheckBox_toggled(bool checked)
+{
+    if (!m_inference || !m_inference->setInt8(checked)) {
+        return;
+    }
+    if (ui->SysEdit) {
+        QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
+        QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
+        ui->SysEdit->appendHtml(QString("%1<font color='purple'>int8 推理: %2</font>")
+                                    .arg(dtp, checked ? "开" : "关"));
+        ui->SysEdit->ensureCursorVisible();
     }
-    return filteredData;
 }
 
 /**
- * @brief 关闭蜂鸣器按键槽
+ * @brief 压缩传输开关槽: 从下一帧起改发 CompressedThreeAxisData(原始码值 + 滤波窗口)，客户端解码后做相同的滑动平均
  */
-void Widget::on_beepOffButton_clicked()
+void Widget::on_CompressStreamCheckBox_toggled(bool checked)
 {
-    beepctl->stopAlert();
+    m_compressStream = checked;
     if (ui->SysEdit) {
         QDate cd = QDate::currentDate(); QTime ct = QTime::currentTime();
         QString dtp = QString("[%1 %2] ").arg(cd.toString("yyyy-MM-dd")).arg(ct.toString("HH:mm:ss"));
-        ui->SysEdit->appendHtml(QString("%1<font color='orange'>Alert has been closed.").arg(dtp));
+        ui->SysEdit->appendHtml(QString("%1<font color='purple'>压缩传输: %2</font>")
+                                    .arg(dtp, checked ? "开" : "关"));
         ui->SysEdit->ensureCursorVisible();
     }
 }
-
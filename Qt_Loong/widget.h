@@ -5,6 +5,7 @@
 #include <QTimer>
 #include "qcustomplot.h"
 #include "datareader.h"
+#include "acquisitionthread.h"
 #include <QRandomGenerator> // 用于生成模拟数据
 #include <cmath>          // 用于 std::sin, std::cos
 #include <QProcess>
@@ -15,6 +16,14 @@
 #include "widget_2.h"
 #include "datasender.h"
 #include "beepctl.h"
+#include "movingaverage.h"
+#include "modelipc.h"
+#include "inferencethread.h"
+#include "recordfile.h"
+#include "recordwriterthread.h"
+#include "historystore.h"
+#include "replayloader.h"
+#include <QHash>
 #include <QThread>
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -50,6 +59,12 @@ private slots:
 
     void on_HistoryBackButton_clicked();
 
+    void on_ReplayFileButton_clicked();
+
+    void on_ReplaySlider_valueChanged(int value);
+
+    void on_ReplaySlider_sliderReleased();
+
     void on_HistoryCleanButton_clicked();
 
     void on_HistoryCleanAllButton_clicked();
@@ -58,6 +73,24 @@ private slots:
 
     void on_beepOffButton_clicked();
 
+    void on_OverlapCheckBox_toggled(bool checked);
+
+    void on_Int8CheckBox_toggled(bool checked);
+
+    void on_CompressStreamCheckBox_toggled(bool checked);
+
+    // 模型通信通道返回的结果
+    void onModelResult(quint32 sequence, bool overlapped, int classIndex, double predictedConfidence,
+                       const QVector<double>& probabilities, const QVector<double>& features);
+    void onModelError(quint32 sequence, const QString& message);
+
+    // Collect 模式后台写盘线程报告的错误和写入卡顿
+    void onRecordWriteError(const QString& path, const QString& message);
+    void onRecordWriteStalled(qint64 writeMs, int backlog);
+    void onCollectFinished(quint64 framesCaptured);
+    // 模型环消费: 按 m_modelDrainMs 的节奏把新帧发送给模型
+    void drainModelRing();
+
 private:
     Ui::Widget *ui;
     // 心跳定时器，阻止屏幕休眠
@@ -81,24 +114,67 @@ private:
     widget_2 *m_mfccDisplayWindow;
 
     // 用于Collect模式的成员变量
-    QString m_currentCollectCsvPath;  // 当前正在收集的CSV文件的完整路径
-    QFile m_collectCsvFile;           // 当前打开用于收集的文件对象
-    QTextStream m_collectCsvStream;   // 当前用于写入收集文件的文本流
+    QString m_currentCollectPath;     // 当前正在收集的录制文件(<标签>.rec)的完整路径
+    RecordWriterThread* m_recordWriter; // Collect模式后台写盘线程，界面线程只负责入队
     int m_collect_cnt = 0;           // 用于记录已收集的样本数量
     bool finish = false;
+    QString m_collectLabel;          // 本次采集的标签(已去除非法字符)
+    QString m_collectTargetPath;     // 本次采集的录制文件，写入失败后据此重新打开
+    quint64 m_collectBaseFrames = 0; // 本次采集开始时写盘线程的统计，进度和丢帧按差值计算
+    quint64 m_collectBaseDropped = 0;
+    quint64 m_collectReportedDropped = 0;
 
     // 辅助函数声明
-    bool openAndPrepareCollectCsvFile(const QString& filePath, const QString& headerLine);
-    void closeCollectCsvFile();
+    bool startCollectCapture();
+    void updateCollectProgress();
+    void openCollectRecord(const QString& filePath, const QString& label);
+    void closeCollectRecord();
+    Record::FileHeader recordHeader(const QString& label); // 按采集线程的标定生成录制文件头
 
     bool Model_Deploy = false; //模型部署标志位
     QProcess *m_pythonModelProcess; // 用于管理 Python 模型进程
+    ModelIpcServer *m_modelIpc;     // 与 Python 模型进程之间的二进制通信通道
+    InferenceThread *m_inference;   // 进程内推理线程，部署成功时代替 Python 模型进程
+    bool m_nativeInference = true;  // [可调] 优先以 MfccEngine + ResNetEngine 在进程内推理(需要 resnet_weights.bin)，否则使用 Python 模型服务
+    bool m_int8Inference = false;   // [可调] 进程内推理默认使用 int8 路径(权重文件带量化系数时)，运行中由 Int8CheckBox 切换
+    bool startNativeModel();
+    void startPythonModel();
+    quint64 modelDroppedFrames() const;
     QString m_csvDataPath; // 存储CSV文件的路径
-    bool writeDataToCsv(const QString& filename,
-                        const QVector<double>& timeData,
-                        const QVector<double>& xData,
-                        const QVector<double>& yData,
-                        const QVector<double>& zData);
+    bool m_archiveHistory = true; // [可调] 预测可信时将原始数据追加到历史存储(m_history)，供历史回溯; 关闭后不写SD卡
+    HistoryStore m_history;        // 分段追加写入的历史数据存储(<m_csvDataPath>/history)
+    int m_historyBoxItems = 50;    // [可调] HistoryBox 中列出的最新记录数，只限制列表，存储中的数据按淘汰条件保留
+    ReplayLoader m_replayLoader;   // 回放文件的内存映射，同一文件再次回放时不重新读取
+    double m_replayWindowSec = 10.0; // [可调] 回放文件时一次显示的时长(s)
+    int m_replaySliderStepMs = 100;  // [可调] ReplaySlider 每一格对应的时长(ms)
+    void setupReplaySlider();        // 按 m_replayLoader 中文件的时长设置 ReplaySlider 的范围
+    QVector<float> m_replayX, m_replayY, m_replayZ; // 回放数据缓冲区，各次回放复用
+    bool m_compressStream = false; // [可调] 启动时是否压缩传输: 向客户端发送 AdcCodec 压缩的原始数据(约为未压缩的 1/10)，由客户端滤波; 运行中由 CompressStreamCheckBox 切换
+    bool m_overlapWindows = false; // 连续发送的两帧之间额外分析一个 50% 重叠窗口(结果数加倍)，由 OverlapCheckBox 切换
+    quint64 m_lastModelFrame = 0;  // 上一个发送给模型的采集帧序号
+    bool m_hasLastModelFrame = false;
+    // 已发送、等待模型结果的帧
+    struct PendingFrame {
+        qint64 timeMs = 0;   // 采集时刻，历史回放时为存储中记录的键
+        bool archive = false;
+        quint64 frameSequence = 0;
+        QVector<double> xData, yData, zData; // 仅 archive 时保存
+    };
+    QHash<quint32, PendingFrame> m_pendingFrames;
+    bool submitFrameToModel(qint64 timeMs,
+                            quint64 frameSequence,
+                            const QVector<double>& xData,
+                            const QVector<double>& yData,
+                            const QVector<double>& zData,
+                            bool archive,
+                            bool continuous = false);
+    void applyPrediction(qint64 historyTimeMs, int classIndex, double predictedConfidence,
+                         const QVector<double>& probabilities, const QVector<double>& features);
+    bool writeDataToHistory(qint64 timeMs,
+                            quint64 frameSequence,
+                            const QVector<double>& xData,
+                            const QVector<double>& yData,
+                            const QVector<double>& zData);
     void setLED(QLabel* label, int color, int size); //LED模拟
     void setupMultiAxisPlot(); // 波形显示设置函数
     void generateDataBatch(QVector<double>& timeKeys,
@@ -126,29 +202,46 @@ private:
 
     QString Mode = "Monitor";        //工作模式 Monitor/Collect/History
     QString Mode_Buf = "Monitor";
-    DataReader m_dataReader;  //采样数据获取器
+    AcquisitionThread* m_acquisitionThread;         // 采样数据采集线程
+    AcquisitionThread::FrameRing* m_frameRing;       // 界面线程消费的帧缓冲环(绘图和网络发送)
+    AcquisitionThread::FrameRing* m_storageRing;     // 写盘线程消费的帧缓冲环(Collect 录制)
+    AcquisitionThread::FrameRing* m_modelRing;       // 模型分析消费的帧缓冲环
+    QTimer m_modelTimer;                             // 模型环消费定时器
+    int m_modelDrainMs = 50;           // [可调] 模型环的消费间隔(ms)，小于一帧的时长(102.4ms)
+    bool m_lockAllMemory = false;      // [可调] 采集线程 mlockall 整个进程(否则只锁定采集缓冲区)
+    bool m_spikeFilterEnabled = true;  // [可调] 采集线程中的脉冲抑制(Hampel)
+    int m_spikeHalfWindow = 3;         // [可调] 脉冲抑制半窗长(1~4)，窗口 = 2k+1 点
+    float m_spikeThreshold = 3.0f;     // [可调] 脉冲判定阈值(MAD 估计的标准差倍数)
+    float m_spikeMinCodes = 4.0f;      // [可调] 最小判定偏差(ADC 量化间隔数)，按各轴标定换算
+    QString acquisitionStatusText() const; // 状态栏中的采集数据质量统计
     const int m_batchSize = 1024;//每次分析1024个点
+    MovingAverageFilter m_movingAverage{3}; // [可调] 滤波窗口大小，可以设为3, 5, 7等奇数。值越大越平滑。
+    QVector<double> m_filteredX, m_filteredY, m_filteredZ; // 滤波后的绘图数据，各批次复用
     int m_currentBatchNumber = 0;
 
     BeepCtl* beepctl;; //蜂鸣器
 
     // --- 历史功能相关 ---
     void populateHistoryBox(); // 填充 HistoryBox 下拉列表
-    QString getProcessedCsvDir(); // 辅助函数获取 processed_csv 目录路径
+    QString getProcessedCsvDir(); // 辅助函数获取旧版本 processed_csv 目录路径(Python 目录模式仍把处理过的文件移入该目录)
+    void importLegacyHistory();   // 启动时把 processed_csv 中的文件导入 m_history
     QString getSensorDataDir();   // 辅助函数获取 sensor_data_for_python 目录路径
-    void addHistoryItem(const QString& fullFileName);
-    bool loadAndDisplayCsvData(const QString& csvFilePath); //解析csv文件并显示波形
-    void cleanupOldHistoryFiles(); // 删除较早的波形
-    QString convertFileNameToDisplayFormat(const QString &fileName); // 辅助函数，用于将文件名格式转换为HistoryBox中的显示格式
+    void addHistoryItem(qint64 timeMs);
+    void updateHistoryButtons();  // 按 HistoryBox 是否有记录启用/禁用历史相关控件
+    bool loadAndDisplayHistory(qint64 timeMs, bool submitToModel = false); // 从历史存储读取一条记录并显示波形
+    bool loadAndDisplayCsvData(const QString& csvFilePath, bool submitToModel = false, double fromSec = 0.0); //映射录制文件或csv文件并显示 fromSec 起的一段波形
+    bool displayReplayBuffers(int count, double firstTime, quint64 frameSequence, qint64 historyTimeMs, bool submitToModel);
+    void displayReplayData(QVector<double>& timeKeys, QVector<double>& xData, QVector<double>& yData, QVector<double>& zData);
+    static QString historyDisplayText(qint64 timeMs); // HistoryBox 中的显示格式 yyyy-MM-dd HH:mm:ss.zzz
 
     // --- 获取屏幕分辨率 ---
     void checkScreenResolution();
 
-    // --- 用于执行滑动平均滤波的辅助函数 ---
-    QVector<double> applyMovingAverageFilter(const QVector<double>& rawData, int windowSize);
 signals:
     // 新增一个用于触发数据发送的信号
     void newDataReadyToSend(const QVector<double>& xData, const QVector<double>& yData, const QVector<double>& zData);
+    // m_compressStream 打开时代替 newDataReadyToSend，传递原始数据
+    void newRawDataReadyToSend(const QVector<double>& xData, const QVector<double>& yData, const QVector<double>& zData);
     // 用于传输模型发送
     void newModelOutReadyToSend(const QString& className, double confidence);
     // 用于状态发送
@@ -11,7 +11,7 @@ from torch.utils.data import Dataset, DataLoader
 import json  # [新增]
 import sys  # [新增]
 
-from pure_python_mfcc import safe_mfcc
+from pure_python_mfcc import MFCC
 
 plt.rcParams["font.family"] = ["SimHei", "WenQuanYi Micro Hei", "Heiti TC"]
 
@@ -28,6 +28,8 @@ class AccelerometerDataset(Dataset):
         self.frame_length = frame_length
         self.transform = transform
         self.label_encoder = LabelEncoder()
+        # 窗函数、滤波器组等只计算一次，供所有样本复用
+        self.mfcc = MFCC(samplerate=self.sample_rate, numcep=13, nfilt=26, nfft=1024)
         self.data, self.labels = self._load_data()
         self.classes = self.label_encoder.classes_
 
@@ -72,18 +74,12 @@ class AccelerometerDataset(Dataset):
                 if num_samples == 0:
                     # print(f"警告: 文件 {csv_file} 的行数少于 {self.frame_length}，已跳过") # 注释掉，避免过多日志
                     continue
-                for j in range(num_samples):
-                    start_idx = j * self.frame_length
-                    end_idx = start_idx + self.frame_length
-                    x_axis = df.iloc[start_idx:end_idx, 0].values
-                    y_axis = df.iloc[start_idx:end_idx, 1].values
-                    z_axis = df.iloc[start_idx:end_idx, 2].values
-                    x_mfcc = self._calculate_mfcc(x_axis)
-                    y_mfcc = self._calculate_mfcc(y_axis)
-                    z_mfcc = self._calculate_mfcc(z_axis)
-                    combined_mfcc = np.stack([x_mfcc, y_mfcc, z_mfcc], axis=2)
-                    data.append(combined_mfcc)
-                    labels.append(label)
+                # [样本数, 3轴, frame_length]，整个文件一次计算MFCC后调整为 [样本数, 帧数, MFCC系数, 3轴]
+                signals = df.values[:num_samples * self.frame_length].reshape(
+                    num_samples, self.frame_length, 3).transpose(0, 2, 1)
+                combined_mfcc = self._calculate_mfcc(signals).transpose(0, 2, 3, 1)
+                data.extend(combined_mfcc)
+                labels.extend([label] * num_samples)
             except Exception as e:
                 print(f"Python Error: 处理文件 {csv_file} 时出错: {str(e)}", file=sys.stderr, flush=True)
 
@@ -115,15 +111,9 @@ class AccelerometerDataset(Dataset):
         return data, encoded_labels
 
     def _calculate_mfcc(self, signal):
-        # --- 你的原有代码，保持不变 ---
+        # signal: [..., 采样点数] -> [..., 帧数, MFCC系数]
         signal = signal.astype(np.float32)
-        mfcc_feat = safe_mfcc(
-            signal,
-            samplerate=self.sample_rate,
-            numcep=13,
-            nfilt=26,
-            nfft=1024
-        )
+        mfcc_feat = self.mfcc(signal)
         return mfcc_feat
 
     def __len__(self):